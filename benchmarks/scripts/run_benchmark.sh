@@ -122,7 +122,10 @@ gcc -O3 -march=native -flto \
     "$PROJECT_DIR/src/lexer.c" \
     "$PROJECT_DIR/src/parser.c" \
     "$PROJECT_DIR/src/json.c" \
-    "$PROJECT_DIR/src/mem_pool.c"
+    "$PROJECT_DIR/src/mem_pool.c" \
+    "$PROJECT_DIR/src/hash.c" \
+    "$PROJECT_DIR/src/intern.c" \
+    -pthread
 
 echo -e "${GREEN}✓ C benchmark compiled${NC}"
 
@@ -132,7 +135,8 @@ echo -e "${BLUE}Running C parser benchmark...${NC}"
 "$BENCHMARK_DIR/bin/bench_parser" \
     "$DATA_DIR" \
     "$RESULT_DIR/performance.csv" \
-    "$RESULT_DIR/memory.csv"
+    "$RESULT_DIR/memory.csv" \
+    "$RESULT_DIR/page_faults.csv"
 echo -e "${GREEN}✓ C benchmark complete${NC}"
 
 # Run Node.js benchmark
@@ -0,0 +1,517 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "../../include/parser.h"
+#include "../../include/mem_pool.h"
+#include "../../include/intern.h"
+
+// Hash table microbenchmark: insert, lookup and in-order iteration
+// throughput for object tables, insert cost for key sets that fully collide
+// under the previous fixed-seed FNV-1a hash or, for every seed, under a
+// multiply-fold hash keyed only at the start, repeated lookups with prebuilt
+// key handles, parsing a stream of same-shaped documents with and
+// without a shared intern table, and the cost of an intern table hit from
+// one thread and from several at once
+
+#define BLOCK_LEN 6
+#define BLOCK_CHARS "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789"
+
+#define MIN_TOTAL_OPS 4000000
+
+#define HOT_KEYS 12
+#define HOT_OBJECTS 4096
+#define HOT_ROUNDS 100
+
+#define STREAM_KEYS 200
+#define STREAM_DOCS 2000
+
+#define INTERN_ROUNDS 20000
+#define INTERN_THREADS 4
+
+static double get_time_us(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000.0 + tv.tv_usec;
+}
+
+typedef struct {
+    char* data;
+    size_t* offsets;
+    size_t* lengths;
+    size_t count;
+} key_set_t;
+
+// Keys shaped like large_object.json / feature-flag maps
+static key_set_t make_keys(size_t count, const char* prefix) {
+    key_set_t keys;
+    keys.count = count;
+    keys.data = malloc(count * 32);
+    keys.offsets = malloc(count * sizeof(size_t));
+    keys.lengths = malloc(count * sizeof(size_t));
+    size_t pos = 0;
+    for (size_t i = 0; i < count; i++) {
+        int len = snprintf(keys.data + pos, 32, "%s%zu", prefix, i);
+        keys.offsets[i] = pos;
+        keys.lengths[i] = (size_t)len;
+        pos += (size_t)len + 1;
+    }
+    return keys;
+}
+
+static void free_keys(key_set_t* keys) {
+    free(keys->data);
+    free(keys->offsets);
+    free(keys->lengths);
+}
+
+// The hash used for object keys before the seeded hash
+static uint32_t fnv1a_step(uint32_t hash, const char* str, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (uint8_t)str[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static uint64_t rng_state = 0x9E3779B97F4A7C15ULL;
+static uint64_t rng_next(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static void random_block(char* out) {
+    for (int i = 0; i < BLOCK_LEN; i++) {
+        out[i] = BLOCK_CHARS[rng_next() % (sizeof(BLOCK_CHARS) - 1)];
+    }
+}
+
+/**
+ * Birthday-search two different blocks that map FNV state `from` to the same
+ * state. Chaining one such pair per position yields 2^positions keys with an
+ * identical 32-bit FNV-1a hash.
+ */
+static uint32_t find_block_pair(uint32_t from, char* a, char* b) {
+    size_t table_size = 1 << 20;
+    uint32_t* states = calloc(table_size, sizeof(uint32_t));
+    char* blocks = malloc(table_size * BLOCK_LEN);
+    unsigned char* used = calloc(table_size, 1);
+
+    while (1) {
+        char block[BLOCK_LEN];
+        random_block(block);
+        uint32_t state = fnv1a_step(from, block, BLOCK_LEN);
+        size_t slot = state & (table_size - 1);
+        while (used[slot] && states[slot] != state) {
+            slot = (slot + 1) & (table_size - 1);
+        }
+        if (used[slot] && memcmp(blocks + slot * BLOCK_LEN, block, BLOCK_LEN) != 0) {
+            memcpy(a, blocks + slot * BLOCK_LEN, BLOCK_LEN);
+            memcpy(b, block, BLOCK_LEN);
+            free(states);
+            free(blocks);
+            free(used);
+            return state;
+        }
+        used[slot] = 1;
+        states[slot] = state;
+        memcpy(blocks + slot * BLOCK_LEN, block, BLOCK_LEN);
+    }
+}
+
+// Build 2^positions keys sharing one FNV-1a hash
+static key_set_t make_colliding_keys(int positions) {
+    char pairs[32][2][BLOCK_LEN];
+    uint32_t state = 2166136261u;
+    for (int p = 0; p < positions; p++) {
+        state = find_block_pair(state, pairs[p][0], pairs[p][1]);
+    }
+
+    key_set_t keys;
+    keys.count = (size_t)1 << positions;
+    size_t key_len = (size_t)positions * BLOCK_LEN;
+    keys.data = malloc(keys.count * (key_len + 1));
+    keys.offsets = malloc(keys.count * sizeof(size_t));
+    keys.lengths = malloc(keys.count * sizeof(size_t));
+    for (size_t i = 0; i < keys.count; i++) {
+        char* key = keys.data + i * (key_len + 1);
+        for (int p = 0; p < positions; p++) {
+            memcpy(key + p * BLOCK_LEN, pairs[p][(i >> p) & 1], BLOCK_LEN);
+        }
+        key[key_len] = '\0';
+        keys.offsets[i] = i * (key_len + 1);
+        keys.lengths[i] = key_len;
+    }
+    return keys;
+}
+
+/**
+ * Keys "<8-byte counter><JSON_HASH_P1><suffix>". A hash that XORs each word
+ * with the public constant multiplies by zero at the middle word and forgets
+ * the counter, so all of these would share one hash whatever the seed.
+ */
+static key_set_t make_reset_keys(size_t count) {
+    const uint64_t reset = JSON_HASH_P1;
+    const size_t key_len = 24;
+    key_set_t keys;
+    keys.count = count;
+    keys.data = malloc(count * (key_len + 1));
+    keys.offsets = malloc(count * sizeof(size_t));
+    keys.lengths = malloc(count * sizeof(size_t));
+    for (size_t i = 0; i < count; i++) {
+        char* key = keys.data + i * (key_len + 1);
+        char counter[9];
+        snprintf(counter, sizeof(counter), "%08zx", i);
+        memcpy(key, counter, 8);
+        memcpy(key + 8, &reset, 8);
+        memcpy(key + 16, "_suffix_", 8);
+        key[key_len] = '\0';
+        keys.offsets[i] = i * (key_len + 1);
+        keys.lengths[i] = key_len;
+    }
+    return keys;
+}
+
+// Keys of the set that share the first key's current hash_string()
+static size_t count_same_hash(const key_set_t* keys) {
+    uint32_t first = hash_string(keys->data, keys->lengths[0]);
+    size_t same = 0;
+    for (size_t i = 0; i < keys->count; i++) {
+        same += hash_string(keys->data + keys->offsets[i], keys->lengths[i]) == first;
+    }
+    return same;
+}
+
+static double time_inserts(const key_set_t* keys, size_t count) {
+    mem_pool_t* pool = pool_create();
+    hash_table_t table;
+    hash_table_init_inplace(&table, 0, pool);
+
+    double start = get_time_us();
+    for (size_t i = 0; i < count; i++) {
+        hash_table_insert(&table, keys->data + keys->offsets[i], keys->lengths[i],
+                          json_value_number((double)i), pool);
+    }
+    double elapsed = get_time_us() - start;
+
+    pool_destroy(pool);
+    return elapsed;
+}
+
+static void bench_adversarial(FILE* csv) {
+    const int positions = 16;
+    key_set_t colliding = make_colliding_keys(positions);
+    key_set_t reset = make_reset_keys(colliding.count);
+    key_set_t control = make_keys(colliding.count, "key_");
+
+    uint32_t first = fnv1a_step(2166136261u, colliding.data, colliding.lengths[0]);
+    size_t same = 0;
+    for (size_t i = 0; i < colliding.count; i++) {
+        same += fnv1a_step(2166136261u, colliding.data + colliding.offsets[i], colliding.lengths[i]) == first;
+    }
+
+    printf("\nAdversarial keys: %zu keys, %zu share FNV-1a hash 0x%08x\n", colliding.count, same, first);
+    printf("Seed-independent keys: %zu keys, %zu share the first key's hash (%zu for FNV keys)\n",
+           reset.count, count_same_hash(&reset), count_same_hash(&colliding));
+    printf("%10s %14s %14s %14s\n", "keys", "colliding ns", "reset ns", "control ns");
+    if (csv) {
+        fprintf(csv, "\nkeys,colliding_insert_ns,reset_insert_ns,control_insert_ns\n");
+    }
+
+    for (size_t count = 1024; count <= colliding.count; count *= 2) {
+        double colliding_ns = time_inserts(&colliding, count) * 1000.0 / count;
+        double reset_ns = time_inserts(&reset, count) * 1000.0 / count;
+        double control_ns = time_inserts(&control, count) * 1000.0 / count;
+        printf("%10zu %14.2f %14.2f %14.2f\n", count, colliding_ns, reset_ns, control_ns);
+        if (csv) {
+            fprintf(csv, "%zu,%.2f,%.2f,%.2f\n", count, colliding_ns, reset_ns, control_ns);
+        }
+    }
+
+    free_keys(&colliding);
+    free_keys(&reset);
+    free_keys(&control);
+}
+
+// Same dozen keys looked up across many objects, by C string and by handle
+static void bench_hot_keys(FILE* csv) {
+    static const char* names[HOT_KEYS] = {
+        "id", "type", "timestamp", "user_id", "session", "status",
+        "latency_ms", "region", "endpoint", "method", "bytes", "trace_id",
+    };
+    mem_pool_t* pool = pool_create();
+    json_value_t* objects = malloc(HOT_OBJECTS * sizeof(json_value_t));
+    for (size_t o = 0; o < HOT_OBJECTS; o++) {
+        objects[o] = json_value_object_pooled(HOT_KEYS, pool);
+        for (size_t k = 0; k < HOT_KEYS; k++) {
+            hash_table_insert(objects[o].object, names[k], strlen(names[k]),
+                              json_value_number((double)k), pool);
+        }
+    }
+
+    json_key_t keys[HOT_KEYS];
+    for (size_t k = 0; k < HOT_KEYS; k++) {
+        keys[k] = json_key(names[k]);
+    }
+
+    volatile double sum = 0.0;
+    double start = get_time_us();
+    for (int r = 0; r < HOT_ROUNDS; r++) {
+        for (size_t o = 0; o < HOT_OBJECTS; o++) {
+            for (size_t k = 0; k < HOT_KEYS; k++) {
+                sum += json_object_get(&objects[o], (char*)names[k]).number;
+            }
+        }
+    }
+    double cstr_us = get_time_us() - start;
+
+    start = get_time_us();
+    for (int r = 0; r < HOT_ROUNDS; r++) {
+        for (size_t o = 0; o < HOT_OBJECTS; o++) {
+            for (size_t k = 0; k < HOT_KEYS; k++) {
+                sum += json_object_get_key(&objects[o], keys[k]).number;
+            }
+        }
+    }
+    double key_us = get_time_us() - start;
+
+    double ops = (double)HOT_ROUNDS * HOT_OBJECTS * HOT_KEYS;
+    printf("\nHot keys: %d keys x %d objects\n", HOT_KEYS, HOT_OBJECTS);
+    printf("%14s %14s\n", "char* ns", "json_key ns");
+    printf("%14.2f %14.2f\n", cstr_us * 1000.0 / ops, key_us * 1000.0 / ops);
+    if (csv) {
+        fprintf(csv, "\ncstr_get_ns,key_get_ns\n%.2f,%.2f\n", cstr_us * 1000.0 / ops, key_us * 1000.0 / ops);
+    }
+
+    free(objects);
+    pool_destroy(pool);
+}
+
+// NDJSON-style record: STREAM_KEYS fields, same keys in every document
+static char* make_stream_doc(void) {
+    size_t cap = STREAM_KEYS * 48 + 2;
+    char* doc = malloc(cap);
+    size_t pos = 0;
+    doc[pos++] = '{';
+    for (int i = 0; i < STREAM_KEYS; i++) {
+        pos += snprintf(doc + pos, cap - pos, "%s\"event_field_name_%d\": %d", i ? ", " : "", i, i);
+    }
+    doc[pos++] = '}';
+    doc[pos] = '\0';
+    return doc;
+}
+
+static void bench_interning(FILE* csv) {
+    char* doc = make_stream_doc();
+    intern_table_t* table = intern_table_create(0);
+
+    // Query keys as a caller would keep them: canonical pointers or plain copies
+    key_set_t queries = make_keys(STREAM_KEYS, "event_field_name_");
+    const char* canonical[STREAM_KEYS];
+    uint32_t hashes[STREAM_KEYS];
+    for (size_t i = 0; i < STREAM_KEYS; i++) {
+        const char* key = queries.data + queries.offsets[i];
+        hashes[i] = hash_string(key, queries.lengths[i]);
+        canonical[i] = intern_table_add(table, key, queries.lengths[i], hashes[i]);
+    }
+
+    printf("\nDocument stream: %d docs x %d keys\n", STREAM_DOCS, STREAM_KEYS);
+    printf("%10s %14s %14s %14s\n", "mode", "parse us/doc", "pool bytes", "lookup ns");
+    if (csv) {
+        fprintf(csv, "\nmode,parse_us_per_doc,pool_bytes_per_doc,lookup_ns\n");
+    }
+
+    for (int interned = 0; interned <= 1; interned++) {
+        double parse_us = 0.0, lookup_us = 0.0;
+        size_t pool_bytes = 0;
+        volatile size_t found = 0;
+        volatile double sum = 0.0;
+
+        for (int d = 0; d < STREAM_DOCS; d++) {
+            double start = get_time_us();
+            lexer_t lexer = lexer_init(doc);
+            parser_t parser = parser_init(&lexer);
+            parser.intern = interned ? table : NULL;
+            parser.current_token = next_token(&lexer);
+            json_value_t value = parse(&parser);
+            parse_us += get_time_us() - start;
+
+            start = get_time_us();
+            for (size_t i = 0; i < STREAM_KEYS; i++) {
+                const char* key = interned ? canonical[i] : queries.data + queries.offsets[i];
+                found += hash_table_get_hashed(value.object, key, queries.lengths[i], hashes[i]) != NULL;
+            }
+            lookup_us += get_time_us() - start;
+
+            pool_bytes = pool_bytes_used(parser.pool);
+            lexer_free(&lexer);
+            parser_free(&parser);
+        }
+
+        const char* mode = interned ? "interned" : "copied";
+        double lookup_ns = lookup_us * 1000.0 / ((double)STREAM_DOCS * STREAM_KEYS);
+        printf("%10s %14.2f %14zu %14.2f\n", mode, parse_us / STREAM_DOCS, pool_bytes, lookup_ns);
+        if (csv) {
+            fprintf(csv, "%s,%.2f,%zu,%.2f\n", mode, parse_us / STREAM_DOCS, pool_bytes, lookup_ns);
+        }
+    }
+
+    free_keys(&queries);
+    intern_table_destroy(table);
+    free(doc);
+}
+
+typedef struct {
+    intern_table_t* table;
+    const key_set_t* keys;
+    const uint32_t* hashes;
+    size_t found;
+} intern_hits_t;
+
+// intern_table_add() on keys already in the table, as a parser with a
+// warm dictionary calls it for every member
+static void* intern_hits(void* arg) {
+    intern_hits_t* job = arg;
+    size_t found = 0;
+    for (int r = 0; r < INTERN_ROUNDS; r++) {
+        for (size_t i = 0; i < job->keys->count; i++) {
+            found += intern_table_add(job->table, job->keys->data + job->keys->offsets[i], job->keys->lengths[i],
+                                      job->hashes[i]) != NULL;
+        }
+    }
+    job->found = found;
+    return NULL;
+}
+
+static void bench_intern_lookup(FILE* csv) {
+    intern_table_t* table = intern_table_create(0);
+    key_set_t keys = make_keys(STREAM_KEYS, "event_field_name_");
+    uint32_t hashes[STREAM_KEYS];
+    for (size_t i = 0; i < STREAM_KEYS; i++) {
+        hashes[i] = hash_string(keys.data + keys.offsets[i], keys.lengths[i]);
+        intern_table_add(table, keys.data + keys.offsets[i], keys.lengths[i], hashes[i]);
+    }
+
+    printf("\nIntern hits: %d keys\n", STREAM_KEYS);
+    printf("%10s %14s\n", "threads", "ns per hit");
+    if (csv) {
+        fprintf(csv, "\nthreads,intern_hit_ns\n");
+    }
+
+    for (int threads = 1; threads <= INTERN_THREADS; threads *= 2) {
+        intern_hits_t jobs[INTERN_THREADS];
+        pthread_t ids[INTERN_THREADS];
+        double start = get_time_us();
+        for (int t = 0; t < threads; t++) {
+            jobs[t] = (intern_hits_t){ table, &keys, hashes, 0 };
+            pthread_create(&ids[t], NULL, intern_hits, &jobs[t]);
+        }
+        for (int t = 0; t < threads; t++) {
+            pthread_join(ids[t], NULL);
+        }
+        // Wall time over all threads' hits: flat if lookups scale across cores
+        double hit_ns = (get_time_us() - start) * 1000.0 / ((double)threads * INTERN_ROUNDS * STREAM_KEYS);
+        printf("%10d %14.2f\n", threads, hit_ns);
+        if (csv) {
+            fprintf(csv, "%d,%.2f\n", threads, hit_ns);
+        }
+    }
+
+    free_keys(&keys);
+    intern_table_destroy(table);
+}
+
+int main(int argc, char** argv) {
+    const char* output = argc > 1 ? argv[1] : NULL;
+    FILE* csv = output ? fopen(output, "w") : NULL;
+    if (csv) {
+        fprintf(csv, "keys,insert_ns,lookup_hit_ns,lookup_miss_ns,iterate_ns,pool_bytes\n");
+    }
+
+    printf("Hash Table Benchmark\n");
+    printf("====================\n\n");
+    printf("%10s %12s %12s %12s %12s %12s\n", "keys", "insert ns", "hit ns", "miss ns", "iterate ns", "pool bytes");
+
+    size_t sizes[] = {8, 64, 512, 4096, 32768, 262144};
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        size_t count = sizes[s];
+        size_t rounds = MIN_TOTAL_OPS / count;
+        if (rounds < 3) rounds = 3;
+
+        key_set_t keys = make_keys(count, "key_");
+        key_set_t misses = make_keys(count, "missing_");
+
+        double insert_us = 0.0, hit_us = 0.0, miss_us = 0.0, iterate_us = 0.0;
+        size_t pool_bytes = 0;
+        volatile size_t found = 0;
+        volatile double sum = 0.0;
+
+        for (size_t r = 0; r < rounds; r++) {
+            mem_pool_t* pool = pool_create();
+            hash_table_t table;
+            hash_table_init_inplace(&table, 0, pool);
+
+            double start = get_time_us();
+            for (size_t i = 0; i < count; i++) {
+                hash_table_insert(&table, keys.data + keys.offsets[i], keys.lengths[i],
+                                  json_value_number((double)i), pool);
+            }
+            insert_us += get_time_us() - start;
+
+            start = get_time_us();
+            for (size_t i = 0; i < count; i++) {
+                found += hash_table_get(&table, keys.data + keys.offsets[i], keys.lengths[i]) != NULL;
+            }
+            hit_us += get_time_us() - start;
+
+            start = get_time_us();
+            for (size_t i = 0; i < count; i++) {
+                found += hash_table_get(&table, misses.data + misses.offsets[i], misses.lengths[i]) != NULL;
+            }
+            miss_us += get_time_us() - start;
+
+            // Visit every member in order, as a transform would
+            json_value_t object = json_value_init(JSON_OBJECT);
+            object.object = &table;
+            double total = 0.0;
+            start = get_time_us();
+            json_object_iter_t it = json_object_iter(&object);
+            for (hash_entry_t* entry; (entry = json_object_next(&it));) {
+                total += entry->value.number;
+            }
+            iterate_us += get_time_us() - start;
+            sum += total;
+
+            pool_bytes = pool_bytes_used(pool);
+            pool_destroy(pool);
+        }
+
+        double ops = (double)count * rounds;
+        double insert_ns = insert_us * 1000.0 / ops;
+        double hit_ns = hit_us * 1000.0 / ops;
+        double miss_ns = miss_us * 1000.0 / ops;
+        double iterate_ns = iterate_us * 1000.0 / ops;
+
+        printf("%10zu %12.2f %12.2f %12.2f %12.2f %12zu\n", count, insert_ns, hit_ns, miss_ns, iterate_ns, pool_bytes);
+        if (csv) {
+            fprintf(csv, "%zu,%.2f,%.2f,%.2f,%.2f,%zu\n", count, insert_ns, hit_ns, miss_ns, iterate_ns, pool_bytes);
+        }
+
+        free_keys(&keys);
+        free_keys(&misses);
+    }
+
+    bench_adversarial(csv);
+    bench_hot_keys(csv);
+    bench_interning(csv);
+    bench_intern_lookup(csv);
+
+    if (csv) {
+        fclose(csv);
+        printf("\nResults written to %s\n", output);
+    }
+    return 0;
+}
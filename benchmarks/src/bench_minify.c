@@ -0,0 +1,138 @@
+#include <stdio.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/time.h>
+
+#include "../../include/parser.h"
+#include "../../include/serializer.h"
+#include "../../include/minify.h"
+
+// Minify benchmark: for every file in the data directory, time
+// json_minify() into a reused buffer, a compact and a pretty
+// json_reformat() into a discarding sink, and the parse -> serialize
+// path they replace. Throughput is in input MB/s.
+
+#define MIN_ITERATIONS 20
+#define MIN_BYTES (64 * 1024 * 1024)
+
+static double get_time_us(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000.0 + tv.tv_usec;
+}
+
+static char* read_file(const char* filepath, size_t* size) {
+    FILE* file = fopen(filepath, "rb");
+    if (!file) {
+        fprintf(stderr, "Error: Cannot open file %s\n", filepath);
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    *size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char* content = malloc(*size + 1);
+    if (content) {
+        *size = fread(content, 1, *size, file);
+        content[*size] = '\0';
+    }
+    fclose(file);
+    return content;
+}
+
+static bool discard(void* ctx, const struct iovec* iov, int iovcnt) {
+    size_t* total = ctx;
+    for (int i = 0; i < iovcnt; i++) {
+        *total += iov[i].iov_len;
+    }
+    return true;
+}
+
+// Time json_reformat() with the given indent; 0 if the file is rejected
+static double time_reformat(const char* text, size_t size, size_t iterations, int indent) {
+    json_writer_config_t config = {.indent = indent};
+    size_t total = 0;
+    double start = get_time_us();
+    for (size_t i = 0; i < iterations; i++) {
+        json_writer_t writer = json_writer_init_fn(discard, &total, &config);
+        bool ok = json_reformat(text, size, &writer) && json_writer_finish(&writer);
+        json_writer_free(&writer);
+        if (!ok) return 0;
+    }
+    return size / ((get_time_us() - start) / iterations);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <data_directory> [output.csv]\n", argv[0]);
+        return 1;
+    }
+    const char* data_dir = argv[1];
+    FILE* csv = argc > 2 ? fopen(argv[2], "w") : NULL;
+    if (csv) {
+        fprintf(csv, "file,input_bytes,output_bytes,minify_mbps,reformat_mbps,pretty_mbps,parse_serialize_mbps\n");
+    }
+
+    DIR* dir = opendir(data_dir);
+    if (!dir) {
+        fprintf(stderr, "Error: Cannot open directory %s\n", data_dir);
+        return 1;
+    }
+
+    printf("Minify Benchmark\n");
+    printf("================\n\n");
+    printf("%-24s %10s %10s %12s %12s %12s %12s\n", "file", "in bytes", "out bytes", "minify MB/s",
+           "compact MB/s", "pretty MB/s", "parse MB/s");
+
+    json_buffer_t buffer = json_buffer_init(0);
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        size_t name_len = strlen(entry->d_name);
+        if (name_len < 5 || strcmp(entry->d_name + name_len - 5, ".json") != 0) {
+            continue;
+        }
+        char filepath[1024];
+        snprintf(filepath, sizeof(filepath), "%s/%s", data_dir, entry->d_name);
+        size_t size;
+        char* text = read_file(filepath, &size);
+        if (!text) continue;
+        char* out = malloc(size + 1);
+        size_t iterations = MIN_BYTES / (size + 1);
+        if (iterations < MIN_ITERATIONS) iterations = MIN_ITERATIONS;
+
+        size_t out_len = 0;
+        double start = get_time_us();
+        for (size_t i = 0; i < iterations; i++) {
+            out_len = json_minify(text, size, out);
+        }
+        double minify_mbps = size / ((get_time_us() - start) / iterations);
+        double compact_mbps = time_reformat(text, size, iterations, 0);
+        double pretty_mbps = time_reformat(text, size, iterations, 2);
+
+        // The DOM path minify replaces
+        start = get_time_us();
+        for (size_t i = 0; i < iterations; i++) {
+            lexer_t lexer = lexer_init_view(text, size);
+            parser_t parser = parser_init(&lexer);
+            parser.current_token = next_token(&lexer);
+            json_value_t value = parse(&parser);
+            buffer.len = 0;
+            json_serialize_into(&buffer, &value);
+            parser_free(&parser);
+            lexer_free(&lexer);
+        }
+        double parse_mbps = size / ((get_time_us() - start) / iterations);
+
+        printf("%-24s %10zu %10zu %12.1f %12.1f %12.1f %12.1f\n", entry->d_name, size, out_len,
+               minify_mbps, compact_mbps, pretty_mbps, parse_mbps);
+        if (csv) {
+            fprintf(csv, "%s,%zu,%zu,%.2f,%.2f,%.2f,%.2f\n", entry->d_name, size, out_len,
+                    minify_mbps, compact_mbps, pretty_mbps, parse_mbps);
+        }
+        free(out);
+        free(text);
+    }
+    closedir(dir);
+    json_buffer_free(&buffer);
+    if (csv) fclose(csv);
+    return 0;
+}
@@ -4,6 +4,7 @@
 #include <sys/time.h>
 #include <dirent.h>
 #include <sys/stat.h>
+#include <sys/resource.h>
 
 // Define BENCHMARK_MEMORY_TRACKING before including mem_track.h
 // This will redirect all malloc/free calls to our tracking functions
@@ -22,6 +23,7 @@ typedef struct {
     double throughput_mbps;
     size_t file_size;
     mem_stats_t mem_stats;
+    pool_usage_t pool_usage;
 } benchmark_result_t;
 
 // Get current time in microseconds
@@ -129,10 +131,87 @@ benchmark_result_t benchmark_file(const char* filepath) {
     result.parse_time_ms = (total_time / ITERATIONS) / 1000.0;
     result.throughput_mbps = (file_size / (1024.0 * 1024.0)) / (result.parse_time_ms / 1000.0);
 
+    // One untimed parse with accounting on to break the pool down by category
+    pool_config_t config = pool_config_for_input(file_size);
+    config.flags |= POOL_ACCOUNTING;
+    lexer_t lexer = lexer_init(json_content);
+    parser_t parser = parser_init_ex(&lexer, &config);
+    parser.current_token = next_token(&lexer);
+    parse(&parser);
+    pool_usage(parser.pool, &result.pool_usage);
+    lexer_free(&lexer);
+    parser_free(&parser);
+
     free(json_content);
     return result;
 }
 
+typedef struct {
+    const char* name;
+    unsigned flags;
+} pool_mode_t;
+
+static const pool_mode_t POOL_MODES[] = {
+    {"malloc", 0},
+    {"mmap", POOL_MMAP},
+    {"mmap+prefault", POOL_MMAP | POOL_PREFAULT},
+    {"hugepages", POOL_HUGEPAGES},
+    {"hugepages+prefault", POOL_HUGEPAGES | POOL_PREFAULT},
+};
+
+static long minor_faults(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_minflt;
+}
+
+// Parse time and minor page faults per parse for each pool backing. Only
+// documents whose first pool block is large enough to be mapped differ.
+void benchmark_page_faults(const char* filepath, const char* name, FILE* fault_file) {
+    size_t file_size;
+    char* json_content = read_file(filepath, &file_size);
+    if (!json_content) return;
+
+    pool_config_t sized = pool_config_for_input(file_size);
+    if (sized.first_block_size < POOL_MMAP_MIN_BLOCK) {
+        free(json_content);
+        return;
+    }
+
+    printf("Page faults: %s\n", name);
+    for (size_t m = 0; m < sizeof(POOL_MODES) / sizeof(POOL_MODES[0]); m++) {
+        pool_config_t config = sized;
+        config.flags = POOL_MODES[m].flags;
+
+        double total_time = 0.0;
+        long faults = 0;
+        for (int i = 0; i < ITERATIONS; i++) {
+            long faults_before = minor_faults();
+            double start = get_time_us();
+
+            lexer_t lexer = lexer_init(json_content);
+            parser_t parser = parser_init_ex(&lexer, &config);
+            parser.current_token = next_token(&lexer);
+            parse(&parser);
+
+            total_time += get_time_us() - start;
+            faults += minor_faults() - faults_before;
+            lexer_free(&lexer);
+            parser_free(&parser);
+        }
+
+        double parse_ms = total_time / ITERATIONS / 1000.0;
+        double faults_per_parse = (double)faults / ITERATIONS;
+        printf("  %-20s %8.3f ms %10.0f faults\n", POOL_MODES[m].name, parse_ms, faults_per_parse);
+        if (fault_file) {
+            fprintf(fault_file, "%s,%s,%.3f,%.0f\n", name, POOL_MODES[m].name, parse_ms, faults_per_parse);
+        }
+    }
+    printf("\n");
+
+    free(json_content);
+}
+
 // Get just the filename from path
 const char* get_basename(const char* path) {
     const char* last_slash = strrchr(path, '/');
@@ -141,13 +220,14 @@ const char* get_basename(const char* path) {
 
 int main(int argc, char** argv) {
     if (argc < 2) {
-        fprintf(stderr, "Usage: %s <data_directory> [output_perf.csv] [output_mem.csv]\n", argv[0]);
+        fprintf(stderr, "Usage: %s <data_directory> [output_perf.csv] [output_mem.csv] [output_faults.csv]\n", argv[0]);
         return 1;
     }
 
     const char* data_dir = argv[1];
     const char* output_perf = argc > 2 ? argv[2] : "performance.csv";
     const char* output_mem = argc > 3 ? argv[3] : "memory.csv";
+    const char* output_faults = argc > 4 ? argv[4] : NULL;
 
     // Open output files
     FILE* perf_file = fopen(output_perf, "w");
@@ -160,10 +240,17 @@ int main(int argc, char** argv) {
 
     // Write CSV headers
     fprintf(perf_file, "file,size_bytes,parse_time_ms,throughput_mbps\n");
-    fprintf(mem_file, "file,malloc_count,free_count,realloc_count,calloc_count,total_allocated,total_freed,peak_usage,pool_allocated,pool_used,rss_start,rss_end,rss_delta,rss_peak,leaked\n");
+    FILE* fault_file = output_faults ? fopen(output_faults, "w") : NULL;
+    if (fault_file) {
+        fprintf(fault_file, "file,mode,parse_time_ms,minor_faults\n");
+    }
+    fprintf(mem_file, "file,malloc_count,free_count,realloc_count,calloc_count,total_allocated,total_freed,peak_usage,pool_allocated,pool_used,rss_start,rss_end,rss_delta,rss_peak,leaked,"
+                      "pool_strings,pool_keys,pool_arrays,pool_hash,pool_other,"
+                      "abandoned_arrays,abandoned_hash,pool_padding,pool_unused\n");
 
     printf("JSON Parser Benchmark\n");
-    printf("====================\n\n");
+    printf("====================\n");
+    printf("Container alignment: %d bytes\n\n", JSON_CONTAINER_ALIGN);
 
     // Read directory and benchmark each JSON file
     DIR* dir = opendir(data_dir);
@@ -205,6 +292,18 @@ int main(int argc, char** argv) {
         printf("  Pool: allocated=%zu, used=%zu bytes\n",
                result.mem_stats.pool_allocated,
                result.mem_stats.pool_used);
+        const pool_usage_t* usage = &result.pool_usage;
+        printf("  Pool by category: strings=%zu, keys=%zu, arrays=%zu, hash=%zu, other=%zu bytes\n",
+               usage->live[POOL_CAT_STRING],
+               usage->live[POOL_CAT_KEY],
+               usage->live[POOL_CAT_ARRAY],
+               usage->live[POOL_CAT_HASH],
+               usage->live[POOL_CAT_OTHER]);
+        printf("  Pool waste: abandoned arrays=%zu, abandoned hash=%zu, padding=%zu, unused=%zu bytes\n",
+               usage->abandoned[POOL_CAT_ARRAY],
+               usage->abandoned[POOL_CAT_HASH],
+               usage->padding,
+               usage->unused);
         printf("  RSS: %zu → %zu bytes (Δ%+zd, peak %zu)\n",
                result.mem_stats.rss_start,
                result.mem_stats.rss_end,
@@ -225,7 +324,8 @@ int main(int argc, char** argv) {
                 result.throughput_mbps);
 
         size_t rss_delta = result.mem_stats.rss_end - result.mem_stats.rss_start;
-        fprintf(mem_file, "%s,%zu,%zu,%zu,%zu,%zu,%zu,%zu,%zu,%zu,%zu,%zu,%zu,%zu,%zu\n",
+        fprintf(mem_file, "%s,%zu,%zu,%zu,%zu,%zu,%zu,%zu,%zu,%zu,%zu,%zu,%zu,%zu,%zu,"
+                          "%zu,%zu,%zu,%zu,%zu,%zu,%zu,%zu,%zu\n",
                 entry->d_name,
                 result.mem_stats.malloc_count,
                 result.mem_stats.free_count,
@@ -240,7 +340,18 @@ int main(int argc, char** argv) {
                 result.mem_stats.rss_end,
                 rss_delta,
                 result.mem_stats.rss_peak,
-                leaked);
+                leaked,
+                usage->live[POOL_CAT_STRING],
+                usage->live[POOL_CAT_KEY],
+                usage->live[POOL_CAT_ARRAY],
+                usage->live[POOL_CAT_HASH],
+                usage->live[POOL_CAT_OTHER],
+                usage->abandoned[POOL_CAT_ARRAY],
+                usage->abandoned[POOL_CAT_HASH],
+                usage->padding,
+                usage->unused);
+
+        benchmark_page_faults(filepath, entry->d_name, fault_file);
 
         free(result.filename);
         file_count++;
@@ -249,11 +360,22 @@ int main(int argc, char** argv) {
     closedir(dir);
     fclose(perf_file);
     fclose(mem_file);
+    if (fault_file) {
+        fclose(fault_file);
+    }
+
+    pool_cache_stats_t cache;
+    pool_cache_stats(&cache);
+    printf("Pool block cache: %zu thread hits, %zu shared hits, %zu misses, %zu evicted\n\n",
+           cache.thread_hits, cache.shared_hits, cache.misses, cache.evicted);
 
     printf("Benchmark complete! Processed %d files.\n", file_count);
     printf("Results written to:\n");
     printf("  - %s\n", output_perf);
     printf("  - %s\n", output_mem);
+    if (output_faults) {
+        printf("  - %s\n", output_faults);
+    }
 
     return 0;
 }
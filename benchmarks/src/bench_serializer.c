@@ -0,0 +1,223 @@
+#include <stdio.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "../../include/parser.h"
+#include "../../include/serializer.h"
+
+// Serializer benchmark: for every file in the data directory, time
+// serializing the parsed document into a reused buffer, parallel
+// serialization with one thread per CPU, canonical (RFC 8785) output with
+// sorted keys, spliced serialization after editing one leaf (unchanged
+// subtrees copied from the input), and a full parse -> serialize round
+// trip. The output is parsed once more and
+// serialized again to check it is stable, and the parallel text is
+// compared with the sequential one.
+
+#define MIN_ITERATIONS 20
+#define MIN_BYTES (64 * 1024 * 1024)
+
+static double get_time_us(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000.0 + tv.tv_usec;
+}
+
+static char* read_file(const char* filepath, size_t* size) {
+    FILE* file = fopen(filepath, "rb");
+    if (!file) {
+        fprintf(stderr, "Error: Cannot open file %s\n", filepath);
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    *size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char* content = malloc(*size + 1);
+    if (content) {
+        *size = fread(content, 1, *size, file);
+        content[*size] = '\0';
+    }
+    fclose(file);
+    return content;
+}
+
+typedef struct {
+    lexer_t lexer;
+    parser_t parser;
+    json_value_t value;
+} parsed_t;
+
+static void parse_text(parsed_t* doc, const char* text, size_t len) {
+    doc->lexer = lexer_init_view(text, len);
+    doc->parser = parser_init(&doc->lexer);
+    doc->parser.current_token = next_token(&doc->lexer);
+    doc->value = parse(&doc->parser);
+}
+
+static void parsed_free(parsed_t* doc) {
+    parser_free(&doc->parser);
+    lexer_free(&doc->lexer);
+}
+
+// Follow the first member or element down to a scalar and change it,
+// marking every container on the way as edited
+static void edit_first_leaf(json_value_t* value) {
+    while (value && (value->type == JSON_ARRAY || value->type == JSON_OBJECT)) {
+        if (value->type == JSON_ARRAY) {
+            value = json_array_edit(value, 0);
+            continue;
+        }
+        json_object_iter_t it = json_object_iter(value);
+        hash_entry_t* first = json_object_next(&it);
+        value = first ? json_object_edit(value, hash_entry_key(first).str) : NULL;
+    }
+    if (value) *value = json_value_number(42);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <data_directory> [output.csv]\n", argv[0]);
+        return 1;
+    }
+    const char* data_dir = argv[1];
+    FILE* csv = argc > 2 ? fopen(argv[2], "w") : NULL;
+    if (csv) {
+        fprintf(csv, "file,input_bytes,output_bytes,serialize_mbps,parallel_mbps,canonical_mbps,splice_mbps,round_trip_mbps,stable\n");
+    }
+
+    DIR* dir = opendir(data_dir);
+    if (!dir) {
+        fprintf(stderr, "Error: Cannot open directory %s\n", data_dir);
+        return 1;
+    }
+
+    printf("Serializer Benchmark\n");
+    printf("====================\n\n");
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    printf("Parallel serialization: %ld threads\n\n", cpus);
+    printf("%-24s %10s %10s %14s %14s %14s %14s %14s %8s\n", "file", "in bytes", "out bytes", "serialize MB/s",
+           "parallel MB/s", "canonical MB/s", "splice MB/s", "round trip MB/s", "stable");
+
+    json_buffer_t buffer = json_buffer_init(0);
+    json_buffer_t check = json_buffer_init(0);
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        size_t name_len = strlen(entry->d_name);
+        if (name_len < 5 || strcmp(entry->d_name + name_len - 5, ".json") != 0) {
+            continue;
+        }
+        char filepath[1024];
+        snprintf(filepath, sizeof(filepath), "%s/%s", data_dir, entry->d_name);
+        size_t size;
+        char* text = read_file(filepath, &size);
+        if (!text) continue;
+
+        parsed_t doc;
+        parse_text(&doc, text, size);
+        if (doc.parser.has_error) {
+            fprintf(stderr, "%s: %s\n", entry->d_name, doc.parser.error_message);
+            parsed_free(&doc);
+            free(text);
+            continue;
+        }
+
+        buffer.len = 0;
+        json_serialize_into(&buffer, &doc.value);
+        size_t out_len = buffer.len;
+        size_t iterations = MIN_BYTES / (size + 1);
+        if (iterations < MIN_ITERATIONS) iterations = MIN_ITERATIONS;
+
+        // Serialize only, into the same buffer each time
+        double start = get_time_us();
+        for (size_t i = 0; i < iterations; i++) {
+            buffer.len = 0;
+            json_serialize_into(&buffer, &doc.value);
+        }
+        double serialize_us = (get_time_us() - start) / iterations;
+
+        // Parallel, split at the default threshold
+        bool same = true;
+        start = get_time_us();
+        for (size_t i = 0; i < iterations; i++) {
+            size_t parallel_len;
+            char* parallel = json_serialize_parallel(&doc.value, &parallel_len, NULL);
+            if (i == 0) {
+                same = parallel && parallel_len == out_len && memcmp(parallel, buffer.data, out_len) == 0;
+            }
+            free(parallel);
+        }
+        double parallel_us = (get_time_us() - start) / iterations;
+
+        // Canonical, into a reused buffer
+        size_t canonical_len = 0;
+        start = get_time_us();
+        for (size_t i = 0; i < iterations; i++) {
+            check.len = 0;
+            json_serialize_canonical_into(&check, &doc.value);
+            canonical_len = check.len;
+        }
+        double canonical_us = (get_time_us() - start) / iterations;
+        parsed_free(&doc);
+
+        // Spliced, after editing one leaf of a document parsed with spans
+        json_spans_t spans = json_spans_init();
+        parsed_t edited;
+        edited.lexer = lexer_init_view(text, size);
+        edited.parser = parser_init(&edited.lexer);
+        edited.parser.spans = &spans;
+        edited.parser.current_token = next_token(&edited.lexer);
+        edited.value = parse(&edited.parser);
+        edit_first_leaf(&edited.value);
+        size_t splice_len = 0;
+        start = get_time_us();
+        for (size_t i = 0; i < iterations; i++) {
+            check.len = 0;
+            json_serialize_spliced_into(&check, &edited.value, &spans);
+            splice_len = check.len;
+        }
+        double splice_us = (get_time_us() - start) / iterations;
+        parsed_free(&edited);
+        json_spans_free(&spans);
+
+        // Parse and serialize
+        start = get_time_us();
+        for (size_t i = 0; i < iterations; i++) {
+            parsed_t round;
+            parse_text(&round, text, size);
+            buffer.len = 0;
+            json_serialize_into(&buffer, &round.value);
+            parsed_free(&round);
+        }
+        double round_us = (get_time_us() - start) / iterations;
+
+        // Output parses back and serializes to the same text
+        parsed_t again;
+        char* output = strndup(buffer.data, buffer.len);
+        parse_text(&again, output, buffer.len);
+        check.len = 0;
+        bool stable = same && !again.parser.has_error && json_serialize_into(&check, &again.value) &&
+                      check.len == out_len;
+        parsed_free(&again);
+        free(output);
+
+        double serialize_mbps = out_len / serialize_us;
+        double parallel_mbps = out_len / parallel_us;
+        double canonical_mbps = canonical_len / canonical_us;
+        double splice_mbps = splice_len / splice_us;
+        double round_mbps = size / round_us;
+        printf("%-24s %10zu %10zu %14.1f %14.1f %14.1f %14.1f %14.1f %8s\n", entry->d_name, size, out_len,
+               serialize_mbps, parallel_mbps, canonical_mbps, splice_mbps, round_mbps, stable ? "yes" : "NO");
+        if (csv) {
+            fprintf(csv, "%s,%zu,%zu,%.2f,%.2f,%.2f,%.2f,%.2f,%d\n", entry->d_name, size, out_len,
+                    serialize_mbps, parallel_mbps, canonical_mbps, splice_mbps, round_mbps, stable);
+        }
+        free(text);
+    }
+    closedir(dir);
+    json_buffer_free(&buffer);
+    json_buffer_free(&check);
+    if (csv) fclose(csv);
+    return 0;
+}
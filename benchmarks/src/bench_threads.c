@@ -0,0 +1,125 @@
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include "../../include/parser.h"
+#include "../../include/mem_pool.h"
+
+// Multi-threaded small-document parsing: every thread parses the same
+// request-sized document in a loop, once creating and destroying a pool
+// per parse and once borrowing a pool_thread_attach() pool. Each thread
+// does a fixed amount of work, so linear scaling keeps docs/s per thread
+// flat as threads are added.
+
+#define DOCS_PER_THREAD 200000
+#define MAX_THREADS 64
+
+static const char *DOC =
+    "{\"id\": 48213, \"user\": {\"name\": \"alice\", \"roles\": [\"admin\", \"dev\"]}, "
+    "\"active\": true, \"score\": 97.5, \"tags\": [\"a\", \"b\", \"c\"], \"parent\": null}";
+
+static double get_time_us(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000.0 + tv.tv_usec;
+}
+
+typedef struct {
+    bool thread_pool;
+    size_t doc_len;
+    pthread_barrier_t* start;
+    size_t parsed;
+} worker_t;
+
+static void* worker_run(void* arg) {
+    worker_t* worker = arg;
+    if (worker->thread_pool) {
+        pool_thread_attach(NULL);
+    }
+    pthread_barrier_wait(worker->start);
+
+    size_t parsed = 0;
+    for (int i = 0; i < DOCS_PER_THREAD; i++) {
+        lexer_t lexer = lexer_init_view(DOC, worker->doc_len);
+        parser_t parser = parser_init(&lexer);
+        parser.current_token = next_token(&lexer);
+        json_value_t value = parse(&parser);
+        parsed += !parser.has_error && value.type == JSON_OBJECT;
+        parser_free(&parser);
+        lexer_free(&lexer);
+    }
+    worker->parsed = parsed;
+
+    if (worker->thread_pool) {
+        pool_thread_detach();
+    }
+    return NULL;
+}
+
+// Docs per second across all threads
+static double run(int threads, bool thread_pool) {
+    pthread_barrier_t start;
+    pthread_barrier_init(&start, NULL, threads + 1);
+    worker_t workers[MAX_THREADS];
+    pthread_t ids[MAX_THREADS];
+    for (int t = 0; t < threads; t++) {
+        workers[t] = (worker_t){ .thread_pool = thread_pool, .doc_len = strlen(DOC), .start = &start };
+        pthread_create(&ids[t], NULL, worker_run, &workers[t]);
+    }
+
+    pthread_barrier_wait(&start);
+    double begin = get_time_us();
+    size_t parsed = 0;
+    for (int t = 0; t < threads; t++) {
+        pthread_join(ids[t], NULL);
+        parsed += workers[t].parsed;
+    }
+    double elapsed = get_time_us() - begin;
+    pthread_barrier_destroy(&start);
+
+    if (parsed != (size_t)threads * DOCS_PER_THREAD) {
+        fprintf(stderr, "parse failed: %zu of %zu documents\n", parsed, (size_t)threads * DOCS_PER_THREAD);
+    }
+    return parsed / (elapsed / 1000000.0);
+}
+
+int main(int argc, char** argv) {
+    const char* output = argc > 1 ? argv[1] : NULL;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int max_threads = argc > 2 ? atoi(argv[2]) : (int)(cpus > 0 ? cpus : 1);
+    if (max_threads < 1) max_threads = 1;
+    if (max_threads > MAX_THREADS) max_threads = MAX_THREADS;
+
+    FILE* csv = output ? fopen(output, "w") : NULL;
+    if (csv) {
+        fprintf(csv, "threads,per_doc_pool_docs_per_s,thread_pool_docs_per_s\n");
+    }
+
+    printf("Thread Scaling Benchmark\n");
+    printf("========================\n\n");
+    printf("%zu-byte document, %d docs per thread, %ld CPUs online\n\n", strlen(DOC), DOCS_PER_THREAD, cpus);
+    printf("%8s %16s %16s %16s %10s\n", "threads", "per-doc pool/s", "thread pool/s", "per thread/s", "scaling");
+
+    double base = 0.0;
+    for (int threads = 1; threads <= max_threads; threads = threads < max_threads && threads * 2 > max_threads ? max_threads : threads * 2) {
+        double per_doc = run(threads, false);
+        double attached = run(threads, true);
+        if (threads == 1) base = attached;
+
+        printf("%8d %16.0f %16.0f %16.0f %9.2fx\n", threads, per_doc, attached, attached / threads, attached / base);
+        if (csv) {
+            fprintf(csv, "%d,%.0f,%.0f\n", threads, per_doc, attached);
+        }
+        if (threads == max_threads) break;
+    }
+
+    pool_cache_stats_t cache;
+    pool_cache_stats(&cache);
+    printf("\nBlock cache: %zu misses, %zu thread hits, %zu shared hits\n",
+           cache.misses, cache.thread_hits, cache.shared_hits);
+
+    if (csv) fclose(csv);
+    return 0;
+}
@@ -0,0 +1,105 @@
+#ifndef BUILDER_H
+#define BUILDER_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "json.h"
+#include "mem_pool.h"
+
+/**
+ * Builds a document in one pool by streaming calls, for generating
+ * responses without the heap-backed json_value_*() constructors.
+ *
+ *   json_builder_t b = json_builder_init(NULL);
+ *   json_builder_begin_object(&b);
+ *   json_builder_key(&b, "id", 2);
+ *   json_builder_number(&b, 42);
+ *   json_builder_key(&b, "tags", 4);
+ *   json_builder_begin_array(&b);
+ *   json_builder_string(&b, "a", 1);
+ *   json_builder_end(&b);
+ *   json_builder_end(&b);
+ *   json_value_t doc = json_builder_finish(&b);
+ *   ...
+ *   json_builder_free(&b);
+ *
+ * Like the parser, the values of open containers wait on a scratch stack,
+ * and each container is allocated at its exact size when it is closed, so
+ * arrays and tables never grow. Strings are copied into the pool as they
+ * are added; keys are copied next to their table when the object closes.
+ *
+ * Keys and strings are plain text: every backslash and quote in them is
+ * literal. They are stored escaped, as the parser stores strings, so the
+ * serializer writes them back out unchanged and json_get_str() returns the
+ * escaped form.
+ *
+ * Errors are sticky: a misplaced call or a failed allocation sets has_error
+ * and every later call is ignored. The document lives in the builder's pool
+ * and is freed by json_builder_free() when the builder owns it.
+ */
+
+typedef struct {
+  size_t key_offset;  // into the key scratch buffer
+  uint32_t key_len;
+  uint32_t hash;
+  json_value_t value;
+} builder_item_t;
+
+typedef struct {
+  bool is_object;
+  size_t items_base;  // first item of this container
+  size_t keys_base;   // first key byte of this container
+} builder_frame_t;
+
+typedef struct {
+  mem_pool_t *pool;
+  bool owns_pool;
+
+  builder_frame_t *frames;  // open containers, innermost last
+  size_t depth;
+  size_t frames_cap;
+
+  builder_item_t *items;    // values of every open container
+  size_t items_len;
+  size_t items_cap;
+
+  char *keys;               // key bytes of every open object
+  size_t keys_len;
+  size_t keys_cap;
+
+  bool has_key;             // a key is waiting for its value
+  json_value_t root;
+  bool has_root;
+
+  bool has_error;
+  char error_message[128];
+} json_builder_t;
+
+// Builder with its own pool; NULL config sizes it like pool_create()
+json_builder_t json_builder_init(const pool_config_t *config);
+// Builder that allocates the document in a caller-owned pool
+json_builder_t json_builder_init_with_pool(mem_pool_t *pool);
+void json_builder_free(json_builder_t *);
+
+void json_builder_begin_object(json_builder_t *);
+void json_builder_begin_array(json_builder_t *);
+// Close the innermost open container
+void json_builder_end(json_builder_t *);
+
+// Key of the next value, as plain text; only valid directly inside an
+// object. A repeated key keeps the last value. Keys escaping to more than
+// HASH_KEY_LEN_MAX bytes are an error.
+void json_builder_key(json_builder_t *, const char *key, size_t len);
+
+// String value, as plain text; more than JSON_STRING_LEN_MAX bytes
+// escaped is an error
+void json_builder_string(json_builder_t *, const char *str, size_t len);
+void json_builder_number(json_builder_t *, double number);
+void json_builder_bool(json_builder_t *, bool boolean);
+void json_builder_null(json_builder_t *);
+
+// The finished document, or a JSON_NULL value if containers are still open,
+// nothing was added, or an error occurred
+json_value_t json_builder_finish(json_builder_t *);
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef DTOA_H
+#define DTOA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Shortest round-trip double formatting (Grisu2).
+ *
+ * Digits come from Loitsch's Grisu2: the value and its rounding boundaries
+ * are scaled by a cached power of ten into 64-bit fixed point, and digits
+ * are generated until the result lies strictly inside the boundaries. The
+ * output always reads back as the same double and is the shortest such
+ * text for all but a tiny fraction of inputs, where it is one digit
+ * longer. Whole numbers up to 2^53 skip Grisu and are formatted as
+ * integers directly.
+ *
+ * Layout follows ECMAScript Number::toString: plain decimals for decimal
+ * exponents from -6 to 20 (0.000001, 123.45, 100000000000000000000),
+ * otherwise d.ddde+XX / d.ddde-XX. NaN and infinities, which JSON cannot
+ * hold, are written as null, and -0 as 0.
+ */
+
+// Enough for any output, including the sign
+#define JSON_DOUBLE_MAX_LEN 32
+
+// Write value into buf (at least JSON_DOUBLE_MAX_LEN bytes, no NUL added);
+// returns the length
+size_t json_format_double(char *buf, double value);
+
+// Same layout, always with the shortest digits and, among those, the
+// closest to value, as ECMAScript and RFC 8785 require. Uses Grisu3, which
+// proves its digits or gives up (about 0.5% of doubles); those values are
+// formatted exactly through printf/strtod instead, at about ten times the
+// cost.
+size_t json_format_double_exact(char *buf, double value);
+
+// Digits of value backwards from end, two at a time; returns the first digit
+char *json_format_uint(char *end, uint64_t value);
+
+#endif
@@ -0,0 +1,159 @@
+#ifndef ESCAPE_H
+#define ESCAPE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/**
+ * String escaping shared by the writers (serializer.h, writer.h) and the
+ * builder.
+ *
+ * Strings are held as the parser stores them: the raw body between the
+ * quotes, escape sequences included. Writers copy clean runs in bulk,
+ * pass valid escape sequences through unchanged and escape what would
+ * otherwise be invalid: quotes, control characters and backslashes that do
+ * not start an escape.
+ *
+ * Application text is different: every backslash in it is literal, so
+ * json_escape_text() escapes each special byte on its own. Use it for
+ * strings that did not come from JSON source.
+ *
+ *   while (i < len) {
+ *     size_t run = json_escape_clean_run(s + i, len - i);
+ *     append(s + i, run);
+ *     if ((i += run) == len) break;
+ *     char escaped[JSON_ESCAPE_MAX_LEN];
+ *     size_t used;
+ *     append(escaped, json_escape_special(s + i, len - i, escaped, &used));
+ *     i += used;
+ *   }
+ */
+
+#define JSON_ESCAPE_MAX_LEN 6
+
+#define JSON_SWAR_ONES 0x0101010101010101ULL
+#define JSON_SWAR_HIGHS 0x8080808080808080ULL
+
+// Length of the leading run of s that needs no escaping: no quote,
+// backslash or control character. Scans 16 bytes at a time with SSE2, then
+// 8 at a time.
+static inline size_t json_escape_clean_run(const char *s, size_t len) {
+  size_t i = 0;
+#if defined(__SSE2__)
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i control = _mm_set1_epi8(0x1F);
+  for (; i + 16 <= len; i += 16) {
+    __m128i chunk = _mm_loadu_si128((const __m128i *)(s + i));
+    // chunk <= 0x1F unsigned: max(chunk, 0x1F) == 0x1F
+    __m128i special = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+        _mm_cmpeq_epi8(_mm_max_epu8(chunk, control), control));
+    uint32_t mask = (uint32_t)_mm_movemask_epi8(special);
+    if (mask) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+#endif
+  for (; i + 8 <= len; i += 8) {
+    uint64_t word;
+    memcpy(&word, s + i, sizeof(word));
+    uint64_t q = word ^ (JSON_SWAR_ONES * '"');
+    uint64_t b = word ^ (JSON_SWAR_ONES * '\\');
+    // Zero bytes of q and b, and bytes below 0x20; exact up to the first hit
+    uint64_t special = ((q - JSON_SWAR_ONES) & ~q) | ((b - JSON_SWAR_ONES) & ~b) |
+                       ((word - JSON_SWAR_ONES * 0x20) & ~word);
+    special &= JSON_SWAR_HIGHS;
+    if (special) {
+      return i + (__builtin_ctzll(special) >> 3);
+    }
+  }
+  for (; i < len; i++) {
+    unsigned char ch = (unsigned char)s[i];
+    if (ch == '"' || ch == '\\' || ch < 0x20) break;
+  }
+  return i;
+}
+
+static inline int json_escape_is_hex(char ch) {
+  return (ch >= '0' && ch <= '9') || (ch >= 'a' && ch <= 'f') || (ch >= 'A' && ch <= 'F');
+}
+
+// Length of the escape sequence at s[0] == '\\', or 0 if it is not one
+static inline size_t json_escape_length(const char *s, size_t len) {
+  if (len < 2) return 0;
+  switch (s[1]) {
+    case '"': case '\\': case '/': case 'b': case 'f': case 'n': case 'r': case 't':
+      return 2;
+    case 'u':
+      return len >= 6 && json_escape_is_hex(s[2]) && json_escape_is_hex(s[3]) &&
+             json_escape_is_hex(s[4]) && json_escape_is_hex(s[5]) ? 6 : 0;
+    default:
+      return 0;
+  }
+}
+
+// Escape for a byte of application text that json_escape_clean_run()
+// stopped at: writes it to out and returns its length
+static inline size_t json_escape_text(unsigned char ch, char out[JSON_ESCAPE_MAX_LEN]) {
+  static const char hex[] = "0123456789abcdef";
+  out[0] = '\\';
+  switch (ch) {
+    case '\\': out[1] = '\\'; return 2;
+    case '"':  out[1] = '"'; return 2;
+    case '\b': out[1] = 'b'; return 2;
+    case '\f': out[1] = 'f'; return 2;
+    case '\n': out[1] = 'n'; return 2;
+    case '\r': out[1] = 'r'; return 2;
+    case '\t': out[1] = 't'; return 2;
+    default:
+      out[1] = 'u';
+      out[2] = '0';
+      out[3] = '0';
+      out[4] = hex[ch >> 4];
+      out[5] = hex[ch & 0xF];
+      return 6;
+  }
+}
+
+// Output for the byte json_escape_clean_run() stopped at in a stored
+// string: writes it to out and returns its length. *used is the input
+// consumed, a whole escape sequence or one byte.
+static inline size_t json_escape_special(const char *s, size_t len,
+                                         char out[JSON_ESCAPE_MAX_LEN], size_t *used) {
+  *used = 1;
+  if (s[0] == '\\') {
+    size_t escape = json_escape_length(s, len);
+    if (escape) {
+      memcpy(out, s, escape);
+      *used = escape;
+      return escape;
+    }
+  }
+  return json_escape_text((unsigned char)s[0], out);
+}
+
+// Escape application text into out, or only measure it when out is NULL.
+// Returns the escaped length.
+static inline size_t json_escape_text_into(char *out, const char *s, size_t len) {
+  size_t n = 0;
+  size_t i = 0;
+  while (i < len) {
+    size_t run = json_escape_clean_run(s + i, len - i);
+    if (out) memcpy(out + n, s + i, run);
+    n += run;
+    if ((i += run) == len) break;
+    char escaped[JSON_ESCAPE_MAX_LEN];
+    size_t escaped_len = json_escape_text((unsigned char)s[i++], escaped);
+    if (out) memcpy(out + n, escaped, escaped_len);
+    n += escaped_len;
+  }
+  return n;
+}
+
+#endif
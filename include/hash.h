@@ -0,0 +1,88 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Seeded word-at-a-time string hash (wyhash-style multiply-fold).
+ *
+ * Keys are consumed 8 bytes per step; each step folds the 128-bit product of
+ * the word and the running state, each XORed with its own word of a
+ * per-process random secret. Keying every step matters: with public
+ * constants, a word equal to the constant zeroes the product and resets the
+ * state, so keys sharing a suffix after it collide under every seed.
+ *
+ * The begin/step/finish functions are exposed so callers that already walk
+ * a key word by word can produce the same value as hash_string().
+ */
+
+#define JSON_HASH_P0 0xa0761d6478bd642fULL
+#define JSON_HASH_P1 0xe7037ed1a0b428dbULL
+#define JSON_HASH_P2 0x8ebc6af09c88c6e3ULL
+#define JSON_HASH_P3 0x589965cc75374cc3ULL
+
+// Process-wide secret words, randomized at load time: the initial state,
+// then the keys for each word, the state, and the final mix
+extern uint64_t json_hash_secret[4];
+
+// Derive the secret from a seed, e.g. for reproducible benchmarks. Must be
+// called before any object is built: existing tables are not rehashed.
+void json_hash_seed(uint64_t seed);
+
+static inline uint64_t json_hash_mix(uint64_t a, uint64_t b) {
+  __uint128_t r = (__uint128_t)a * b;
+  return (uint64_t)r ^ (uint64_t)(r >> 64);
+}
+
+static inline uint64_t json_hash_read64(const char *p) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static inline uint64_t json_hash_read32(const char *p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+// Load the last 0-7 bytes of a key without reading past them
+static inline uint64_t json_hash_read_tail(const char *p, size_t n) {
+  if (n >= 4) {
+    return (json_hash_read32(p) << 32) | json_hash_read32(p + n - 4);
+  }
+  if (n > 0) {
+    return ((uint64_t)(uint8_t)p[0] << 16) | ((uint64_t)(uint8_t)p[n >> 1] << 8) |
+           (uint64_t)(uint8_t)p[n - 1];
+  }
+  return 0;
+}
+
+static inline uint64_t json_hash_begin(void) {
+  return json_hash_secret[0];
+}
+
+static inline uint64_t json_hash_step(uint64_t state, uint64_t word) {
+  return json_hash_mix(word ^ json_hash_secret[1], state ^ json_hash_secret[2]);
+}
+
+static inline uint32_t json_hash_finish(uint64_t state, const char *tail, size_t tail_len, size_t len) {
+  state = json_hash_mix(json_hash_read_tail(tail, tail_len) ^ json_hash_secret[1],
+                        state ^ json_hash_secret[3] ^ len);
+  return (uint32_t)(state ^ (state >> 32));
+}
+
+static inline uint32_t hash_string(const char *str, size_t len) {
+  uint64_t state = json_hash_begin();
+  size_t i = 0;
+
+  for (; i + 8 <= len; i += 8) {
+    state = json_hash_step(state, json_hash_read64(str + i));
+  }
+
+  return json_hash_finish(state, str + i, len - i, len);
+}
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef INTERN_H
+#define INTERN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "mem_pool.h"
+#include "hash.h"
+
+/**
+ * Shared key dictionary for parsing many documents with the same keys.
+ *
+ * Each distinct key is stored once, NUL-terminated, in the table's own pool
+ * together with its hash_string() value. A parser given an intern table
+ * stores these canonical pointers in its objects instead of copying every
+ * key into the document pool, and lookups made with a canonical pointer
+ * match by pointer before comparing bytes.
+ *
+ * The table is safe to share between threads. Lookups take no lock: they
+ * probe a slot array published with a release store, and each slot's
+ * string pointer is written last, so a reader sees either an empty slot or
+ * a complete entry. Only a miss takes the mutex to insert. Growing copies
+ * into a new array and keeps the old one for readers still probing it,
+ * until the table is destroyed. Canonical strings never move and stay
+ * valid until intern_table_destroy(), so the table must outlive every
+ * document parsed with it. Hashes come from the process-wide seed; do not
+ * call json_hash_seed() once keys have been interned.
+ */
+
+typedef struct {
+  const char *str;  // canonical copy, NULL for an empty slot; set last
+  uint32_t len;
+  uint32_t hash;
+} intern_entry_t;
+
+typedef struct intern_slots {
+  struct intern_slots *retired;  // smaller array this one replaced
+  size_t capacity;               // power of two
+  intern_entry_t entries[];      // linear probing, at most half full
+} intern_slots_t;
+
+typedef struct {
+  pthread_mutex_t lock;    // serializes inserts
+  intern_slots_t *slots;   // current array, read without the lock
+  size_t size;
+  size_t max_entries;      // 0 for no limit
+  mem_pool_t *pool;        // canonical key bytes
+} intern_table_t;
+
+// Create a table holding at most max_entries keys (0 for no limit). Once it
+// is full, new keys are not interned and callers fall back to copying.
+intern_table_t *intern_table_create(size_t max_entries);
+void intern_table_destroy(intern_table_t *table);
+
+// Canonical pointer for key, or NULL if it has not been interned
+const char *intern_table_lookup(intern_table_t *table, const char *key, size_t len, uint32_t hash);
+
+// Canonical pointer for key, adding it if needed. Returns NULL when the
+// table is full, out of memory, or the key is longer than UINT32_MAX.
+const char *intern_table_add(intern_table_t *table, const char *key, size_t len, uint32_t hash);
+
+size_t intern_table_size(intern_table_t *table);
+
+static inline const char *intern_string(intern_table_t *table, const char *key, size_t len) {
+  return intern_table_add(table, key, len, hash_string(key, len));
+}
+
+#endif
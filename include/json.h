@@ -1,11 +1,16 @@
+#ifndef JSON_H
+#define JSON_H
+
 #ifdef BENCHMARK_MEMORY_TRACKING
 #include "../benchmarks/include/mem_track.h"
 #endif
+#include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include "mem_pool.h"
+#include "hash.h"
 /**
  * In JSON, values must be one of the following data types:
  * - a string
@@ -18,6 +23,14 @@
 
 #define ARRAY_MIN_CAP 4
 
+// Start alignment of pooled container storage: array blocks and hash table
+// entries. Table control bytes follow the entries and bucket index, so they
+// share the alignment once capacity is at least 8. Override at build time, e.g. 64 for
+// cache-line aligned containers or POOL_ALIGNMENT to pack them tightly.
+#ifndef JSON_CONTAINER_ALIGN
+#define JSON_CONTAINER_ALIGN 32
+#endif
+
 typedef enum {
   JSON_NULL,
   JSON_BOOL,
@@ -30,76 +43,299 @@ typedef enum {
 // Forward declarations - only for pointers
 typedef struct json_value json_value_t;
 typedef struct hash_entry hash_entry_t;
-typedef struct hash_bucket hash_bucket_t;
+typedef struct json_array json_array_t;
 
-// hash_bucket only contains pointer to entries, so can be defined now
-struct hash_bucket {
-  hash_entry_t *items;  // pointer is OK with incomplete type
-  size_t len;
-  size_t cap;
-};
+/**
+ * Objects use an open-addressing (Swiss-table style) hash table whose
+ * entries are kept in insertion order.
+ *
+ * A single pool allocation holds the entry array, a bucket index and the
+ * control bytes:
+ *
+ *   entries[growth(capacity)] | index[capacity] | ctrl[capacity + HASH_GROUP_WIDTH]
+ *
+ * Inserts append to the entry array, so walking it visits members in the
+ * order they were added without touching empty buckets. Each of the
+ * `capacity` buckets has a control byte, which is HASH_CTRL_EMPTY,
+ * HASH_CTRL_DELETED, or the low 7 bits of the key hash for a full bucket,
+ * and a 32-bit index of its entry. Probing compares 16 tags at a time
+ * before touching any entry. The first HASH_GROUP_WIDTH control bytes are
+ * mirrored past the end so a group can be loaded at any bucket without
+ * wrapping. Tables sized for a known entry count may be smaller than a
+ * group.
+ *
+ * Deleting an entry leaves a hole (NULL key) in the entry array, except at
+ * its end; holes are squeezed out when the table next resizes.
+ */
+#define HASH_GROUP_WIDTH 16
+#define HASH_TABLE_MIN_CAP 16
+
+#define HASH_CTRL_EMPTY   ((uint8_t)0x80)
+#define HASH_CTRL_DELETED ((uint8_t)0xFE)
+
+// hash_table_t.flags
+#define HASH_TABLE_POOLED        (1u << 0)  // entries and copied keys live in a pool
 
 typedef struct {
-  hash_bucket_t *buckets;
-  size_t capacity;
-  size_t size;
+  hash_entry_t *entries;  // insertion order; index and control bytes follow
+  uint32_t capacity;      // buckets, a power of two
+  uint32_t size;          // number of live entries
+  uint32_t growth_left;   // appends before a resize
+  uint32_t flags;         // HASH_TABLE_* flags
 } hash_table_t;
 
-// Now json_value is complete
+// json_value_t.flags: the string or array block lives in a pool, so it is
+// returned to it by json_value_free_pooled() and never passed to free().
+// Objects carry the equivalent flag on their hash table, which covers the
+// table header too.
+#define JSON_VALUE_POOLED (1u << 0)
+// The container is unedited since parsing and its source text is in a span
+// table (span.h). The json_object_* and json_array_* edits clear it.
+#define JSON_VALUE_SPAN   (1u << 1)
+// The string's bytes are stored in the value itself (see json_value_t)
+#define JSON_VALUE_INLINE (1u << 2)
+
+// Longest string value, and longest object key, stored inline
+#define JSON_INLINE_MAX 12
+#define HASH_KEY_INLINE_MAX 7
+
+// Set in hash_entry_t.key_len for an interned key, which the entry borrows
+// and never frees. Keys are limited to HASH_KEY_LEN_MAX bytes to leave room.
+#define HASH_KEY_BORROWED (1u << 31)
+#define HASH_KEY_LEN_MAX  (HASH_KEY_BORROWED - 1)
+
+// Longest string value; string_len holds 32 bits
+#define JSON_STRING_LEN_MAX UINT32_MAX
+
+/**
+ * A value is 16 bytes: the type and flags, then one 8-byte payload. Arrays
+ * and objects live out of line, so an array of numbers costs 16 bytes per
+ * element and a table entry 32. Read values through the accessors below
+ * rather than the fields where layout may matter to the caller.
+ *
+ * Strings of up to JSON_INLINE_MAX bytes, as copied by the parser, the
+ * builder and json_value_string_n(), are stored in the value itself with
+ * JSON_VALUE_INLINE set: the length goes in inline_len and the bytes run
+ * from inline_chars to the end of the value, over string_len and the
+ * payload. Reading them needs no pointer and they cost the pool nothing.
+ * Longer strings are a pointer and their length. Either way the bytes are
+ * NUL-terminated. Every byte is a named field, so plain struct copies carry
+ * inline strings along.
+ */
 struct json_value {
-  json_type_t type;
+  uint8_t type;         // json_type_t
+  uint8_t flags;        // JSON_VALUE_* flags
+  uint8_t inline_len;   // JSON_VALUE_INLINE strings only
+  char inline_chars;    // first byte of an inline string
+  uint32_t string_len;  // length of an out-of-line string
   union {
     double number;
-    char *string;
+    char *string;          // out-of-line strings only
     bool boolean;
-    struct {
-      json_value_t *items;
-      size_t len;
-      size_t cap;
-    } array;
-    hash_table_t object;
+    json_array_t *array;   // NULL only if allocation failed
+    hash_table_t *object;  // NULL only if allocation failed
   };
 };
 
+// One allocation: the header, then cap items
+struct json_array {
+  size_t len;
+  size_t cap;
+  json_value_t items[];
+};
+
 // Now hash_entry can use json_value_t by value
+// Keys of 1 to HASH_KEY_INLINE_MAX bytes are stored in place of the key
+// pointer, NUL-terminated; read keys through hash_entry_key().
 struct hash_entry {
-  char *key;
-  size_t key_len;
+  union {
+    char *key;  // longer and empty keys; see hash_entry_live()
+    char key_inline[HASH_KEY_INLINE_MAX + 1];
+  };
+  uint32_t key_len;    // with HASH_KEY_BORROWED; see hash_entry_key_len()
+  uint32_t hash;       // hash_string(key), kept so resizes never rehash
   json_value_t value;  // stored by value
 };
 
+_Static_assert(sizeof(json_value_t) == 16, "json_value_t should stay 16 bytes");
+_Static_assert(offsetof(json_value_t, inline_chars) + JSON_INLINE_MAX + 1 == sizeof(json_value_t),
+               "inline strings and their NUL should fill the value");
+_Static_assert(sizeof(hash_entry_t) == 32, "hash_entry_t should stay 32 bytes");
 
-static inline uint32_t hash_string(const char *str, size_t len) {
-  uint32_t hash = 2166136261u;
+static inline size_t json_array_block_size(size_t cap) {
+  return sizeof(json_array_t) + cap * sizeof(json_value_t);
+}
 
-  for (size_t i = 0; i < len; i++) {
-    hash ^= (uint8_t)str[i];
-    hash *= 16777619u;
+// A string and its length. The bytes are NUL-terminated and belong to the
+// value or entry they came from.
+typedef struct {
+  const char *str;
+  size_t len;
+} json_str_t;
+
+// Empty keys stay out of line, so an inline key never reads as NULL
+static inline bool hash_key_fits_inline(size_t key_len) {
+  return key_len - 1 < HASH_KEY_INLINE_MAX;
+}
+
+// Deleted entries have a NULL key and zero length; an inline key of NUL
+// bytes also reads as a NULL pointer, so the length decides
+static inline bool hash_entry_live(const hash_entry_t *entry) {
+  return entry->key || entry->key_len;
+}
+
+static inline uint32_t hash_entry_key_len(const hash_entry_t *entry) {
+  return entry->key_len & HASH_KEY_LEN_MAX;
+}
+
+static inline json_str_t hash_entry_key(const hash_entry_t *entry) {
+  uint32_t len = hash_entry_key_len(entry);
+  json_str_t key = { hash_key_fits_inline(len) ? entry->key_inline : entry->key, len };
+  return key;
+}
+
+// Accessors. Each returns a neutral result (0, false, NULL) for a value of
+// another type.
+static inline json_type_t json_typeof(const json_value_t *value) {
+  return (json_type_t)value->type;
+}
+
+static inline double json_get_number(const json_value_t *value) {
+  return value->type == JSON_NUMBER ? value->number : 0;
+}
+
+static inline bool json_get_bool(const json_value_t *value) {
+  return value->type == JSON_BOOL && value->boolean;
+}
+
+// String bytes and length; { NULL, 0 } for other types. Inline bytes live
+// in the value, so the pointer is only good while the value stays put.
+static inline json_str_t json_get_str(const json_value_t *value) {
+  json_str_t str = { NULL, 0 };
+  if (value->type != JSON_STRING) return str;
+  if (value->flags & JSON_VALUE_INLINE) {
+    str.str = (const char *)value + offsetof(json_value_t, inline_chars);
+    str.len = value->inline_len;
+  } else {
+    str.str = value->string;
+    str.len = value->string_len;
   }
+  return str;
+}
+
+static inline const char *json_get_string(const json_value_t *value) {
+  return json_get_str(value).str;
+}
 
-  return hash;
+static inline size_t json_array_len(const json_value_t *value) {
+  return value->type == JSON_ARRAY && value->array ? value->array->len : 0;
 }
 
+// Element index, or NULL when out of range
+static inline json_value_t *json_array_at(const json_value_t *value, size_t index) {
+  return index < json_array_len(value) ? &value->array->items[index] : NULL;
+}
+
+// Max load factor is 7/8; small tables always keep one empty bucket
+static inline uint32_t hash_capacity_to_growth(uint32_t capacity) {
+  return capacity < 8 ? capacity - 1 : capacity - capacity / 8;
+}
+
+// Bytes before the bucket index, padded so the control bytes share the
+// entries' alignment once capacity is at least 8
+static inline size_t hash_table_entries_size(uint32_t capacity) {
+  size_t size = hash_capacity_to_growth(capacity) * sizeof(hash_entry_t);
+  return (size + JSON_CONTAINER_ALIGN - 1) & ~(size_t)(JSON_CONTAINER_ALIGN - 1);
+}
+
+static inline uint32_t *hash_table_index(const hash_table_t *table) {
+  return (uint32_t *)((char *)table->entries + hash_table_entries_size(table->capacity));
+}
+
+static inline uint8_t *hash_table_ctrl(const hash_table_t *table) {
+  return (uint8_t *)(hash_table_index(table) + table->capacity);
+}
+
+// Entries appended since the last resize, holes included
+static inline uint32_t hash_table_used(const hash_table_t *table) {
+  return table->entries ? hash_capacity_to_growth(table->capacity) - table->growth_left : 0;
+}
+
+static inline bool hash_ctrl_is_full(uint8_t ctrl) {
+  return (ctrl & 0x80) == 0;
+}
+
+
 hash_table_t *hash_table_init(size_t);
+// Storage comes from pool, or from the heap when pool is NULL
 int hash_table_init_inplace(hash_table_t *table, size_t initial_size, mem_pool_t *pool);
 void hash_table_free(hash_table_t *);
 void hash_table_free_entries(hash_table_t *);
 int hash_table_insert(hash_table_t *, const char *, size_t, json_value_t, mem_pool_t *pool);
+// Make room for count entries without further resizing
+int hash_table_reserve(hash_table_t *, size_t count, mem_pool_t *pool);
 int hash_table_delete(hash_table_t *, const char *, size_t);
+// Delete and return the entry's key and value storage to pool
+int hash_table_delete_pooled(hash_table_t *, const char *, size_t, mem_pool_t *pool);
 json_value_t *hash_table_get(hash_table_t *, const char *, size_t);
 
+// Variants taking a precomputed hash_string(key, key_len)
+int hash_table_insert_hashed(hash_table_t *, const char *, size_t, uint32_t hash, json_value_t, mem_pool_t *pool);
+json_value_t *hash_table_get_hashed(hash_table_t *, const char *, size_t, uint32_t hash);
+
+// Store a canonical key (see intern.h) without copying it. The key must
+// outlive the table and is never freed through it. Lookups made with the
+// same pointer match without comparing bytes. Keys short enough to store
+// inline are copied instead.
+int hash_table_insert_interned(hash_table_t *, const char *, size_t, uint32_t hash, json_value_t, mem_pool_t *pool);
+
+/**
+ * Object key with its length and hash computed once, for looking up the same
+ * key in many objects. A key made from an interned string (see intern.h)
+ * also matches entries by pointer. Keys must be rebuilt if json_hash_seed()
+ * changes the seed.
+ */
+typedef struct {
+  const char *str;
+  uint32_t len;
+  uint32_t hash;
+} json_key_t;
+
+// A key over HASH_KEY_LEN_MAX cannot be stored, so it gets a length that
+// matches no entry
+static inline json_key_t json_key_n(const char *str, size_t len) {
+  uint32_t stored_len = len > HASH_KEY_LEN_MAX ? HASH_KEY_LEN_MAX + 1 : (uint32_t)len;
+  json_key_t key = { str, stored_len, hash_string(str, len) };
+  return key;
+}
+
+static inline json_key_t json_key(const char *str) {
+  return json_key_n(str, strlen(str));
+}
+
 // Create new json_value_t
 json_value_t json_value_init(json_type_t);
 
 int json_value_cmp(json_value_t *a, json_value_t *b);
 
-// Free json_value_t and all nested content
+// Free json_value_t and all nested content. Pooled storage is left to the
+// pool and reclaimed by pool_destroy().
 void json_value_free(json_value_t *);
+// Like json_value_free(), but returns pooled storage to pool's free lists so
+// later pooled allocations reuse it. pool must be the one the value was
+// built in.
+void json_value_free_pooled(json_value_t *, mem_pool_t *pool);
 
 // Create json_value_t
 json_value_t json_value_bool(bool);
 json_value_t json_value_number(double);
+// Takes ownership of a heap string, which is never stored inline. A string
+// longer than JSON_STRING_LEN_MAX is freed and a JSON_NULL value returned.
 json_value_t json_value_string(char *);
+// Copy of len bytes: inline when short, otherwise into pool, or the heap
+// when pool is NULL. Returns a JSON_NULL value if out of memory or len is
+// over JSON_STRING_LEN_MAX.
+json_value_t json_value_string_n(const char *, size_t len, mem_pool_t *pool);
 json_value_t json_value_array(size_t);
 json_value_t json_value_object(size_t size);
 
@@ -111,16 +347,86 @@ int json_array_cmp(json_value_t *a, json_value_t *b);
 
 int json_object_cmp(json_value_t *a, json_value_t *b);
 
-void json_object_set(json_value_t *, char *, json_value_t);
+// Takes ownership of a malloc'd key. Returns 0, or -1 if the member could
+// not be stored (out of memory, or a parsed object that needs
+// json_object_set_pooled() to grow); the value then still belongs to the
+// caller.
+int json_object_set(json_value_t *, char *, json_value_t);
 json_value_t json_object_get(json_value_t *, char *);
 int json_object_delete(json_value_t *, char *);
+int json_object_delete_pooled(json_value_t *, char *, mem_pool_t *pool);
 size_t json_object_size(json_value_t *);
 int json_object_has(json_value_t *, char *);
 
-// Handle json_value_array push and pop
-void json_array_push(json_value_t *, json_value_t);
+// Lookups with a prebuilt key: no strlen, no hashing
+json_value_t json_object_get_key(json_value_t *, json_key_t);
+int json_object_has_key(json_value_t *, json_key_t);
+
+/**
+ * Cursor over an object's members in insertion order. It walks the entry
+ * array directly, allocates nothing and stays valid while values are
+ * edited in place; inserting into or deleting from the object ends its use.
+ *
+ *   json_object_iter_t it = json_object_iter(&obj);
+ *   for (hash_entry_t *entry; (entry = json_object_next(&it));) {
+ *     json_str_t key = hash_entry_key(entry);
+ *     use(key.str, key.len, &entry->value);
+ *   }
+ */
+typedef struct {
+  hash_entry_t *next;
+  hash_entry_t *end;
+} json_object_iter_t;
+
+// Non-objects iterate nothing
+static inline json_object_iter_t json_object_iter(const json_value_t *obj) {
+  json_object_iter_t it = { NULL, NULL };
+  if (obj->type == JSON_OBJECT && obj->object && obj->object->entries) {
+    it.next = obj->object->entries;
+    it.end = obj->object->entries + hash_table_used(obj->object);
+  }
+  return it;
+}
+
+// Next member, or NULL when done; deleted entries are skipped
+static inline hash_entry_t *json_object_next(json_object_iter_t *it) {
+  while (it->next < it->end) {
+    hash_entry_t *entry = it->next++;
+    if (hash_entry_live(entry)) return entry;
+  }
+  return NULL;
+}
+
+// Handle json_value_array push and pop. Push returns 0, or -1 if the array
+// could not grow; parsed (pooled) arrays only grow through
+// json_array_push_pooled().
+int json_array_push(json_value_t *, json_value_t);
 int json_array_pop(json_value_t *);
 
-// Pooled versions (for internal use by parser)
-void json_object_set_pooled(json_value_t *, char *, json_value_t, mem_pool_t *pool);
-void json_array_push_pooled(json_value_t *, json_value_t, mem_pool_t *pool);
+// Pooled versions, for the parser and for editing parsed documents. Replaced
+// values and outgrown storage go back to the pool's free lists.
+// Returns 0, or -1 if the member could not be stored
+int json_object_set_pooled(json_value_t *, char *, json_value_t, mem_pool_t *pool);
+// Returns 0, or -1 if the pool could not grow the array
+int json_array_push_pooled(json_value_t *, json_value_t, mem_pool_t *pool);
+// Frees the last element and shrinks the storage once it is a quarter full
+int json_array_pop_pooled(json_value_t *, mem_pool_t *pool);
+
+// Mark a value as edited, so a spliced serialization (span.h) writes it
+// instead of copying its source text
+static inline void json_value_touch(json_value_t *value) {
+  value->flags &= (uint8_t)~JSON_VALUE_SPAN;
+}
+
+// Member or element for editing in place, or NULL: the container and the
+// member are touched, so chaining these down a path marks every level on it
+json_value_t *json_object_edit(json_value_t *, const char *key);
+json_value_t *json_array_edit(json_value_t *, size_t index);
+
+// Bumped when a json_object_* or json_array_* call edits a container that
+// is still flagged JSON_VALUE_SPAN: it was not reached by touching the
+// path, so its parents may still be flagged. Span tables recorded before
+// the bump are no longer trusted (span.h).
+extern uint64_t json_span_generation;
+
+#endif
@@ -5,8 +5,11 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 #define SMALL_BUFFER 32
+// Numbers shorter than this are copied to the stack for strtod
+#define NUMBER_BUFFER 64
 
 typedef enum {
   TOKEN_LBRACE,
@@ -32,17 +35,21 @@ typedef struct {
 typedef struct {
   token_type_t type;
   int line, column;
+  uint32_t hash;  // hash_string() of a TOKEN_STRING lexeme when requested
   string_slice_t lexeme;
 } token_t;
 
 typedef struct {
   const char *start;
   const char *current;
+  const char *end;  // terminating NUL of the input
   int line;
   int column;
 
   token_t last_token;
   bool has_peeked;
+  bool hash_strings;  // compute token.hash while scanning strings
+  bool owns_input;    // input is a private copy freed by lexer_free()
 } lexer_t;
 
 // util functions
@@ -59,11 +66,16 @@ void skip_whitespace(lexer_t *);
 char *slice_to_string(string_slice_t);
 int slice_strcmp(string_slice_t, char *);
 int slice_cmp(string_slice_t, string_slice_t);
+// Reads only the slice; 0 with errno set to ENOMEM if a long copy fails
 double slice_to_double(string_slice_t);
 void slice_print(string_slice_t);
 
 
+// Lex a private copy of a NUL-terminated string
 lexer_t lexer_init(const char *);
+// Lex input in place without copying or allocating. input[len] must be
+// '\0' and the buffer must outlive the lexer and every token from it.
+lexer_t lexer_init_view(const char *input, size_t len);
 void lexer_free(lexer_t *);
 
 void token_free(token_t *);
@@ -6,12 +6,55 @@
 #include <stdbool.h>
 
 #define POOL_BLOCK_SIZE (1024 * 1024) // 1MB blocks
+#define POOL_MIN_BLOCK_SIZE 4096       // power of two
+#define POOL_MAX_BLOCK_SIZE (64 * 1024 * 1024)
+// Pool bytes per input byte for a parsed document, measured on benchmarks/data
+#define POOL_INPUT_FOOTPRINT 4
 #define POOL_ALIGNMENT 8
+#define POOL_CACHE_LINE 64
+#define POOL_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+// Blocks smaller than this stay on malloc even when mmap is requested
+#define POOL_MMAP_MIN_BLOCK POOL_HUGE_PAGE_SIZE
+// Free-list size classes: POOL_ALIGNMENT << class bytes, the last class
+// holding every chunk of at least that size
+#define POOL_FREE_CLASSES 12
+
+// pool_config_t.flags
+#define POOL_MMAP          (1u << 0)  // map large blocks directly with mmap
+#define POOL_HUGEPAGES     (1u << 1)  // huge-page aligned, MADV_HUGEPAGE mappings
+#define POOL_HUGETLB       (1u << 2)  // try MAP_HUGETLB first (needs reserved pages)
+#define POOL_PREFAULT      (1u << 3)  // populate mapped blocks up front
+#define POOL_TRIM_ON_RESET (1u << 4)  // pool_reset() releases pages past retain_bytes
+#define POOL_ACCOUNTING    (1u << 5)  // track bytes per category, see pool_usage()
+#define POOL_FIXED         (1u << 6)  // set by pool_create_static(): never grows
+
+/**
+ * Categories for pool accounting. Allocations are tagged with
+ * pool_account() by the code that makes them; bytes nobody tagged are
+ * reported as POOL_CAT_OTHER.
+ */
+typedef enum {
+  POOL_CAT_OTHER,
+  POOL_CAT_STRING,  // string values
+  POOL_CAT_KEY,     // copied object keys
+  POOL_CAT_ARRAY,   // array item storage
+  POOL_CAT_HASH,    // hash table entries, bucket index and control bytes
+  POOL_CAT_COUNT
+} pool_category_t;
+
+typedef struct {
+  size_t live[POOL_CAT_COUNT];       // bytes still referenced
+  size_t abandoned[POOL_CAT_COUNT];  // bytes left behind when a container moved
+  size_t padding;                    // alignment padding from pool_alloc_aligned()
+  size_t unused;                     // block bytes never handed out
+  size_t recycled;                   // abandoned bytes handed out again from the free lists
+} pool_usage_t;
 
 typedef struct pool_block {
   struct pool_block *next;
   size_t size;
   size_t used;
+  size_t map_size;  // length of the mapping for mmap blocks, 0 for malloc
   char data[];
 } pool_block_t;
 
@@ -21,16 +64,168 @@ typedef struct {
   size_t total_allocated;
   size_t total_used;
   size_t block_count;
+  size_t next_block_size;  // size of the next block chained on
+  size_t max_block_size;   // cap for geometric block growth
+  unsigned flags;          // POOL_* flags from the config
+  size_t retain_bytes;     // resident bytes kept by pool_reset()
+  pool_usage_t *usage;     // counters, NULL unless POOL_ACCOUNTING
+  void *free_lists[POOL_FREE_CLASSES];  // chunks returned by pool_free()
+  size_t free_bytes;       // bytes held by the free lists
 } mem_pool_t;
 
+/**
+ * Block sizing and backing for a pool. The first block holds
+ * first_block_size bytes and each block chained after it doubles in size up
+ * to max_block_size. Allocations larger than that get a block of their own.
+ * Zero sizes take the defaults.
+ *
+ * Blocks of at least POOL_MMAP_MIN_BLOCK can be mapped directly (POOL_MMAP),
+ * backed by huge pages (POOL_HUGEPAGES, POOL_HUGETLB) and pre-faulted
+ * (POOL_PREFAULT); if a mapping fails the block comes from malloc instead.
+ * With POOL_TRIM_ON_RESET, pool_reset() keeps the first retain_bytes of the
+ * pool resident and releases the rest with MADV_DONTNEED.
+ */
+typedef struct {
+  size_t first_block_size;
+  size_t max_block_size;
+  unsigned flags;
+  size_t retain_bytes;
+} pool_config_t;
+
+// POOL_BLOCK_SIZE first block, growing to POOL_MAX_BLOCK_SIZE
+pool_config_t pool_config_default(void);
+// First block sized to the expected DOM footprint of a document of
+// input_len bytes, rounded up to a power of two
+pool_config_t pool_config_for_input(size_t input_len);
+
 mem_pool_t *pool_create(void);
+mem_pool_t *pool_create_with_config(const pool_config_t *config);
+
+/**
+ * Pool living entirely inside a caller-supplied buffer (stack, static or
+ * otherwise preallocated). The pool header and its single block are carved
+ * from the buffer, so neither creation nor allocation touches malloc.
+ * Allocations that do not fit return NULL instead of growing the pool.
+ * pool_destroy() is a no-op; the buffer stays owned by the caller. Returns
+ * NULL if the buffer cannot hold the header.
+ */
+mem_pool_t *pool_create_static(void *buffer, size_t size);
 
 void *pool_alloc(mem_pool_t *pool, size_t size);
+// Allocate with the start aligned to `alignment` (a power of two, at most
+// POOL_BLOCK_SIZE). Alignments up to POOL_ALIGNMENT behave like pool_alloc.
 void *pool_alloc_aligned(mem_pool_t *pool, size_t size, size_t alignment);
+// Grow the most recent allocation in place; fails if ptr is not at the top of
+// the current block or the block has no room left
+bool pool_extend(mem_pool_t *pool, void *ptr, size_t old_size, size_t new_size);
+// Forget every allocation; blocks are kept and refilled in order
 void pool_reset(mem_pool_t *pool);
+
+/**
+ * Size-class free lists for long-lived pools whose contents are edited.
+ * pool_free() files a chunk under the largest class it can hold and
+ * pool_alloc_reuse() takes one from the smallest class that fits, falling
+ * back to the bump pointer when that list is empty or its head is not
+ * aligned as requested. size must be the size the chunk was allocated
+ * with. A chunk between two class sizes only serves the smaller one.
+ * pool_reset() and pool_rollback() empty the lists.
+ */
+void pool_free(mem_pool_t *pool, void *ptr, size_t size);
+void *pool_alloc_reuse(mem_pool_t *pool, size_t size, size_t alignment);
+// Bytes waiting on the free lists
+size_t pool_bytes_free(mem_pool_t *pool);
+
+/**
+ * Checkpoint of a pool's allocation state. pool_rollback() frees everything
+ * allocated since the mark, in time proportional to the blocks touched
+ * since. Blocks are kept for reuse. A mark is invalidated by pool_reset()
+ * and by rolling back to an earlier mark.
+ */
+typedef struct {
+  pool_block_t *block;
+  size_t used;
+  size_t total_used;
+} pool_mark_t;
+
+pool_mark_t pool_mark(mem_pool_t *pool);
+void pool_rollback(mem_pool_t *pool, pool_mark_t mark);
 void pool_destroy(mem_pool_t *pool);
 
 size_t pool_bytes_used(mem_pool_t *pool);
 size_t pool_bytes_allocated(mem_pool_t *pool);
 
+// Tag size bytes of the latest allocation with a category. No-op unless the
+// pool was created with POOL_ACCOUNTING.
+static inline void pool_account(mem_pool_t *pool, pool_category_t category, size_t size) {
+  if (__builtin_expect(pool->usage != NULL, 0)) {
+    pool->usage->live[category] += (size + POOL_ALIGNMENT - 1) & ~(size_t)(POOL_ALIGNMENT - 1);
+  }
+}
+
+// Move size tagged bytes from live to abandoned, for storage a container
+// stopped using when it grew into a new allocation
+static inline void pool_account_abandon(mem_pool_t *pool, pool_category_t category, size_t size) {
+  if (__builtin_expect(pool->usage != NULL, 0)) {
+    size = (size + POOL_ALIGNMENT - 1) & ~(size_t)(POOL_ALIGNMENT - 1);
+    pool->usage->live[category] -= size;
+    pool->usage->abandoned[category] += size;
+  }
+}
+
+// Copy the pool's counters into usage; returns false if the pool was created
+// without POOL_ACCOUNTING. Counters cover everything since creation or the
+// last pool_reset(); pool_rollback() does not rewind them. Bytes reused from
+// the free lists count as live and as abandoned, so live + abandoned +
+// padding + unused - recycled is the pool's allocated size.
+bool pool_usage(mem_pool_t *pool, pool_usage_t *usage);
+
+/**
+ * Blocks freed by pool_destroy() whose size is a power of two from
+ * POOL_MIN_BLOCK_SIZE to POOL_BLOCK_SIZE (the default block, and the blocks
+ * pool_config_for_input() picks for small inputs) are kept in a
+ * process-wide cache, a per-thread front list backed by a shared list, and
+ * handed to the next pool of the same size instead of being returned to
+ * the allocator. Limits are in blocks of any of these sizes; setting both
+ * to 0 disables caching.
+ */
+#define POOL_CACHE_THREAD_BLOCKS 4
+#define POOL_CACHE_SHARED_BLOCKS 32
+
+typedef struct {
+  size_t thread_hits;    // blocks reused from a thread's own cache
+  size_t shared_hits;    // blocks reused from the shared cache
+  size_t misses;         // blocks allocated fresh
+  size_t released;       // blocks handed to the cache by pool_destroy()
+  size_t evicted;        // released blocks freed because the cache was full
+  size_t thread_blocks;  // blocks held by the calling thread
+  size_t shared_blocks;  // blocks held in the shared cache
+} pool_cache_stats_t;
+
+void pool_cache_set_limits(size_t thread_blocks, size_t shared_blocks);
+void pool_cache_stats(pool_cache_stats_t *stats);
+// Free the shared cache and the calling thread's cached blocks
+void pool_cache_trim(void);
+
+/**
+ * Thread pools. pool_thread_attach() gives the calling thread a long-lived
+ * pool (NULL config for the defaults) that parser_init() borrows instead of
+ * creating and destroying a pool per document, so steady-state parsing on
+ * a worker thread calls neither malloc nor any locked code. Every document
+ * parsed on the thread shares the pool, which is reset when the last
+ * borrower releases it: free parsers on the thread that created them, and
+ * a document kept alive keeps every later document's memory until it is
+ * freed.
+ *
+ * pool_thread_detach() destroys the pool and fails while parsers still
+ * borrow it; a thread that exits attached destroys it too.
+ */
+mem_pool_t *pool_thread_attach(const pool_config_t *config);
+bool pool_thread_detach(void);
+// The calling thread's attached pool, or NULL
+mem_pool_t *pool_thread_current(void);
+// Borrow the attached pool (NULL if none) and give it back; the final
+// release resets the pool
+mem_pool_t *pool_thread_acquire(void);
+void pool_thread_release(mem_pool_t *pool);
+
 #endif
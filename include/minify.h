@@ -0,0 +1,35 @@
+#ifndef MINIFY_H
+#define MINIFY_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "writer.h"
+
+/**
+ * Whitespace passes over JSON text that never build values.
+ *
+ * json_minify() drops the whitespace between tokens. It works 64 bytes at
+ * a time: SSE2 compares find whitespace, quotes and backslashes, backslash
+ * runs of odd length mark escaped quotes, and a prefix XOR over the
+ * remaining quotes gives the bytes inside strings, whose whitespace is
+ * kept. The surviving bytes are packed with SSSE3 byte shuffles (8 bytes
+ * per shuffle, from a 256-entry table), or copied as runs without SSSE3.
+ * The input is not validated; text that is not JSON is minified as far as
+ * its quotes allow.
+ *
+ * json_reformat() re-emits a document token by token through a
+ * json_writer_t, so it pretty-prints (writer indent set) or compacts while
+ * checking the syntax, in constant memory. Strings and numbers are copied
+ * as they appear in the input.
+ */
+
+// Copy in to out without insignificant whitespace and return the new
+// length. out needs len bytes and may be in itself.
+size_t json_minify(const char *in, size_t len, char *out);
+
+// Tokenize in (in[len] must be '\0', as for lexer_init_view()) and write
+// the document to writer, without finishing it. False if the input is not
+// one JSON value or the writer failed; the writer's error_message says why.
+bool json_reformat(const char *in, size_t len, json_writer_t *writer);
+
+#endif
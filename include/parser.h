@@ -6,6 +6,16 @@
 #include "lexer.h"
 #include "json.h"
 #include "mem_pool.h"
+#include "intern.h"
+#include "span.h"
+
+// Object member waiting for its enclosing '}' so the table can be sized once
+typedef struct {
+  const char *key;  // points into the lexer input
+  uint32_t key_len;
+  uint32_t hash;    // computed by the lexer while scanning the key
+  json_value_t value;
+} parser_member_t;
 
 typedef struct {
   lexer_t *lexer;
@@ -14,9 +24,25 @@ typedef struct {
   char error_message[256];
   mem_pool_t *pool;
   bool owns_pool;  // whether the parser owns the pool
+  bool thread_pool;  // borrowed from pool_thread_attach()
+  intern_table_t *intern;  // optional shared key dictionary, not owned
+  json_spans_t *spans;     // optional container source spans, not owned
+
+  // Pending members of every open object, innermost last
+  parser_member_t *members;
+  size_t members_len;
+  size_t members_cap;
 } parser_t;
 
+// Sizes the parser's pool from the input length, or borrows the calling
+// thread's pool_thread_attach() pool when there is one
 parser_t parser_init(lexer_t *);
+// Explicit pool sizing; NULL behaves like parser_init()
+parser_t parser_init_ex(lexer_t *, const pool_config_t *config);
+// Parse into a caller-owned pool, which parser_free() leaves alone. With a
+// pool_create_static() pool and lexer_init_view() the parser never calls
+// malloc; running out of room fails the parse with "Out of memory".
+parser_t parser_init_with_pool(lexer_t *, mem_pool_t *pool);
 void parser_free(parser_t *);
 
 json_value_t parse(parser_t *);
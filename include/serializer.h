@@ -0,0 +1,108 @@
+#ifndef SERIALIZER_H
+#define SERIALIZER_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "json.h"
+#include "span.h"
+
+/**
+ * Compact JSON writer. Output has no whitespace and object members come out
+ * in insertion order, which for parsed documents is source order.
+ *
+ * Strings and keys are escaped as described in escape.h: valid escape
+ * sequences from the parser pass through unchanged, so parsed documents
+ * round-trip byte for byte.
+ *
+ * Numbers are formatted by json_format_double() (dtoa.h): shortest
+ * round-trip digits, whole numbers as integers, and null for NaN and
+ * infinities, which JSON cannot represent.
+ */
+
+// Output buffer: either grown with realloc or a fixed caller buffer
+typedef struct {
+  char *data;
+  size_t len;
+  size_t cap;
+  bool owned;   // data is ours to grow and free
+  bool failed;  // ran out of room (fixed) or memory (owned)
+} json_buffer_t;
+
+// Growable buffer; initial_cap 0 picks a default
+json_buffer_t json_buffer_init(size_t initial_cap);
+// Buffer over caller memory; writes that do not fit fail instead of growing
+json_buffer_t json_buffer_fixed(char *buf, size_t cap);
+void json_buffer_free(json_buffer_t *);
+
+// Append value to the buffer, NUL-terminated; false if it ran out of room.
+// Reusing one growable buffer across calls (set len to 0) avoids malloc.
+bool json_serialize_into(json_buffer_t *, const json_value_t *);
+// Newly malloc'd NUL-terminated text, or NULL; len may be NULL
+char *json_serialize(const json_value_t *, size_t *len);
+// Write into buf; returns the length written, excluding the NUL, or 0 if
+// the text and its NUL do not fit in cap bytes
+size_t json_serialize_to(const json_value_t *, char *buf, size_t cap);
+
+// Write value to stdout as compact JSON followed by a newline
+void json_value_print(const json_value_t *);
+
+/**
+ * Parallel serialization for large documents. Arrays and objects with at
+ * least min_split members are cut into ranges of elements (or table
+ * entries), each serialized into its own buffer by a pool of threads; the
+ * text around them (brackets, keys and small members) is written by the
+ * calling thread as it plans the ranges. Containers below the threshold
+ * are searched for large children down to a few levels, so documents like
+ * {"type": ..., "features": [ millions ]} split too.
+ *
+ * The parts are then concatenated, or written to an fd in writev() gather
+ * calls without being copied. The text is byte-identical to
+ * json_serialize().
+ */
+typedef struct {
+  int threads;       // workers including the caller; 0 uses one per online CPU
+  size_t min_split;  // smallest container to split; 0 picks 4096
+} json_parallel_config_t;
+
+// Same text as json_serialize(); NULL config for defaults
+char *json_serialize_parallel(const json_value_t *, size_t *len, const json_parallel_config_t *);
+// Write the text to fd; false on an allocation or write error
+bool json_serialize_parallel_fd(const json_value_t *, int fd, const json_parallel_config_t *);
+
+/**
+ * Spliced serialization of a parsed, then edited, document (see span.h).
+ * Containers still flagged JSON_VALUE_SPAN are copied from the parser
+ * input as they were, whitespace and member order included; only the
+ * containers on edited paths are written afresh, compactly and in
+ * insertion order. The work follows the size of the edits rather than the
+ * document. The text may differ from json_serialize()'s in whitespace, and
+ * parses to the same value.
+ */
+bool json_serialize_spliced_into(json_buffer_t *, const json_value_t *, const json_spans_t *);
+// Newly malloc'd NUL-terminated text, or NULL; len may be NULL
+char *json_serialize_spliced(const json_value_t *, const json_spans_t *, size_t *len);
+// Write to fd in writev() gather calls: long copied spans are sent
+// straight from the input, without being copied at all
+bool json_serialize_spliced_fd(const json_value_t *, const json_spans_t *, int fd);
+
+/**
+ * Canonical JSON (RFC 8785, the JSON Canonicalization Scheme), for hashing
+ * and signing: the same value always gives the same bytes.
+ *
+ * - Object members are sorted by key, compared as UTF-16 code units. Keys
+ *   are sorted with a merge sort, on scratch space reused by every object
+ *   in the document; most comparisons look only at the first 8 bytes.
+ * - Numbers take the ECMAScript form, from json_format_double_exact().
+ * - Strings are escaped minimally. Escape sequences from the input are
+ *   decoded, and only quote, backslash and control characters are escaped
+ *   again. Everything else, '/' and non-ASCII included, is written as UTF-8.
+ *
+ * Fails on values the scheme cannot represent: NaN and infinities, lone
+ * surrogate escapes, and keys that are equal once decoded. The UTF-8 of
+ * the input is not checked.
+ */
+bool json_serialize_canonical_into(json_buffer_t *, const json_value_t *);
+// Newly malloc'd NUL-terminated text, or NULL; len may be NULL
+char *json_serialize_canonical(const json_value_t *, size_t *len);
+
+#endif
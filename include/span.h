@@ -0,0 +1,78 @@
+#ifndef SPAN_H
+#define SPAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "json.h"
+
+/**
+ * Source spans of parsed containers, for re-serializing an edited document
+ * by copying the text of everything that did not change.
+ *
+ * A parser given a span table records, for every array and object that
+ * parses cleanly, the offset and length of its text from the opening to
+ * the closing bracket, and sets JSON_VALUE_SPAN on the value. Spans live
+ * in this side table rather than in json_value_t, which stays 16 bytes;
+ * they are keyed by the container's storage (array block or table header),
+ * which is unique among live containers and travels with the value when
+ * it is copied into its parent.
+ *
+ * Every container on the path to an edit must be unflagged, so the
+ * spliced serializer (serializer.h) writes it afresh while its untouched
+ * children are still copied. Reach what you edit through the _edit()
+ * lookups in json.h, which touch each level they pass and the member they
+ * return, or json_value_touch() each level yourself.
+ *
+ * The json_object_* and json_array_* calls cannot see a container's
+ * parents. Used on a container that is still flagged, they assume the
+ * path was skipped and bump json_span_generation. Every table recorded
+ * before the bump then finds no spans, and the next spliced write is a
+ * full one: correct, but without reuse. Writes to a value's fields that
+ * make no call at all, such as json_array_at(doc, 0)->number = 2, cannot
+ * be seen. json_spans_verify() catches them while debugging.
+ *
+ *   json_spans_t spans = json_spans_init();
+ *   parser.spans = &spans;
+ *   json_value_t doc = parse(&parser);
+ *   json_object_edit(&doc, "status")->number = 2;
+ *   json_serialize_spliced_fd(&doc, &spans, fd);
+ *
+ * Offsets are into the lexer's input, which parse() stores in the table;
+ * it must outlive the table's use, so parse with lexer_init_view() over a
+ * buffer the caller keeps (lexer_init() input is freed by lexer_free()).
+ */
+
+typedef struct {
+  const void *storage;  // array block or table header; NULL for an empty slot
+  size_t start;         // offset of the '[' or '{'
+  size_t len;           // through the closing bracket
+} json_span_t;
+
+typedef struct {
+  const char *input;
+  json_span_t *slots;   // linear probing, at most half full
+  size_t capacity;      // power of two
+  size_t size;
+  uint64_t generation;  // json_span_generation when recording began
+} json_spans_t;
+
+json_spans_t json_spans_init(void);
+void json_spans_free(json_spans_t *);
+// Forget every span, keeping the slots for the next document
+void json_spans_clear(json_spans_t *);
+
+// Record or replace the span of the container with this storage; false if
+// out of memory
+bool json_spans_add(json_spans_t *, const void *storage, size_t start, size_t len);
+
+// Span of an unedited parsed container, or NULL. NULL for every container
+// once json_span_generation has moved on from the table's.
+const json_span_t *json_spans_find(const json_spans_t *, const json_value_t *);
+
+// Debug check: true if the source text of every container that would be
+// copied still parses to its current value. False points at an edit that
+// skipped the path. Costs a parse of the copied text.
+bool json_spans_verify(const json_spans_t *, const json_value_t *);
+
+#endif
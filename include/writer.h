@@ -0,0 +1,116 @@
+#ifndef WRITER_H
+#define WRITER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/uio.h>
+
+/**
+ * Streaming JSON writer: emits a document from begin/end, key and value
+ * calls without building a json_value_t tree.
+ *
+ *   json_writer_t w = json_writer_init_fd(fd, NULL);
+ *   json_writer_begin_array(&w);
+ *   for (...) {
+ *     json_writer_begin_object(&w);
+ *     json_writer_key(&w, "id", 2);
+ *     json_writer_number(&w, id);
+ *     json_writer_end(&w);
+ *   }
+ *   json_writer_end(&w);
+ *   bool ok = json_writer_finish(&w);
+ *   json_writer_free(&w);
+ *
+ * Output collects in fixed-size chunks, allocated as they are first
+ * needed. When the last chunk fills, all of them go to the fd or callback
+ * in one writev() gather call and the writer starts over at the first, so
+ * memory stays at max_chunks * chunk_size plus one byte per open container
+ * however large the document. String runs longer than a chunk are not
+ * copied: they go out in the same gather call as the buffered output.
+ *
+ * Keys and strings are application text: every backslash, quote and
+ * control character is escaped, so the text reads back as given. The _raw
+ * variants take a string body as it appears in JSON source and pass its
+ * escapes through, as the serializer does. Numbers are formatted by
+ * json_format_double(). With indent set, members and elements start on
+ * their own lines and keys are followed by ": ".
+ *
+ * Errors are sticky, as in the builder: a misplaced call or a failed write
+ * sets has_error and every later call is ignored.
+ */
+
+#define JSON_WRITER_MAX_CHUNKS 64
+
+// Callback sink: write every iovec in order; false stops the writer
+typedef bool (*json_write_fn)(void *ctx, const struct iovec *iov, int iovcnt);
+
+typedef struct {
+  size_t chunk_size;  // 0 picks 64 KiB
+  int max_chunks;     // chunks buffered before a flush, up to JSON_WRITER_MAX_CHUNKS; 0 picks 4
+  int indent;         // spaces per level; 0 writes compact JSON
+} json_writer_config_t;
+
+typedef struct {
+  char *chunks[JSON_WRITER_MAX_CHUNKS];
+  size_t chunk_size;
+  int max_chunks;
+  int chunk;          // chunk being filled
+  size_t len;         // bytes used in it
+  uint64_t written;   // bytes handed to the sink so far
+
+  int fd;             // -1 when writing to fn
+  json_write_fn fn;
+  void *ctx;
+  int indent;
+
+  uint8_t *frames;    // open containers, innermost last
+  size_t depth;
+  size_t frames_cap;
+  bool has_key;       // a key is waiting for its value
+  bool done;          // the root value is complete
+
+  bool has_error;
+  char error_message[128];
+} json_writer_t;
+
+// Writer to a file descriptor, which is not closed; NULL config for defaults
+json_writer_t json_writer_init_fd(int fd, const json_writer_config_t *config);
+// Writer to a callback
+json_writer_t json_writer_init_fn(json_write_fn fn, void *ctx, const json_writer_config_t *config);
+void json_writer_free(json_writer_t *);
+
+void json_writer_begin_object(json_writer_t *);
+void json_writer_begin_array(json_writer_t *);
+// Close the innermost open container
+void json_writer_end(json_writer_t *);
+
+// Key of the next value; only valid directly inside an object. Keys are not
+// checked for repeats.
+void json_writer_key(json_writer_t *, const char *key, size_t len);
+// Key already in JSON source form, escapes included, e.g. a lexeme
+void json_writer_key_raw(json_writer_t *, const char *key, size_t len);
+
+void json_writer_string(json_writer_t *, const char *str, size_t len);
+// String body already in JSON source form, escapes included
+void json_writer_string_raw(json_writer_t *, const char *str, size_t len);
+void json_writer_number(json_writer_t *, double number);
+void json_writer_bool(json_writer_t *, bool boolean);
+void json_writer_null(json_writer_t *);
+// Value text written as given, e.g. a number lexeme kept digit for digit;
+// the caller vouches that it is valid JSON
+void json_writer_raw(json_writer_t *, const char *text, size_t len);
+
+// The innermost open container is an object
+bool json_writer_in_object(const json_writer_t *);
+
+// Send buffered output now, e.g. between records of a long export
+bool json_writer_flush(json_writer_t *);
+// Check the document is complete and flush it; false on any error
+bool json_writer_finish(json_writer_t *);
+
+// writev() until every byte is out, resuming after short writes and EINTR;
+// advances iov. False with errno set on a write error.
+bool json_write_all(int fd, struct iovec *iov, int count);
+
+#endif
@@ -0,0 +1,288 @@
+#include "../include/builder.h"
+#include "../include/escape.h"
+
+#include <stdio.h>
+#include <string.h>
+
+json_builder_t json_builder_init(const pool_config_t *config) {
+  json_builder_t builder = json_builder_init_with_pool(
+      config ? pool_create_with_config(config) : pool_create());
+  builder.owns_pool = true;
+  if (!builder.pool) {
+    builder.has_error = true;
+    snprintf(builder.error_message, sizeof(builder.error_message), "Out of memory");
+  }
+  return builder;
+}
+
+json_builder_t json_builder_init_with_pool(mem_pool_t *pool) {
+  json_builder_t builder = {
+    .pool = pool,
+    .owns_pool = false,
+    .has_error = false,
+  };
+  return builder;
+}
+
+void json_builder_free(json_builder_t *builder) {
+  free(builder->frames);
+  free(builder->items);
+  free(builder->keys);
+  builder->frames = NULL;
+  builder->items = NULL;
+  builder->keys = NULL;
+  builder->depth = builder->items_len = builder->keys_len = 0;
+  builder->frames_cap = builder->items_cap = builder->keys_cap = 0;
+  if (builder->owns_pool && builder->pool) {
+    pool_destroy(builder->pool);
+    builder->pool = NULL;
+  }
+}
+
+__attribute__((cold))
+static void builder_error(json_builder_t *builder, const char *msg) {
+  if (builder->has_error) return;
+  builder->has_error = true;
+  snprintf(builder->error_message, sizeof(builder->error_message), "Builder error: %s", msg);
+}
+
+// Make room for one more element in a heap scratch array
+static bool builder_reserve(json_builder_t *builder, void **data, size_t *cap, size_t len,
+                            size_t need, size_t elem_size) {
+  if (len + need <= *cap) return true;
+  size_t new_cap = *cap ? *cap * 2 : 16;
+  while (new_cap < len + need) {
+    new_cap *= 2;
+  }
+  void *grown = realloc(*data, new_cap * elem_size);
+  if (!grown) {
+    builder_error(builder, "Out of memory");
+    return false;
+  }
+  *data = grown;
+  *cap = new_cap;
+  return true;
+}
+
+// Place a finished value: the document root, or the next member or element
+// of the innermost open container
+static void builder_add(json_builder_t *builder, json_value_t value) {
+  if (builder->depth == 0) {
+    if (builder->has_root) {
+      builder_error(builder, "Document already has a root value");
+      return;
+    }
+    builder->root = value;
+    builder->has_root = true;
+    return;
+  }
+
+  builder_frame_t *frame = &builder->frames[builder->depth - 1];
+  if (frame->is_object && !builder->has_key) {
+    builder_error(builder, "Object member needs a key");
+    return;
+  }
+
+  if (!frame->is_object) {
+    if (!builder_reserve(builder, (void **)&builder->items, &builder->items_cap,
+                         builder->items_len, 1, sizeof(builder_item_t))) {
+      return;
+    }
+    builder->items[builder->items_len].key_len = 0;
+    builder->items[builder->items_len].value = value;
+  } else {
+    // The key already reserved and filled this item
+    builder->items[builder->items_len].value = value;
+    builder->has_key = false;
+  }
+  builder->items_len++;
+}
+
+static void builder_begin(json_builder_t *builder, bool is_object) {
+  if (builder->has_error) return;
+  if (builder->depth == 0 && builder->has_root) {
+    builder_error(builder, "Document already has a root value");
+    return;
+  }
+  if (builder->depth > 0 && builder->frames[builder->depth - 1].is_object && !builder->has_key) {
+    builder_error(builder, "Object member needs a key");
+    return;
+  }
+  if (!builder_reserve(builder, (void **)&builder->frames, &builder->frames_cap,
+                       builder->depth, 1, sizeof(builder_frame_t))) {
+    return;
+  }
+
+  // The container's key, if any, stays on the item stack below its members
+  if (builder->has_key) {
+    builder->items_len++;
+    builder->has_key = false;
+  }
+
+  builder_frame_t *frame = &builder->frames[builder->depth++];
+  frame->is_object = is_object;
+  frame->items_base = builder->items_len;
+  frame->keys_base = builder->keys_len;
+}
+
+void json_builder_begin_object(json_builder_t *builder) {
+  builder_begin(builder, true);
+}
+
+void json_builder_begin_array(json_builder_t *builder) {
+  builder_begin(builder, false);
+}
+
+static json_value_t builder_finish_array(json_builder_t *builder, builder_frame_t *frame) {
+  size_t count = builder->items_len - frame->items_base;
+  json_value_t array = json_value_array_pooled(count, builder->pool);
+  if (!array.array) {
+    builder_error(builder, "Out of memory");
+    return json_value_init(JSON_NULL);
+  }
+  builder_item_t *items = builder->items + frame->items_base;
+  for (size_t i = 0; i < count; i++) {
+    array.array->items[i] = items[i].value;
+  }
+  array.array->len = count;
+  return array;
+}
+
+static json_value_t builder_finish_object(json_builder_t *builder, builder_frame_t *frame) {
+  size_t count = builder->items_len - frame->items_base;
+  json_value_t object = json_value_object_pooled(count, builder->pool);
+  if (!object.object) {
+    builder_error(builder, "Out of memory");
+    return json_value_init(JSON_NULL);
+  }
+  builder_item_t *items = builder->items + frame->items_base;
+  for (size_t i = 0; i < count; i++) {
+    const char *key = builder->keys + items[i].key_offset;
+    int res = hash_table_insert_hashed(object.object, key, items[i].key_len, items[i].hash,
+                                       items[i].value, builder->pool);
+    if (res < 0) {
+      builder_error(builder, "Out of memory");
+      break;
+    } else if (res == 1) {
+      // Duplicate key: last value wins; the replaced one's storage is reused
+      json_value_t *existing = hash_table_get_hashed(object.object, key, items[i].key_len,
+                                                     items[i].hash);
+      json_value_free_pooled(existing, builder->pool);
+      *existing = items[i].value;
+    }
+  }
+  return object;
+}
+
+void json_builder_end(json_builder_t *builder) {
+  if (builder->has_error) return;
+  if (builder->depth == 0) {
+    builder_error(builder, "No open container to end");
+    return;
+  }
+  if (builder->has_key) {
+    builder_error(builder, "Key without a value");
+    return;
+  }
+
+  builder_frame_t frame = builder->frames[--builder->depth];
+  json_value_t value = frame.is_object ? builder_finish_object(builder, &frame)
+                                       : builder_finish_array(builder, &frame);
+  builder->items_len = frame.items_base;
+  builder->keys_len = frame.keys_base;
+  if (builder->has_error) return;
+
+  // Reattach the key the container was opened under
+  if (builder->depth > 0 && builder->frames[builder->depth - 1].is_object) {
+    builder->items_len--;
+    builder->has_key = true;
+  }
+  builder_add(builder, value);
+}
+
+void json_builder_key(json_builder_t *builder, const char *key, size_t len) {
+  if (builder->has_error) return;
+  if (builder->depth == 0 || !builder->frames[builder->depth - 1].is_object) {
+    builder_error(builder, "Key outside an object");
+    return;
+  }
+  if (builder->has_key) {
+    builder_error(builder, "Key without a value");
+    return;
+  }
+  // Stored escaped, as the parser stores keys; escaping never shortens
+  size_t escaped_len = len <= HASH_KEY_LEN_MAX ? json_escape_text_into(NULL, key, len) : len;
+  if (escaped_len > HASH_KEY_LEN_MAX) {
+    builder_error(builder, "Key too long");
+    return;
+  }
+  if (!builder_reserve(builder, (void **)&builder->keys, &builder->keys_cap, builder->keys_len, escaped_len, 1) ||
+      !builder_reserve(builder, (void **)&builder->items, &builder->items_cap,
+                       builder->items_len, 1, sizeof(builder_item_t))) {
+    return;
+  }
+
+  char *stored = builder->keys + builder->keys_len;
+  json_escape_text_into(stored, key, len);
+  builder_item_t *item = &builder->items[builder->items_len];
+  item->key_offset = builder->keys_len;
+  item->key_len = (uint32_t)escaped_len;
+  item->hash = hash_string(stored, escaped_len);
+  builder->keys_len += escaped_len;
+  builder->has_key = true;
+}
+
+void json_builder_string(json_builder_t *builder, const char *str, size_t len) {
+  if (builder->has_error) return;
+  if (len > JSON_STRING_LEN_MAX) {
+    builder_error(builder, "String too long");
+    return;
+  }
+  // Strings are stored escaped, as the parser stores them. Text that needs
+  // it is escaped past the end of the key scratch buffer, then copied.
+  if (json_escape_clean_run(str, len) != len) {
+    size_t escaped_len = json_escape_text_into(NULL, str, len);
+    if (escaped_len > JSON_STRING_LEN_MAX) {
+      builder_error(builder, "String too long");
+      return;
+    }
+    if (!builder_reserve(builder, (void **)&builder->keys, &builder->keys_cap, builder->keys_len, escaped_len, 1)) {
+      return;
+    }
+    char *escaped = builder->keys + builder->keys_len;
+    json_escape_text_into(escaped, str, len);
+    str = escaped;
+    len = escaped_len;
+  }
+  json_value_t value = json_value_string_n(str, len, builder->pool);
+  if (value.type != JSON_STRING) {
+    builder_error(builder, "Out of memory");
+    return;
+  }
+  builder_add(builder, value);
+}
+
+void json_builder_number(json_builder_t *builder, double number) {
+  if (builder->has_error) return;
+  builder_add(builder, json_value_number(number));
+}
+
+void json_builder_bool(json_builder_t *builder, bool boolean) {
+  if (builder->has_error) return;
+  builder_add(builder, json_value_bool(boolean));
+}
+
+void json_builder_null(json_builder_t *builder) {
+  if (builder->has_error) return;
+  builder_add(builder, json_value_init(JSON_NULL));
+}
+
+json_value_t json_builder_finish(json_builder_t *builder) {
+  if (!builder->has_error && builder->depth > 0) {
+    builder_error(builder, "Unclosed container");
+  }
+  if (builder->has_error || !builder->has_root) {
+    return json_value_init(JSON_NULL);
+  }
+  return builder->root;
+}
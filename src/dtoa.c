@@ -0,0 +1,463 @@
+#include "../include/dtoa.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Unsigned 64-bit significand with a binary exponent: f * 2^e
+typedef struct {
+  uint64_t f;
+  int e;
+} diyfp_t;
+
+typedef struct {
+  uint64_t f;
+  int e;  // binary exponent of f
+  int k;  // decimal exponent: f * 2^e ~= 10^k
+} cached_power_t;
+
+// Scaled digits must land in [2^-kAlpha, 2^-kGamma) after multiplication
+#define GRISU_ALPHA (-60)
+#define GRISU_GAMMA (-32)
+
+#define CACHED_POWERS_MIN_DEC_EXP (-300)
+#define CACHED_POWERS_DEC_EXP_STEP 8
+
+// Normalized 64-bit approximations of 10^k, rounded to nearest, for
+// k = -300, -292, ..., 324
+static const cached_power_t CACHED_POWERS[] = {
+  {0xAB70FE17C79AC6CA, -1060, -300},
+  {0xFF77B1FCBEBCDC4F, -1034, -292},
+  {0xBE5691EF416BD60C, -1007, -284},
+  {0x8DD01FAD907FFC3C,  -980, -276},
+  {0xD3515C2831559A83,  -954, -268},
+  {0x9D71AC8FADA6C9B5,  -927, -260},
+  {0xEA9C227723EE8BCB,  -901, -252},
+  {0xAECC49914078536D,  -874, -244},
+  {0x823C12795DB6CE57,  -847, -236},
+  {0xC21094364DFB5637,  -821, -228},
+  {0x9096EA6F3848984F,  -794, -220},
+  {0xD77485CB25823AC7,  -768, -212},
+  {0xA086CFCD97BF97F4,  -741, -204},
+  {0xEF340A98172AACE5,  -715, -196},
+  {0xB23867FB2A35B28E,  -688, -188},
+  {0x84C8D4DFD2C63F3B,  -661, -180},
+  {0xC5DD44271AD3CDBA,  -635, -172},
+  {0x936B9FCEBB25C996,  -608, -164},
+  {0xDBAC6C247D62A584,  -582, -156},
+  {0xA3AB66580D5FDAF6,  -555, -148},
+  {0xF3E2F893DEC3F126,  -529, -140},
+  {0xB5B5ADA8AAFF80B8,  -502, -132},
+  {0x87625F056C7C4A8B,  -475, -124},
+  {0xC9BCFF6034C13053,  -449, -116},
+  {0x964E858C91BA2655,  -422, -108},
+  {0xDFF9772470297EBD,  -396, -100},
+  {0xA6DFBD9FB8E5B88F,  -369,  -92},
+  {0xF8A95FCF88747D94,  -343,  -84},
+  {0xB94470938FA89BCF,  -316,  -76},
+  {0x8A08F0F8BF0F156B,  -289,  -68},
+  {0xCDB02555653131B6,  -263,  -60},
+  {0x993FE2C6D07B7FAC,  -236,  -52},
+  {0xE45C10C42A2B3B06,  -210,  -44},
+  {0xAA242499697392D3,  -183,  -36},
+  {0xFD87B5F28300CA0E,  -157,  -28},
+  {0xBCE5086492111AEB,  -130,  -20},
+  {0x8CBCCC096F5088CC,  -103,  -12},
+  {0xD1B71758E219652C,   -77,   -4},
+  {0x9C40000000000000,   -50,    4},
+  {0xE8D4A51000000000,   -24,   12},
+  {0xAD78EBC5AC620000,     3,   20},
+  {0x813F3978F8940984,    30,   28},
+  {0xC097CE7BC90715B3,    56,   36},
+  {0x8F7E32CE7BEA5C70,    83,   44},
+  {0xD5D238A4ABE98068,   109,   52},
+  {0x9F4F2726179A2245,   136,   60},
+  {0xED63A231D4C4FB27,   162,   68},
+  {0xB0DE65388CC8ADA8,   189,   76},
+  {0x83C7088E1AAB65DB,   216,   84},
+  {0xC45D1DF942711D9A,   242,   92},
+  {0x924D692CA61BE758,   269,  100},
+  {0xDA01EE641A708DEA,   295,  108},
+  {0xA26DA3999AEF774A,   322,  116},
+  {0xF209787BB47D6B85,   348,  124},
+  {0xB454E4A179DD1877,   375,  132},
+  {0x865B86925B9BC5C2,   402,  140},
+  {0xC83553C5C8965D3D,   428,  148},
+  {0x952AB45CFA97A0B3,   455,  156},
+  {0xDE469FBD99A05FE3,   481,  164},
+  {0xA59BC234DB398C25,   508,  172},
+  {0xF6C69A72A3989F5C,   534,  180},
+  {0xB7DCBF5354E9BECE,   561,  188},
+  {0x88FCF317F22241E2,   588,  196},
+  {0xCC20CE9BD35C78A5,   614,  204},
+  {0x98165AF37B2153DF,   641,  212},
+  {0xE2A0B5DC971F303A,   667,  220},
+  {0xA8D9D1535CE3B396,   694,  228},
+  {0xFB9B7CD9A4A7443C,   720,  236},
+  {0xBB764C4CA7A44410,   747,  244},
+  {0x8BAB8EEFB6409C1A,   774,  252},
+  {0xD01FEF10A657842C,   800,  260},
+  {0x9B10A4E5E9913129,   827,  268},
+  {0xE7109BFBA19C0C9D,   853,  276},
+  {0xAC2820D9623BF429,   880,  284},
+  {0x80444B5E7AA7CF85,   907,  292},
+  {0xBF21E44003ACDD2D,   933,  300},
+  {0x8E679C2F5E44FF8F,   960,  308},
+  {0xD433179D9C8CB841,   986,  316},
+  {0x9E19DB92B4E31BA9,  1013,  324},
+};
+
+static inline diyfp_t diyfp_sub(diyfp_t x, diyfp_t y) {
+  return (diyfp_t){x.f - y.f, x.e};
+}
+
+// Upper 64 bits of the 128-bit product, rounded
+static inline diyfp_t diyfp_mul(diyfp_t x, diyfp_t y) {
+  __uint128_t product = (__uint128_t)x.f * y.f;
+  uint64_t high = (uint64_t)(product >> 64);
+  uint64_t low = (uint64_t)product;
+  return (diyfp_t){high + (low >> 63), x.e + y.e + 64};
+}
+
+static inline diyfp_t diyfp_normalize(diyfp_t x) {
+  int shift = __builtin_clzll(x.f);
+  return (diyfp_t){x.f << shift, x.e - shift};
+}
+
+static inline diyfp_t diyfp_normalize_to(diyfp_t x, int e) {
+  return (diyfp_t){x.f << (x.e - e), e};
+}
+
+// value (finite, > 0) and the midpoints to its neighbours, all normalized
+// to the upper boundary's exponent
+static void compute_boundaries(double value, diyfp_t *w, diyfp_t *minus, diyfp_t *plus) {
+  const uint64_t hidden_bit = 1ULL << 52;
+  const int bias = 1023 + 52;
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  uint64_t fraction = bits & (hidden_bit - 1);
+  int exponent = (int)(bits >> 52);
+
+  diyfp_t v = exponent == 0 ? (diyfp_t){fraction, 1 - bias}
+                            : (diyfp_t){fraction + hidden_bit, exponent - bias};
+
+  // At a power of two the lower neighbour is half as far away
+  bool lower_closer = fraction == 0 && exponent > 1;
+  diyfp_t m_plus = {2 * v.f + 1, v.e - 1};
+  diyfp_t m_minus = lower_closer ? (diyfp_t){4 * v.f - 1, v.e - 2}
+                                 : (diyfp_t){2 * v.f - 1, v.e - 1};
+
+  *plus = diyfp_normalize(m_plus);
+  *minus = diyfp_normalize_to(m_minus, plus->e);
+  *w = diyfp_normalize(v);
+}
+
+// Cached power c = 10^-k such that e + c.e + 64 lands in [alpha, gamma]
+static inline cached_power_t cached_power_for(int e) {
+  int f = GRISU_ALPHA - e - 1;
+  int k = (f * 78913) / (1 << 18) + (f > 0);
+  int index = (-CACHED_POWERS_MIN_DEC_EXP + k + (CACHED_POWERS_DEC_EXP_STEP - 1)) /
+              CACHED_POWERS_DEC_EXP_STEP;
+  return CACHED_POWERS[index];
+}
+
+// Digit count of n and the power of ten of its leading digit
+static inline int largest_pow10(uint32_t n, uint32_t *pow10) {
+  static const uint32_t powers[] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000,
+  };
+  int digits = 10;
+  while (digits > 1 && n < powers[digits - 1]) {
+    digits--;
+  }
+  *pow10 = powers[digits - 1];
+  return digits;
+}
+
+// Nudge the last digit towards w while staying inside the boundaries
+static inline void grisu2_round(char *buf, int len, uint64_t dist, uint64_t delta,
+                                uint64_t rest, uint64_t ten_k) {
+  while (rest < dist && delta - rest >= ten_k &&
+         (rest + ten_k < dist || dist - rest > rest + ten_k - dist)) {
+    buf[len - 1]--;
+    rest += ten_k;
+  }
+}
+
+// Generate digits of M+ until what is left is within delta of M-
+static void grisu2_digit_gen(char *buf, int *len, int *dec_exp,
+                             diyfp_t m_minus, diyfp_t w, diyfp_t m_plus) {
+  uint64_t delta = diyfp_sub(m_plus, m_minus).f;
+  uint64_t dist = diyfp_sub(m_plus, w).f;
+
+  // Split M+ into integral part p1 and fractional part p2 at 2^-e
+  const int shift = -m_plus.e;
+  const uint64_t one = 1ULL << shift;
+  uint32_t p1 = (uint32_t)(m_plus.f >> shift);
+  uint64_t p2 = m_plus.f & (one - 1);
+
+  uint32_t pow10;
+  int n = largest_pow10(p1, &pow10);
+  int length = 0;
+  while (n > 0) {
+    buf[length++] = (char)('0' + p1 / pow10);
+    p1 %= pow10;
+    n--;
+    uint64_t rest = ((uint64_t)p1 << shift) + p2;
+    if (rest <= delta) {
+      *dec_exp += n;
+      grisu2_round(buf, length, dist, delta, rest, (uint64_t)pow10 << shift);
+      *len = length;
+      return;
+    }
+    pow10 /= 10;
+  }
+
+  int m = 0;
+  while (true) {
+    p2 *= 10;
+    buf[length++] = (char)('0' + (p2 >> shift));
+    p2 &= one - 1;
+    m++;
+    delta *= 10;
+    dist *= 10;
+    if (p2 <= delta) break;
+  }
+  *dec_exp -= m;
+  grisu2_round(buf, length, dist, delta, p2, one);
+  *len = length;
+}
+
+// Shortest digits of value (finite, > 0): value ~= digits * 10^dec_exp
+static int grisu2(char *digits, int *dec_exp, double value) {
+  diyfp_t w, m_minus, m_plus;
+  compute_boundaries(value, &w, &m_minus, &m_plus);
+
+  cached_power_t cached = cached_power_for(m_plus.e);
+  diyfp_t c = {cached.f, cached.e};
+  diyfp_t w_scaled = diyfp_mul(w, c);
+  diyfp_t minus_scaled = diyfp_mul(m_minus, c);
+  diyfp_t plus_scaled = diyfp_mul(m_plus, c);
+
+  // Shrink the interval by one unit on each side to absorb the rounding
+  // error of the multiplication
+  minus_scaled.f++;
+  plus_scaled.f--;
+
+  int len = 0;
+  *dec_exp = -cached.k;
+  grisu2_digit_gen(digits, &len, dec_exp, minus_scaled, w_scaled, plus_scaled);
+  return len;
+}
+
+// Grisu3's last-digit check: move the last digit towards w like
+// grisu2_round(), then succeed only if the digits are certainly the closest
+// to w and certainly inside the boundaries, given the scaling error unit
+static bool grisu3_round_weed(char *buf, int len, uint64_t dist_too_high_w, uint64_t unsafe_interval,
+                              uint64_t rest, uint64_t ten_k, uint64_t unit) {
+  uint64_t small_dist = dist_too_high_w - unit;
+  uint64_t big_dist = dist_too_high_w + unit;
+  while (rest < small_dist && unsafe_interval - rest >= ten_k &&
+         (rest + ten_k < small_dist || small_dist - rest >= rest + ten_k - small_dist)) {
+    buf[len - 1]--;
+    rest += ten_k;
+  }
+  // Another digit could be as close to w
+  if (rest < big_dist && unsafe_interval - rest >= ten_k &&
+      (rest + ten_k < big_dist || big_dist - rest > rest + ten_k - big_dist)) {
+    return false;
+  }
+  return 2 * unit <= rest && rest <= unsafe_interval - 4 * unit;
+}
+
+// Like grisu2_digit_gen(), but over the boundaries widened by the scaling
+// error: the first digits inside them are the shortest candidate, and
+// grisu3_round_weed() decides whether they are safe to use
+static bool grisu3_digit_gen(char *buf, int *len, int *dec_exp,
+                             diyfp_t low, diyfp_t w, diyfp_t high) {
+  uint64_t unit = 1;
+  diyfp_t too_low = {low.f - unit, low.e};
+  diyfp_t too_high = {high.f + unit, high.e};
+  uint64_t unsafe_interval = diyfp_sub(too_high, too_low).f;
+  uint64_t dist = diyfp_sub(too_high, w).f;
+
+  const int shift = -w.e;
+  const uint64_t one = 1ULL << shift;
+  uint32_t p1 = (uint32_t)(too_high.f >> shift);
+  uint64_t p2 = too_high.f & (one - 1);
+
+  uint32_t pow10;
+  int n = largest_pow10(p1, &pow10);
+  int length = 0;
+  while (n > 0) {
+    buf[length++] = (char)('0' + p1 / pow10);
+    p1 %= pow10;
+    n--;
+    uint64_t rest = ((uint64_t)p1 << shift) + p2;
+    if (rest < unsafe_interval) {
+      *dec_exp += n;
+      *len = length;
+      return grisu3_round_weed(buf, length, dist, unsafe_interval, rest, (uint64_t)pow10 << shift, unit);
+    }
+    pow10 /= 10;
+  }
+
+  int m = 0;
+  while (true) {
+    p2 *= 10;
+    unit *= 10;
+    unsafe_interval *= 10;
+    buf[length++] = (char)('0' + (p2 >> shift));
+    p2 &= one - 1;
+    m++;
+    if (p2 < unsafe_interval) {
+      *dec_exp -= m;
+      *len = length;
+      return grisu3_round_weed(buf, length, dist * unit, unsafe_interval, p2, one, unit);
+    }
+  }
+}
+
+// Shortest, closest digits of value (finite, > 0), or false for the few
+// values where Grisu3 cannot be sure; *len is then a lower bound on the
+// shortest length
+static bool grisu3(char *digits, int *len, int *dec_exp, double value) {
+  diyfp_t w, m_minus, m_plus;
+  compute_boundaries(value, &w, &m_minus, &m_plus);
+
+  cached_power_t cached = cached_power_for(m_plus.e);
+  diyfp_t c = {cached.f, cached.e};
+  *dec_exp = -cached.k;
+  return grisu3_digit_gen(digits, len, dec_exp, diyfp_mul(m_minus, c), diyfp_mul(w, c),
+                          diyfp_mul(m_plus, c));
+}
+
+// Exact fallback for grisu3(): printf rounds correctly, so the first
+// precision from min_len up whose text reads back as value gives the
+// shortest digits, and the closest ones of that length
+__attribute__((cold, noinline))
+static int shortest_by_printf(char *digits, int *dec_exp, double value, int min_len) {
+  char text[40];
+  int len = min_len < 1 ? 1 : min_len;
+  for (; len < 17; len++) {
+    snprintf(text, sizeof(text), "%.*e", len - 1, value);
+    if (strtod(text, NULL) == value) break;
+  }
+  snprintf(text, sizeof(text), "%.*e", len - 1, value);
+
+  // d.ddde[+-]x
+  digits[0] = text[0];
+  memcpy(digits + 1, text + 2, len - 1);
+  const char *exp = text + (len > 1 ? len + 1 : 1) + 1;
+  *dec_exp = atoi(exp) - (len - 1);
+  return len;
+}
+
+static const char DIGIT_PAIRS[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+char *json_format_uint(char *end, uint64_t value) {
+  while (value >= 100) {
+    unsigned pair = (unsigned)(value % 100) * 2;
+    value /= 100;
+    *--end = DIGIT_PAIRS[pair + 1];
+    *--end = DIGIT_PAIRS[pair];
+  }
+  if (value >= 10) {
+    unsigned pair = (unsigned)value * 2;
+    *--end = DIGIT_PAIRS[pair + 1];
+    *--end = DIGIT_PAIRS[pair];
+  } else {
+    *--end = (char)('0' + value);
+  }
+  return end;
+}
+
+// Lay out len digits with decimal point position point (value is
+// 0.d1d2... * 10^point) the way ECMAScript Number::toString does
+static size_t format_digits(char *out, const char *digits, int len, int point) {
+  char *p = out;
+  if (len <= point && point <= 21) {
+    // Integer: digits then zeros
+    memcpy(p, digits, len);
+    p += len;
+    memset(p, '0', point - len);
+    p += point - len;
+  } else if (0 < point && point <= 21) {
+    memcpy(p, digits, point);
+    p += point;
+    *p++ = '.';
+    memcpy(p, digits + point, len - point);
+    p += len - point;
+  } else if (-6 < point && point <= 0) {
+    *p++ = '0';
+    *p++ = '.';
+    memset(p, '0', -point);
+    p += -point;
+    memcpy(p, digits, len);
+    p += len;
+  } else {
+    *p++ = digits[0];
+    if (len > 1) {
+      *p++ = '.';
+      memcpy(p, digits + 1, len - 1);
+      p += len - 1;
+    }
+    int exp = point - 1;
+    *p++ = 'e';
+    *p++ = exp < 0 ? '-' : '+';
+    char text[4];
+    char *end = text + sizeof(text);
+    char *start = json_format_uint(end, (uint64_t)(exp < 0 ? -exp : exp));
+    memcpy(p, start, end - start);
+    p += end - start;
+  }
+  return (size_t)(p - out);
+}
+
+static inline size_t format_double(char *buf, double value, bool exact) {
+  if (!isfinite(value)) {
+    memcpy(buf, "null", 4);
+    return 4;
+  }
+
+  // Whole numbers exactly representable in a double
+  if (value >= -9007199254740992.0 && value <= 9007199254740992.0 &&
+      value == (double)(int64_t)value) {
+    int64_t integer = (int64_t)value;
+    uint64_t magnitude = integer < 0 ? 0 - (uint64_t)integer : (uint64_t)integer;
+    char text[24];
+    char *end = text + sizeof(text);
+    char *start = json_format_uint(end, magnitude);
+    if (integer < 0) *--start = '-';
+    memcpy(buf, start, end - start);
+    return (size_t)(end - start);
+  }
+
+  char *p = buf;
+  if (value < 0) {
+    *p++ = '-';
+    value = -value;
+  }
+  char digits[20];
+  int dec_exp;
+  int len;
+  if (!exact) {
+    len = grisu2(digits, &dec_exp, value);
+  } else if (!grisu3(digits, &len, &dec_exp, value)) {
+    len = shortest_by_printf(digits, &dec_exp, value, len);
+  }
+  return (size_t)(p - buf) + format_digits(p, digits, len, len + dec_exp);
+}
+
+size_t json_format_double(char *buf, double value) {
+  return format_double(buf, value, false);
+}
+
+size_t json_format_double_exact(char *buf, double value) {
+  return format_double(buf, value, true);
+}
@@ -0,0 +1,43 @@
+#include "../include/hash.h"
+
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+uint64_t json_hash_secret[4] = { JSON_HASH_P0, JSON_HASH_P1, JSON_HASH_P2, JSON_HASH_P3 };
+
+// Expand the seed with splitmix64 so every secret word is well mixed, even
+// for small seeds, and distinct from the others
+void json_hash_seed(uint64_t seed) {
+  for (int i = 0; i < 4; i++) {
+    uint64_t z = (seed += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    json_hash_secret[i] = z ^ (z >> 31);
+  }
+}
+
+// Seed the secret from the OS before main() so hashing never has to check it
+__attribute__((constructor, cold))
+static void json_hash_init_secret(void) {
+  uint64_t seed = 0;
+
+  FILE *urandom = fopen("/dev/urandom", "rb");
+  if (urandom) {
+    if (fread(&seed, sizeof(seed), 1, urandom) != 1) {
+      seed = 0;
+    }
+    fclose(urandom);
+  }
+
+  if (seed == 0) {
+    // Fallback: mix clock, pid and an ASLR address
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    seed = json_hash_mix((uint64_t)ts.tv_nsec ^ JSON_HASH_P0,
+                         (uint64_t)ts.tv_sec ^ ((uint64_t)getpid() << 32) ^
+                         (uint64_t)(uintptr_t)&seed);
+  }
+
+  json_hash_seed(seed);
+}
@@ -0,0 +1,133 @@
+#include "../include/intern.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define INTERN_MIN_CAP 256
+
+static intern_slots_t *intern_slots_create(size_t capacity) {
+  intern_slots_t *slots = calloc(1, sizeof(intern_slots_t) + capacity * sizeof(intern_entry_t));
+  if (slots) slots->capacity = capacity;
+  return slots;
+}
+
+__attribute__((cold))
+intern_table_t *intern_table_create(size_t max_entries) {
+  intern_table_t *table = malloc(sizeof(intern_table_t));
+  if (!table) return NULL;
+
+  table->slots = intern_slots_create(INTERN_MIN_CAP);
+  table->pool = pool_create();
+  if (!table->slots || !table->pool || pthread_mutex_init(&table->lock, NULL) != 0) {
+    free(table->slots);
+    if (table->pool) pool_destroy(table->pool);
+    free(table);
+    return NULL;
+  }
+
+  table->size = 0;
+  table->max_entries = max_entries;
+  return table;
+}
+
+__attribute__((cold))
+void intern_table_destroy(intern_table_t *table) {
+  if (!table) return;
+  pthread_mutex_destroy(&table->lock);
+  pool_destroy(table->pool);
+  for (intern_slots_t *slots = table->slots, *next; slots; slots = next) {
+    next = slots->retired;
+    free(slots);
+  }
+  free(table);
+}
+
+// Canonical string in slots for key, or NULL. Slots are never cleared or
+// rewritten once their string is set, so this needs no lock.
+static const char *intern_probe(const intern_slots_t *slots, const char *key, size_t len, uint32_t hash) {
+  size_t mask = slots->capacity - 1;
+  for (size_t pos = hash & mask;; pos = (pos + 1) & mask) {
+    const intern_entry_t *entry = &slots->entries[pos];
+    const char *str = __atomic_load_n(&entry->str, __ATOMIC_ACQUIRE);
+    if (!str) return NULL;
+    if (entry->hash == hash && entry->len == len && memcmp(str, key, len) == 0) {
+      return str;
+    }
+  }
+}
+
+// Empty slot where an absent key goes. Caller holds the lock.
+static intern_entry_t *intern_empty_slot(intern_slots_t *slots, uint32_t hash) {
+  size_t mask = slots->capacity - 1;
+  size_t pos = hash & mask;
+  while (slots->entries[pos].str) {
+    pos = (pos + 1) & mask;
+  }
+  return &slots->entries[pos];
+}
+
+// Copy into a slot array twice the size and publish it; hashes are stored,
+// so nothing is rehashed. The old array stays for readers still probing it.
+static bool intern_grow(intern_table_t *table) {
+  intern_slots_t *old = table->slots;
+  intern_slots_t *slots = intern_slots_create(old->capacity * 2);
+  if (!slots) return false;
+
+  for (size_t i = 0; i < old->capacity; i++) {
+    if (old->entries[i].str) {
+      *intern_empty_slot(slots, old->entries[i].hash) = old->entries[i];
+    }
+  }
+  slots->retired = old;
+  __atomic_store_n(&table->slots, slots, __ATOMIC_RELEASE);
+  return true;
+}
+
+const char *intern_table_lookup(intern_table_t *table, const char *key, size_t len, uint32_t hash) {
+  return intern_probe(__atomic_load_n(&table->slots, __ATOMIC_ACQUIRE), key, len, hash);
+}
+
+// Insert under the lock; another thread may have added the key since the
+// lock-free lookup missed
+static const char *intern_insert_locked(intern_table_t *table, const char *key, size_t len, uint32_t hash) {
+  const char *str = intern_probe(table->slots, key, len, hash);
+  if (str) {
+    return str;
+  }
+
+  if (table->max_entries && table->size >= table->max_entries) {
+    return NULL;
+  }
+
+  if ((table->size + 1) * 2 > table->slots->capacity && !intern_grow(table)) {
+    return NULL;
+  }
+
+  char *copy = pool_alloc(table->pool, len + 1);
+  if (!copy) return NULL;
+  memcpy(copy, key, len);
+  copy[len] = '\0';
+
+  // Fill the entry before publishing its string to readers
+  intern_entry_t *entry = intern_empty_slot(table->slots, hash);
+  entry->len = (uint32_t)len;
+  entry->hash = hash;
+  __atomic_store_n(&entry->str, copy, __ATOMIC_RELEASE);
+  __atomic_store_n(&table->size, table->size + 1, __ATOMIC_RELAXED);
+  return copy;
+}
+
+const char *intern_table_add(intern_table_t *table, const char *key, size_t len, uint32_t hash) {
+  if (len > UINT32_MAX) return NULL;  // entries hold 32-bit lengths
+  const char *str = intern_table_lookup(table, key, len, hash);
+  if (str) return str;
+
+  pthread_mutex_lock(&table->lock);
+  str = intern_insert_locked(table, key, len, hash);
+  pthread_mutex_unlock(&table->lock);
+  return str;
+}
+
+size_t intern_table_size(intern_table_t *table) {
+  return __atomic_load_n(&table->size, __ATOMIC_RELAXED);
+}
@@ -4,10 +4,10 @@
 int json_array_cmp(json_value_t *a, json_value_t *b) {
   if (!(a && b)) return -1;
   if (a->type != JSON_ARRAY || b->type != JSON_ARRAY) return -1;
-  if (a->array.len != b->array.len) return -1;
+  if (json_array_len(a) != json_array_len(b)) return -1;
   
-  for (int i = 0; i < a->array.len; i++) {
-    int res = json_value_cmp(&a->array.items[i], &b->array.items[i]);
+  for (int i = 0; i < json_array_len(a); i++) {
+    int res = json_value_cmp(&a->array->items[i], &b->array->items[i]);
     if (res != 0) {
       return res;
     }
@@ -18,21 +18,19 @@ int json_array_cmp(json_value_t *a, json_value_t *b) {
 
 int json_object_cmp(json_value_t *a, json_value_t *b) {
   if (a->type != JSON_OBJECT || b->type != JSON_OBJECT) return -1;
-  if (a->object.size != b->object.size) return -1;
+  if (json_object_size(a) != json_object_size(b)) return -1;
 
   // For each entry in a, check if it exists in b with the same value
-  for (size_t i = 0; i < a->object.capacity; i++) {
-    hash_bucket_t *bucket = &a->object.buckets[i];
-    for (size_t j = 0; j < bucket->len; j++) {
-      hash_entry_t *entry = &bucket->items[j];
-      // Look up the same key in b
-      json_value_t *b_val = hash_table_get(&b->object, entry->key, entry->key_len);
-      if (!b_val) return -1;  // Key not found in b
-
-      // Compare values
-      int res = json_value_cmp(&entry->value, b_val);
-      if (res != 0) return res;
-    }
+  json_object_iter_t it = json_object_iter(a);
+  for (hash_entry_t *entry; (entry = json_object_next(&it));) {
+    // Look up the same key in b
+    json_str_t key = hash_entry_key(entry);
+    json_value_t *b_val = hash_table_get_hashed(b->object, key.str, key.len, entry->hash);
+    if (!b_val) return -1;  // Key not found in b
+
+    // Compare values
+    int res = json_value_cmp(&entry->value, b_val);
+    if (res != 0) return res;
   }
 
   return 0;
@@ -48,8 +46,11 @@ int json_value_cmp(json_value_t *a, json_value_t *b) {
       return a->number - b->number;
     case JSON_BOOL:
       return a->boolean - b->boolean; 
-    case JSON_STRING:
-      return strcmp(a->string, b->string);
+    case JSON_STRING: {
+      json_str_t sa = json_get_str(a), sb = json_get_str(b);
+      int res = memcmp(sa.str, sb.str, sa.len < sb.len ? sa.len : sb.len);
+      return res ? res : (sa.len > sb.len) - (sa.len < sb.len);
+    }
     case JSON_ARRAY:
       return json_array_cmp(a, b);
     case JSON_OBJECT:
@@ -57,81 +58,255 @@ int json_value_cmp(json_value_t *a, json_value_t *b) {
   }
 }
 
+uint64_t json_span_generation = 0;
+
+// Touch a container edited through the json_object_* / json_array_* calls.
+// If it was still flagged, its path was never touched: retire every span.
+static inline void container_edited(json_value_t *value) {
+  if (value->flags & JSON_VALUE_SPAN) {
+    json_value_touch(value);
+    __atomic_add_fetch(&json_span_generation, 1, __ATOMIC_RELAXED);
+  }
+}
+
+// DOM storage comes from the pool when pooled is set and from the heap
+// otherwise. Pooled storage goes back to the pool's free lists, or is left
+// for pool_destroy() when no pool is given.
+static void *dom_alloc(bool pooled, mem_pool_t *pool, pool_category_t category,
+                       size_t size, size_t alignment) {
+  if (!pooled) return malloc(size);
+  if (!pool) return NULL;
+  void *ptr = pool_alloc_reuse(pool, size, alignment);
+  if (ptr) pool_account(pool, category, size);
+  return ptr;
+}
+
+static void dom_free(bool pooled, mem_pool_t *pool, pool_category_t category, void *ptr, size_t size) {
+  if (!pooled) {
+    free(ptr);
+  } else if (pool && ptr) {
+    pool_account_abandon(pool, category, size);
+    pool_free(pool, ptr, size);
+  }
+}
+
+// Largest capacity whose block fits the power-of-two size class holding
+// min_block bytes. Pooled arrays grow and shrink between these sizes, so
+// outgrown blocks land on a free list that later arrays draw from.
+static size_t json_array_class_cap(size_t min_block) {
+  size_t block = 64;
+  while (block < min_block) block <<= 1;
+  return (block - sizeof(json_array_t)) / sizeof(json_value_t);
+}
+
+// Move a pooled array block to storage for nsize elements
 static int json_array_resize(json_value_t *val, size_t nsize, mem_pool_t *pool) {
-  if (!val || !val->array.items) return -1;
+  if (!val || !val->array) return -1;
 
-  json_value_t *temp = pool_alloc(pool, nsize * sizeof(json_value_t));
+  json_array_t *temp = dom_alloc(true, pool, POOL_CAT_ARRAY, json_array_block_size(nsize), JSON_CONTAINER_ALIGN);
   if (!temp) return -1;
 
-  memcpy(temp, val->array.items, val->array.len * sizeof(json_value_t));
-  val->array.items = temp;
-  val->array.cap = nsize;
+  memcpy(temp, val->array, json_array_block_size(val->array->len));
+  dom_free(true, pool, POOL_CAT_ARRAY, val->array, json_array_block_size(val->array->cap));
+  val->array = temp;
+  val->array->cap = nsize;
   return 0;
 }
 
 json_value_t json_value_init(json_type_t type) {
   json_value_t val;
   val.type = type;
+  val.flags = 0;
   return val;
 }
 
+static void hash_table_release(hash_table_t *table, mem_pool_t *pool);
+
 void json_value_free(json_value_t *val) {
+  json_value_free_pooled(val, NULL);
+}
+
+void json_value_free_pooled(json_value_t *val, mem_pool_t *pool) {
   if (!val) return;
 
-  if (val->type == JSON_STRING) {
-    free(val->string);
+  bool pooled = val->flags & JSON_VALUE_POOLED;
+  if (val->type == JSON_STRING && !(val->flags & JSON_VALUE_INLINE)) {
+    if (val->string) {
+      dom_free(pooled, pool, POOL_CAT_STRING, val->string, val->string_len + 1);
+    }
     val->string = NULL;
   }
-  if (val->type == JSON_ARRAY) {
+  if (val->type == JSON_ARRAY && val->array) {
     // Free nested values in array
-    for (size_t i = 0; i < val->array.len; i++) {
-      json_value_free(&val->array.items[i]);
+    for (size_t i = 0; i < val->array->len; i++) {
+      json_value_free_pooled(&val->array->items[i], pool);
     }
-    free(val->array.items);
-    val->array.items = NULL;
+    dom_free(pooled, pool, POOL_CAT_ARRAY, val->array, json_array_block_size(val->array->cap));
+    val->array = NULL;
   }
-  if (val->type == JSON_OBJECT) {
-    // Free hash table entries (keys, values, and buckets)
-    hash_table_free_entries(&val->object);
+  if (val->type == JSON_OBJECT && val->object) {
+    // Free hash table entries (keys, values, and storage), then the header
+    hash_table_t *table = val->object;
+    bool table_pooled = table->flags & HASH_TABLE_POOLED;
+    hash_table_release(table, pool);
+    dom_free(table_pooled, pool, POOL_CAT_HASH, table, sizeof(hash_table_t));
+    val->object = NULL;
   }
   // Note: Do not free val itself, as it may be stack-allocated
 }
 
-// Initialize a hash table in-place (for embedded structs)
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define HASH_H1(hash) ((size_t)(hash) >> 7)
+#define HASH_H2(hash) ((uint8_t)((hash) & 0x7F))
+
+// Rounded to the pool's alignment so in-place growth is accounted exactly
+static inline size_t hash_table_alloc_size(uint32_t capacity) {
+  size_t size = hash_table_entries_size(capacity) + capacity * sizeof(uint32_t) + capacity + HASH_GROUP_WIDTH;
+  return (size + POOL_ALIGNMENT - 1) & ~(size_t)(POOL_ALIGNMENT - 1);
+}
+
+// Bitmask of group buckets whose control byte equals h2
+static inline uint32_t hash_group_match(const uint8_t *group, uint8_t h2) {
+#if defined(__SSE2__)
+  __m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+  return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)h2)));
+#else
+  uint32_t mask = 0;
+  for (int i = 0; i < HASH_GROUP_WIDTH; i++) {
+    mask |= (uint32_t)(group[i] == h2) << i;
+  }
+  return mask;
+#endif
+}
+
+static inline uint32_t hash_group_match_empty(const uint8_t *group) {
+  return hash_group_match(group, HASH_CTRL_EMPTY);
+}
+
+// EMPTY and DELETED both have the high bit set, full buckets never do
+static inline uint32_t hash_group_match_empty_or_deleted(const uint8_t *group) {
+#if defined(__SSE2__)
+  return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)group));
+#else
+  uint32_t mask = 0;
+  for (int i = 0; i < HASH_GROUP_WIDTH; i++) {
+    mask |= (uint32_t)(group[i] >> 7) << i;
+  }
+  return mask;
+#endif
+}
+
+// Write a control byte and keep the mirrored tail in sync. Tables smaller
+// than a group repeat their control bytes across the whole tail.
+static inline void hash_set_ctrl(hash_table_t *table, size_t i, uint8_t value) {
+  uint8_t *ctrl = hash_table_ctrl(table);
+  ctrl[i] = value;
+  for (size_t mirror = i + table->capacity; mirror < table->capacity + HASH_GROUP_WIDTH;
+       mirror += table->capacity) {
+    ctrl[mirror] = value;
+  }
+}
+
+// First EMPTY or DELETED bucket on the probe sequence for hash
+static size_t hash_find_first_non_full(const hash_table_t *table, uint32_t hash) {
+  const uint8_t *ctrl = hash_table_ctrl(table);
+  size_t mask = table->capacity - 1;
+  size_t pos = HASH_H1(hash) & mask;
+  size_t step = 0;
+
+  while (true) {
+    uint32_t m = hash_group_match_empty_or_deleted(ctrl + pos);
+    if (m) {
+      return (pos + __builtin_ctz(m)) & mask;
+    }
+    step += HASH_GROUP_WIDTH;
+    pos = (pos + step) & mask;
+  }
+}
+
+// Whether a live entry with key's length holds key. Inline keys are
+// NUL-padded to a word, so one compare decides; interned keys match by
+// pointer.
+static inline bool hash_entry_matches(const hash_entry_t *entry, const char *key, size_t key_len, uint32_t hash) {
+  if (hash_key_fits_inline(key_len)) {
+    uint64_t stored, wanted = 0;
+    memcpy(&stored, entry->key_inline, sizeof(stored));
+    memcpy(&wanted, key, key_len);
+    return stored == wanted;
+  }
+  return entry->key == key || (entry->hash == hash && memcmp(entry->key, key, key_len) == 0);
+}
+
+// Bucket index slot of key, or NULL
+static uint32_t *hash_table_find_index(const hash_table_t *table, const char *key, size_t key_len, uint32_t hash) {
+  if (!table || !table->entries) return NULL;
+
+  const uint8_t *ctrl = hash_table_ctrl(table);
+  uint32_t *index = hash_table_index(table);
+  size_t mask = table->capacity - 1;
+  size_t pos = HASH_H1(hash) & mask;
+  size_t step = 0;
+  uint8_t h2 = HASH_H2(hash);
+
+  while (true) {
+    const uint8_t *group = ctrl + pos;
+    uint32_t m = hash_group_match(group, h2);
+    while (m) {
+      uint32_t *slot = &index[(pos + __builtin_ctz(m)) & mask];
+      hash_entry_t *entry = &table->entries[*slot];
+      if (hash_entry_key_len(entry) == key_len && hash_entry_matches(entry, key, key_len, hash)) {
+        return slot;
+      }
+      m &= m - 1;
+    }
+    if (hash_group_match_empty(group)) {
+      return NULL;
+    }
+    step += HASH_GROUP_WIDTH;
+    pos = (pos + step) & mask;
+  }
+}
+
+static inline hash_entry_t *hash_table_find(const hash_table_t *table, const char *key, size_t key_len,
+                                            uint32_t hash) {
+  uint32_t *slot = hash_table_find_index(table, key, key_len, hash);
+  return slot ? &table->entries[*slot] : NULL;
+}
+
+// Initialize a hash table in-place (for embedded structs). A zero size hint
+// gets the default capacity; otherwise the table is sized to hold
+// initial_size entries without resizing.
 int hash_table_init_inplace(hash_table_t *table, size_t initial_size, mem_pool_t *pool) {
   if (!table) return -1;
 
-  size_t capacity = 16;
-  while (capacity < initial_size) {
+  uint32_t capacity = initial_size == 0 ? HASH_TABLE_MIN_CAP : 2;
+  while (hash_capacity_to_growth(capacity) < initial_size) {
     capacity <<= 1;
   }
 
-  table->buckets = pool_alloc(pool, capacity * sizeof(hash_bucket_t));
-  if (!table->buckets) {
+  table->flags = pool ? HASH_TABLE_POOLED : 0;
+  table->entries = dom_alloc(pool != NULL, pool, POOL_CAT_HASH, hash_table_alloc_size(capacity),
+                             JSON_CONTAINER_ALIGN);
+  if (!table->entries) {
     return -1;
   }
-  memset(table->buckets, 0, capacity * sizeof(hash_bucket_t));
-
   table->capacity = capacity;
+  memset(hash_table_ctrl(table), HASH_CTRL_EMPTY, capacity + HASH_GROUP_WIDTH);
+
   table->size = 0;
+  table->growth_left = hash_capacity_to_growth(capacity);
   return 0;
 }
 
-// Allocate and initialize a hash table on heap
-// Note: This function is deprecated and not used with memory pools
+// Allocate and initialize a hash table on heap, as json_value_object() does
 hash_table_t *hash_table_init(size_t initial_size) {
   hash_table_t *table = (hash_table_t *)malloc(sizeof(hash_table_t));
   if (!table) return NULL;
 
-  // Create a temporary pool for this table (not recommended)
-  mem_pool_t *pool = pool_create();
-  if (!pool) {
-    free(table);
-    return NULL;
-  }
-
-  if (hash_table_init_inplace(table, initial_size, pool) != 0) {
-    pool_destroy(pool);
+  if (hash_table_init_inplace(table, initial_size, NULL) != 0) {
     free(table);
     return NULL;
   }
@@ -139,24 +314,36 @@ hash_table_t *hash_table_init(size_t initial_size) {
   return table;
 }
 
-// Free only entries and buckets (for embedded structs)
-void hash_table_free_entries(hash_table_t *table) {
-  if (!table || !table->buckets) return;
-
-  for (size_t i = 0; i < table->capacity; i++) {
-    hash_bucket_t *bucket = &table->buckets[i];
-    for (size_t j = 0; j < bucket->len; j++) {
-      hash_entry_t *entry = &bucket->items[j];
-      free(entry->key);
-      json_value_free(&entry->value);  // Free nested content (value is embedded)
-    }
-    free(bucket->items);  // Free the bucket's items array
+// Release an entry's key unless it is inline or borrowed
+static inline void hash_entry_release_key(hash_table_t *table, hash_entry_t *entry, mem_pool_t *pool) {
+  if (!hash_key_fits_inline(entry->key_len) && !(entry->key_len & HASH_KEY_BORROWED)) {
+    dom_free(table->flags & HASH_TABLE_POOLED, pool, POOL_CAT_KEY, entry->key, entry->key_len + 1);
+  }
+}
+
+// Free entries and their storage, returning pooled storage to pool if given
+static void hash_table_release(hash_table_t *table, mem_pool_t *pool) {
+  if (!table || !table->entries) return;
+
+  uint32_t used = hash_table_used(table);
+  for (uint32_t i = 0; i < used; i++) {
+    hash_entry_t *entry = &table->entries[i];
+    if (!hash_entry_live(entry)) continue;
+    hash_entry_release_key(table, entry, pool);
+    json_value_free_pooled(&entry->value, pool);  // Free nested content (value is embedded)
   }
 
-  free(table->buckets);
-  table->buckets = NULL;
+  dom_free(table->flags & HASH_TABLE_POOLED, pool, POOL_CAT_HASH, table->entries,
+           hash_table_alloc_size(table->capacity));
+  table->entries = NULL;
   table->size = 0;
   table->capacity = 0;
+  table->growth_left = 0;
+}
+
+// Free only entries and their storage (for embedded structs)
+void hash_table_free_entries(hash_table_t *table) {
+  hash_table_release(table, NULL);
 }
 
 // Free entire hash table (for heap-allocated tables)
@@ -166,188 +353,274 @@ void hash_table_free(hash_table_t *table) {
   free(table);
 }
 
-#define HASH_TABLE_LOAD_FACTOR 0.75f
+// Slide live entries over the holes left by deletes, keeping their order
+static void hash_table_compact(hash_table_t *table) {
+  uint32_t used = hash_table_used(table);
+  if (used == table->size) return;
 
-// Resize hash table when load factor exceeded
-static int hash_table_resize(hash_table_t *table, mem_pool_t *pool) {
-  size_t new_capacity = table->capacity * 2;
-  hash_bucket_t *new_buckets = pool_alloc(pool, new_capacity * sizeof(hash_bucket_t));
-  if (!new_buckets) return -1;
-  memset(new_buckets, 0, new_capacity * sizeof(hash_bucket_t));
-
-  // Rehash all entries from old buckets to new buckets
-  for (size_t i = 0; i < table->capacity; i++) {
-    hash_bucket_t *bucket = &table->buckets[i];
-    for (size_t j = 0; j < bucket->len; j++) {
-      hash_entry_t *entry = &bucket->items[j];
-
-      // Calculate new bucket index
-      uint32_t hash = hash_string(entry->key, entry->key_len);
-      size_t new_index = hash & (new_capacity - 1);
-
-      // Insert into new bucket (grow array if needed)
-      hash_bucket_t *new_bucket = &new_buckets[new_index];
-      if (new_bucket->len >= new_bucket->cap) {
-        size_t new_cap = new_bucket->cap == 0 ? 2 : new_bucket->cap * 2;
-        hash_entry_t *new_items = pool_alloc(pool, new_cap * sizeof(hash_entry_t));
-        if (!new_items) {
-          return -1;
-        }
-        if (new_bucket->items) {
-          memcpy(new_items, new_bucket->items, new_bucket->len * sizeof(hash_entry_t));
-        }
-        new_bucket->items = new_items;
-        new_bucket->cap = new_cap;
-      }
-      new_bucket->items[new_bucket->len++] = *entry;  // copy entry (key pointer + value)
+  uint32_t live = 0;
+  for (uint32_t i = 0; i < used; i++) {
+    if (hash_entry_live(&table->entries[i])) {
+      table->entries[live++] = table->entries[i];
     }
   }
+}
 
-  table->buckets = new_buckets;
-  table->capacity = new_capacity;
+// Index the first size entries from scratch, dropping every tombstone.
+// Keys are known to be unique.
+static void hash_table_rebuild_index(hash_table_t *table) {
+  uint8_t *ctrl = hash_table_ctrl(table);
+  uint32_t *index = hash_table_index(table);
+  memset(ctrl, HASH_CTRL_EMPTY, table->capacity + HASH_GROUP_WIDTH);
+
+  for (uint32_t i = 0; i < table->size; i++) {
+    uint32_t hash = table->entries[i].hash;
+    size_t bucket = hash_find_first_non_full(table, hash);
+    hash_set_ctrl(table, bucket, HASH_H2(hash));
+    index[bucket] = i;
+  }
+  table->growth_left = hash_capacity_to_growth(table->capacity) - table->size;
+}
 
+// Grow to new_capacity, in place when the table is the pool's last allocation
+static int hash_table_grow(hash_table_t *table, uint32_t new_capacity, mem_pool_t *pool) {
+  uint32_t old_capacity = table->capacity;
+  bool pooled = table->flags & HASH_TABLE_POOLED;
+
+  // Entries stay at the front, so only the index and control bytes move
+  if (pooled && pool_extend(pool, table->entries, hash_table_alloc_size(old_capacity),
+                            hash_table_alloc_size(new_capacity))) {
+    pool_account(pool, POOL_CAT_HASH, hash_table_alloc_size(new_capacity) - hash_table_alloc_size(old_capacity));
+    hash_table_compact(table);
+    table->capacity = new_capacity;
+    hash_table_rebuild_index(table);
+    return 0;
+  }
+
+  hash_table_t grown;
+  grown.entries = dom_alloc(pooled, pool, POOL_CAT_HASH, hash_table_alloc_size(new_capacity),
+                            JSON_CONTAINER_ALIGN);
+  if (!grown.entries) return -1;
+  grown.capacity = new_capacity;
+  grown.size = table->size;
+  grown.flags = table->flags;
+
+  uint32_t used = hash_table_used(table);
+  uint32_t live = 0;
+  for (uint32_t i = 0; i < used; i++) {
+    if (hash_entry_live(&table->entries[i])) {
+      grown.entries[live++] = table->entries[i];
+    }
+  }
+  hash_table_rebuild_index(&grown);
+
+  dom_free(pooled, pool, POOL_CAT_HASH, table->entries, hash_table_alloc_size(old_capacity));
+  *table = grown;
   return 0;
 }
 
-int hash_table_insert(hash_table_t *table, const char *key, size_t key_len, json_value_t value, mem_pool_t *pool) {
-  if ((float)table->size / table->capacity >= HASH_TABLE_LOAD_FACTOR) {
-    if (hash_table_resize(table, pool) != 0) {
-      return -1;
-    }
+// Out of room to append: squeeze out holes, or grow if that frees too little
+static int hash_table_resize(hash_table_t *table, mem_pool_t *pool) {
+  // Compacting leaves at least a quarter of the entries free
+  uint32_t growth = hash_capacity_to_growth(table->capacity);
+  if (table->size <= growth - growth / 4 && table->size < growth) {
+    hash_table_compact(table);
+    hash_table_rebuild_index(table);
+    return 0;
+  }
+  return hash_table_grow(table, table->capacity * 2, pool);
+}
+
+int hash_table_reserve(hash_table_t *table, size_t count, mem_pool_t *pool) {
+  uint32_t capacity = table->capacity;
+  while (hash_capacity_to_growth(capacity) < count) {
+    capacity <<= 1;
+  }
+  if (capacity != table->capacity) {
+    return hash_table_grow(table, capacity, pool);
+  }
+  // Holes count against growth; drop them if they are in the way
+  if (count > table->size && table->growth_left < count - table->size) {
+    hash_table_compact(table);
+    hash_table_rebuild_index(table);
   }
+  return 0;
+}
 
-  uint32_t hash = hash_string(key, key_len);
-  size_t index = hash & (table->capacity - 1);
+int hash_table_insert(hash_table_t *table, const char *key, size_t key_len, json_value_t value, mem_pool_t *pool) {
+  return hash_table_insert_hashed(table, key, key_len, hash_string(key, key_len), value, pool);
+}
 
-  hash_bucket_t *bucket = &table->buckets[index];
+static int hash_table_insert_entry(hash_table_t *table, const char *key, size_t key_len, uint32_t hash,
+                                   json_value_t value, mem_pool_t *pool, bool copy_key) {
+  if (key_len > HASH_KEY_LEN_MAX) {
+    return -1;
+  }
 
   // Check for duplicate key
-  for (size_t i = 0; i < bucket->len; i++) {
-    if (bucket->items[i].key_len == key_len &&
-        memcmp(bucket->items[i].key, key, key_len) == 0) {
-      return 1;  // Duplicate key found
-    }
+  if (hash_table_find(table, key, key_len, hash)) {
+    return 1;  // Duplicate key found
   }
 
-  // Grow bucket array if needed
-  if (bucket->len >= bucket->cap) {
-    size_t new_cap = bucket->cap == 0 ? 2 : bucket->cap * 2;
-    hash_entry_t *new_items = pool_alloc(pool, new_cap * sizeof(hash_entry_t));
-    if (!new_items) return -1;
-    if (bucket->items) {
-      memcpy(new_items, bucket->items, bucket->len * sizeof(hash_entry_t));
-    }
-    bucket->items = new_items;
-    bucket->cap = new_cap;
+  if (table->growth_left == 0 && hash_table_resize(table, pool) != 0) {
+    return -1;
   }
 
-  // Allocate and copy key
-  char *key_copy = pool_alloc(pool, key_len + 1);
-  if (!key_copy) return -1;
-  memcpy(key_copy, key, key_len);
-  key_copy[key_len] = '\0';
+  // Allocate and copy key; interned keys are borrowed as-is and marked so
+  // only this entry's key is left unfreed
+  char *stored_key = (char *)key;
+  uint32_t stored_len = (uint32_t)key_len;
+  if (hash_key_fits_inline(key_len)) {
+    stored_key = NULL;
+  } else if (copy_key) {
+    stored_key = dom_alloc(table->flags & HASH_TABLE_POOLED, pool, POOL_CAT_KEY, key_len + 1, POOL_ALIGNMENT);
+    if (!stored_key) return -1;
+    memcpy(stored_key, key, key_len);
+    stored_key[key_len] = '\0';
+  } else {
+    stored_len |= HASH_KEY_BORROWED;
+  }
 
-  // Add entry to bucket
-  hash_entry_t *entry = &bucket->items[bucket->len++];
-  entry->key = key_copy;
-  entry->key_len = key_len;
+  // Append the entry; a tombstone bucket can be reused for its index
+  uint32_t position = hash_table_used(table);
+  size_t bucket = hash_find_first_non_full(table, hash);
+  hash_set_ctrl(table, bucket, HASH_H2(hash));
+  hash_table_index(table)[bucket] = position;
+  table->growth_left--;
+
+  hash_entry_t *entry = &table->entries[position];
+  entry->key = stored_key;
+  if (!stored_key) {
+    memcpy(entry->key_inline, key, key_len);
+    entry->key_inline[key_len] = '\0';
+  }
+  entry->key_len = stored_len;
+  entry->hash = hash;
   entry->value = value;  // copy by value
 
   table->size++;
   return 0;
 }
 
+int hash_table_insert_hashed(hash_table_t *table, const char *key, size_t key_len, uint32_t hash,
+                             json_value_t value, mem_pool_t *pool) {
+  return hash_table_insert_entry(table, key, key_len, hash, value, pool, true);
+}
+
+int hash_table_insert_interned(hash_table_t *table, const char *key, size_t key_len, uint32_t hash,
+                               json_value_t value, mem_pool_t *pool) {
+  return hash_table_insert_entry(table, key, key_len, hash, value, pool, false);
+}
+
 // Pooled version (for parser use)
-void json_object_set_pooled(json_value_t *obj, char *key, json_value_t val, mem_pool_t *pool) {
-  if (obj->type != JSON_OBJECT) return;
+int json_object_set_pooled(json_value_t *obj, char *key, json_value_t val, mem_pool_t *pool) {
+  if (obj->type != JSON_OBJECT) return -1;
+  container_edited(obj);
 
   size_t key_len = strlen(key);
 
   // Check if key already exists
-  json_value_t *existing = hash_table_get(&obj->object, key, key_len);
+  json_value_t *existing = hash_table_get(obj->object, key, key_len);
   if (existing) {
-    // Update existing value
-    json_value_free(existing);
+    // Update existing value; the old one's storage is reused
+    json_value_free_pooled(existing, pool);
     *existing = val;
-    return;
+    return 0;
   }
 
   // Insert into hash table (key is copied, value is copied by value)
-  hash_table_insert(&obj->object, key, key_len, val, pool);
+  return hash_table_insert(obj->object, key, key_len, val, pool) == 0 ? 0 : -1;
 }
 
 // Public API version (uses malloc)
-void json_object_set(json_value_t *obj, char *key, json_value_t val) {
-  if (obj->type != JSON_OBJECT) return;
+int json_object_set(json_value_t *obj, char *key, json_value_t val) {
+  if (obj->type != JSON_OBJECT) {
+    free(key);
+    return -1;
+  }
+  container_edited(obj);
 
   size_t key_len = strlen(key);
 
   // Check if key already exists
-  json_value_t *existing = hash_table_get(&obj->object, key, key_len);
+  json_value_t *existing = hash_table_get(obj->object, key, key_len);
   if (existing) {
     // Update existing value
     json_value_free(existing);
     *existing = val;
     free(key);  // Free the duplicate key
-    return;
+    return 0;
   }
 
-  // Create a temporary pool for this operation (not ideal, but maintains API)
-  mem_pool_t *temp_pool = pool_create();
-  if (!temp_pool) return;
-
-  // Insert into hash table (key is copied, value is copied by value)
-  hash_table_insert(&obj->object, key, key_len, val, temp_pool);
+  // Insert into hash table (key is copied, value is copied by value). A
+  // pooled table cannot grow or copy keys without its pool.
+  int res = hash_table_insert(obj->object, key, key_len, val, NULL);
   free(key);  // hash_table_insert copies the key
-  // Note: We don't destroy the pool as the hash table now owns the allocated memory
+  return res == 0 ? 0 : -1;
 }
 
 json_value_t *hash_table_get(hash_table_t *table, const char *key, size_t key_len) {
-  uint32_t hash = hash_string(key, key_len);
-  size_t index = hash & (table->capacity - 1);
-
-  hash_bucket_t *bucket = &table->buckets[index];
-  for (size_t i = 0; i < bucket->len; i++) {
-    hash_entry_t *entry = &bucket->items[i];
-    if (entry->key_len == key_len && memcmp(entry->key, key, key_len) == 0) {
-      return &entry->value;  // return pointer to embedded value
-    }
-  }
+  return hash_table_get_hashed(table, key, key_len, hash_string(key, key_len));
+}
 
-  return NULL;
+json_value_t *hash_table_get_hashed(hash_table_t *table, const char *key, size_t key_len, uint32_t hash) {
+  hash_entry_t *entry = hash_table_find(table, key, key_len, hash);
+  return entry ? &entry->value : NULL;  // return pointer to embedded value
 }
 
 int hash_table_delete(hash_table_t *table, const char *key, size_t key_len) {
-  uint32_t hash = hash_string(key, key_len);
-  size_t index = hash & (table->capacity - 1);
+  return hash_table_delete_pooled(table, key, key_len, NULL);
+}
 
-  hash_bucket_t *bucket = &table->buckets[index];
+int hash_table_delete_pooled(hash_table_t *table, const char *key, size_t key_len, mem_pool_t *pool) {
+  uint32_t *slot = hash_table_find_index(table, key, key_len, hash_string(key, key_len));
+  if (!slot) {
+    return -1;  // Key not found
+  }
 
-  for (size_t i = 0; i < bucket->len; i++) {
-    hash_entry_t *entry = &bucket->items[i];
-    if (entry->key_len == key_len && memcmp(entry->key, key, key_len) == 0) {
-      // Free the entry's data
-      free(entry->key);
-      json_value_free(&entry->value);
+  // Free the entry's data and leave a hole in the insertion order
+  hash_entry_t *entry = &table->entries[*slot];
+  hash_entry_release_key(table, entry, pool);
+  json_value_free_pooled(&entry->value, pool);
+  entry->key = NULL;
+  entry->key_len = 0;
+
+  size_t mask = table->capacity - 1;
+  size_t index = slot - hash_table_index(table);
+  const uint8_t *ctrl = hash_table_ctrl(table);
+
+  // If no probe window around this bucket was ever full, lookups could not
+  // have continued past it, so the bucket can go straight back to EMPTY. A
+  // table smaller than a group is always probed in one load and keeps an
+  // empty bucket.
+  bool was_never_full = table->capacity < HASH_GROUP_WIDTH;
+  if (!was_never_full) {
+    uint32_t empty_before = hash_group_match_empty(ctrl + ((index - HASH_GROUP_WIDTH) & mask));
+    uint32_t empty_after = hash_group_match_empty(ctrl + index);
+    was_never_full = empty_before && empty_after &&
+        (size_t)(__builtin_ctz(empty_after) + __builtin_clz(empty_before) - 16) < HASH_GROUP_WIDTH;
+  }
 
-      // Move last entry to this position (swap-remove)
-      if (i < bucket->len - 1) {
-        bucket->items[i] = bucket->items[bucket->len - 1];
-      }
-      bucket->len--;
-      table->size--;
-      return 0;
+  if (was_never_full) {
+    hash_set_ctrl(table, index, HASH_CTRL_EMPTY);
+    // The last entry can be taken back. A tombstone must keep its entry
+    // counted, so that full and deleted buckets never outnumber the growth
+    // limit and probing always reaches an empty bucket.
+    if (*slot == hash_table_used(table) - 1) {
+      table->growth_left++;
     }
+  } else {
+    hash_set_ctrl(table, index, HASH_CTRL_DELETED);
   }
-
-  return -1;  // Key not found
+  table->size--;
+  return 0;
 }
 
 json_value_t json_object_get(json_value_t *obj, char *key) {
   if (obj->type != JSON_OBJECT) return json_value_init(JSON_NULL);
 
   size_t key_len = strlen(key);
-  json_value_t *result = hash_table_get(&obj->object, key, key_len);
+  json_value_t *result = hash_table_get(obj->object, key, key_len);
 
   if (result) {
     return *result;
@@ -357,75 +630,165 @@ json_value_t json_object_get(json_value_t *obj, char *key) {
 }
 
 int json_object_delete(json_value_t *obj, char *key) {
+  return json_object_delete_pooled(obj, key, NULL);
+}
+
+int json_object_delete_pooled(json_value_t *obj, char *key, mem_pool_t *pool) {
   if (obj->type != JSON_OBJECT) return -1;
+  container_edited(obj);
   size_t key_len = strlen(key);
-  return hash_table_delete(&obj->object, key, key_len);
+  return hash_table_delete_pooled(obj->object, key, key_len, pool);
 }
 
 size_t json_object_size(json_value_t *obj) {
   if (obj->type != JSON_OBJECT) return 0;
-  return obj->object.size;
+  return obj->object ? obj->object->size : 0;
 }
 
 int json_object_has(json_value_t *obj, char *key) {
   if (obj->type != JSON_OBJECT) return 0;
   size_t key_len = strlen(key);
-  return hash_table_get(&obj->object, key, key_len) != NULL;
+  return hash_table_get(obj->object, key, key_len) != NULL;
+}
+
+json_value_t json_object_get_key(json_value_t *obj, json_key_t key) {
+  if (obj->type != JSON_OBJECT) return json_value_init(JSON_NULL);
+
+  json_value_t *result = hash_table_get_hashed(obj->object, key.str, key.len, key.hash);
+  return result ? *result : json_value_init(JSON_NULL);
+}
+
+int json_object_has_key(json_value_t *obj, json_key_t key) {
+  if (obj->type != JSON_OBJECT) return 0;
+  return hash_table_get_hashed(obj->object, key.str, key.len, key.hash) != NULL;
+}
+
+json_value_t *json_object_edit(json_value_t *obj, const char *key) {
+  if (obj->type != JSON_OBJECT) return NULL;
+  json_value_t *member = hash_table_get(obj->object, key, strlen(key));
+  if (member) {
+    json_value_touch(obj);
+    json_value_touch(member);
+  }
+  return member;
 }
 
 /*
  * TODO: For robust object operation, following functions can be added:
  * json_object_clear(json_value_t *obj)
- * json_object_keys(json_value_t *obj)
  */
 
 // Pooled version (for parser use)
-void json_array_push_pooled(json_value_t *arr, json_value_t val, mem_pool_t *pool) {
-  if ((float)arr->array.len >= (float)arr->array.cap * 0.75) {
-    size_t new_cap = arr->array.cap * 2;
-    json_value_t *new_items = pool_alloc(pool, new_cap * sizeof(json_value_t));
-    if (!new_items) {
-      return;
+int json_array_push_pooled(json_value_t *arr, json_value_t val, mem_pool_t *pool) {
+  container_edited(arr);
+  if (!(arr->flags & JSON_VALUE_POOLED)) {
+    return json_array_push(arr, val);
+  }
+
+  if ((float)arr->array->len >= (float)arr->array->cap * 0.75) {
+    if (json_array_resize(arr, json_array_class_cap(json_array_block_size(arr->array->cap) + 1), pool) != 0) {
+      return -1;
     }
-    memcpy(new_items, arr->array.items, arr->array.len * sizeof(json_value_t));
-    arr->array.items = new_items;
-    arr->array.cap = new_cap;
   }
 
-  arr->array.items[arr->array.len++] = val;
+  arr->array->items[arr->array->len++] = val;
+  return 0;
 }
 
 // Public API version (uses realloc)
-void json_array_push(json_value_t *arr, json_value_t val) {
-  if ((float)arr->array.len >= (float)arr->array.cap * 0.75) {
-    size_t new_cap = arr->array.cap * 2;
-    json_value_t *new_items = realloc(arr->array.items, new_cap * sizeof(json_value_t));
-    if (!new_items) {
-      return;
+int json_array_push(json_value_t *arr, json_value_t val) {
+  if (arr->type != JSON_ARRAY || !arr->array) return -1;
+  container_edited(arr);
+  if ((float)arr->array->len >= (float)arr->array->cap * 0.75) {
+    if (arr->flags & JSON_VALUE_POOLED) {
+      // Pool storage must not reach realloc; use the spare capacity, then
+      // leave growing to json_array_push_pooled()
+      if (arr->array->len == arr->array->cap) return -1;
+    } else {
+      size_t new_cap = arr->array->cap * 2;
+      json_array_t *grown = realloc(arr->array, json_array_block_size(new_cap));
+      if (!grown) {
+        return -1;
+      }
+      arr->array = grown;
+      arr->array->cap = new_cap;
     }
-    arr->array.items = new_items;
-    arr->array.cap = new_cap;
   }
 
-  arr->array.items[arr->array.len++] = val;
+  arr->array->items[arr->array->len++] = val;
+  return 0;
 }
 
 int json_array_pop(json_value_t *arr) {
-  if (!arr || arr->type != JSON_ARRAY || arr->array.len == 0 ||
-      !arr->array.items)
+  if (!arr || json_array_len(arr) == 0)
     return -1;
 
-  arr->array.len--;
+  container_edited(arr);
+  arr->array->len--;
+
+  // Note: popped values are not freed and storage is never shrunk; use
+  // json_array_pop_pooled() to reclaim pooled memory
+
+  return 0;
+}
+
+int json_array_pop_pooled(json_value_t *arr, mem_pool_t *pool) {
+  if (!arr || json_array_len(arr) == 0)
+    return -1;
 
-  // Note: We don't resize down when using memory pool since
-  // the pool doesn't support deallocation
+  container_edited(arr);
+  json_value_free_pooled(&arr->array->items[--arr->array->len], pool);
 
+  // Halve at a quarter full, so push/pop at the boundary cannot thrash
+  if ((arr->flags & JSON_VALUE_POOLED) && arr->array->cap > ARRAY_MIN_CAP &&
+      arr->array->len <= arr->array->cap / 4) {
+    size_t half = json_array_class_cap(json_array_block_size(arr->array->cap) / 2);
+    if (half >= ARRAY_MIN_CAP) json_array_resize(arr, half, pool);
+  }
   return 0;
 }
 
+json_value_t *json_array_edit(json_value_t *arr, size_t index) {
+  json_value_t *element = json_array_at(arr, index);
+  if (element) {
+    json_value_touch(arr);
+    json_value_touch(element);
+  }
+  return element;
+}
+
 json_value_t json_value_string(char *str) {
   json_value_t val = json_value_init(JSON_STRING);
+  size_t len = str ? strlen(str) : 0;
+  if (len > JSON_STRING_LEN_MAX) {
+    free(str);
+    return json_value_init(JSON_NULL);
+  }
   val.string = str;
+  val.string_len = (uint32_t)len;
+  return val;
+}
+
+json_value_t json_value_string_n(const char *str, size_t len, mem_pool_t *pool) {
+  if (len > JSON_STRING_LEN_MAX) return json_value_init(JSON_NULL);
+  json_value_t val = json_value_init(JSON_STRING);
+  if (len <= JSON_INLINE_MAX) {
+    char *chars = (char *)&val + offsetof(json_value_t, inline_chars);
+    val.flags = JSON_VALUE_INLINE;
+    val.inline_len = (uint8_t)len;
+    memcpy(chars, str, len);
+    chars[len] = '\0';
+    return val;
+  }
+
+  // Through the free lists, so space from freed strings is used again
+  char *copy = dom_alloc(pool != NULL, pool, POOL_CAT_STRING, len + 1, POOL_ALIGNMENT);
+  if (!copy) return json_value_init(JSON_NULL);
+  memcpy(copy, str, len);
+  copy[len] = '\0';
+  val.flags = pool ? JSON_VALUE_POOLED : 0;
+  val.string = copy;
+  val.string_len = (uint32_t)len;
   return val;
 }
 
@@ -446,15 +809,22 @@ json_value_t json_value_array_pooled(size_t size, mem_pool_t *pool) {
   json_value_t val = json_value_init(JSON_ARRAY);
   // Ensure minimum capacity of ARRAY_MIN_CAP
   size_t cap = size < ARRAY_MIN_CAP ? ARRAY_MIN_CAP : size;
-  val.array.items = pool_alloc(pool, sizeof(json_value_t) * cap);
-  val.array.len = 0;
-  val.array.cap = cap;
+  val.flags = JSON_VALUE_POOLED;
+  val.array = dom_alloc(true, pool, POOL_CAT_ARRAY, json_array_block_size(cap), JSON_CONTAINER_ALIGN);
+  if (val.array) {
+    val.array->len = 0;
+    val.array->cap = cap;
+  }
   return val;
 }
 
 json_value_t json_value_object_pooled(size_t size, mem_pool_t *pool) {
   json_value_t val = json_value_init(JSON_OBJECT);
-  hash_table_init_inplace(&val.object, size, pool);
+  val.object = dom_alloc(true, pool, POOL_CAT_HASH, sizeof(hash_table_t), POOL_ALIGNMENT);
+  if (val.object && hash_table_init_inplace(val.object, size, pool) != 0) {
+    dom_free(true, pool, POOL_CAT_HASH, val.object, sizeof(hash_table_t));
+    val.object = NULL;
+  }
   return val;
 }
 
@@ -463,20 +833,16 @@ json_value_t json_value_array(size_t size) {
   json_value_t val = json_value_init(JSON_ARRAY);
   // Ensure minimum capacity of ARRAY_MIN_CAP
   size_t cap = size < ARRAY_MIN_CAP ? ARRAY_MIN_CAP : size;
-  val.array.items = malloc(sizeof(json_value_t) * cap);
-  val.array.len = 0;
-  val.array.cap = cap;
+  val.array = malloc(json_array_block_size(cap));
+  if (val.array) {
+    val.array->len = 0;
+    val.array->cap = cap;
+  }
   return val;
 }
 
 json_value_t json_value_object(size_t size) {
   json_value_t val = json_value_init(JSON_OBJECT);
-
-  // Create a temporary pool for the hash table (not ideal, but maintains API)
-  mem_pool_t *temp_pool = pool_create();
-  if (!temp_pool) return val;
-
-  hash_table_init_inplace(&val.object, size, temp_pool);
-  // Note: We don't destroy the pool as the hash table now owns the allocated memory
+  val.object = hash_table_init(size);
   return val;
 }
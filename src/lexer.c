@@ -1,16 +1,29 @@
 #include "../include/lexer.h"
+#include "../include/hash.h"
+
+#include <errno.h>
 
 __attribute__((cold))
 lexer_t lexer_init(const char *input) {
   size_t len = strlen(input);
   char *in_str = malloc(len + 1);
   strcpy(in_str, input);
+  lexer_t lexer = lexer_init_view(in_str, len);
+  lexer.owns_input = true;
+  return lexer;
+}
+
+__attribute__((cold))
+lexer_t lexer_init_view(const char *input, size_t len) {
   lexer_t lexer = {
-    .start = in_str,
-    .current = in_str,
+    .start = input,
+    .current = input,
+    .end = input + len,
     .line = 1,
     .column = 1,
     .has_peeked = false,
+    .hash_strings = false,
+    .owns_input = false,
     .last_token = {
       .lexeme = {
         .start = NULL,
@@ -23,7 +36,7 @@ lexer_t lexer_init(const char *input) {
 
 __attribute__((cold))
 void lexer_free(lexer_t *lexer) {
-  if (lexer->start) {
+  if (lexer->owns_input && lexer->start) {
     free((char *)lexer->start);
   }
 }
@@ -31,6 +44,7 @@ void lexer_free(lexer_t *lexer) {
 // String slice helper functions
 char *slice_to_string(string_slice_t slice) {
   char *str = malloc(slice.length + 1);
+  if (!str) return NULL;
   memcpy(str, slice.start, slice.length);
   str[slice.length] = '\0';
   return str;
@@ -52,15 +66,20 @@ int slice_cmp(string_slice_t a, string_slice_t b) {
 }
 
 double slice_to_double(string_slice_t slice) {
-  char buffer[SMALL_BUFFER];
-  if (slice.length < SMALL_BUFFER) {
+  char buffer[NUMBER_BUFFER];
+  if (slice.length < NUMBER_BUFFER) {
     memcpy(buffer, slice.start, slice.length);
     buffer[slice.length] = '\0';
     return strtod(buffer, NULL);
   }
 
-  // Fallback heap allocation
+  // Longer than any real number. The slice need not be NUL-terminated,
+  // so strtod only ever reads a bounded copy.
   char *temp = slice_to_string(slice);
+  if (!temp) {
+    errno = ENOMEM;
+    return 0.0;
+  }
   double res = strtod(temp, NULL);
   free(temp);
   return res;
@@ -176,51 +195,106 @@ token_t tokenize_number(lexer_t *lexer) {
   return token;
 }
 
-// Improved string tokenization with escape sequence handling
-token_t tokenize_string(lexer_t *lexer) {
+#define SWAR_ONES  0x0101010101010101ULL
+#define SWAR_HIGHS 0x8080808080808080ULL
+
+// High bit set in every byte of word equal to byte
+static inline uint64_t swar_match(uint64_t word, uint8_t byte) {
+  uint64_t x = word ^ (SWAR_ONES * byte);
+  return (x - SWAR_ONES) & ~x & SWAR_HIGHS;
+}
+
+/**
+ * Scan a string body 8 bytes at a time, stopping only at quotes, backslashes
+ * and newlines. With hash set, the lexeme is hashed in the same pass: every
+ * full word behind the scan position is fed to the hash, so the result is
+ * identical to hash_string() over the raw lexeme.
+ */
+static inline token_t scan_string(lexer_t *lexer, bool hash) {
   token_t token;
-  const char *start;
 
   // Skip opening quote
-  lexer->current++;
-  lexer->column++;
-  start = lexer->current;
+  const char *start = lexer->current + 1;
+  const char *p = start;
+  const char *end = lexer->end;
+  const char *col_base = lexer->current;  // column = col + (p - col_base)
+  int col = lexer->column;
+  int line = lexer->line;
+
+  uint64_t state = hash ? json_hash_begin() : 0;
+  const char *hashed = start;
+
+  while (true) {
+    if (p + 8 <= end) {
+      uint64_t word;
+      memcpy(&word, p, sizeof(word));
+      uint64_t special = swar_match(word, '"') | swar_match(word, '\\') | swar_match(word, '\n');
+      if (!special) {
+        p += 8;
+        if (hash) {
+          while (hashed + 8 <= p) {
+            state = json_hash_step(state, json_hash_read64(hashed));
+            hashed += 8;
+          }
+        }
+        continue;
+      }
+      p += __builtin_ctzll(special) >> 3;
+    }
 
-  while (*lexer->current != '\0' && *lexer->current != '"') {
-    if (*lexer->current == '\\') {
+    char ch = *p;
+    if (ch == '"' || ch == '\0') {
+      // An escape can leave a whole word unhashed right before the quote;
+      // the tail must be shorter than a word, as in hash_string()
+      while (hash && hashed + 8 <= p) {
+        state = json_hash_step(state, json_hash_read64(hashed));
+        hashed += 8;
+      }
+      break;
+    }
+    if (ch == '\\') {
       // Skip escape sequence
-      lexer->current++;
-      lexer->column++;
-      if (*lexer->current != '\0') {
-        lexer->current++;
-        lexer->column++;
+      p++;
+      if (*p != '\0') {
+        p++;
       }
+    } else if (ch == '\n') {
+      line++;
+      col = 1;
+      col_base = ++p;
     } else {
-      if (*lexer->current == '\n') {
-        lexer->line++;
-        lexer->column = 1;
-      } else {
-        lexer->column++;
+      p++;
+    }
+
+    if (hash) {
+      while (hashed + 8 <= p) {
+        state = json_hash_step(state, json_hash_read64(hashed));
+        hashed += 8;
       }
-      lexer->current++;
     }
   }
 
-  if (*lexer->current == '\0') {
+  lexer->line = line;
+  lexer->column = col + (int)(p - col_base);
+  lexer->current = p;
+
+  if (*p == '\0') {
     // Unterminated string
     token.type = TOKEN_ERROR;
     token.line = lexer->line;
     token.column = lexer->column;
+    token.hash = 0;
     token.lexeme.start = "Unterminated string";
-    token.lexeme.length = 19; 
+    token.lexeme.length = 19;
     return token;
   }
 
   // Calculate length and create lexeme
-  size_t len = lexer->current - start;
+  size_t len = p - start;
   token.type = TOKEN_STRING;
   token.line = lexer->line;
   token.column = lexer->column - len - 1; // Adjust for opening quote
+  token.hash = hash ? json_hash_finish(state, hashed, p - hashed, len) : 0;
   token.lexeme.start = start;
   token.lexeme.length = len;
 
@@ -231,6 +305,11 @@ token_t tokenize_string(lexer_t *lexer) {
   return token;
 }
 
+// Improved string tokenization with escape sequence handling
+token_t tokenize_string(lexer_t *lexer) {
+  return lexer->hash_strings ? scan_string(lexer, true) : scan_string(lexer, false);
+}
+
 __attribute__((cold))
 void token_free(token_t *token) {
 }
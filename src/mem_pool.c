@@ -6,39 +6,475 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
 
 static inline size_t align_up(size_t size, size_t alignment) {
   return (size + alignment - 1) & ~(alignment - 1);
 }
 
-static pool_block_t *block_create(size_t min_size) {
-  size_t block_size = min_size > POOL_BLOCK_SIZE ? min_size : POOL_BLOCK_SIZE;
-  pool_block_t *block = malloc(sizeof(pool_block_t) + block_size);
-  if (!block) return NULL;
+/**
+ * Recycled block cache. Blocks freed by pool_destroy() go to a small
+ * per-thread list first, then to a mutex-protected shared list, and only
+ * back to the allocator once both are full. Each list keeps one chain per
+ * power-of-two size from POOL_MIN_BLOCK_SIZE to POOL_BLOCK_SIZE, so pools
+ * sized for small inputs recycle their blocks too; the limits count blocks
+ * of every size together. Blocks are reused LIFO so the next pool gets
+ * memory that is already mapped and likely in cache. Larger and odd-sized
+ * blocks are never cached.
+ *
+ * Everything a thread owns (its cached blocks, its cache counters and its
+ * attached pool) lives in one thread_state_t. Counters are written only by
+ * their own thread, so counting never bounces a shared cache line between
+ * workers; pool_cache_stats() sums the live threads found in the registry
+ * and the totals left by threads that have exited.
+ */
+static size_t cache_thread_limit = POOL_CACHE_THREAD_BLOCKS;
+static size_t cache_shared_limit = POOL_CACHE_SHARED_BLOCKS;
+
+typedef struct {
+  size_t thread_hits;
+  size_t shared_hits;
+  size_t misses;
+  size_t released;
+  size_t evicted;
+} cache_counters_t;
+
+#define CACHE_CLASSES (__builtin_ctz(POOL_BLOCK_SIZE) - __builtin_ctz(POOL_MIN_BLOCK_SIZE) + 1)
+
+typedef struct thread_state {
+  pool_block_t *cache[CACHE_CLASSES];
+  size_t cache_len;  // blocks in every class
+  cache_counters_t counters;
+  mem_pool_t *pool;   // pool_thread_attach() pool
+  size_t pool_users;  // parsers borrowing it
+  bool registered;
+  struct thread_state *prev;
+  struct thread_state *next;
+} thread_state_t;
+
+static __thread thread_state_t thread_state;
+
+static pthread_mutex_t shared_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static pool_block_t *shared_cache[CACHE_CLASSES];
+static size_t shared_cache_len;
+
+static pthread_mutex_t registry_lock = PTHREAD_MUTEX_INITIALIZER;
+static thread_state_t *registry;   // threads that have counted something
+static cache_counters_t retired;   // counters of exited threads
+
+static pthread_key_t thread_state_key;
+static pthread_once_t thread_state_key_once = PTHREAD_ONCE_INIT;
+
+static void thread_state_register(void);
+
+// Only the owning thread writes its counters; the relaxed store keeps
+// pool_cache_stats() reads from other threads well defined
+#define CACHE_COUNT(counter) \
+  do { \
+    if (__builtin_expect(!thread_state.registered, 0)) thread_state_register(); \
+    __atomic_store_n(&thread_state.counters.counter, thread_state.counters.counter + 1, __ATOMIC_RELAXED); \
+  } while (0)
+
+static void counters_add(cache_counters_t *sum, const cache_counters_t *counters) {
+  sum->thread_hits += __atomic_load_n(&counters->thread_hits, __ATOMIC_RELAXED);
+  sum->shared_hits += __atomic_load_n(&counters->shared_hits, __ATOMIC_RELAXED);
+  sum->misses += __atomic_load_n(&counters->misses, __ATOMIC_RELAXED);
+  sum->released += __atomic_load_n(&counters->released, __ATOMIC_RELAXED);
+  sum->evicted += __atomic_load_n(&counters->evicted, __ATOMIC_RELAXED);
+}
+
+// Cache chain for a block size, or -1 if blocks of that size are not cached
+static inline int cache_class(size_t size) {
+  if (size < POOL_MIN_BLOCK_SIZE || size > POOL_BLOCK_SIZE || (size & (size - 1))) return -1;
+  return __builtin_ctzl(size) - __builtin_ctz(POOL_MIN_BLOCK_SIZE);
+}
+
+// Push to the shared list, or free the block if it is full
+static void shared_cache_put(pool_block_t *block, int class) {
+  pthread_mutex_lock(&shared_cache_lock);
+  if (shared_cache_len < __atomic_load_n(&cache_shared_limit, __ATOMIC_RELAXED)) {
+    block->next = shared_cache[class];
+    shared_cache[class] = block;
+    __atomic_store_n(&shared_cache_len, shared_cache_len + 1, __ATOMIC_RELAXED);
+    block = NULL;
+  }
+  pthread_mutex_unlock(&shared_cache_lock);
+
+  if (block) {
+    CACHE_COUNT(evicted);
+    free(block);
+  }
+}
+
+// Thread exit: destroy the attached pool, hand the thread's blocks to the
+// shared list and fold its counters into the retired totals
+__attribute__((cold))
+static void thread_state_exit(void *unused) {
+  (void)unused;
+  if (thread_state.pool) {
+    pool_destroy(thread_state.pool);
+    thread_state.pool = NULL;
+    thread_state.pool_users = 0;
+  }
+  for (int class = 0; class < CACHE_CLASSES; class++) {
+    while (thread_state.cache[class]) {
+      pool_block_t *block = thread_state.cache[class];
+      thread_state.cache[class] = block->next;
+      shared_cache_put(block, class);
+    }
+  }
+  thread_state.cache_len = 0;
+
+  pthread_mutex_lock(&registry_lock);
+  counters_add(&retired, &thread_state.counters);
+  if (thread_state.prev) {
+    thread_state.prev->next = thread_state.next;
+  } else {
+    registry = thread_state.next;
+  }
+  if (thread_state.next) {
+    thread_state.next->prev = thread_state.prev;
+  }
+  pthread_mutex_unlock(&registry_lock);
+
+  memset(&thread_state.counters, 0, sizeof(thread_state.counters));
+  thread_state.registered = false;
+}
+
+__attribute__((cold))
+static void thread_state_key_create(void) {
+  pthread_key_create(&thread_state_key, thread_state_exit);
+}
+
+// First cache event on this thread: join the registry and install the exit
+// hook, so threads that never touch a pool pay nothing
+__attribute__((cold))
+static void thread_state_register(void) {
+  pthread_once(&thread_state_key_once, thread_state_key_create);
+  pthread_setspecific(thread_state_key, &thread_state);
+
+  pthread_mutex_lock(&registry_lock);
+  thread_state.prev = NULL;
+  thread_state.next = registry;
+  if (registry) {
+    registry->prev = &thread_state;
+  }
+  registry = &thread_state;
+  pthread_mutex_unlock(&registry_lock);
+  thread_state.registered = true;
+}
+
+static pool_block_t *block_cache_take(int class) {
+  pool_block_t *block = thread_state.cache[class];
+  if (block) {
+    thread_state.cache[class] = block->next;
+    thread_state.cache_len--;
+    CACHE_COUNT(thread_hits);
+    return block;
+  }
+
+  if (__atomic_load_n(&shared_cache_len, __ATOMIC_RELAXED) == 0) {
+    return NULL;
+  }
+
+  pthread_mutex_lock(&shared_cache_lock);
+  block = shared_cache[class];
+  if (block) {
+    shared_cache[class] = block->next;
+    __atomic_store_n(&shared_cache_len, shared_cache_len - 1, __ATOMIC_RELAXED);
+  }
+  pthread_mutex_unlock(&shared_cache_lock);
+
+  if (block) {
+    CACHE_COUNT(shared_hits);
+  }
+  return block;
+}
+
+static void block_release(pool_block_t *block) {
+  if (block->map_size) {
+    munmap(block, block->map_size);
+    return;
+  }
+  int class = cache_class(block->size);
+  if (class < 0) {
+    free(block);
+    return;
+  }
+
+  CACHE_COUNT(released);
+  if (thread_state.cache_len < __atomic_load_n(&cache_thread_limit, __ATOMIC_RELAXED)) {
+    block->next = thread_state.cache[class];
+    thread_state.cache[class] = block;
+    thread_state.cache_len++;
+    return;
+  }
+
+  shared_cache_put(block, class);
+}
+
+/**
+ * Map a block directly. With POOL_HUGEPAGES the mapping is aligned to
+ * POOL_HUGE_PAGE_SIZE and marked MADV_HUGEPAGE so the kernel can back it
+ * with transparent huge pages; POOL_HUGETLB tries reserved hugetlbfs pages
+ * first. POOL_PREFAULT populates the pages up front. Returns NULL if the
+ * mapping fails so the caller can fall back to malloc.
+ */
+__attribute__((cold))
+static pool_block_t *block_map(size_t block_size, unsigned flags) {
+  size_t page = (size_t)sysconf(_SC_PAGESIZE);
+  bool huge = flags & POOL_HUGEPAGES;
+  size_t unit = huge ? POOL_HUGE_PAGE_SIZE : page;
+  size_t map_size = align_up(sizeof(pool_block_t) + block_size, unit);
+  int map_flags = MAP_PRIVATE | MAP_ANONYMOUS;
+  char *base = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+  if (flags & POOL_HUGETLB) {
+    int populate = 0;
+#ifdef MAP_POPULATE
+    populate = (flags & POOL_PREFAULT) ? MAP_POPULATE : 0;
+#endif
+    map_size = align_up(sizeof(pool_block_t) + block_size, POOL_HUGE_PAGE_SIZE);
+    base = mmap(NULL, map_size, PROT_READ | PROT_WRITE, map_flags | MAP_HUGETLB | populate, -1, 0);
+  }
+#endif
+
+  if (base == MAP_FAILED && huge) {
+    // Over-map so a huge-page aligned range can be carved out
+    char *raw = mmap(NULL, map_size + POOL_HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, map_flags, -1, 0);
+    if (raw == MAP_FAILED) return NULL;
+    base = (char *)align_up((uintptr_t)raw, POOL_HUGE_PAGE_SIZE);
+    if (base > raw) munmap(raw, base - raw);
+    size_t tail = (raw + map_size + POOL_HUGE_PAGE_SIZE) - (base + map_size);
+    if (tail) munmap(base + map_size, tail);
+#ifdef MADV_HUGEPAGE
+    madvise(base, map_size, MADV_HUGEPAGE);
+#endif
+    if (flags & POOL_PREFAULT) {
+      // Populate after the advice so faults are served with huge pages
+      bool populated = false;
+#ifdef MADV_POPULATE_WRITE
+      populated = madvise(base, map_size, MADV_POPULATE_WRITE) == 0;
+#endif
+      for (size_t off = 0; !populated && off < map_size; off += page) {
+        base[off] = 0;
+      }
+    }
+  }
+
+  if (base == MAP_FAILED) {
+#ifdef MAP_POPULATE
+    if (flags & POOL_PREFAULT) map_flags |= MAP_POPULATE;
+#endif
+    base = mmap(NULL, map_size, PROT_READ | PROT_WRITE, map_flags, -1, 0);
+    if (base == MAP_FAILED) return NULL;
+  }
+
+  pool_block_t *block = (pool_block_t *)base;
+  block->map_size = map_size;
+  block->size = map_size - sizeof(pool_block_t);
+  return block;
+}
+
+static pool_block_t *block_create(size_t block_size, unsigned flags) {
+  pool_block_t *block = NULL;
+  if ((flags & (POOL_MMAP | POOL_HUGEPAGES | POOL_HUGETLB)) && block_size >= POOL_MMAP_MIN_BLOCK) {
+    block = block_map(block_size, flags);
+  }
+
+  if (!block) {
+    int class = cache_class(block_size);
+    block = class >= 0 ? block_cache_take(class) : NULL;
+    if (!block) {
+      block = malloc(sizeof(pool_block_t) + block_size);
+      if (!block) return NULL;
+      CACHE_COUNT(misses);
+    }
+    block->map_size = 0;
+    block->size = block_size;
+  }
 
   block->next = NULL;
-  block->size = block_size;
   block->used = 0;
   return block;
 }
 
+void pool_cache_set_limits(size_t thread_blocks, size_t shared_blocks) {
+  __atomic_store_n(&cache_thread_limit, thread_blocks, __ATOMIC_RELAXED);
+  __atomic_store_n(&cache_shared_limit, shared_blocks, __ATOMIC_RELAXED);
+}
+
+void pool_cache_stats(pool_cache_stats_t *stats) {
+  cache_counters_t sum = {0};
+  pthread_mutex_lock(&registry_lock);
+  counters_add(&sum, &retired);
+  for (thread_state_t *state = registry; state; state = state->next) {
+    counters_add(&sum, &state->counters);
+  }
+  pthread_mutex_unlock(&registry_lock);
+
+  stats->thread_hits = sum.thread_hits;
+  stats->shared_hits = sum.shared_hits;
+  stats->misses = sum.misses;
+  stats->released = sum.released;
+  stats->evicted = sum.evicted;
+  stats->thread_blocks = thread_state.cache_len;
+  stats->shared_blocks = __atomic_load_n(&shared_cache_len, __ATOMIC_RELAXED);
+}
+
+__attribute__((cold))
+void pool_cache_trim(void) {
+  pool_block_t *shared[CACHE_CLASSES];
+  pthread_mutex_lock(&shared_cache_lock);
+  memcpy(shared, shared_cache, sizeof(shared));
+  memset(shared_cache, 0, sizeof(shared_cache));
+  __atomic_store_n(&shared_cache_len, 0, __ATOMIC_RELAXED);
+  pthread_mutex_unlock(&shared_cache_lock);
+
+  for (int class = 0; class < CACHE_CLASSES; class++) {
+    for (pool_block_t *block = thread_state.cache[class], *next; block; block = next) {
+      next = block->next;
+      free(block);
+    }
+    thread_state.cache[class] = NULL;
+    for (pool_block_t *block = shared[class], *next; block; block = next) {
+      next = block->next;
+      free(block);
+    }
+  }
+  thread_state.cache_len = 0;
+}
+
+pool_config_t pool_config_default(void) {
+  pool_config_t config = {
+    .first_block_size = POOL_BLOCK_SIZE,
+    .max_block_size = POOL_MAX_BLOCK_SIZE,
+    .flags = 0,
+    .retain_bytes = 0,
+  };
+  return config;
+}
+
+pool_config_t pool_config_for_input(size_t input_len) {
+  pool_config_t config = pool_config_default();
+  size_t estimate = input_len < POOL_MAX_BLOCK_SIZE / POOL_INPUT_FOOTPRINT
+      ? input_len * POOL_INPUT_FOOTPRINT
+      : POOL_MAX_BLOCK_SIZE;
+
+  // Powers of two, like the doubling that follows, are the sizes the block
+  // cache recycles
+  size_t block_size = POOL_MIN_BLOCK_SIZE;
+  while (block_size < estimate) {
+    block_size *= 2;
+  }
+  config.first_block_size = block_size;
+  return config;
+}
+
 mem_pool_t *pool_create(void) {
+  pool_config_t config = pool_config_default();
+  return pool_create_with_config(&config);
+}
+
+mem_pool_t *pool_create_with_config(const pool_config_t *config) {
+  size_t first = config->first_block_size ? config->first_block_size : POOL_BLOCK_SIZE;
+  size_t max = config->max_block_size ? config->max_block_size : POOL_MAX_BLOCK_SIZE;
+  first = align_up(first, POOL_ALIGNMENT);
+  if (max < first) max = first;
+
   mem_pool_t *pool = malloc(sizeof(mem_pool_t));
   if (!pool) return NULL;
 
-  pool->head = block_create(POOL_BLOCK_SIZE);
+  pool->head = block_create(first, config->flags);
   if (!pool->head) {
     free(pool);
     return NULL;
   }
 
   pool->current = pool->head;
-  pool->total_allocated = POOL_BLOCK_SIZE;
+  pool->total_allocated = pool->head->size;
   pool->total_used = 0;
   pool->block_count = 1;
+  pool->next_block_size = first * 2 < max ? first * 2 : max;
+  pool->max_block_size = max;
+  pool->flags = config->flags;
+  pool->retain_bytes = config->retain_bytes;
+  pool->usage = NULL;
+  memset(pool->free_lists, 0, sizeof(pool->free_lists));
+  pool->free_bytes = 0;
+  if (config->flags & POOL_ACCOUNTING) {
+    pool->usage = calloc(1, sizeof(pool_usage_t));
+  }
   return pool;
 }
 
+mem_pool_t *pool_create_static(void *buffer, size_t size) {
+  if (!buffer) return NULL;
+
+  uintptr_t start = align_up((uintptr_t)buffer, POOL_ALIGNMENT);
+  size_t header = align_up(sizeof(mem_pool_t), POOL_ALIGNMENT);
+  size_t skipped = start - (uintptr_t)buffer + header + sizeof(pool_block_t);
+  if (size <= skipped) return NULL;
+
+  mem_pool_t *pool = (mem_pool_t *)start;
+  pool_block_t *block = (pool_block_t *)(start + header);
+  block->next = NULL;
+  block->size = (size - skipped) & ~(size_t)(POOL_ALIGNMENT - 1);
+  block->used = 0;
+  block->map_size = 0;
+
+  pool->head = block;
+  pool->current = block;
+  pool->total_allocated = block->size;
+  pool->total_used = 0;
+  pool->block_count = 1;
+  pool->next_block_size = block->size;
+  pool->max_block_size = block->size;
+  pool->flags = POOL_FIXED;
+  pool->retain_bytes = 0;
+  pool->usage = NULL;
+  memset(pool->free_lists, 0, sizeof(pool->free_lists));
+  pool->free_bytes = 0;
+  return pool;
+}
+
+// Move to a block with room for min_size: the next block kept by
+// pool_reset() if it is big enough, otherwise a new one chained after the
+// current block. Block sizes double up to max_block_size; larger requests
+// get a block of their own size.
+static pool_block_t *pool_grow(mem_pool_t *pool, size_t min_size) {
+  if (pool->flags & POOL_FIXED) return NULL;
+
+  pool_block_t *next = pool->current->next;
+  if (next && next->size >= min_size) {
+    pool->current = next;
+    return next;
+  }
+
+  size_t block_size = pool->next_block_size;
+  if (block_size < min_size) {
+    block_size = min_size;
+  }
+
+  pool_block_t *new_block = block_create(block_size, pool->flags);
+  if (!new_block) return NULL;
+
+  new_block->next = next;
+  pool->current->next = new_block;
+  pool->current = new_block;
+  pool->total_allocated += new_block->size;
+  pool->block_count++;
+
+  if (pool->next_block_size < pool->max_block_size) {
+    size_t next = pool->next_block_size * 2;
+    pool->next_block_size = next < pool->max_block_size ? next : pool->max_block_size;
+  }
+  return new_block;
+}
+
 void *pool_alloc(mem_pool_t *pool, size_t size) {
   size = align_up(size, POOL_ALIGNMENT);
 
@@ -49,44 +485,195 @@ void *pool_alloc(mem_pool_t *pool, size_t size) {
     return ptr;
   }
 
-  pool_block_t *new_block = block_create(size);
+  pool_block_t *new_block = pool_grow(pool, size);
   if (!new_block) return NULL;
 
-  new_block->next = NULL;
-  pool->current->next = new_block;
-  pool->current = new_block;
-  pool->total_allocated += new_block->size;
-  pool->block_count++;
-
   void *ptr = new_block->data;
   new_block->used = size;
   pool->total_used += size;
   return ptr;
 }
 
+void *pool_alloc_aligned(mem_pool_t *pool, size_t size, size_t alignment) {
+  if (alignment <= POOL_ALIGNMENT) {
+    return pool_alloc(pool, size);
+  }
+  if ((alignment & (alignment - 1)) != 0 || alignment > POOL_BLOCK_SIZE) {
+    return NULL;
+  }
+
+  size = align_up(size, POOL_ALIGNMENT);
+
+  // Padding counts as used so pool_extend still sees ptr + size at the top
+  pool_block_t *block = pool->current;
+  uintptr_t top = (uintptr_t)(block->data + block->used);
+  size_t padding = align_up(top, alignment) - top;
+  if (block->used + padding + size <= block->size) {
+    if (pool->usage) pool->usage->padding += padding;
+    block->used += padding + size;
+    pool->total_used += padding + size;
+    return (void *)(top + padding);
+  }
+
+  // Block data is only 8-byte aligned; reserve room to align inside it
+  pool_block_t *new_block = pool_grow(pool, size + alignment - POOL_ALIGNMENT);
+  if (!new_block) return NULL;
+
+  top = (uintptr_t)new_block->data;
+  padding = align_up(top, alignment) - top;
+  if (pool->usage) pool->usage->padding += padding;
+  new_block->used = padding + size;
+  pool->total_used += padding + size;
+  return (void *)(top + padding);
+}
+
+bool pool_extend(mem_pool_t *pool, void *ptr, size_t old_size, size_t new_size) {
+  if (!pool || !ptr) return false;
+
+  old_size = align_up(old_size, POOL_ALIGNMENT);
+  new_size = align_up(new_size, POOL_ALIGNMENT);
+  if (new_size < old_size) return false;
+
+  pool_block_t *block = pool->current;
+  if ((char *)ptr + old_size != block->data + block->used) return false;
+  if (block->used - old_size + new_size > block->size) return false;
+
+  block->used += new_size - old_size;
+  pool->total_used += new_size - old_size;
+  return true;
+}
+
 void pool_reset(mem_pool_t *pool) {
   if (!pool) return;
 
+  // With POOL_TRIM_ON_RESET, keep the first retain_bytes resident and hand
+  // the touched pages past that back to the kernel
+  bool trim = pool->flags & POOL_TRIM_ON_RESET;
+  size_t keep = pool->retain_bytes;
+  size_t page = trim ? (size_t)sysconf(_SC_PAGESIZE) : 0;
+
   pool_block_t *current = pool->head;
   while (current) {
+    if (trim && current->used > keep) {
+      uintptr_t start = align_up((uintptr_t)(current->data + keep), page);
+      uintptr_t end = align_up((uintptr_t)(current->data + current->used), page);
+      uintptr_t limit = (uintptr_t)(current->data + current->size) & ~(uintptr_t)(page - 1);
+      if (end > limit) end = limit;
+      if (end > start) {
+        madvise((void *)start, end - start, MADV_DONTNEED);
+      }
+    }
+    keep = keep > current->size ? keep - current->size : 0;
     current->used = 0;
     current = current->next;
   }
 
   pool->current = pool->head;
   pool->total_used = 0;
+  memset(pool->free_lists, 0, sizeof(pool->free_lists));
+  pool->free_bytes = 0;
+  if (pool->usage) {
+    memset(pool->usage, 0, sizeof(pool_usage_t));
+  }
+}
+
+// Free chunks are threaded through their own storage. Only chunks in the
+// last, open-ended class record their size.
+typedef struct pool_free_chunk {
+  struct pool_free_chunk *next;
+  size_t size;
+} pool_free_chunk_t;
+
+// Largest class a chunk of size bytes can serve
+static inline int free_class_floor(size_t size) {
+  int cls = 63 - __builtin_clzll(size / POOL_ALIGNMENT);
+  return cls < POOL_FREE_CLASSES - 1 ? cls : POOL_FREE_CLASSES - 1;
+}
+
+// Smallest class whose chunks all hold size bytes
+static inline int free_class_ceil(size_t size) {
+  size_t units = size / POOL_ALIGNMENT;
+  int cls = units <= 1 ? 0 : 64 - __builtin_clzll(units - 1);
+  return cls < POOL_FREE_CLASSES - 1 ? cls : POOL_FREE_CLASSES - 1;
+}
+
+void pool_free(mem_pool_t *pool, void *ptr, size_t size) {
+  if (!pool || !ptr || size == 0) return;
+  // pool_alloc() rounded the request up, so that much is owned
+  size = align_up(size, POOL_ALIGNMENT);
+
+  // Below the last class a chunk only ever serves its class size
+  int cls = free_class_floor(size);
+  pool_free_chunk_t *chunk = ptr;
+  chunk->next = pool->free_lists[cls];
+  if (cls == POOL_FREE_CLASSES - 1) {
+    chunk->size = size;
+  } else {
+    size = (size_t)POOL_ALIGNMENT << cls;
+  }
+  pool->free_lists[cls] = chunk;
+  pool->free_bytes += size;
+}
+
+void *pool_alloc_reuse(mem_pool_t *pool, size_t size, size_t alignment) {
+  if (pool->free_bytes) {
+    size = align_up(size, POOL_ALIGNMENT);
+    int cls = free_class_ceil(size);
+    pool_free_chunk_t *chunk = pool->free_lists[cls];
+    if (chunk && ((uintptr_t)chunk & (alignment - 1)) == 0 &&
+        (cls < POOL_FREE_CLASSES - 1 || chunk->size >= size)) {
+      pool->free_lists[cls] = chunk->next;
+      size_t chunk_size = cls < POOL_FREE_CLASSES - 1 ? (size_t)POOL_ALIGNMENT << cls : chunk->size;
+      pool->free_bytes -= chunk_size;
+      if (pool->usage) pool->usage->recycled += size;
+      return chunk;
+    }
+  }
+  return pool_alloc_aligned(pool, size, alignment);
+}
+
+size_t pool_bytes_free(mem_pool_t *pool) {
+  return pool ? pool->free_bytes : 0;
+}
+
+pool_mark_t pool_mark(mem_pool_t *pool) {
+  pool_mark_t mark = {
+    .block = pool->current,
+    .used = pool->current->used,
+    .total_used = pool->total_used,
+  };
+  return mark;
+}
+
+void pool_rollback(mem_pool_t *pool, pool_mark_t mark) {
+  // Blocks entered since the mark follow it in the chain up to current
+  pool_block_t *block = mark.block;
+  while (block != pool->current) {
+    block = block->next;
+    block->used = 0;
+  }
+
+  mark.block->used = mark.used;
+  pool->current = mark.block;
+  pool->total_used = mark.total_used;
+
+  // Chunks past the mark are gone; the rest are simply forgotten
+  memset(pool->free_lists, 0, sizeof(pool->free_lists));
+  pool->free_bytes = 0;
 }
 
 void pool_destroy(mem_pool_t *pool) {
-  if (!pool) return;
+  // Fixed pools live in the caller's buffer
+  if (!pool || (pool->flags & POOL_FIXED)) return;
 
   pool_block_t *current = pool->head;
   while (current) {
     pool_block_t *next = current->next;
-    free(current);
+    block_release(current);
     current = next;
   }
 
+  free(pool->usage);
   free(pool);
 }
 
@@ -97,3 +684,64 @@ size_t pool_bytes_used(mem_pool_t *pool) {
 size_t pool_bytes_allocated(mem_pool_t *pool) {
   return pool ? pool->total_allocated : 0;
 }
+
+bool pool_usage(mem_pool_t *pool, pool_usage_t *usage) {
+  if (!pool || !pool->usage) return false;
+
+  *usage = *pool->usage;
+  size_t tagged = usage->padding;
+  for (int i = 0; i < POOL_CAT_COUNT; i++) {
+    tagged += usage->live[i] + usage->abandoned[i];
+  }
+  tagged -= usage->recycled;
+  // Everything untagged is OTHER; a rollback can leave the counters ahead
+  usage->live[POOL_CAT_OTHER] += pool->total_used > tagged ? pool->total_used - tagged : 0;
+  usage->unused = pool->total_allocated - pool->total_used;
+  return true;
+}
+
+mem_pool_t *pool_thread_attach(const pool_config_t *config) {
+  if (thread_state.pool) return thread_state.pool;
+
+  pool_config_t defaults = pool_config_default();
+  mem_pool_t *pool = pool_create_with_config(config ? config : &defaults);
+  if (!pool) return NULL;
+
+  // The exit hook destroys the pool if the thread never detaches
+  if (!thread_state.registered) {
+    thread_state_register();
+  }
+  thread_state.pool = pool;
+  thread_state.pool_users = 0;
+  return pool;
+}
+
+bool pool_thread_detach(void) {
+  if (!thread_state.pool) return true;
+  if (thread_state.pool_users > 0) return false;
+
+  pool_destroy(thread_state.pool);
+  thread_state.pool = NULL;
+  return true;
+}
+
+mem_pool_t *pool_thread_current(void) {
+  return thread_state.pool;
+}
+
+mem_pool_t *pool_thread_acquire(void) {
+  mem_pool_t *pool = thread_state.pool;
+  if (pool) {
+    thread_state.pool_users++;
+  }
+  return pool;
+}
+
+void pool_thread_release(mem_pool_t *pool) {
+  if (!pool || pool != thread_state.pool || thread_state.pool_users == 0) return;
+
+  // Last document gone: refill the same blocks from the start
+  if (--thread_state.pool_users == 0) {
+    pool_reset(pool);
+  }
+}
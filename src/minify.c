@@ -0,0 +1,289 @@
+#include "../include/minify.h"
+#include "../include/lexer.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+#if defined(__PCLMUL__)
+#include <wmmintrin.h>
+#endif
+
+#define EVEN_BITS 0x5555555555555555ULL
+#define ODD_BITS 0xAAAAAAAAAAAAAAAAULL
+
+static inline bool is_json_space(char ch) {
+  return ch == ' ' || ch == '\n' || ch == '\t' || ch == '\r';
+}
+
+// Byte-at-a-time minify, carrying the same state as the block scanner: a
+// backslash escapes the next byte and unescaped quotes toggle in_string
+static size_t minify_tail(const char *in, size_t len, char *out, bool in_string, bool escaped) {
+  size_t o = 0;
+  for (size_t i = 0; i < len; i++) {
+    char ch = in[i];
+    if (in_string || !is_json_space(ch)) {
+      out[o++] = ch;
+    }
+    if (escaped) {
+      escaped = false;
+    } else if (ch == '\\') {
+      escaped = true;
+    } else if (ch == '"') {
+      in_string = !in_string;
+    }
+  }
+  return o;
+}
+
+#if defined(__SSE2__)
+
+#if defined(__SSSE3__)
+// Shuffle indices of the kept bytes of an 8-byte group, for each mask of
+// dropped bytes; unused lanes are 0x80 (zero)
+static uint64_t compact_table[256];
+
+__attribute__((constructor, cold))
+static void minify_init_table(void) {
+  for (int mask = 0; mask < 256; mask++) {
+    uint64_t entry = 0x8080808080808080ULL;
+    int out = 0;
+    for (int i = 0; i < 8; i++) {
+      if (mask & (1 << i)) continue;
+      entry &= ~(0xFFULL << (out * 8));
+      entry |= (uint64_t)i << (out * 8);
+      out++;
+    }
+    compact_table[mask] = entry;
+  }
+}
+#endif
+
+static inline uint64_t prefix_xor(uint64_t bits) {
+#if defined(__PCLMUL__)
+  __m128i product = _mm_clmulepi64_si128(_mm_set_epi64x(0, (long long)bits), _mm_set1_epi8((char)0xFF), 0);
+  return (uint64_t)_mm_cvtsi128_si64(product);
+#else
+  bits ^= bits << 1;
+  bits ^= bits << 2;
+  bits ^= bits << 4;
+  bits ^= bits << 8;
+  bits ^= bits << 16;
+  bits ^= bits << 32;
+  return bits;
+#endif
+}
+
+// Bytes escaped by an odd-length backslash run, carrying runs across
+// blocks (Langdale and Lemire, "Parsing Gigabytes of JSON per Second")
+static inline uint64_t find_escaped(uint64_t backslash, uint64_t *prev_odd) {
+  uint64_t start_edges = backslash & ~(backslash << 1);
+  uint64_t even_start_mask = EVEN_BITS ^ *prev_odd;
+  uint64_t even_starts = start_edges & even_start_mask;
+  uint64_t odd_starts = start_edges & ~even_start_mask;
+  uint64_t even_carries = backslash + even_starts;
+  uint64_t odd_carries;
+  bool ends_odd = __builtin_add_overflow(backslash, odd_starts, &odd_carries);
+  odd_carries |= *prev_odd;
+  *prev_odd = ends_odd ? 1 : 0;
+  uint64_t even_carry_ends = even_carries & ~backslash;
+  uint64_t odd_carry_ends = odd_carries & ~backslash;
+  return (even_carry_ends & ODD_BITS) | (odd_carry_ends & EVEN_BITS);
+}
+
+static inline uint64_t match_mask(const __m128i chunks[4], char byte) {
+  __m128i needle = _mm_set1_epi8(byte);
+  uint64_t mask = 0;
+  for (int i = 0; i < 4; i++) {
+    mask |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chunks[i], needle)) << (i * 16);
+  }
+  return mask;
+}
+
+static inline uint64_t space_mask(const __m128i chunks[4]) {
+  const __m128i space = _mm_set1_epi8(' ');
+  const __m128i tab = _mm_set1_epi8('\t');
+  const __m128i newline = _mm_set1_epi8('\n');
+  const __m128i cr = _mm_set1_epi8('\r');
+  uint64_t mask = 0;
+  for (int i = 0; i < 4; i++) {
+    __m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunks[i], space), _mm_cmpeq_epi8(chunks[i], tab)),
+                               _mm_or_si128(_mm_cmpeq_epi8(chunks[i], newline), _mm_cmpeq_epi8(chunks[i], cr)));
+    mask |= (uint64_t)(uint32_t)_mm_movemask_epi8(hit) << (i * 16);
+  }
+  return mask;
+}
+
+// Write the bytes of a 64-byte block not in drop. Every byte of the block
+// is already loaded, so out may trail the input in the same buffer.
+static inline char *compact_block(char *out, const char *block, const __m128i chunks[4], uint64_t drop) {
+#if defined(__SSSE3__)
+  (void)block;
+  for (int i = 0; i < 4; i++) {
+    uint32_t bits = (uint32_t)(drop >> (i * 16));
+    __m128i low = chunks[i];
+    __m128i high = _mm_srli_si128(chunks[i], 8);
+    __m128i packed = _mm_shuffle_epi8(low, _mm_loadl_epi64((const __m128i *)&compact_table[bits & 0xFF]));
+    _mm_storel_epi64((__m128i *)out, packed);
+    out += 8 - __builtin_popcount(bits & 0xFF);
+    packed = _mm_shuffle_epi8(high, _mm_loadl_epi64((const __m128i *)&compact_table[(bits >> 8) & 0xFF]));
+    _mm_storel_epi64((__m128i *)out, packed);
+    out += 8 - __builtin_popcount((bits >> 8) & 0xFF);
+  }
+#else
+  (void)chunks;
+  // Copy runs of kept bytes
+  uint64_t keep = ~drop;
+  while (keep) {
+    int start = __builtin_ctzll(keep);
+    uint64_t rest = ~(keep >> start);
+    int run = rest ? __builtin_ctzll(rest) : 64 - start;
+    memmove(out, block + start, run);
+    out += run;
+    if (start + run >= 64) break;
+    keep &= ~0ULL << (start + run);
+  }
+#endif
+  return out;
+}
+
+size_t json_minify(const char *in, size_t len, char *out) {
+  char *o = out;
+  uint64_t prev_odd = 0;        // the next byte is escaped
+  uint64_t prev_in_string = 0;  // all ones inside a string
+  size_t i = 0;
+  for (; i + 64 <= len; i += 64) {
+    __m128i chunks[4];
+    for (int c = 0; c < 4; c++) {
+      chunks[c] = _mm_loadu_si128((const __m128i *)(in + i + c * 16));
+    }
+    uint64_t spaces = space_mask(chunks);
+    uint64_t backslash = match_mask(chunks, '\\');
+    uint64_t quotes = match_mask(chunks, '"') & ~find_escaped(backslash, &prev_odd);
+    uint64_t in_string = prefix_xor(quotes) ^ prev_in_string;
+    prev_in_string = (uint64_t)((int64_t)in_string >> 63);
+
+    uint64_t drop = spaces & ~in_string;
+    if (!drop) {
+      memmove(o, in + i, 64);
+      o += 64;
+    } else if (drop != ~0ULL) {
+      o = compact_block(o, in + i, chunks, drop);
+    }
+  }
+  return (o - out) + minify_tail(in + i, len - i, o, prev_in_string != 0, prev_odd != 0);
+}
+
+#else
+
+size_t json_minify(const char *in, size_t len, char *out) {
+  return minify_tail(in, len, out, false, false);
+}
+
+#endif
+
+__attribute__((cold))
+static bool reformat_error(json_writer_t *writer, token_t token, const char *msg) {
+  if (!writer->has_error) {
+    writer->has_error = true;
+    snprintf(writer->error_message, sizeof(writer->error_message),
+             "Reformat error at line %d, column %d: %s", token.line, token.column, msg);
+  }
+  return false;
+}
+
+// What the next token may be
+typedef enum {
+  EXPECT_VALUE,
+  EXPECT_KEY,
+  EXPECT_COLON,
+  EXPECT_SEPARATOR,  // comma or the end of the container
+  EXPECT_EOF,
+} expect_t;
+
+bool json_reformat(const char *in, size_t len, json_writer_t *writer) {
+  lexer_t lexer = lexer_init_view(in, len);
+  expect_t expect = EXPECT_VALUE;
+  bool opened = false;  // the innermost container has no members yet
+
+  while (!writer->has_error) {
+    token_t token = next_token(&lexer);
+    switch (token.type) {
+      case TOKEN_EOF:
+        if (expect != EXPECT_EOF) return reformat_error(writer, token, "Unexpected end of input");
+        return true;
+      case TOKEN_ERROR:
+        return reformat_error(writer, token, "Invalid token");
+      case TOKEN_COLON:
+        if (expect != EXPECT_COLON) return reformat_error(writer, token, "Unexpected ':'");
+        expect = EXPECT_VALUE;
+        continue;
+      case TOKEN_COMMA:
+        if (expect != EXPECT_SEPARATOR) return reformat_error(writer, token, "Unexpected ','");
+        expect = json_writer_in_object(writer) ? EXPECT_KEY : EXPECT_VALUE;
+        continue;
+      case TOKEN_RBRACE:
+      case TOKEN_RBRACKET: {
+        bool object = token.type == TOKEN_RBRACE;
+        bool can_close = expect == EXPECT_SEPARATOR ||
+                         (opened && expect == (object ? EXPECT_KEY : EXPECT_VALUE));
+        if (writer->depth == 0 || !can_close || json_writer_in_object(writer) != object) {
+          return reformat_error(writer, token, object ? "Unexpected '}'" : "Unexpected ']'");
+        }
+        json_writer_end(writer);
+        opened = false;
+        expect = writer->depth ? EXPECT_SEPARATOR : EXPECT_EOF;
+        continue;
+      }
+      case TOKEN_STRING:
+        if (expect == EXPECT_KEY) {
+          json_writer_key_raw(writer, token.lexeme.start, token.lexeme.length);
+          opened = false;
+          expect = EXPECT_COLON;
+          continue;
+        }
+        break;
+      default:
+        break;
+    }
+
+    // A value
+    if (expect != EXPECT_VALUE) return reformat_error(writer, token, "Unexpected value");
+    opened = false;
+    switch (token.type) {
+      case TOKEN_LBRACE:
+        json_writer_begin_object(writer);
+        opened = true;
+        expect = EXPECT_KEY;
+        continue;
+      case TOKEN_LBRACKET:
+        json_writer_begin_array(writer);
+        opened = true;
+        expect = EXPECT_VALUE;
+        continue;
+      case TOKEN_STRING:
+        json_writer_string_raw(writer, token.lexeme.start, token.lexeme.length);
+        break;
+      case TOKEN_NUMBER:
+        json_writer_raw(writer, token.lexeme.start, token.lexeme.length);
+        break;
+      case TOKEN_TRUE:
+        json_writer_bool(writer, true);
+        break;
+      case TOKEN_FALSE:
+        json_writer_bool(writer, false);
+        break;
+      default:
+        json_writer_null(writer);
+        break;
+    }
+    expect = writer->depth ? EXPECT_SEPARATOR : EXPECT_EOF;
+  }
+  return false;
+}
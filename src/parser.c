@@ -1,20 +1,67 @@
 #include "../include/parser.h"
 
 parser_t parser_init(lexer_t *lexer) {
-  mem_pool_t *pool = pool_create();
+  return parser_init_ex(lexer, NULL);
+}
+
+parser_t parser_init_ex(lexer_t *lexer, const pool_config_t *config) {
+  pool_config_t sized;
+  if (!config) {
+    mem_pool_t *thread_pool = pool_thread_acquire();
+    if (thread_pool) {
+      parser_t parser = parser_init_with_pool(lexer, thread_pool);
+      parser.thread_pool = true;
+      return parser;
+    }
+    sized = pool_config_for_input((size_t)(lexer->end - lexer->start));
+    config = &sized;
+  }
+  parser_t parser = parser_init_with_pool(lexer, pool_create_with_config(config));
+  parser.owns_pool = true;
+  return parser;
+}
+
+parser_t parser_init_with_pool(lexer_t *lexer, mem_pool_t *pool) {
   parser_t parser = {
     .lexer = lexer,
     .pool = pool,
-    .owns_pool = true,
+    .owns_pool = false,
+    .thread_pool = false,
+    .intern = NULL,
+    .spans = NULL,
     .has_error = false,
   };
   return parser;
 }
+
+// Fixed and thread pools hold the member stack too, so the parser never
+// calls malloc
+static inline bool members_in_pool(parser_t *parser) {
+  return parser->pool && ((parser->pool->flags & POOL_FIXED) || parser->thread_pool);
+}
+
 void parser_free(parser_t *parser) {
   token_free(&parser->current_token);
+  if (!members_in_pool(parser)) {
+    free(parser->members);
+  }
+  parser->members = NULL;
+  parser->members_len = parser->members_cap = 0;
   if (parser->owns_pool && parser->pool) {
     pool_destroy(parser->pool);
     parser->pool = NULL;
+  } else if (parser->thread_pool) {
+    pool_thread_release(parser->pool);
+    parser->pool = NULL;
+    parser->thread_pool = false;
+  }
+}
+
+// Pool exhausted; keeps an earlier syntax error if there is one
+__attribute__((cold))
+static void parser_out_of_memory(parser_t *parser) {
+  if (!parser->has_error) {
+    parser_error(parser, "Out of memory");
   }
 }
 
@@ -26,25 +73,23 @@ void parser_error(parser_t *parser, const char *msg) {
            parser->current_token.line, parser->current_token.column, msg);
 }
 
-char *pool_strdup(mem_pool_t *pool, const char *src, size_t len) {
-  char *dist = pool_alloc(pool, len + 1);
-  if (dist) {
-    memcpy(dist, src, len);
-    dist[len] = '\0';
-  }
-  return dist;
-}
-
 json_value_t parse_string(parser_t *parser) {
   if (!check(parser, TOKEN_STRING)) {
     parser_error(parser, "Expected string");
     return json_value_init(JSON_NULL);
   }
 
+  // Short strings are stored in the value and need no pool memory
   string_slice_t slice = parser->current_token.lexeme;
-  char *str = pool_strdup(parser->pool, slice.start, slice.length);
-
-  json_value_t value = json_value_string(str);
+  if (slice.length > JSON_STRING_LEN_MAX) {
+    parser_error(parser, "String too long");
+    return json_value_init(JSON_NULL);
+  }
+  json_value_t value = json_value_string_n(slice.start, slice.length, parser->pool);
+  if (value.type != JSON_STRING) {
+    parser_out_of_memory(parser);
+    return value;
+  }
   advance(parser);
   return value;
 }
@@ -54,7 +99,23 @@ json_value_t parse_number(parser_t *parser) {
     parser_error(parser, "Expected number");
   }
 
-  double num = slice_to_double(parser->current_token.lexeme);
+  string_slice_t lexeme = parser->current_token.lexeme;
+  double num;
+  if (lexeme.length < NUMBER_BUFFER || !parser->pool) {
+    num = slice_to_double(lexeme);
+  } else {
+    // Too long for the stack: copy it to the pool rather than the heap, so
+    // a fixed arena parse stays off malloc, and hand the copy back
+    char *copy = pool_alloc(parser->pool, lexeme.length + 1);
+    if (!copy) {
+      parser_out_of_memory(parser);
+      return json_value_init(JSON_NULL);
+    }
+    memcpy(copy, lexeme.start, lexeme.length);
+    copy[lexeme.length] = '\0';
+    num = strtod(copy, NULL);
+    pool_free(parser->pool, copy, lexeme.length + 1);
+  }
   json_value_t value = json_value_number(num);
   advance(parser);
   return value;
@@ -106,17 +167,35 @@ json_value_t parse_value(parser_t *parser) {
   }
 }
 
+// Record the text of a container that parsed cleanly, from its opening to
+// its closing bracket
+static inline void record_span(parser_t *parser, json_value_t *value, const char *open, const char *close) {
+  if (!parser->spans || parser->has_error) return;
+  const void *storage = value->type == JSON_ARRAY ? (const void *)value->array
+                                                  : (const void *)value->object;
+  if (storage && json_spans_add(parser->spans, storage, (size_t)(open - parser->lexer->start),
+                                (size_t)(close + 1 - open))) {
+    value->flags |= JSON_VALUE_SPAN;
+  }
+}
+
 json_value_t parse_array(parser_t *parser) {
   if (!check(parser, TOKEN_LBRACKET)) {
     parser_error(parser, "Expected '['");
     return json_value_array_pooled(0, parser->pool);
   }
+  const char *open = parser->current_token.lexeme.start;
   advance(parser);
 
   json_value_t array = json_value_array_pooled(0, parser->pool);
+  if (!array.array) {
+    parser_out_of_memory(parser);
+    return json_value_init(JSON_NULL);
+  }
 
   // Check for empty array
   if (check(parser, TOKEN_RBRACKET)) {
+    record_span(parser, &array, open, parser->current_token.lexeme.start);
     advance(parser);
     return array;
   }
@@ -127,7 +206,10 @@ json_value_t parse_array(parser_t *parser) {
       return array;
     }
 
-    json_array_push_pooled(&array, element, parser->pool);
+    if (json_array_push_pooled(&array, element, parser->pool) != 0) {
+      parser_out_of_memory(parser);
+      return array;
+    }
 
     if (check(parser, TOKEN_COMMA)) {
       advance(parser);
@@ -143,61 +225,157 @@ json_value_t parse_array(parser_t *parser) {
   if (!check(parser, TOKEN_RBRACKET)) {
     parser_error(parser, "Expected ']'");
   }
+  record_span(parser, &array, open, parser->current_token.lexeme.start);
   advance(parser);
 
   return array;
 }
 
+// Fetch the next token, which the grammar says is an object key, hashing it
+// while it is scanned
+static inline void advance_to_key(parser_t *parser) {
+  parser->lexer->hash_strings = true;
+  advance(parser);
+  parser->lexer->hash_strings = false;
+}
+
+static bool push_member(parser_t *parser, token_t *key, json_value_t value) {
+  if (parser->members_len == parser->members_cap) {
+    size_t new_cap = parser->members_cap == 0 ? 16 : parser->members_cap * 2;
+    parser_member_t *grown;
+    if (members_in_pool(parser)) {
+      grown = pool_alloc(parser->pool, new_cap * sizeof(parser_member_t));
+      if (grown && parser->members_len) {
+        memcpy(grown, parser->members, parser->members_len * sizeof(parser_member_t));
+      }
+    } else {
+      grown = realloc(parser->members, new_cap * sizeof(parser_member_t));
+    }
+    if (!grown) {
+      parser_out_of_memory(parser);
+      return false;
+    }
+    parser->members = grown;
+    parser->members_cap = new_cap;
+  }
+  parser_member_t *member = &parser->members[parser->members_len++];
+  member->key = key->lexeme.start;
+  member->key_len = (uint32_t)key->lexeme.length;
+  member->hash = key->hash;
+  member->value = value;
+  return true;
+}
+
+// Build the object from members pushed since base, sized so it never resizes
+static json_value_t finish_object(parser_t *parser, size_t base) {
+  size_t count = parser->members_len - base;
+  json_value_t object = json_value_object_pooled(count, parser->pool);
+  if (!object.object) {
+    parser_out_of_memory(parser);
+    parser->members_len = base;
+    return json_value_init(JSON_NULL);
+  }
+
+  for (size_t i = base; i < parser->members_len; i++) {
+    parser_member_t *member = &parser->members[i];
+    // Keys short enough to store inline gain nothing from interning
+    const char *canonical = parser->intern && !hash_key_fits_inline(member->key_len)
+        ? intern_table_add(parser->intern, member->key, member->key_len, member->hash)
+        : NULL;
+    int res;
+    if (canonical) {
+      member->key = canonical;
+      res = hash_table_insert_interned(object.object, canonical, member->key_len, member->hash,
+                                       member->value, parser->pool);
+    } else {
+      // Inline key, no dictionary, or it is full: copy the key into the document
+      res = hash_table_insert_hashed(object.object, member->key, member->key_len, member->hash,
+                                     member->value, parser->pool);
+    }
+    if (res < 0) {
+      parser_out_of_memory(parser);
+      break;
+    } else if (res == 1) {
+      // Duplicate key: last value wins; the replaced one's storage is reused
+      json_value_t *existing = hash_table_get_hashed(object.object, member->key, member->key_len,
+                                                     member->hash);
+      json_value_free_pooled(existing, parser->pool);
+      *existing = member->value;
+    }
+  }
+
+  parser->members_len = base;
+  return object;
+}
+
+// Consume the closing '}' and build the object
+static json_value_t close_object(parser_t *parser, size_t base, const char *open) {
+  const char *close = parser->current_token.lexeme.start;
+  advance(parser);
+  json_value_t object = finish_object(parser, base);
+  record_span(parser, &object, open, close);
+  return object;
+}
+
 json_value_t parse_object(parser_t *parser) {
   if (!check(parser, TOKEN_LBRACE)) {
     parser_error(parser, "Expected '{'");
     return json_value_object_pooled(0, parser->pool);
   }
-  advance(parser);
+  const char *open = parser->current_token.lexeme.start;
+  advance_to_key(parser);
 
-  json_value_t object = json_value_object_pooled(0, parser->pool);
+  size_t base = parser->members_len;
 
   if (check(parser, TOKEN_RBRACE)) {
-    advance(parser);
-    return object;
+    return close_object(parser, base, open);
   }
 
   while (true) {
     if (parser->has_error) {
-      return object;
+      return finish_object(parser, base);
     }
     if (!check(parser, TOKEN_STRING)) {
       parser_error(parser, "Expected string key in object");
-      return object;
+      return finish_object(parser, base);
     }
 
-    char *key = pool_strdup(parser->pool, parser->current_token.lexeme.start, parser->current_token.lexeme.length);
+    token_t key = parser->current_token;
+    if (key.lexeme.length > HASH_KEY_LEN_MAX) {
+      parser_error(parser, "Key too long");
+      return finish_object(parser, base);
+    }
     advance(parser);
 
     if (!check(parser, TOKEN_COLON)) {
       parser_error(parser, "Expected ':'");
-      return object;
+      return finish_object(parser, base);
     }
 
     advance(parser);
     json_value_t value = parse_value(parser);
-    json_object_set_pooled(&object, key, value, parser->pool);
+    if (!push_member(parser, &key, value)) {
+      return finish_object(parser, base);
+    }
 
     if (check(parser, TOKEN_COMMA)) {
-      advance(parser);
+      advance_to_key(parser);
       continue;
     } else if (check(parser, TOKEN_RBRACE)) {
       break;
     } else {
       parser_error(parser, "Expected ',' or '}' in object");
-      return object;
+      return finish_object(parser, base);
     }
   }
 
-  advance(parser);  // Consume the closing '}'
-  return object;
+  return close_object(parser, base, open);
 }
 
 json_value_t parse(parser_t *parser) {
+  if (parser->spans) {
+    parser->spans->input = parser->lexer->start;
+    parser->spans->generation = __atomic_load_n(&json_span_generation, __ATOMIC_RELAXED);
+  }
   return parse_value(parser);
 }
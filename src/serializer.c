@@ -0,0 +1,982 @@
+#include "../include/serializer.h"
+#include "../include/dtoa.h"
+#include "../include/escape.h"
+#include "../include/writer.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define BUFFER_MIN_CAP 256
+#define WRITEV_BATCH 1024  // IOV_MAX on Linux
+
+json_buffer_t json_buffer_init(size_t initial_cap) {
+  json_buffer_t buffer = {
+    .data = NULL,
+    .len = 0,
+    .cap = 0,
+    .owned = true,
+    .failed = false,
+  };
+  if (initial_cap) {
+    buffer.data = malloc(initial_cap);
+    buffer.cap = buffer.data ? initial_cap : 0;
+  }
+  return buffer;
+}
+
+json_buffer_t json_buffer_fixed(char *buf, size_t cap) {
+  json_buffer_t buffer = {
+    .data = buf,
+    .len = 0,
+    .cap = buf ? cap : 0,
+    .owned = false,
+    .failed = false,
+  };
+  return buffer;
+}
+
+void json_buffer_free(json_buffer_t *buffer) {
+  if (buffer->owned) {
+    free(buffer->data);
+  }
+  buffer->data = NULL;
+  buffer->len = buffer->cap = 0;
+}
+
+__attribute__((cold, noinline))
+static bool buffer_grow(json_buffer_t *buffer, size_t need) {
+  if (!buffer->owned) {
+    buffer->failed = true;
+    return false;
+  }
+  size_t cap = buffer->cap ? buffer->cap * 2 : BUFFER_MIN_CAP;
+  while (cap < buffer->len + need) {
+    cap *= 2;
+  }
+  char *data = realloc(buffer->data, cap);
+  if (!data) {
+    buffer->failed = true;
+    return false;
+  }
+  buffer->data = data;
+  buffer->cap = cap;
+  return true;
+}
+
+// Room for need more bytes
+static inline bool buffer_reserve(json_buffer_t *buffer, size_t need) {
+  if (__builtin_expect(buffer->len + need <= buffer->cap, 1)) return true;
+  if (buffer->failed) return false;
+  return buffer_grow(buffer, need);
+}
+
+static inline void buffer_append(json_buffer_t *buffer, const char *data, size_t len) {
+  if (!buffer_reserve(buffer, len)) return;
+  memcpy(buffer->data + buffer->len, data, len);
+  buffer->len += len;
+}
+
+static inline void buffer_put(json_buffer_t *buffer, char ch) {
+  if (!buffer_reserve(buffer, 1)) return;
+  buffer->data[buffer->len++] = ch;
+}
+
+static void write_string(json_buffer_t *buffer, const char *s, size_t len) {
+  buffer_put(buffer, '"');
+  size_t i = 0;
+  while (i < len) {
+    size_t run = json_escape_clean_run(s + i, len - i);
+    buffer_append(buffer, s + i, run);
+    i += run;
+    if (i == len) break;
+
+    char escaped[JSON_ESCAPE_MAX_LEN];
+    size_t used;
+    buffer_append(buffer, escaped, json_escape_special(s + i, len - i, escaped, &used));
+    i += used;
+  }
+  buffer_put(buffer, '"');
+}
+
+static inline void write_key(json_buffer_t *buffer, const hash_entry_t *entry) {
+  json_str_t key = hash_entry_key(entry);
+  write_string(buffer, key.str, key.len);
+}
+
+// Format in place when the longest number fits; otherwise through a
+// scratch copy, since a nearly full fixed buffer may still hold this one
+static inline void write_number(json_buffer_t *buffer, double number) {
+  if (__builtin_expect(buffer->len + JSON_DOUBLE_MAX_LEN <= buffer->cap, 1)) {
+    buffer->len += json_format_double(buffer->data + buffer->len, number);
+    return;
+  }
+  char text[JSON_DOUBLE_MAX_LEN];
+  buffer_append(buffer, text, json_format_double(text, number));
+}
+
+static void write_value(json_buffer_t *buffer, const json_value_t *value) {
+  switch (value->type) {
+    case JSON_NULL:
+      buffer_append(buffer, "null", 4);
+      break;
+    case JSON_BOOL:
+      if (value->boolean) {
+        buffer_append(buffer, "true", 4);
+      } else {
+        buffer_append(buffer, "false", 5);
+      }
+      break;
+    case JSON_NUMBER:
+      write_number(buffer, value->number);
+      break;
+    case JSON_STRING: {
+      json_str_t str = json_get_str(value);
+      write_string(buffer, str.str, str.len);
+      break;
+    }
+    case JSON_ARRAY:
+      buffer_put(buffer, '[');
+      for (size_t i = 0, len = json_array_len(value); i < len && !buffer->failed; i++) {
+        if (i) buffer_put(buffer, ',');
+        write_value(buffer, &value->array->items[i]);
+      }
+      buffer_put(buffer, ']');
+      break;
+    case JSON_OBJECT: {
+      buffer_put(buffer, '{');
+      json_object_iter_t it = json_object_iter(value);
+      bool first = true;
+      for (const hash_entry_t *entry; !buffer->failed && (entry = json_object_next(&it));) {
+        if (!first) buffer_put(buffer, ',');
+        first = false;
+        write_key(buffer, entry);
+        buffer_put(buffer, ':');
+        write_value(buffer, &entry->value);
+      }
+      buffer_put(buffer, '}');
+      break;
+    }
+  }
+}
+
+bool json_serialize_into(json_buffer_t *buffer, const json_value_t *value) {
+  write_value(buffer, value);
+  buffer_put(buffer, '\0');
+  if (buffer->failed) return false;
+  buffer->len--;  // NUL is not part of the text
+  return true;
+}
+
+char *json_serialize(const json_value_t *value, size_t *len) {
+  json_buffer_t buffer = json_buffer_init(BUFFER_MIN_CAP);
+  if (!json_serialize_into(&buffer, value)) {
+    json_buffer_free(&buffer);
+    return NULL;
+  }
+  if (len) *len = buffer.len;
+  return buffer.data;
+}
+
+size_t json_serialize_to(const json_value_t *value, char *buf, size_t cap) {
+  json_buffer_t buffer = json_buffer_fixed(buf, cap);
+  return json_serialize_into(&buffer, value) ? buffer.len : 0;
+}
+
+void json_value_print(const json_value_t *value) {
+  json_buffer_t buffer = json_buffer_init(BUFFER_MIN_CAP);
+  if (json_serialize_into(&buffer, value)) {
+    fwrite(buffer.data, 1, buffer.len, stdout);
+    putchar('\n');
+  }
+  json_buffer_free(&buffer);
+}
+
+#define PARALLEL_DEFAULT_MIN_SPLIT 4096
+#define PARALLEL_RANGES_PER_THREAD 4
+#define PARALLEL_PLAN_DEPTH 3
+
+// Members [begin, end) of a split container: elements of an array, or
+// table entries of an object
+typedef struct {
+  const json_value_t *value;
+  size_t begin;
+  size_t end;
+  bool leads;         // first range of its container
+  json_buffer_t out;  // every member preceded by a comma
+} range_task_t;
+
+// Output in order: literal text planned by the caller, or a range's buffer
+typedef struct {
+  bool is_range;
+  size_t index;       // range, or offset into the literal buffer
+  size_t len;         // literal length
+} piece_t;
+
+typedef struct {
+  json_buffer_t literal;
+  size_t literal_start;  // literal text not yet in a piece
+  piece_t *pieces;
+  size_t pieces_len;
+  size_t pieces_cap;
+  range_task_t *ranges;
+  size_t ranges_len;
+  size_t ranges_cap;
+  size_t min_split;
+  int threads;
+  size_t next;           // next range to claim
+  bool failed;
+} plan_t;
+
+static bool plan_grow(plan_t *plan, void **data, size_t *cap, size_t len, size_t elem_size) {
+  if (len < *cap) return true;
+  size_t new_cap = *cap ? *cap * 2 : 64;
+  void *grown = realloc(*data, new_cap * elem_size);
+  if (!grown) {
+    plan->failed = true;
+    return false;
+  }
+  *data = grown;
+  *cap = new_cap;
+  return true;
+}
+
+static void plan_piece(plan_t *plan, bool is_range, size_t index, size_t len) {
+  if (!plan_grow(plan, (void **)&plan->pieces, &plan->pieces_cap, plan->pieces_len, sizeof(piece_t))) {
+    return;
+  }
+  plan->pieces[plan->pieces_len++] = (piece_t){is_range, index, len};
+}
+
+// End the literal piece before a range
+static void plan_cut(plan_t *plan) {
+  size_t len = plan->literal.len - plan->literal_start;
+  if (len) plan_piece(plan, false, plan->literal_start, len);
+  plan->literal_start = plan->literal.len;
+}
+
+static void plan_split(plan_t *plan, const json_value_t *value, size_t count) {
+  bool is_array = value->type == JSON_ARRAY;
+  size_t total = is_array ? json_array_len(value) : hash_table_used(value->object);
+  // Enough ranges to balance the threads, none smaller than min_split members
+  size_t members = count / ((size_t)plan->threads * PARALLEL_RANGES_PER_THREAD);
+  if (members < plan->min_split) members = plan->min_split;
+  size_t step = is_array ? members : (size_t)((double)members * total / count);
+  if (step == 0) step = 1;
+
+  buffer_put(&plan->literal, is_array ? '[' : '{');
+  plan_cut(plan);
+  for (size_t begin = 0; begin < total && !plan->failed; begin += step) {
+    if (!plan_grow(plan, (void **)&plan->ranges, &plan->ranges_cap, plan->ranges_len, sizeof(range_task_t))) {
+      return;
+    }
+    range_task_t *range = &plan->ranges[plan->ranges_len];
+    range->value = value;
+    range->begin = begin;
+    range->end = begin + step < total ? begin + step : total;
+    range->leads = begin == 0;
+    range->out = json_buffer_init(0);
+    plan_piece(plan, true, plan->ranges_len++, 0);
+  }
+  buffer_put(&plan->literal, is_array ? ']' : '}');
+}
+
+// Write value into the literal, splitting large containers into ranges
+static void plan_value(plan_t *plan, const json_value_t *value, int depth) {
+  // Storage is NULL only after a failed allocation; it holds no members
+  size_t count = value->type == JSON_ARRAY ? json_array_len(value) :
+                 value->type == JSON_OBJECT && value->object ? value->object->size : 0;
+  if (count >= plan->min_split) {
+    plan_split(plan, value, count);
+    return;
+  }
+  if (count == 0 || depth >= PARALLEL_PLAN_DEPTH) {
+    write_value(&plan->literal, value);
+    return;
+  }
+
+  if (value->type == JSON_ARRAY) {
+    buffer_put(&plan->literal, '[');
+    for (size_t i = 0, len = json_array_len(value); i < len && !plan->failed; i++) {
+      if (i) buffer_put(&plan->literal, ',');
+      plan_value(plan, &value->array->items[i], depth + 1);
+    }
+    buffer_put(&plan->literal, ']');
+    return;
+  }
+  json_object_iter_t it = json_object_iter(value);
+  bool first = true;
+  buffer_put(&plan->literal, '{');
+  for (const hash_entry_t *entry; !plan->failed && (entry = json_object_next(&it));) {
+    if (!first) buffer_put(&plan->literal, ',');
+    first = false;
+    write_key(&plan->literal, entry);
+    buffer_put(&plan->literal, ':');
+    plan_value(plan, &entry->value, depth + 1);
+  }
+  buffer_put(&plan->literal, '}');
+}
+
+static void write_range(range_task_t *range) {
+  json_buffer_t *out = &range->out;
+  const json_value_t *value = range->value;
+  if (value->type == JSON_ARRAY) {
+    for (size_t i = range->begin; i < range->end && !out->failed; i++) {
+      buffer_put(out, ',');
+      write_value(out, &value->array->items[i]);
+    }
+    return;
+  }
+  const hash_entry_t *entries = value->object->entries;
+  for (size_t i = range->begin; i < range->end && !out->failed; i++) {
+    if (!hash_entry_live(&entries[i])) continue;
+    buffer_put(out, ',');
+    write_key(out, &entries[i]);
+    buffer_put(out, ':');
+    write_value(out, &entries[i].value);
+  }
+}
+
+static void *parallel_worker(void *arg) {
+  plan_t *plan = arg;
+  for (;;) {
+    size_t i = __atomic_fetch_add(&plan->next, 1, __ATOMIC_RELAXED);
+    if (i >= plan->ranges_len) break;
+    write_range(&plan->ranges[i]);
+  }
+  return NULL;
+}
+
+static void plan_free(plan_t *plan) {
+  for (size_t i = 0; i < plan->ranges_len; i++) {
+    json_buffer_free(&plan->ranges[i].out);
+  }
+  free(plan->ranges);
+  free(plan->pieces);
+  json_buffer_free(&plan->literal);
+}
+
+// sysconf() reads /sys on Linux; ask once
+static int online_cpus(void) {
+  static int cpus;
+  int n = __atomic_load_n(&cpus, __ATOMIC_RELAXED);
+  if (!n) {
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    n = online > 0 ? (int)online : 1;
+    __atomic_store_n(&cpus, n, __ATOMIC_RELAXED);
+  }
+  return n;
+}
+
+// Plan value and serialize its ranges. On success the pieces, in order,
+// hold the text; false if memory ran out.
+static bool plan_run(plan_t *plan, const json_value_t *value, const json_parallel_config_t *config) {
+  memset(plan, 0, sizeof(*plan));
+  plan->literal = json_buffer_init(BUFFER_MIN_CAP);
+  plan->min_split = config && config->min_split ? config->min_split : PARALLEL_DEFAULT_MIN_SPLIT;
+  plan->threads = config && config->threads > 0 ? config->threads : online_cpus();
+
+  plan_value(plan, value, 0);
+  plan_cut(plan);
+  if (plan->failed || plan->literal.failed) return false;
+
+  // The caller is one of the workers
+  int helpers = plan->threads - 1;
+  if ((size_t)helpers > plan->ranges_len) helpers = (int)plan->ranges_len;
+  if (helpers > 0 && plan->ranges_len > 1) {
+    pthread_t *tids = malloc(sizeof(pthread_t) * helpers);
+    int started = 0;
+    while (tids && started < helpers &&
+           pthread_create(&tids[started], NULL, parallel_worker, plan) == 0) {
+      started++;
+    }
+    parallel_worker(plan);
+    for (int i = 0; i < started; i++) {
+      pthread_join(tids[i], NULL);
+    }
+    free(tids);
+  } else {
+    parallel_worker(plan);
+  }
+
+  for (size_t i = 0; i < plan->ranges_len; i++) {
+    if (plan->ranges[i].out.failed) return false;
+  }
+  return true;
+}
+
+// Text of piece i; the leading comma of each container's first non-empty
+// range is dropped
+static const char *piece_text(plan_t *plan, size_t i, bool *skip, size_t *len) {
+  piece_t *piece = &plan->pieces[i];
+  if (!piece->is_range) {
+    *len = piece->len;
+    return plan->literal.data + piece->index;
+  }
+  range_task_t *range = &plan->ranges[piece->index];
+  if (range->leads) *skip = true;
+  size_t offset = 0;
+  if (*skip && range->out.len) {
+    offset = 1;
+    *skip = false;
+  }
+  *len = range->out.len - offset;
+  return range->out.data + offset;
+}
+
+char *json_serialize_parallel(const json_value_t *value, size_t *len,
+                              const json_parallel_config_t *config) {
+  plan_t plan;
+  if (!plan_run(&plan, value, config)) {
+    plan_free(&plan);
+    return NULL;
+  }
+  if (plan.ranges_len == 0) {
+    // Nothing was split: the literal is the whole text
+    buffer_put(&plan.literal, '\0');
+    char *text = plan.literal.failed ? NULL : plan.literal.data;
+    if (text) {
+      if (len) *len = plan.literal.len - 1;
+      plan.literal.data = NULL;
+    }
+    plan_free(&plan);
+    return text;
+  }
+  size_t total = 0;
+  for (size_t i = 0; i < plan.pieces_len; i++) {
+    total += plan.pieces[i].is_range ? plan.ranges[plan.pieces[i].index].out.len : plan.pieces[i].len;
+  }
+  char *text = malloc(total + 1);
+  size_t pos = 0;
+  bool skip = false;
+  for (size_t i = 0; text && i < plan.pieces_len; i++) {
+    size_t piece_len;
+    const char *piece = piece_text(&plan, i, &skip, &piece_len);
+    memcpy(text + pos, piece, piece_len);
+    pos += piece_len;
+  }
+  if (text) {
+    text[pos] = '\0';
+    if (len) *len = pos;
+  }
+  plan_free(&plan);
+  return text;
+}
+
+bool json_serialize_parallel_fd(const json_value_t *value, int fd,
+                                const json_parallel_config_t *config) {
+  plan_t plan;
+  bool ok = plan_run(&plan, value, config);
+  struct iovec iov[WRITEV_BATCH];
+  int count = 0;
+  bool skip = false;
+  for (size_t i = 0; ok && i < plan.pieces_len; i++) {
+    size_t piece_len;
+    const char *piece = piece_text(&plan, i, &skip, &piece_len);
+    if (!piece_len) continue;
+    iov[count].iov_base = (void *)piece;
+    iov[count].iov_len = piece_len;
+    if (++count == WRITEV_BATCH) {
+      ok = json_write_all(fd, iov, count);
+      count = 0;
+    }
+  }
+  if (ok && count) ok = json_write_all(fd, iov, count);
+  plan_free(&plan);
+  return ok;
+}
+
+// Spans shorter than this are copied into the literal text even when
+// gathering, where an iovec would cost more than the copy
+#define SPLICE_MIN_GATHER 256
+
+// Output in order: literal text written by the walk, or a run of input
+typedef struct {
+  const char *input;  // NULL for literal text
+  size_t offset;      // into the literal buffer
+  size_t len;
+} splice_piece_t;
+
+typedef struct {
+  json_buffer_t *out;
+  const json_spans_t *spans;
+  bool gather;           // list long spans as pieces instead of copying
+  size_t literal_start;  // literal text not yet in a piece
+  splice_piece_t *pieces;
+  size_t pieces_len;
+  size_t pieces_cap;
+  bool failed;
+} splice_t;
+
+static void splice_piece(splice_t *splice, const char *input, size_t offset, size_t len) {
+  if (splice->pieces_len == splice->pieces_cap) {
+    size_t new_cap = splice->pieces_cap ? splice->pieces_cap * 2 : 64;
+    splice_piece_t *grown = realloc(splice->pieces, new_cap * sizeof(splice_piece_t));
+    if (!grown) {
+      splice->failed = true;
+      return;
+    }
+    splice->pieces = grown;
+    splice->pieces_cap = new_cap;
+  }
+  splice->pieces[splice->pieces_len++] = (splice_piece_t){input, offset, len};
+}
+
+// End the literal piece before a run of input
+static void splice_cut(splice_t *splice) {
+  size_t len = splice->out->len - splice->literal_start;
+  if (len) splice_piece(splice, NULL, splice->literal_start, len);
+  splice->literal_start = splice->out->len;
+}
+
+static void write_spliced(splice_t *splice, const json_value_t *value) {
+  json_buffer_t *buffer = splice->out;
+  const json_span_t *span = json_spans_find(splice->spans, value);
+  if (span) {
+    const char *text = splice->spans->input + span->start;
+    if (splice->gather && span->len >= SPLICE_MIN_GATHER) {
+      splice_cut(splice);
+      splice_piece(splice, text, 0, span->len);
+    } else {
+      buffer_append(buffer, text, span->len);
+    }
+    return;
+  }
+
+  // Edited container: written afresh around its children, which may
+  // still be copied
+  switch (value->type) {
+    case JSON_ARRAY:
+      buffer_put(buffer, '[');
+      for (size_t i = 0, len = json_array_len(value); i < len && !buffer->failed; i++) {
+        if (i) buffer_put(buffer, ',');
+        write_spliced(splice, &value->array->items[i]);
+      }
+      buffer_put(buffer, ']');
+      break;
+    case JSON_OBJECT: {
+      buffer_put(buffer, '{');
+      json_object_iter_t it = json_object_iter(value);
+      bool first = true;
+      for (const hash_entry_t *entry; !buffer->failed && (entry = json_object_next(&it));) {
+        if (!first) buffer_put(buffer, ',');
+        first = false;
+        write_key(buffer, entry);
+        buffer_put(buffer, ':');
+        write_spliced(splice, &entry->value);
+      }
+      buffer_put(buffer, '}');
+      break;
+    }
+    default:
+      write_value(buffer, value);
+      break;
+  }
+}
+
+bool json_serialize_spliced_into(json_buffer_t *buffer, const json_value_t *value,
+                                 const json_spans_t *spans) {
+  splice_t splice = {
+    .out = buffer,
+    .spans = spans,
+    .gather = false,
+  };
+  write_spliced(&splice, value);
+  buffer_put(buffer, '\0');
+  if (buffer->failed) return false;
+  buffer->len--;
+  return true;
+}
+
+char *json_serialize_spliced(const json_value_t *value, const json_spans_t *spans, size_t *len) {
+  json_buffer_t buffer = json_buffer_init(BUFFER_MIN_CAP);
+  if (!json_serialize_spliced_into(&buffer, value, spans)) {
+    json_buffer_free(&buffer);
+    return NULL;
+  }
+  if (len) *len = buffer.len;
+  return buffer.data;
+}
+
+bool json_serialize_spliced_fd(const json_value_t *value, const json_spans_t *spans, int fd) {
+  json_buffer_t literal = json_buffer_init(BUFFER_MIN_CAP);
+  splice_t splice = {
+    .out = &literal,
+    .spans = spans,
+    .gather = true,
+  };
+  write_spliced(&splice, value);
+  splice_cut(&splice);
+  bool ok = !literal.failed && !splice.failed;
+
+  // Pieces hold offsets until now, as the literal buffer moved as it grew
+  struct iovec iov[WRITEV_BATCH];
+  int count = 0;
+  for (size_t i = 0; ok && i < splice.pieces_len; i++) {
+    splice_piece_t *piece = &splice.pieces[i];
+    iov[count].iov_base = (void *)(piece->input ? piece->input : literal.data + piece->offset);
+    iov[count].iov_len = piece->len;
+    if (++count == WRITEV_BATCH) {
+      ok = json_write_all(fd, iov, count);
+      count = 0;
+    }
+  }
+  if (ok && count) ok = json_write_all(fd, iov, count);
+  free(splice.pieces);
+  json_buffer_free(&literal);
+  return ok;
+}
+
+// Canonical output (RFC 8785). Object members are sorted on a stack shared
+// by all open objects, so the scratch arrays grow to the document's widest
+// nesting once and are reused by every object after that.
+
+#define CANONICAL_INSERTION_SORT_MAX 16
+#define CANONICAL_BAD_CODE_POINT 0xFFFFFFFFu
+
+// Member being sorted: its key as decoded UTF-8 (the stored key itself
+// when it has no escapes), with the first eight bytes in big-endian order
+// so most comparisons are one integer compare
+typedef struct {
+  uint64_t prefix;
+  const char *key;
+  size_t key_len;
+  const hash_entry_t *entry;
+} canonical_member_t;
+
+typedef struct {
+  json_buffer_t *out;
+  canonical_member_t *members;  // members of every open object, innermost last
+  size_t members_len;
+  size_t members_cap;
+  json_buffer_t keys;           // decoded keys of the object being sorted
+  bool invalid;                 // input RFC 8785 cannot represent
+} canonical_t;
+
+static inline uint32_t hex4(const char *s) {
+  uint32_t value = 0;
+  for (int i = 0; i < 4; i++) {
+    char ch = s[i];
+    value = value * 16 + (uint32_t)(ch <= '9' ? ch - '0' : (ch | 0x20) - 'a' + 10);
+  }
+  return value;
+}
+
+// Code point of the escape sequence at s (json_escape_length() > 0),
+// joining a surrogate pair; *used is the input consumed. A lone surrogate
+// gives CANONICAL_BAD_CODE_POINT.
+static uint32_t escape_code_point(const char *s, size_t len, size_t *used) {
+  *used = 2;
+  switch (s[1]) {
+    case 'b': return '\b';
+    case 'f': return '\f';
+    case 'n': return '\n';
+    case 'r': return '\r';
+    case 't': return '\t';
+    case 'u': break;
+    default: return (unsigned char)s[1];
+  }
+  *used = 6;
+  uint32_t cp = hex4(s + 2);
+  if (cp < 0xD800 || cp > 0xDFFF) return cp;
+  if (cp >= 0xDC00 || len < 12 || s[6] != '\\' || json_escape_length(s + 6, len - 6) != 6 || s[7] != 'u') {
+    return CANONICAL_BAD_CODE_POINT;
+  }
+  uint32_t low = hex4(s + 8);
+  if (low < 0xDC00 || low > 0xDFFF) return CANONICAL_BAD_CODE_POINT;
+  *used = 12;
+  return 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+}
+
+static inline size_t utf8_encode(char out[4], uint32_t cp) {
+  if (cp < 0x80) {
+    out[0] = (char)cp;
+    return 1;
+  }
+  if (cp < 0x800) {
+    out[0] = (char)(0xC0 | (cp >> 6));
+    out[1] = (char)(0x80 | (cp & 0x3F));
+    return 2;
+  }
+  if (cp < 0x10000) {
+    out[0] = (char)(0xE0 | (cp >> 12));
+    out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    out[2] = (char)(0x80 | (cp & 0x3F));
+    return 3;
+  }
+  out[0] = (char)(0xF0 | (cp >> 18));
+  out[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+  out[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+  out[3] = (char)(0x80 | (cp & 0x3F));
+  return 4;
+}
+
+// Decoded form of string s, appended to out: escape sequences become the
+// characters they stand for, anything else is copied
+static void decode_string(canonical_t *canonical, json_buffer_t *out, const char *s, size_t len) {
+  size_t i = 0;
+  while (i < len) {
+    const char *backslash = memchr(s + i, '\\', len - i);
+    size_t run = backslash ? (size_t)(backslash - (s + i)) : len - i;
+    buffer_append(out, s + i, run);
+    i += run;
+    if (i == len) break;
+
+    size_t used = 1;
+    char utf8[4];
+    size_t utf8_len = 1;
+    utf8[0] = '\\';
+    if (json_escape_length(s + i, len - i)) {
+      uint32_t cp = escape_code_point(s + i, len - i, &used);
+      if (cp == CANONICAL_BAD_CODE_POINT) {
+        canonical->invalid = true;
+        return;
+      }
+      utf8_len = utf8_encode(utf8, cp);
+    }
+    buffer_append(out, utf8, utf8_len);
+    i += used;
+  }
+}
+
+// String with the minimal escaping of RFC 8785: quote, backslash and
+// control characters only, the controls in their short forms where JSON
+// has one and as lowercase \u00xx otherwise
+static void write_canonical_string(canonical_t *canonical, const char *s, size_t len) {
+  json_buffer_t *buffer = canonical->out;
+  buffer_put(buffer, '"');
+  size_t i = 0;
+  while (i < len) {
+    size_t run = json_escape_clean_run(s + i, len - i);
+    buffer_append(buffer, s + i, run);
+    i += run;
+    if (i == len) break;
+
+    char escaped[JSON_ESCAPE_MAX_LEN];
+    size_t used;
+    if (s[i] == '\\' && json_escape_length(s + i, len - i)) {
+      uint32_t cp = escape_code_point(s + i, len - i, &used);
+      if (cp == CANONICAL_BAD_CODE_POINT) {
+        canonical->invalid = true;
+        return;
+      }
+      i += used;
+      if (cp >= 0x20 && cp != '"' && cp != '\\') {
+        char utf8[4];
+        buffer_append(buffer, utf8, utf8_encode(utf8, cp));
+        continue;
+      }
+      // Escape the decoded character afresh; a lone backslash is not an
+      // escape, so it comes out doubled
+      char ch = (char)cp;
+      size_t ignored;
+      buffer_append(buffer, escaped, json_escape_special(&ch, 1, escaped, &ignored));
+      continue;
+    }
+    buffer_append(buffer, escaped, json_escape_special(s + i, len - i, escaped, &used));
+    i += used;
+  }
+  buffer_put(buffer, '"');
+}
+
+static inline uint64_t key_prefix(const char *key, size_t len) {
+  uint64_t word = 0;
+  memcpy(&word, key, len < 8 ? len : 8);
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  word = __builtin_bswap64(word);
+#endif
+  return word;
+}
+
+// Order of the first differing bytes of two UTF-8 keys, by UTF-16 code
+// units. Byte order is code point order, which differs from UTF-16 order
+// only between U+E000..U+FFFF (lead bytes EE, EF) and the supplementary
+// planes (lead bytes F0..F4), which UTF-16 writes as surrogates D800..DFFF.
+static inline int utf16_byte_order(uint8_t a, uint8_t b) {
+  bool a_supplementary = a >= 0xF0, b_supplementary = b >= 0xF0;
+  if (a_supplementary != b_supplementary && (a_supplementary ? b : a) >= 0xEE) {
+    return a_supplementary ? -1 : 1;
+  }
+  return a < b ? -1 : 1;
+}
+
+static int canonical_compare(const canonical_member_t *a, const canonical_member_t *b) {
+  if (a->prefix != b->prefix) {
+    int shift = __builtin_clzll(a->prefix ^ b->prefix) & ~7;
+    return utf16_byte_order((uint8_t)((a->prefix << shift) >> 56), (uint8_t)((b->prefix << shift) >> 56));
+  }
+  size_t common = a->key_len < b->key_len ? a->key_len : b->key_len;
+  for (size_t i = 8; i < common; i++) {
+    if (a->key[i] != b->key[i]) return utf16_byte_order((uint8_t)a->key[i], (uint8_t)b->key[i]);
+  }
+  return a->key_len < b->key_len ? -1 : a->key_len > b->key_len;
+}
+
+static void canonical_insertion_sort(canonical_member_t *members, size_t count) {
+  for (size_t i = 1; i < count; i++) {
+    canonical_member_t member = members[i];
+    size_t j = i;
+    while (j > 0 && canonical_compare(&member, &members[j - 1]) < 0) {
+      members[j] = members[j - 1];
+      j--;
+    }
+    members[j] = member;
+  }
+}
+
+// Merge sort of count members using scratch space for count more
+static void canonical_sort(canonical_member_t *members, size_t count, canonical_member_t *scratch) {
+  if (count <= CANONICAL_INSERTION_SORT_MAX) {
+    canonical_insertion_sort(members, count);
+    return;
+  }
+  size_t half = count / 2;
+  canonical_sort(members, half, scratch);
+  canonical_sort(members + half, count - half, scratch);
+  if (canonical_compare(&members[half - 1], &members[half]) < 0) return;
+
+  memcpy(scratch, members, half * sizeof(canonical_member_t));
+  size_t i = 0, j = half, k = 0;
+  while (i < half && j < count) {
+    members[k++] = canonical_compare(&members[j], &scratch[i]) < 0 ? members[j++] : scratch[i++];
+  }
+  memcpy(members + k, scratch + i, (half - i) * sizeof(canonical_member_t));
+}
+
+static void write_canonical(canonical_t *canonical, const json_value_t *value);
+
+static void write_canonical_object(canonical_t *canonical, const json_value_t *value) {
+  json_buffer_t *buffer = canonical->out;
+  size_t count = value->object ? value->object->size : 0;
+  buffer_put(buffer, '{');
+
+  // Room for the members and the merge scratch
+  size_t base = canonical->members_len;
+  if (base + 2 * count > canonical->members_cap) {
+    size_t cap = canonical->members_cap ? canonical->members_cap : 64;
+    while (cap < base + 2 * count) cap *= 2;
+    canonical_member_t *grown = realloc(canonical->members, cap * sizeof(canonical_member_t));
+    if (!grown) {
+      buffer->failed = true;
+      return;
+    }
+    canonical->members = grown;
+    canonical->members_cap = cap;
+  }
+
+  // Keys with escapes are decoded into keys, reserved up front so the
+  // pointers taken into it stay put; decoding never lengthens a key
+  canonical_member_t *members = canonical->members + base;
+  json_object_iter_t it = json_object_iter(value);
+  size_t n = 0, escaped_len = 0;
+  for (const hash_entry_t *entry; (entry = json_object_next(&it));) {
+    members[n].entry = entry;
+    json_str_t key = hash_entry_key(entry);
+    members[n].key = key.str;
+    members[n].key_len = key.len;
+    if (memchr(key.str, '\\', key.len)) {
+      members[n].key = NULL;
+      escaped_len += key.len;
+    }
+    n++;
+  }
+  size_t keys_mark = canonical->keys.len;
+  if (escaped_len && !buffer_reserve(&canonical->keys, escaped_len)) {
+    buffer->failed = true;
+    return;
+  }
+  for (size_t i = 0; i < n; i++) {
+    canonical_member_t *member = &members[i];
+    if (!member->key) {
+      size_t start = canonical->keys.len;
+      json_str_t key = hash_entry_key(member->entry);
+      decode_string(canonical, &canonical->keys, key.str, key.len);
+      member->key = canonical->keys.data + start;
+      member->key_len = canonical->keys.len - start;
+    }
+    member->prefix = key_prefix(member->key, member->key_len);
+  }
+
+  canonical_sort(members, n, members + n);
+  // Keys that differed only in their escapes are the same key now
+  for (size_t i = 1; i < n; i++) {
+    if (canonical_compare(&members[i - 1], &members[i]) == 0) canonical->invalid = true;
+  }
+  canonical->keys.len = keys_mark;
+
+  canonical->members_len = base + n;
+  for (size_t i = 0; i < n && !buffer->failed && !canonical->invalid; i++) {
+    // Nested objects may move the stack
+    const hash_entry_t *entry = canonical->members[base + i].entry;
+    if (i) buffer_put(buffer, ',');
+    json_str_t key = hash_entry_key(entry);
+    write_canonical_string(canonical, key.str, key.len);
+    buffer_put(buffer, ':');
+    write_canonical(canonical, &entry->value);
+  }
+  canonical->members_len = base;
+  buffer_put(buffer, '}');
+}
+
+static void write_canonical(canonical_t *canonical, const json_value_t *value) {
+  json_buffer_t *buffer = canonical->out;
+  switch (value->type) {
+    case JSON_NUMBER:
+      if (!isfinite(value->number)) {
+        canonical->invalid = true;
+        return;
+      }
+      if (buffer_reserve(buffer, JSON_DOUBLE_MAX_LEN)) {
+        buffer->len += json_format_double_exact(buffer->data + buffer->len, value->number);
+      }
+      break;
+    case JSON_STRING: {
+      json_str_t str = json_get_str(value);
+      write_canonical_string(canonical, str.str, str.len);
+      break;
+    }
+    case JSON_ARRAY:
+      buffer_put(buffer, '[');
+      for (size_t i = 0, len = json_array_len(value); i < len && !buffer->failed && !canonical->invalid; i++) {
+        if (i) buffer_put(buffer, ',');
+        write_canonical(canonical, &value->array->items[i]);
+      }
+      buffer_put(buffer, ']');
+      break;
+    case JSON_OBJECT:
+      write_canonical_object(canonical, value);
+      break;
+    default:
+      write_value(buffer, value);
+      break;
+  }
+}
+
+bool json_serialize_canonical_into(json_buffer_t *buffer, const json_value_t *value) {
+  canonical_t canonical = {
+    .out = buffer,
+    .keys = json_buffer_init(0),
+    .invalid = false,
+  };
+  write_canonical(&canonical, value);
+  free(canonical.members);
+  json_buffer_free(&canonical.keys);
+  buffer_put(buffer, '\0');
+  if (buffer->failed || canonical.invalid) return false;
+  buffer->len--;
+  return true;
+}
+
+char *json_serialize_canonical(const json_value_t *value, size_t *len) {
+  json_buffer_t buffer = json_buffer_init(BUFFER_MIN_CAP);
+  if (!json_serialize_canonical_into(&buffer, value)) {
+    json_buffer_free(&buffer);
+    return NULL;
+  }
+  if (len) *len = buffer.len;
+  return buffer.data;
+}
@@ -0,0 +1,165 @@
+#include "../include/span.h"
+#include "../include/parser.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define SPANS_MIN_CAP 64
+
+// Pool allocations are at least 8-byte aligned, so drop the low bits
+// before the multiplicative hash
+static inline size_t span_hash(const void *storage) {
+  return (size_t)(((uintptr_t)storage >> 3) * 0x9E3779B97F4A7C15ULL >> 16);
+}
+
+json_spans_t json_spans_init(void) {
+  json_spans_t spans = {
+    .input = NULL,
+    .slots = NULL,
+    .capacity = 0,
+    .size = 0,
+    .generation = __atomic_load_n(&json_span_generation, __ATOMIC_RELAXED),
+  };
+  return spans;
+}
+
+void json_spans_free(json_spans_t *spans) {
+  free(spans->slots);
+  *spans = json_spans_init();
+}
+
+void json_spans_clear(json_spans_t *spans) {
+  if (spans->slots) {
+    memset(spans->slots, 0, spans->capacity * sizeof(json_span_t));
+  }
+  spans->size = 0;
+  spans->input = NULL;
+  spans->generation = __atomic_load_n(&json_span_generation, __ATOMIC_RELAXED);
+}
+
+// Slot holding storage, or the empty slot where it would go
+static json_span_t *span_slot(const json_spans_t *spans, const void *storage) {
+  size_t mask = spans->capacity - 1;
+  size_t pos = span_hash(storage) & mask;
+  while (spans->slots[pos].storage && spans->slots[pos].storage != storage) {
+    pos = (pos + 1) & mask;
+  }
+  return &spans->slots[pos];
+}
+
+static bool spans_grow(json_spans_t *spans) {
+  size_t new_capacity = spans->capacity ? spans->capacity * 2 : SPANS_MIN_CAP;
+  json_span_t *slots = calloc(new_capacity, sizeof(json_span_t));
+  if (!slots) return false;
+
+  json_spans_t grown = *spans;
+  grown.slots = slots;
+  grown.capacity = new_capacity;
+  for (size_t i = 0; i < spans->capacity; i++) {
+    if (spans->slots[i].storage) {
+      *span_slot(&grown, spans->slots[i].storage) = spans->slots[i];
+    }
+  }
+
+  free(spans->slots);
+  *spans = grown;
+  return true;
+}
+
+bool json_spans_add(json_spans_t *spans, const void *storage, size_t start, size_t len) {
+  if ((spans->size + 1) * 2 > spans->capacity && !spans_grow(spans)) {
+    return false;
+  }
+  json_span_t *slot = span_slot(spans, storage);
+  if (!slot->storage) spans->size++;
+  slot->storage = storage;
+  slot->start = start;
+  slot->len = len;
+  return true;
+}
+
+const json_span_t *json_spans_find(const json_spans_t *spans, const json_value_t *value) {
+  if (!spans || !spans->size || !(value->flags & JSON_VALUE_SPAN)) return NULL;
+  if (spans->generation != __atomic_load_n(&json_span_generation, __ATOMIC_RELAXED)) return NULL;
+
+  const void *storage;
+  if (value->type == JSON_ARRAY) {
+    storage = value->array;
+  } else if (value->type == JSON_OBJECT) {
+    storage = value->object;
+  } else {
+    return NULL;
+  }
+  json_span_t *slot = span_slot(spans, storage);
+  return slot->storage ? slot : NULL;
+}
+
+// Parsed values compare exactly: numbers by value, strings and keys by
+// their stored bytes
+static bool span_values_equal(const json_value_t *a, const json_value_t *b) {
+  if (a->type != b->type) return false;
+  switch (a->type) {
+    case JSON_NULL: return true;
+    case JSON_BOOL: return a->boolean == b->boolean;
+    case JSON_NUMBER: return a->number == b->number;
+    case JSON_STRING: {
+      json_str_t sa = json_get_str(a), sb = json_get_str(b);
+      return sa.len == sb.len && memcmp(sa.str, sb.str, sa.len) == 0;
+    }
+    case JSON_ARRAY: {
+      size_t len = json_array_len(a);
+      if (len != json_array_len(b)) return false;
+      for (size_t i = 0; i < len; i++) {
+        if (!span_values_equal(json_array_at(a, i), json_array_at(b, i))) return false;
+      }
+      return true;
+    }
+    case JSON_OBJECT: {
+      size_t size = a->object ? a->object->size : 0;
+      if (size != (b->object ? b->object->size : 0)) return false;
+      json_object_iter_t it = json_object_iter(a);
+      for (const hash_entry_t *entry; (entry = json_object_next(&it));) {
+        json_str_t key = hash_entry_key(entry);
+        const json_value_t *other = hash_table_get(b->object, key.str, key.len);
+        if (!other || !span_values_equal(&entry->value, other)) return false;
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool span_text_matches(const json_spans_t *spans, const json_span_t *span, const json_value_t *value) {
+  char *text = malloc(span->len + 1);
+  if (!text) return false;
+  memcpy(text, spans->input + span->start, span->len);
+  text[span->len] = '\0';
+
+  lexer_t lexer = lexer_init_view(text, span->len);
+  parser_t parser = parser_init(&lexer);
+  parser.current_token = next_token(&lexer);
+  json_value_t parsed = parse(&parser);
+  bool same = !parser.has_error && span_values_equal(&parsed, value);
+  parser_free(&parser);
+  lexer_free(&lexer);
+  free(text);
+  return same;
+}
+
+bool json_spans_verify(const json_spans_t *spans, const json_value_t *value) {
+  const json_span_t *span = json_spans_find(spans, value);
+  if (span) return span_text_matches(spans, span, value);
+
+  // Written afresh; its children may still be copied
+  if (value->type == JSON_ARRAY) {
+    for (size_t i = 0, len = json_array_len(value); i < len; i++) {
+      if (!json_spans_verify(spans, json_array_at(value, i))) return false;
+    }
+  } else if (value->type == JSON_OBJECT) {
+    json_object_iter_t it = json_object_iter(value);
+    for (const hash_entry_t *entry; (entry = json_object_next(&it));) {
+      if (!json_spans_verify(spans, &entry->value)) return false;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,372 @@
+#include "../include/writer.h"
+#include "../include/dtoa.h"
+#include "../include/escape.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define WRITER_DEFAULT_CHUNK_SIZE (64 * 1024)
+#define WRITER_DEFAULT_CHUNKS 4
+#define WRITER_MIN_CHUNK_SIZE 64
+
+// Frame flags
+#define FRAME_OBJECT 0x01
+#define FRAME_NONEMPTY 0x02
+
+__attribute__((cold))
+static void writer_error(json_writer_t *writer, const char *msg) {
+  if (writer->has_error) return;
+  writer->has_error = true;
+  snprintf(writer->error_message, sizeof(writer->error_message), "Writer error: %s", msg);
+}
+
+static json_writer_t writer_init(const json_writer_config_t *config) {
+  json_writer_t writer = {
+    .chunk_size = WRITER_DEFAULT_CHUNK_SIZE,
+    .max_chunks = WRITER_DEFAULT_CHUNKS,
+    .fd = -1,
+    .has_error = false,
+  };
+  if (config) {
+    if (config->chunk_size) {
+      writer.chunk_size = config->chunk_size < WRITER_MIN_CHUNK_SIZE ? WRITER_MIN_CHUNK_SIZE
+                                                                     : config->chunk_size;
+    }
+    if (config->max_chunks > 0) {
+      writer.max_chunks = config->max_chunks < JSON_WRITER_MAX_CHUNKS ? config->max_chunks
+                                                                      : JSON_WRITER_MAX_CHUNKS;
+    }
+    writer.indent = config->indent > 0 ? config->indent : 0;
+  }
+  writer.chunks[0] = malloc(writer.chunk_size);
+  if (!writer.chunks[0]) {
+    writer_error(&writer, "Out of memory");
+  }
+  return writer;
+}
+
+json_writer_t json_writer_init_fd(int fd, const json_writer_config_t *config) {
+  json_writer_t writer = writer_init(config);
+  writer.fd = fd;
+  return writer;
+}
+
+json_writer_t json_writer_init_fn(json_write_fn fn, void *ctx, const json_writer_config_t *config) {
+  json_writer_t writer = writer_init(config);
+  writer.fn = fn;
+  writer.ctx = ctx;
+  return writer;
+}
+
+void json_writer_free(json_writer_t *writer) {
+  for (int i = 0; i < JSON_WRITER_MAX_CHUNKS; i++) {
+    free(writer->chunks[i]);
+    writer->chunks[i] = NULL;
+  }
+  free(writer->frames);
+  writer->frames = NULL;
+  writer->depth = writer->frames_cap = 0;
+  writer->chunk = 0;
+  writer->len = 0;
+}
+
+bool json_write_all(int fd, struct iovec *iov, int count) {
+  while (count > 0) {
+    ssize_t n = writev(fd, iov, count);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    while (count > 0 && (size_t)n >= iov->iov_len) {
+      n -= iov->iov_len;
+      iov++;
+      count--;
+    }
+    if (count > 0) {
+      iov->iov_base = (char *)iov->iov_base + n;
+      iov->iov_len -= n;
+    }
+  }
+  return true;
+}
+
+// Send every buffered chunk, then extra, in one gather call and start over
+// at the first chunk
+static bool writer_send(json_writer_t *writer, const char *extra, size_t extra_len) {
+  if (writer->has_error) return false;
+  struct iovec iov[JSON_WRITER_MAX_CHUNKS + 1];
+  int count = 0;
+  size_t total = 0;
+  for (int i = 0; i <= writer->chunk; i++) {
+    size_t len = i < writer->chunk ? writer->chunk_size : writer->len;
+    if (!len) continue;
+    iov[count].iov_base = writer->chunks[i];
+    iov[count].iov_len = len;
+    total += len;
+    count++;
+  }
+  if (extra_len) {
+    iov[count].iov_base = (void *)extra;
+    iov[count].iov_len = extra_len;
+    total += extra_len;
+    count++;
+  }
+  writer->chunk = 0;
+  writer->len = 0;
+  if (!count) return true;
+
+  if (writer->fd >= 0) {
+    if (!json_write_all(writer->fd, iov, count)) {
+      char msg[96];
+      snprintf(msg, sizeof(msg), "write failed: %s", strerror(errno));
+      writer_error(writer, msg);
+      return false;
+    }
+  } else if (!writer->fn || !writer->fn(writer->ctx, iov, count)) {
+    writer_error(writer, "Write callback failed");
+    return false;
+  }
+  writer->written += total;
+  return true;
+}
+
+// Move to the next chunk, or flush when the last one is full
+__attribute__((noinline))
+static bool writer_next_chunk(json_writer_t *writer) {
+  if (writer->chunk + 1 >= writer->max_chunks) {
+    return writer_send(writer, NULL, 0);
+  }
+  int next = writer->chunk + 1;
+  if (!writer->chunks[next]) {
+    writer->chunks[next] = malloc(writer->chunk_size);
+    if (!writer->chunks[next]) {
+      writer_error(writer, "Out of memory");
+      return false;
+    }
+  }
+  writer->chunk = next;
+  writer->len = 0;
+  return true;
+}
+
+static inline void writer_put(json_writer_t *writer, const char *data, size_t len) {
+  while (len) {
+    size_t room = writer->chunk_size - writer->len;
+    if (__builtin_expect(room == 0, 0)) {
+      if (!writer_next_chunk(writer)) return;
+      room = writer->chunk_size;
+    }
+    size_t n = len < room ? len : room;
+    memcpy(writer->chunks[writer->chunk] + writer->len, data, n);
+    writer->len += n;
+    data += n;
+    len -= n;
+  }
+}
+
+static inline void writer_put_char(json_writer_t *writer, char ch) {
+  if (__builtin_expect(writer->len == writer->chunk_size, 0) && !writer_next_chunk(writer)) return;
+  writer->chunks[writer->chunk][writer->len++] = ch;
+}
+
+static void writer_newline(json_writer_t *writer, size_t depth) {
+  static const char spaces[] = "                                                                ";
+  writer_put_char(writer, '\n');
+  size_t count = depth * (size_t)writer->indent;
+  while (count) {
+    size_t n = count < sizeof(spaces) - 1 ? count : sizeof(spaces) - 1;
+    writer_put(writer, spaces, n);
+    count -= n;
+  }
+}
+
+// Quoted string. Text has every special byte escaped; raw strings are
+// stored source form, whose valid escapes pass through.
+static void writer_string(json_writer_t *writer, const char *s, size_t len, bool raw) {
+  writer_put_char(writer, '"');
+  size_t i = 0;
+  while (i < len && !writer->has_error) {
+    size_t run = json_escape_clean_run(s + i, len - i);
+    if (run >= writer->chunk_size) {
+      // Too long to be worth copying: send it straight after the buffer
+      writer_send(writer, s + i, run);
+    } else {
+      writer_put(writer, s + i, run);
+    }
+    i += run;
+    if (i == len) break;
+
+    char escaped[JSON_ESCAPE_MAX_LEN];
+    if (raw) {
+      size_t used;
+      writer_put(writer, escaped, json_escape_special(s + i, len - i, escaped, &used));
+      i += used;
+    } else {
+      writer_put(writer, escaped, json_escape_text((unsigned char)s[i++], escaped));
+    }
+  }
+  writer_put_char(writer, '"');
+}
+
+// Write what goes before a value: the separator and indentation of an
+// array element, or nothing after a key. False if no value belongs here.
+static bool writer_value_start(json_writer_t *writer) {
+  if (writer->has_error) return false;
+  if (writer->depth == 0) {
+    if (writer->done) {
+      writer_error(writer, "Document already has a root value");
+      return false;
+    }
+    return true;
+  }
+  uint8_t *frame = &writer->frames[writer->depth - 1];
+  if (*frame & FRAME_OBJECT) {
+    if (!writer->has_key) {
+      writer_error(writer, "Object member needs a key");
+      return false;
+    }
+    writer->has_key = false;
+    return true;
+  }
+  if (*frame & FRAME_NONEMPTY) writer_put_char(writer, ',');
+  *frame |= FRAME_NONEMPTY;
+  if (writer->indent) writer_newline(writer, writer->depth);
+  return true;
+}
+
+static inline void writer_value_end(json_writer_t *writer) {
+  if (writer->depth == 0) writer->done = true;
+}
+
+static void writer_begin(json_writer_t *writer, bool is_object) {
+  if (!writer_value_start(writer)) return;
+  if (writer->depth == writer->frames_cap) {
+    size_t cap = writer->frames_cap ? writer->frames_cap * 2 : 32;
+    uint8_t *frames = realloc(writer->frames, cap);
+    if (!frames) {
+      writer_error(writer, "Out of memory");
+      return;
+    }
+    writer->frames = frames;
+    writer->frames_cap = cap;
+  }
+  writer->frames[writer->depth++] = is_object ? FRAME_OBJECT : 0;
+  writer_put_char(writer, is_object ? '{' : '[');
+}
+
+void json_writer_begin_object(json_writer_t *writer) {
+  writer_begin(writer, true);
+}
+
+void json_writer_begin_array(json_writer_t *writer) {
+  writer_begin(writer, false);
+}
+
+void json_writer_end(json_writer_t *writer) {
+  if (writer->has_error) return;
+  if (writer->depth == 0) {
+    writer_error(writer, "End without an open container");
+    return;
+  }
+  if (writer->has_key) {
+    writer_error(writer, "Key without a value");
+    return;
+  }
+  uint8_t frame = writer->frames[--writer->depth];
+  if (writer->indent && (frame & FRAME_NONEMPTY)) writer_newline(writer, writer->depth);
+  writer_put_char(writer, (frame & FRAME_OBJECT) ? '}' : ']');
+  writer_value_end(writer);
+}
+
+static void writer_key(json_writer_t *writer, const char *key, size_t len, bool raw) {
+  if (writer->has_error) return;
+  if (writer->depth == 0 || !(writer->frames[writer->depth - 1] & FRAME_OBJECT)) {
+    writer_error(writer, "Key outside an object");
+    return;
+  }
+  if (writer->has_key) {
+    writer_error(writer, "Key without a value");
+    return;
+  }
+  uint8_t *frame = &writer->frames[writer->depth - 1];
+  if (*frame & FRAME_NONEMPTY) writer_put_char(writer, ',');
+  *frame |= FRAME_NONEMPTY;
+  if (writer->indent) writer_newline(writer, writer->depth);
+  writer_string(writer, key, len, raw);
+  if (writer->indent) {
+    writer_put(writer, ": ", 2);
+  } else {
+    writer_put_char(writer, ':');
+  }
+  writer->has_key = true;
+}
+
+void json_writer_key(json_writer_t *writer, const char *key, size_t len) {
+  writer_key(writer, key, len, false);
+}
+
+void json_writer_key_raw(json_writer_t *writer, const char *key, size_t len) {
+  writer_key(writer, key, len, true);
+}
+
+void json_writer_string(json_writer_t *writer, const char *str, size_t len) {
+  if (!writer_value_start(writer)) return;
+  writer_string(writer, str, len, false);
+  writer_value_end(writer);
+}
+
+void json_writer_string_raw(json_writer_t *writer, const char *str, size_t len) {
+  if (!writer_value_start(writer)) return;
+  writer_string(writer, str, len, true);
+  writer_value_end(writer);
+}
+
+void json_writer_number(json_writer_t *writer, double number) {
+  if (!writer_value_start(writer)) return;
+  char text[JSON_DOUBLE_MAX_LEN];
+  writer_put(writer, text, json_format_double(text, number));
+  writer_value_end(writer);
+}
+
+void json_writer_bool(json_writer_t *writer, bool boolean) {
+  if (!writer_value_start(writer)) return;
+  if (boolean) {
+    writer_put(writer, "true", 4);
+  } else {
+    writer_put(writer, "false", 5);
+  }
+  writer_value_end(writer);
+}
+
+void json_writer_null(json_writer_t *writer) {
+  if (!writer_value_start(writer)) return;
+  writer_put(writer, "null", 4);
+  writer_value_end(writer);
+}
+
+void json_writer_raw(json_writer_t *writer, const char *text, size_t len) {
+  if (!writer_value_start(writer)) return;
+  writer_put(writer, text, len);
+  writer_value_end(writer);
+}
+
+bool json_writer_in_object(const json_writer_t *writer) {
+  return writer->depth > 0 && (writer->frames[writer->depth - 1] & FRAME_OBJECT);
+}
+
+bool json_writer_flush(json_writer_t *writer) {
+  return writer_send(writer, NULL, 0);
+}
+
+bool json_writer_finish(json_writer_t *writer) {
+  if (!writer->has_error && writer->depth > 0) {
+    writer_error(writer, "Unclosed container");
+  }
+  if (!writer->has_error && !writer->done) {
+    writer_error(writer, "Nothing written");
+  }
+  return json_writer_flush(writer);
+}
@@ -0,0 +1,279 @@
+#include "../include/builder.h"
+#include "../include/parser.h"
+#include "../include/serializer.h"
+#include "test_framework.h"
+
+#include <string.h>
+
+TEST_SUITE_INIT()
+
+void test_builder_nested() {
+  printf("\n=== Testing builder nesting ===\n");
+
+  json_builder_t b = json_builder_init(NULL);
+  json_builder_begin_object(&b);
+  json_builder_key(&b, "id", 2);
+  json_builder_number(&b, 42);
+  json_builder_key(&b, "name", 4);
+  json_builder_string(&b, "widget", 6);
+  json_builder_key(&b, "tags", 4);
+  json_builder_begin_array(&b);
+  json_builder_string(&b, "a", 1);
+  json_builder_bool(&b, true);
+  json_builder_null(&b);
+  json_builder_begin_object(&b);
+  json_builder_key(&b, "deep", 4);
+  json_builder_number(&b, 1.5);
+  json_builder_end(&b);
+  json_builder_end(&b);
+  json_builder_key(&b, "empty", 5);
+  json_builder_begin_object(&b);
+  json_builder_end(&b);
+  json_builder_key(&b, "last", 4);
+  json_builder_bool(&b, false);
+  json_builder_end(&b);
+  json_value_t doc = json_builder_finish(&b);
+
+  TEST_ASSERT(!b.has_error, "Well-formed calls should not set an error");
+  TEST_ASSERT(doc.type == JSON_OBJECT && json_object_size(&doc) == 5, "Root should be an object with 5 members");
+  TEST_ASSERT(json_object_get(&doc, "id").number == 42, "Number member should be stored");
+
+  json_value_t name = json_object_get(&doc, "name");
+  TEST_ASSERT(name.type == JSON_STRING && strcmp(json_get_string(&name), "widget") == 0, "String member should be copied");
+  TEST_ASSERT(name.flags & JSON_VALUE_INLINE, "Short builder strings should be stored inline");
+
+  json_value_t tags = json_object_get(&doc, "tags");
+  TEST_ASSERT(tags.type == JSON_ARRAY && tags.array->len == 4, "Array member should hold 4 elements");
+  TEST_ASSERT(tags.array->items[1].type == JSON_BOOL && tags.array->items[1].boolean,
+              "Array should keep element order");
+  TEST_ASSERT(tags.array->items[2].type == JSON_NULL, "Null element should be stored");
+  json_value_t inner = tags.array->items[3];
+  TEST_ASSERT(inner.type == JSON_OBJECT && json_object_get(&inner, "deep").number == 1.5,
+              "Object nested in an array should be closed in place");
+
+  json_value_t empty = json_object_get(&doc, "empty");
+  TEST_ASSERT(empty.type == JSON_OBJECT && json_object_size(&empty) == 0, "Empty object should be allowed");
+  TEST_ASSERT(json_object_has(&doc, "last") && !json_object_get(&doc, "last").boolean,
+              "Member after a nested container should keep its own key");
+  TEST_ASSERT(b.items_len == 0 && b.keys_len == 0, "Scratch stacks should be empty after the root closes");
+
+  json_builder_free(&b);
+}
+
+void test_builder_exact_sizes() {
+  printf("\n=== Testing builder container sizes ===\n");
+
+  json_builder_t b = json_builder_init(NULL);
+  json_builder_begin_array(&b);
+  for (int i = 0; i < 100; i++) {
+    json_builder_number(&b, i);
+  }
+  json_builder_end(&b);
+  json_value_t arr = json_builder_finish(&b);
+  TEST_ASSERT(arr.type == JSON_ARRAY && arr.array->len == 100, "Array should hold every element");
+  TEST_ASSERT(arr.array->cap == 100, "Array should be allocated at its exact length");
+  TEST_ASSERT(arr.array->items[99].number == 99, "Last element should be stored");
+  json_builder_free(&b);
+
+  b = json_builder_init(NULL);
+  json_builder_begin_object(&b);
+  char key[32];
+  for (int i = 0; i < 100; i++) {
+    int len = snprintf(key, sizeof(key), "k%d", i);
+    json_builder_key(&b, key, len);
+    json_builder_number(&b, i);
+  }
+  json_builder_end(&b);
+  json_value_t obj = json_builder_finish(&b);
+  json_value_t sized = json_value_object_pooled(100, b.pool);
+  TEST_ASSERT(obj.type == JSON_OBJECT && json_object_size(&obj) == 100, "Object should hold every member");
+  TEST_ASSERT(obj.object->capacity == sized.object->capacity, "Table should be sized once for its member count");
+  TEST_ASSERT(json_object_get(&obj, "k57").number == 57, "Members should be found by key");
+  json_builder_free(&b);
+}
+
+void test_builder_duplicate_keys() {
+  printf("\n=== Testing builder duplicate keys ===\n");
+
+  json_builder_t b = json_builder_init(NULL);
+  json_builder_begin_object(&b);
+  json_builder_key(&b, "a", 1);
+  json_builder_number(&b, 1);
+  json_builder_key(&b, "b", 1);
+  json_builder_number(&b, 2);
+  json_builder_key(&b, "a", 1);
+  json_builder_number(&b, 3);
+  json_builder_end(&b);
+  json_value_t doc = json_builder_finish(&b);
+
+  TEST_ASSERT(!b.has_error && json_object_size(&doc) == 2, "Repeated key should not add a member");
+  TEST_ASSERT(json_object_get(&doc, "a").number == 3, "Last value of a repeated key should win");
+  json_builder_free(&b);
+
+  // The replaced value goes back to the pool
+  size_t distinct_free = 0;
+  for (int dup = 0; dup < 2; dup++) {
+    b = json_builder_init(NULL);
+    json_builder_begin_object(&b);
+    json_builder_key(&b, "a", 1);
+    json_builder_string(&b, "a string too long to inline", 27);
+    json_builder_key(&b, dup ? "a" : "b", 1);
+    json_builder_number(&b, 3);
+    json_builder_end(&b);
+    doc = json_builder_finish(&b);
+    if (!dup) {
+      distinct_free = pool_bytes_free(b.pool);
+      json_builder_free(&b);
+    }
+  }
+  TEST_ASSERT(!b.has_error && json_object_get(&doc, "a").number == 3, "Last value should replace a string");
+  TEST_ASSERT(pool_bytes_free(b.pool) > distinct_free, "Replaced string should be freed to the pool");
+  json_builder_free(&b);
+}
+
+void test_builder_errors() {
+  printf("\n=== Testing builder misuse ===\n");
+
+  json_builder_t b = json_builder_init(NULL);
+  json_builder_begin_array(&b);
+  json_builder_key(&b, "a", 1);
+  TEST_ASSERT(b.has_error && strstr(b.error_message, "Key outside an object"), "Key in an array should fail");
+  json_builder_end(&b);
+  TEST_ASSERT(json_builder_finish(&b).type == JSON_NULL, "Finish after an error should return null");
+  json_builder_free(&b);
+
+  b = json_builder_init(NULL);
+  json_builder_begin_object(&b);
+  json_builder_number(&b, 1);
+  TEST_ASSERT(b.has_error && strstr(b.error_message, "needs a key"), "Member without a key should fail");
+  json_builder_free(&b);
+
+  b = json_builder_init(NULL);
+  json_builder_begin_object(&b);
+  json_builder_key(&b, "a", 1);
+  json_builder_end(&b);
+  TEST_ASSERT(b.has_error && strstr(b.error_message, "Key without a value"), "Dangling key should fail");
+  json_builder_free(&b);
+
+  b = json_builder_init(NULL);
+  json_builder_begin_array(&b);
+  json_builder_end(&b);
+  json_builder_end(&b);
+  TEST_ASSERT(b.has_error && strstr(b.error_message, "No open container"), "Extra end should fail");
+  json_builder_free(&b);
+
+  b = json_builder_init(NULL);
+  json_builder_number(&b, 1);
+  json_builder_number(&b, 2);
+  TEST_ASSERT(b.has_error && strstr(b.error_message, "root"), "Second root value should fail");
+  json_builder_free(&b);
+
+  b = json_builder_init(NULL);
+  json_builder_begin_array(&b);
+  json_builder_number(&b, 1);
+  TEST_ASSERT(json_builder_finish(&b).type == JSON_NULL && b.has_error &&
+              strstr(b.error_message, "Unclosed"), "Finish with an open container should fail");
+  json_builder_free(&b);
+
+  // Lengths that cannot be stored are refused before the text is read
+  b = json_builder_init(NULL);
+  json_builder_begin_object(&b);
+  json_builder_key(&b, "k", (size_t)HASH_KEY_LEN_MAX + 1);
+  TEST_ASSERT(b.has_error && strstr(b.error_message, "Key too long"), "Oversized key should fail");
+  json_builder_free(&b);
+
+  b = json_builder_init(NULL);
+  json_builder_string(&b, "s", (size_t)JSON_STRING_LEN_MAX + 1);
+  TEST_ASSERT(b.has_error && strstr(b.error_message, "String too long"), "Oversized string should fail");
+  json_builder_free(&b);
+
+  b = json_builder_init(NULL);
+  TEST_ASSERT(json_builder_finish(&b).type == JSON_NULL && !b.has_error, "Empty builder should finish as null");
+  json_builder_free(&b);
+}
+
+void test_builder_pool() {
+  printf("\n=== Testing builder pool usage ===\n");
+
+  mem_pool_t *pool = pool_create();
+  json_builder_t b = json_builder_init_with_pool(pool);
+  json_builder_begin_object(&b);
+  char key[32];
+  for (int i = 0; i < 1000; i++) {
+    int len = snprintf(key, sizeof(key), "field_%d", i);
+    json_builder_key(&b, key, len);
+    json_builder_string(&b, key, len);
+  }
+  json_builder_end(&b);
+  json_value_t doc = json_builder_finish(&b);
+  json_builder_free(&b);
+
+  TEST_ASSERT(b.pool == pool, "Borrowed pool should survive json_builder_free");
+  TEST_ASSERT(json_object_size(&doc) == 1000, "Document should outlive the builder");
+  json_value_t field = json_object_get(&doc, "field_999");
+  TEST_ASSERT(strcmp(json_get_string(&field), "field_999") == 0,
+              "Values should live in the caller's pool");
+
+  // One table, 1000 keys and 1000 strings; no growth leaves abandoned copies
+  json_value_t sized = json_value_object_pooled(1000, pool);
+  size_t table_bytes = sized.object->capacity * (sizeof(hash_entry_t) + 1);
+  TEST_ASSERT(pool->total_used < 2 * table_bytes + 2 * 1000 * 16 + 4096,
+              "Pool should hold little beyond the exact-size table and strings");
+  pool_destroy(pool);
+
+  // Running out of a fixed pool is reported, not crashed on
+  static char buffer[2048];
+  mem_pool_t *small = pool_create_static(buffer, sizeof(buffer));
+  b = json_builder_init_with_pool(small);
+  json_builder_begin_array(&b);
+  for (int i = 0; i < 1000; i++) {
+    json_builder_string(&b, "a string that fills the pool", 28);
+  }
+  json_builder_end(&b);
+  TEST_ASSERT(b.has_error && strstr(b.error_message, "Out of memory"), "Exhausted pool should report OOM");
+  TEST_ASSERT(json_builder_finish(&b).type == JSON_NULL, "Failed build should finish as null");
+  json_builder_free(&b);
+}
+
+void test_builder_escaping() {
+  printf("\n=== Testing builder text escaping ===\n");
+
+  // Backslashes and quotes in keys and values are literal text
+  json_builder_t b = json_builder_init(NULL);
+  json_builder_begin_object(&b);
+  json_builder_key(&b, "path\\to", 7);
+  json_builder_string(&b, "C:\\new\\temp", 11);
+  json_builder_key(&b, "say \"hi\"", 8);
+  json_builder_string(&b, "a \"quoted\" \\u0041 word\n", 23);
+  json_builder_end(&b);
+  json_value_t doc = json_builder_finish(&b);
+
+  char *text = json_serialize(&doc, NULL);
+  TEST_ASSERT(text && strcmp(text, "{\"path\\\\to\":\"C:\\\\new\\\\temp\","
+                                   "\"say \\\"hi\\\"\":\"a \\\"quoted\\\" \\\\u0041 word\\n\"}") == 0,
+              "Every backslash and quote should be escaped");
+
+  // The text parses back to the same document
+  lexer_t lexer = lexer_init(text);
+  parser_t parser = parser_init(&lexer);
+  parser.current_token = next_token(&lexer);
+  json_value_t again = parse(&parser);
+  TEST_ASSERT(!parser.has_error && json_value_cmp(&doc, &again) == 0, "Built document should round-trip");
+  json_value_t *path = hash_table_get(again.object, "path\\\\to", 8);
+  TEST_ASSERT(path && json_value_cmp(path, hash_table_get(doc.object, "path\\\\to", 8)) == 0,
+              "Escaped keys should match between built and parsed documents");
+
+  parser_free(&parser);
+  lexer_free(&lexer);
+  free(text);
+  json_builder_free(&b);
+}
+
+TEST_MAIN("Builder",
+  test_builder_nested();
+  test_builder_exact_sizes();
+  test_builder_duplicate_keys();
+  test_builder_errors();
+  test_builder_pool();
+  test_builder_escaping();
+)
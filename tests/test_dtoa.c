@@ -0,0 +1,196 @@
+#include "../include/dtoa.h"
+#include "../include/lexer.h"
+#include "test_framework.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+TEST_SUITE_INIT()
+
+static bool formats_as(double value, const char *expected) {
+  char buf[JSON_DOUBLE_MAX_LEN + 1];
+  size_t len = json_format_double(buf, value);
+  buf[len] = '\0';
+  if (strcmp(buf, expected) != 0) {
+    printf("  %.17g formatted as %s\n", value, buf);
+    return false;
+  }
+  return true;
+}
+
+// Reads text back with the lexer's number conversion
+static double read_back(const char *text, size_t len) {
+  string_slice_t slice = {text, len};
+  return slice_to_double(slice);
+}
+
+void test_dtoa_shortest() {
+  printf("\n=== Testing shortest double formatting ===\n");
+
+  TEST_ASSERT(formats_as(0.1, "0.1"), "0.1 should not print as 0.10000000000000001");
+  TEST_ASSERT(formats_as(0.3, "0.3"), "0.3");
+  TEST_ASSERT(formats_as(0.30000000000000004, "0.30000000000000004"), "0.1 + 0.2 needs 17 digits");
+  TEST_ASSERT(formats_as(123.456, "123.456"), "Plain decimal");
+  TEST_ASSERT(formats_as(-4.35, "-4.35"), "Negative decimal");
+  TEST_ASSERT(formats_as(1.5, "1.5"), "Exact binary fraction");
+  TEST_ASSERT(formats_as(-122.4194155, "-122.4194155"), "Coordinate");
+  TEST_ASSERT(formats_as(37.7749295, "37.7749295"), "Coordinate");
+  TEST_ASSERT(formats_as(5e-324, "5e-324"), "Smallest denormal");
+  TEST_ASSERT(formats_as(2.2250738585072014e-308, "2.2250738585072014e-308"), "Smallest normal");
+  TEST_ASSERT(formats_as(1.7976931348623157e308, "1.7976931348623157e+308"), "Largest double");
+}
+
+void test_dtoa_layout() {
+  printf("\n=== Testing number layout ===\n");
+
+  TEST_ASSERT(formats_as(0.0, "0"), "Zero");
+  TEST_ASSERT(formats_as(-0.0, "0"), "Negative zero prints as 0");
+  TEST_ASSERT(formats_as(100, "100"), "Whole number takes the integer path");
+  TEST_ASSERT(formats_as(-9007199254740992.0, "-9007199254740992"), "-2^53");
+  TEST_ASSERT(formats_as(1e20, "100000000000000000000"), "1e20 is written out");
+  TEST_ASSERT(formats_as(1e21, "1e+21"), "1e21 switches to exponent form");
+  TEST_ASSERT(formats_as(1.5e300, "1.5e+300"), "Large exponent");
+  TEST_ASSERT(formats_as(0.000001, "0.000001"), "1e-6 is written out");
+  TEST_ASSERT(formats_as(1e-7, "1e-7"), "1e-7 switches to exponent form");
+  TEST_ASSERT(formats_as(-2.5e-7, "-2.5e-7"), "Negative small exponent");
+  TEST_ASSERT(formats_as(NAN, "null"), "NaN is null");
+  TEST_ASSERT(formats_as(INFINITY, "null"), "Infinity is null");
+
+  char digits[24];
+  char *end = digits + sizeof(digits);
+  char *start = json_format_uint(end, 18446744073709551615ULL);
+  TEST_ASSERT((size_t)(end - start) == 20 && memcmp(start, "18446744073709551615", 20) == 0,
+              "Integer formatter should handle the full uint64 range");
+}
+
+void test_dtoa_round_trip() {
+  printf("\n=== Testing round trips through slice_to_double() ===\n");
+
+  // Random bit patterns cover every exponent, denormals included
+  uint64_t state = 0x9E3779B97F4A7C15ULL;
+  int failures = 0, tested = 0;
+  size_t longest = 0;
+  char buf[JSON_DOUBLE_MAX_LEN];
+  for (int i = 0; i < 1000000; i++) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    double value;
+    memcpy(&value, &state, sizeof(value));
+    if (!isfinite(value)) continue;
+    size_t len = json_format_double(buf, value);
+    if (len > longest) longest = len;
+    double back = read_back(buf, len);
+    failures += back != value && !(value == 0 && back == 0);
+    tested++;
+  }
+  TEST_ASSERT(tested > 990000 && failures == 0, "Random doubles should read back exactly");
+  TEST_ASSERT(longest < JSON_DOUBLE_MAX_LEN, "Output should fit JSON_DOUBLE_MAX_LEN");
+
+  // Decimal inputs with few digits come back with the same digits
+  int mismatches = 0;
+  for (int i = 1; i < 100000; i++) {
+    char text[32];
+    int text_len = snprintf(text, sizeof(text), "%d.%03d", i / 1000, i % 1000);
+    double value = read_back(text, text_len);
+    size_t len = json_format_double(buf, value);
+    double expected = read_back(buf, len);
+    mismatches += expected != value || len > (size_t)text_len;
+  }
+  TEST_ASSERT(mismatches == 0, "Short decimals should format no longer than their input");
+}
+
+// Exact shortest digits by trying each precision with printf
+static size_t reference_digits(char *digits, double value) {
+  char text[40];
+  int precision = 1;
+  for (; precision < 17; precision++) {
+    snprintf(text, sizeof(text), "%.*e", precision - 1, value);
+    if (strtod(text, NULL) == value) break;
+  }
+  snprintf(text, sizeof(text), "%.*e", precision - 1, value);
+  size_t n = 0;
+  for (const char *p = text; *p && *p != 'e'; p++) {
+    if (*p >= '0' && *p <= '9') digits[n++] = *p;
+  }
+  digits[n] = '\0';
+  return n;
+}
+
+// Significant digits of formatted text, without leading or trailing zeros
+static void text_digits(char *digits, const char *text) {
+  size_t n = 0;
+  for (const char *p = text; *p && *p != 'e'; p++) {
+    if (*p < '0' || *p > '9' || (n == 0 && *p == '0')) continue;
+    digits[n++] = *p;
+  }
+  while (n > 1 && digits[n - 1] == '0') n--;
+  digits[n] = '\0';
+}
+
+void test_dtoa_exact() {
+  printf("\n=== Testing exact shortest formatting ===\n");
+
+  // Number serialization examples from RFC 8785, appendix B
+  static const struct {
+    uint64_t bits;
+    const char *text;
+  } rfc[] = {
+    {0x0000000000000000ULL, "0"}, {0x8000000000000000ULL, "0"},
+    {0x0000000000000001ULL, "5e-324"}, {0x8000000000000001ULL, "-5e-324"},
+    {0x7fefffffffffffffULL, "1.7976931348623157e+308"}, {0xffefffffffffffffULL, "-1.7976931348623157e+308"},
+    {0x4340000000000000ULL, "9007199254740992"}, {0xc340000000000000ULL, "-9007199254740992"},
+    {0x4430000000000000ULL, "295147905179352830000"}, {0x44b52d02c7e14af5ULL, "9.999999999999997e+22"},
+    {0x44b52d02c7e14af6ULL, "1e+23"}, {0x44b52d02c7e14af7ULL, "1.0000000000000001e+23"},
+    {0x444b1ae4d6e2ef4eULL, "999999999999999700000"}, {0x444b1ae4d6e2ef4fULL, "999999999999999900000"},
+    {0x444b1ae4d6e2ef50ULL, "1e+21"}, {0x3eb0c6f7a0b5ed8cULL, "9.999999999999997e-7"},
+    {0x3eb0c6f7a0b5ed8dULL, "0.000001"}, {0x41b3de4355555553ULL, "333333333.3333332"},
+    {0x41b3de4355555554ULL, "333333333.33333325"}, {0x41b3de4355555555ULL, "333333333.3333333"},
+    {0x41b3de4355555556ULL, "333333333.3333334"}, {0x41b3de4355555557ULL, "333333333.33333343"},
+    {0xbecbf647612f3696ULL, "-0.0000033333333333333333"}, {0x43143ff3c1cb0959ULL, "1424953923781206.2"},
+  };
+  int wrong = 0;
+  for (size_t i = 0; i < sizeof(rfc) / sizeof(rfc[0]); i++) {
+    double value;
+    memcpy(&value, &rfc[i].bits, sizeof(value));
+    char buf[JSON_DOUBLE_MAX_LEN + 1];
+    buf[json_format_double_exact(buf, value)] = '\0';
+    if (strcmp(buf, rfc[i].text) != 0) {
+      printf("  %016llx formatted as %s\n", (unsigned long long)rfc[i].bits, buf);
+      wrong++;
+    }
+  }
+  TEST_ASSERT(wrong == 0, "RFC 8785 number examples");
+
+  // Random bit patterns, and random values of everyday magnitude
+  uint64_t state = 0x9E3779B97F4A7C15ULL;
+  int mismatches = 0, checked = 0;
+  for (int i = 0; i < 300000; i++) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    uint64_t bits = state;
+    if (i & 1) {
+      bits = (bits & 0x800FFFFFFFFFFFFFULL) | ((uint64_t)(1023 - 30 + (int)(state >> 56) % 60) << 52);
+    }
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    if (!isfinite(value) || value == 0) continue;
+    char buf[JSON_DOUBLE_MAX_LEN + 1], got[24], expected[24];
+    size_t len = json_format_double_exact(buf, value);
+    buf[len] = '\0';
+    text_digits(got, buf);
+    reference_digits(expected, value);
+    mismatches += strcmp(got, expected) != 0 || read_back(buf, len) != value;
+    checked++;
+  }
+  TEST_ASSERT(checked > 250000 && mismatches == 0, "Exact digits should be the shortest and closest");
+}
+
+TEST_MAIN("Dtoa",
+  test_dtoa_shortest();
+  test_dtoa_layout();
+  test_dtoa_round_trip();
+  test_dtoa_exact();
+)
@@ -0,0 +1,444 @@
+#include "../include/json.h"
+#include "test_framework.h"
+
+TEST_SUITE_INIT()
+
+static void make_key(char *buf, size_t size, int i) {
+  snprintf(buf, size, "key_%d", i);
+}
+
+void test_hash_string() {
+  printf("\n=== Testing seeded string hash ===\n");
+
+  uint64_t saved[4];
+  memcpy(saved, json_hash_secret, sizeof(saved));
+
+  json_hash_seed(42);
+  uint32_t a = hash_string("feature_flag", 12);
+  TEST_ASSERT(a == hash_string("feature_flag", 12), "Hash should be deterministic for a seed");
+  TEST_ASSERT(a != hash_string("feature_flaG", 12), "Changing a byte should change the hash");
+  TEST_ASSERT(hash_string("ab", 2) != hash_string("ab\0", 3), "Trailing zero byte should change the hash");
+
+  json_hash_seed(43);
+  TEST_ASSERT(a != hash_string("feature_flag", 12), "Different seeds should give different hashes");
+
+  // Streaming API matches the one-shot hash for every tail length
+  const char *text = "0123456789abcdefghijklmnopqrstuvwxyz";
+  int mismatches = 0;
+  for (size_t len = 0; len <= strlen(text); len++) {
+    uint64_t state = json_hash_begin();
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+      state = json_hash_step(state, json_hash_read64(text + i));
+    }
+    if (json_hash_finish(state, text + i, len - i, len) != hash_string(text, len)) {
+      mismatches++;
+    }
+  }
+  TEST_ASSERT(mismatches == 0, "Word-at-a-time steps should match hash_string");
+
+  // Prefixes of one string should not collide
+  int collisions = 0;
+  for (size_t i = 0; i < strlen(text); i++) {
+    for (size_t j = i + 1; j <= strlen(text); j++) {
+      if (hash_string(text, i) == hash_string(text, j)) collisions++;
+    }
+  }
+  TEST_ASSERT(collisions == 0, "Prefixes should hash differently");
+
+  // A word equal to a public constant must not reset the state: keys that
+  // differ only before it would then collide under every seed
+  const uint64_t constants[] = { JSON_HASH_P0, JSON_HASH_P1, JSON_HASH_P2, JSON_HASH_P3 };
+  for (uint64_t seed = 1; seed <= 3; seed++) {
+    json_hash_seed(seed);
+    collisions = 0;
+    for (size_t c = 0; c < 4; c++) {
+      char a[24] = "prefix_A", b[24] = "prefix_B";
+      memcpy(a + 8, &constants[c], 8);
+      memcpy(b + 8, &constants[c], 8);
+      memcpy(a + 16, "_suffix", 7);
+      memcpy(b + 16, "_suffix", 7);
+      collisions += hash_string(a, 23) == hash_string(b, 23);
+    }
+    TEST_ASSERT(collisions == 0, "Keys around a constant word should not collide for any seed");
+  }
+
+  json_hash_seed(7);
+  TEST_ASSERT(json_hash_secret[1] != JSON_HASH_P1 && json_hash_secret[1] != json_hash_secret[2],
+              "Seeding should replace every secret word");
+
+  memcpy(json_hash_secret, saved, sizeof(saved));
+}
+
+void test_hash_table_insert_get() {
+  printf("\n=== Testing hash table insert/get ===\n");
+
+  mem_pool_t *pool = pool_create();
+  hash_table_t table;
+  int res = hash_table_init_inplace(&table, 0, pool);
+  TEST_ASSERT(res == 0, "Table should initialize");
+  TEST_ASSERT(table.capacity == HASH_TABLE_MIN_CAP, "Empty table should have minimum capacity");
+
+  res = hash_table_insert(&table, "alpha", 5, json_value_number(1), pool);
+  TEST_ASSERT(res == 0, "Insert should succeed");
+  res = hash_table_insert(&table, "beta", 4, json_value_number(2), pool);
+  TEST_ASSERT(res == 0, "Second insert should succeed");
+  res = hash_table_insert(&table, "alpha", 5, json_value_number(3), pool);
+  TEST_ASSERT(res == 1, "Duplicate insert should return 1");
+  TEST_ASSERT(table.size == 2, "Table should hold two entries");
+
+  json_value_t *val = hash_table_get(&table, "alpha", 5);
+  TEST_ASSERT(val != NULL && val->number == 1, "Lookup should return first value");
+  val = hash_table_get(&table, "beta", 4);
+  TEST_ASSERT(val != NULL && val->number == 2, "Lookup should return second value");
+  TEST_ASSERT(hash_table_get(&table, "gamma", 5) == NULL, "Missing key should return NULL");
+  TEST_ASSERT(hash_table_get(&table, "alph", 4) == NULL, "Prefix of key should not match");
+
+  pool_destroy(pool);
+}
+
+void test_hash_table_growth() {
+  printf("\n=== Testing hash table growth ===\n");
+
+  mem_pool_t *pool = pool_create();
+  hash_table_t table;
+  hash_table_init_inplace(&table, 0, pool);
+
+  const int count = 5000;
+  char key[32];
+  int failures = 0;
+  for (int i = 0; i < count; i++) {
+    make_key(key, sizeof(key), i);
+    if (hash_table_insert(&table, key, strlen(key), json_value_number(i), pool) != 0) {
+      failures++;
+    }
+  }
+  TEST_ASSERT(failures == 0, "All inserts should succeed");
+  TEST_ASSERT(table.size == (uint32_t)count, "Table size should match insert count");
+  TEST_ASSERT(table.capacity >= (uint32_t)count, "Capacity should grow past entry count");
+  TEST_ASSERT((table.capacity & (table.capacity - 1)) == 0, "Capacity should stay a power of two");
+
+  int missing = 0;
+  for (int i = 0; i < count; i++) {
+    make_key(key, sizeof(key), i);
+    json_value_t *val = hash_table_get(&table, key, strlen(key));
+    if (!val || val->number != i) missing++;
+  }
+  TEST_ASSERT(missing == 0, "Every key should be found after growth");
+
+  // Live control bytes should match the size
+  uint8_t *ctrl = hash_table_ctrl(&table);
+  uint32_t full = 0;
+  for (uint32_t i = 0; i < table.capacity; i++) {
+    if (hash_ctrl_is_full(ctrl[i])) full++;
+  }
+  TEST_ASSERT(full == table.size, "Full control bytes should equal table size");
+
+  int mirrored = memcmp(ctrl, ctrl + table.capacity, HASH_GROUP_WIDTH) == 0;
+  TEST_ASSERT(mirrored, "Control tail should mirror the first group");
+
+  pool_destroy(pool);
+}
+
+void test_hash_table_grow_in_place() {
+  printf("\n=== Testing hash table in-place growth ===\n");
+
+  mem_pool_t *pool = pool_create();
+  hash_table_t table;
+  hash_table_init_inplace(&table, 0, pool);
+
+  hash_entry_t *original = table.entries;
+  char key[32];
+  for (int i = 0; i < 14; i++) {
+    snprintf(key, sizeof(key), "copied_key_%d", i);
+    hash_table_insert(&table, key, strlen(key), json_value_number(i), pool);
+  }
+  size_t used_before = pool_bytes_used(pool);
+  TEST_ASSERT(table.growth_left == 0, "Table should be at its load limit");
+
+  // Next insert triggers growth; keys too long to store inline were
+  // allocated after the table, so growth must fall back to a new allocation
+  snprintf(key, sizeof(key), "copied_key_%d", 14);
+  hash_table_insert(&table, key, strlen(key), json_value_number(14), pool);
+  TEST_ASSERT(table.entries != original, "Growth behind other allocations should relocate");
+  TEST_ASSERT(pool_bytes_used(pool) > used_before, "Relocation should allocate");
+
+  // A table that is the last allocation grows without moving
+  hash_table_t reserved;
+  hash_table_init_inplace(&reserved, 0, pool);
+  hash_entry_t *reserved_entries = reserved.entries;
+  int res = hash_table_reserve(&reserved, 1000, pool);
+  TEST_ASSERT(res == 0, "Reserve should succeed");
+  TEST_ASSERT(reserved.entries == reserved_entries, "Top-of-pool table should grow without moving");
+  TEST_ASSERT(reserved.capacity >= 1000, "Reserve should grow capacity");
+  TEST_ASSERT(reserved.growth_left >= 1000, "Reserve should leave room for requested entries");
+
+  // Keys come from another pool so the table stays the top allocation
+  mem_pool_t *key_pool = pool_create();
+  int missing = 0;
+  for (int i = 0; i < 1000; i++) {
+    make_key(key, sizeof(key), i);
+    hash_table_insert(&reserved, key, strlen(key), json_value_number(i), key_pool);
+  }
+  TEST_ASSERT(reserved.entries == reserved_entries, "Reserved table should not resize while filling");
+  res = hash_table_reserve(&reserved, 4000, pool);
+  TEST_ASSERT(res == 0 && reserved.entries == reserved_entries, "Reserve with entries should grow in place");
+  for (int i = 0; i < 1000; i++) {
+    make_key(key, sizeof(key), i);
+    json_value_t *val = hash_table_get(&reserved, key, strlen(key));
+    if (!val || val->number != i) missing++;
+  }
+  TEST_ASSERT(missing == 0, "Every key should be found after in-place rehash");
+
+  pool_destroy(key_pool);
+  pool_destroy(pool);
+}
+
+void test_hash_table_small_capacity() {
+  printf("\n=== Testing hash tables smaller than a probe group ===\n");
+
+  mem_pool_t *pool = pool_create();
+  hash_table_t table;
+  hash_table_init_inplace(&table, 3, pool);
+  TEST_ASSERT(table.capacity == 4, "Sized table should use the smallest fitting capacity");
+  TEST_ASSERT(table.growth_left == 3, "Sized table should fit the requested entries");
+
+  char key[32];
+  int missing = 0;
+  for (int i = 0; i < 50; i++) {
+    make_key(key, sizeof(key), i);
+    hash_table_insert(&table, key, strlen(key), json_value_number(i), pool);
+    // Every earlier key must stay reachable across each growth step
+    for (int j = 0; j <= i; j++) {
+      make_key(key, sizeof(key), j);
+      json_value_t *val = hash_table_get(&table, key, strlen(key));
+      if (!val || val->number != j) missing++;
+    }
+  }
+  TEST_ASSERT(missing == 0, "Keys should survive growth from a small table");
+  TEST_ASSERT(table.size == 50, "Small table should grow to hold all keys");
+
+  hash_table_t one;
+  hash_table_init_inplace(&one, 1, pool);
+  TEST_ASSERT(one.capacity == 2, "Single entry table should have capacity 2");
+  hash_table_insert(&one, "a", 1, json_value_number(1), pool);
+  TEST_ASSERT(hash_table_get(&one, "a", 1) != NULL, "Single entry should be found");
+  TEST_ASSERT(hash_table_get(&one, "b", 1) == NULL, "Missing key in tiny table should not be found");
+
+  pool_destroy(pool);
+}
+
+void test_hash_table_delete_reuse() {
+  printf("\n=== Testing hash table delete and slot reuse ===\n");
+
+  mem_pool_t *pool = pool_create();
+  hash_table_t table;
+  hash_table_init_inplace(&table, 0, pool);
+
+  char key[32];
+  for (int i = 0; i < 10; i++) {
+    make_key(key, sizeof(key), i);
+    hash_table_insert(&table, key, strlen(key), json_value_number(i), pool);
+  }
+
+  uint32_t capacity = table.capacity;
+
+  // Churn: delete and reinsert many distinct keys, tombstones must be recycled
+  int errors = 0;
+  for (int round = 0; round < 200; round++) {
+    make_key(key, sizeof(key), round % 10);
+    if (hash_table_delete_pooled(&table, key, strlen(key), pool) != 0) errors++;
+    if (hash_table_get(&table, key, strlen(key)) != NULL) errors++;
+    if (hash_table_insert(&table, key, strlen(key), json_value_number(round % 10), pool) != 0) errors++;
+  }
+  TEST_ASSERT(errors == 0, "Delete/reinsert churn should succeed");
+  TEST_ASSERT(table.size == 10, "Size should be unchanged after churn");
+  TEST_ASSERT(table.capacity == capacity, "Churn should not grow the table");
+
+  TEST_ASSERT(hash_table_delete(&table, "missing", 7) == -1, "Deleting a missing key should fail");
+
+  pool_destroy(pool);
+}
+
+void test_object_key_handles() {
+  printf("\n=== Testing prebuilt object keys ===\n");
+
+  mem_pool_t *pool = pool_create();
+  json_value_t obj = json_value_object_pooled(0, pool);
+  hash_table_insert(obj.object, "status", 6, json_value_number(200), pool);
+  hash_table_insert(obj.object, "status_text", 11, json_value_bool(true), pool);
+
+  json_key_t status = json_key("status");
+  TEST_ASSERT(status.len == 6 && status.hash == hash_string("status", 6), "Key should carry length and hash");
+  json_key_t prefix = json_key_n("status_text", 6);
+  TEST_ASSERT(prefix.len == 6 && prefix.hash == status.hash, "Length-bounded key should match the prefix");
+
+  json_value_t val = json_object_get_key(&obj, status);
+  TEST_ASSERT(val.type == JSON_NUMBER && val.number == 200, "Get with key handle should find the value");
+  TEST_ASSERT(json_object_get_key(&obj, prefix).number == 200, "Length-bounded key should not read past len");
+  TEST_ASSERT(json_object_has_key(&obj, json_key("status_text")) == 1, "Has with key handle should find key");
+  TEST_ASSERT(json_object_has_key(&obj, json_key("missing")) == 0, "Missing key handle should not be found");
+  TEST_ASSERT(json_object_get_key(&obj, json_key("missing")).type == JSON_NULL, "Missing key should give null");
+
+  json_value_t num = json_value_number(1);
+  TEST_ASSERT(json_object_has_key(&num, status) == 0, "Non-object should not have keys");
+
+  pool_destroy(pool);
+}
+
+// Keys of obj in iteration order, as "k1,k2,..."
+static void iteration_keys(json_value_t *obj, char *out, size_t size) {
+  size_t len = 0;
+  out[0] = '\0';
+  json_object_iter_t it = json_object_iter(obj);
+  for (hash_entry_t *entry; (entry = json_object_next(&it));) {
+    len += snprintf(out + len, size - len, len ? ",%s" : "%s", hash_entry_key(entry).str);
+  }
+}
+
+void test_object_iteration_order() {
+  printf("\n=== Testing insertion-ordered object iteration ===\n");
+
+  mem_pool_t *pool = pool_create();
+  json_value_t obj = json_value_object_pooled(0, pool);
+  char keys[256];
+  iteration_keys(&obj, keys, sizeof(keys));
+  TEST_ASSERT(keys[0] == '\0', "Empty object should iterate nothing");
+
+  const char *names[] = {"zeta", "alpha", "mid", "beta", "omega"};
+  for (int i = 0; i < 5; i++) {
+    json_object_set_pooled(&obj, (char *)names[i], json_value_number(i), pool);
+  }
+  iteration_keys(&obj, keys, sizeof(keys));
+  TEST_ASSERT(strcmp(keys, "zeta,alpha,mid,beta,omega") == 0, "Members should come out in insertion order");
+
+  json_object_set_pooled(&obj, "alpha", json_value_bool(true), pool);
+  iteration_keys(&obj, keys, sizeof(keys));
+  TEST_ASSERT(strcmp(keys, "zeta,alpha,mid,beta,omega") == 0, "Replacing a value should keep its position");
+
+  json_object_delete_pooled(&obj, "mid", pool);
+  json_object_delete_pooled(&obj, "omega", pool);
+  json_object_set_pooled(&obj, "mid", json_value_number(9), pool);
+  iteration_keys(&obj, keys, sizeof(keys));
+  TEST_ASSERT(strcmp(keys, "zeta,alpha,beta,mid") == 0, "Deleted keys should drop out; reinserts go last");
+  TEST_ASSERT(json_object_get(&obj, "mid").number == 9 && json_object_size(&obj) == 4,
+              "Lookups should see the reinserted value");
+
+  // Order survives growth and the compaction of holes
+  char key[32];
+  for (int i = 0; i < 500; i++) {
+    make_key(key, sizeof(key), i);
+    json_object_set_pooled(&obj, key, json_value_number(i), pool);
+    if (i % 3 == 0) {
+      make_key(key, sizeof(key), i / 2);
+      json_object_delete_pooled(&obj, key, pool);
+    }
+  }
+  int out_of_order = 0, last = -1;
+  uint32_t visited = 0;
+  json_object_iter_t it = json_object_iter(&obj);
+  for (hash_entry_t *entry; (entry = json_object_next(&it));) {
+    visited++;
+    const char *key = hash_entry_key(entry).str;
+    if (strncmp(key, "key_", 4) != 0) continue;
+    int n = atoi(key + 4);
+    if (n <= last || entry->value.number != n) out_of_order++;
+    last = n;
+  }
+  TEST_ASSERT(out_of_order == 0, "Order should hold across growth and deletes");
+  TEST_ASSERT(visited == obj.object->size, "Iteration should visit every live member once");
+
+  // Churn on one table: compaction must keep the order it had
+  json_value_t churn = json_value_object_pooled(0, pool);
+  for (int i = 0; i < 10; i++) {
+    make_key(key, sizeof(key), i);
+    json_object_set_pooled(&churn, key, json_value_number(i), pool);
+  }
+  for (int round = 0; round < 100; round++) {
+    make_key(key, sizeof(key), round % 10);
+    json_object_delete_pooled(&churn, key, pool);
+    json_object_set_pooled(&churn, key, json_value_number(round), pool);
+  }
+  iteration_keys(&churn, keys, sizeof(keys));
+  TEST_ASSERT(strcmp(keys, "key_0,key_1,key_2,key_3,key_4,key_5,key_6,key_7,key_8,key_9") == 0,
+              "Each reinserted key should move to the end");
+  TEST_ASSERT(churn.object->capacity == HASH_TABLE_MIN_CAP, "Churn should compact rather than grow");
+
+  // Values can be edited during iteration
+  it = json_object_iter(&churn);
+  for (hash_entry_t *entry; (entry = json_object_next(&it));) {
+    entry->value.number = -1;
+  }
+  TEST_ASSERT(json_object_get(&churn, "key_4").number == -1, "Iteration should expose values in place");
+
+  json_value_t num = json_value_number(1);
+  it = json_object_iter(&num);
+  TEST_ASSERT(json_object_next(&it) == NULL, "Non-objects should iterate nothing");
+
+  pool_destroy(pool);
+}
+
+void test_hash_table_inline_keys() {
+  printf("\n=== Testing inline keys ===\n");
+
+  mem_pool_t *pool = pool_create();
+  hash_table_t table;
+  hash_table_init_inplace(&table, 0, pool);
+
+  // Empty, shortest, longest inline and shortest copied key
+  const char *keys[] = { "", "a", "abcdefg", "abcdefgh" };
+  size_t used = pool_bytes_used(pool);
+  for (int i = 0; i < 3; i++) {
+    hash_table_insert(&table, keys[i], strlen(keys[i]), json_value_number(i), pool);
+  }
+  size_t inline_cost = pool_bytes_used(pool) - used;
+  hash_table_insert(&table, keys[3], 8, json_value_number(3), pool);
+  TEST_ASSERT(pool_bytes_used(pool) - used > inline_cost, "Only the long key should need pool storage");
+  TEST_ASSERT(!hash_key_fits_inline(0) && hash_key_fits_inline(HASH_KEY_INLINE_MAX) &&
+              !hash_key_fits_inline(HASH_KEY_INLINE_MAX + 1), "Inline keys are 1 to 7 bytes");
+
+  int mismatches = 0;
+  json_object_iter_t it = { table.entries, table.entries + hash_table_used(&table) };
+  int i = 0;
+  for (hash_entry_t *entry; (entry = json_object_next(&it)); i++) {
+    json_str_t key = hash_entry_key(entry);
+    if (key.len != strlen(keys[i]) || strcmp(key.str, keys[i]) != 0 || entry->value.number != i) mismatches++;
+    if (hash_table_get(&table, key.str, key.len) != &entry->value) mismatches++;
+  }
+  TEST_ASSERT(i == 4 && mismatches == 0, "Keys should read back in order with their lengths");
+
+  // Deleting an inline key leaves a hole the iterator skips
+  hash_table_delete_pooled(&table, "a", 1, pool);
+  it = (json_object_iter_t){ table.entries, table.entries + hash_table_used(&table) };
+  int visited = 0;
+  while (json_object_next(&it)) visited++;
+  TEST_ASSERT(visited == 3 && hash_table_get(&table, "a", 1) == NULL, "Deleted inline key should be skipped");
+  TEST_ASSERT(hash_table_get(&table, "abcdefg", 7) && hash_table_get(&table, "", 0),
+              "Other keys should survive the delete");
+
+  // Key lengths share 32 bits with the borrowed flag; longer keys are refused
+  TEST_ASSERT(hash_table_insert_hashed(&table, "k", (size_t)HASH_KEY_LEN_MAX + 1, 0, json_value_number(5), pool) == -1 &&
+              table.size == 3, "Keys over HASH_KEY_LEN_MAX should not be stored");
+
+  // A key of NUL bytes is a zero word but not a hole
+  hash_table_insert(&table, "\0\0", 2, json_value_number(4), pool);
+  it = (json_object_iter_t){ table.entries, table.entries + hash_table_used(&table) };
+  visited = 0;
+  while (json_object_next(&it)) visited++;
+  TEST_ASSERT(visited == 4 && hash_table_get(&table, "\0\0", 2) && !hash_table_get(&table, "\0", 1),
+              "NUL-byte keys should be live and matched by length");
+
+  pool_destroy(pool);
+}
+
+TEST_MAIN("Hash Table",
+  test_hash_string();
+  test_hash_table_insert_get();
+  test_hash_table_growth();
+  test_hash_table_grow_in_place();
+  test_hash_table_small_capacity();
+  test_hash_table_delete_reuse();
+  test_object_key_handles();
+  test_object_iteration_order();
+  test_hash_table_inline_keys();
+)
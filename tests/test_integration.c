@@ -49,7 +49,7 @@ void test_simple_json() {
   // Check "name" field
   json_value_t name = json_object_get(&value, "name");
   TEST_ASSERT(name.type == JSON_STRING, "name should be string");
-  TEST_ASSERT(strcmp(name.string, "Barsbold") == 0, "name should be 'Barsbold'");
+  TEST_ASSERT(strcmp(json_get_string(&name), "Barsbold") == 0, "name should be 'Barsbold'");
 
   // Check "age" field
   json_value_t age = json_object_get(&value, "age");
@@ -78,19 +78,19 @@ void test_array_json() {
   json_value_t value = parse(&parser);
   TEST_ASSERT(!parser.has_error, "Should parse without errors");
   TEST_ASSERT(value.type == JSON_ARRAY, "Root should be array");
-  TEST_ASSERT(value.array.len == 4, "Array should have 4 elements");
+  TEST_ASSERT(value.array->len == 4, "Array should have 4 elements");
 
   // Check array elements
-  TEST_ASSERT(value.array.items[0].type == JSON_STRING, "First element should be string");
-  TEST_ASSERT(strcmp(value.array.items[0].string, "Barsbold") == 0, "First element should be 'Barsbold'");
+  TEST_ASSERT(value.array->items[0].type == JSON_STRING, "First element should be string");
+  TEST_ASSERT(strcmp(json_get_string(&value.array->items[0]), "Barsbold") == 0, "First element should be 'Barsbold'");
 
-  TEST_ASSERT(value.array.items[1].type == JSON_NUMBER, "Second element should be number");
-  TEST_ASSERT(value.array.items[1].number == 21.0, "Second element should be 21");
+  TEST_ASSERT(value.array->items[1].type == JSON_NUMBER, "Second element should be number");
+  TEST_ASSERT(value.array->items[1].number == 21.0, "Second element should be 21");
 
-  TEST_ASSERT(value.array.items[2].type == JSON_BOOL, "Third element should be boolean");
-  TEST_ASSERT(value.array.items[2].boolean == true, "Third element should be true");
+  TEST_ASSERT(value.array->items[2].type == JSON_BOOL, "Third element should be boolean");
+  TEST_ASSERT(value.array->items[2].boolean == true, "Third element should be true");
 
-  TEST_ASSERT(value.array.items[3].type == JSON_NULL, "Fourth element should be null");
+  TEST_ASSERT(value.array->items[3].type == JSON_NULL, "Fourth element should be null");
 
   json_value_free(&value);
   lexer_free(&lexer);
@@ -114,20 +114,20 @@ void test_nested_json() {
   // Check company name
   json_value_t company = json_object_get(&value, "company");
   TEST_ASSERT(company.type == JSON_STRING, "company should be string");
-  TEST_ASSERT(strcmp(company.string, "Tech Corp") == 0, "company should be 'Tech Corp'");
+  TEST_ASSERT(strcmp(json_get_string(&company), "Tech Corp") == 0, "company should be 'Tech Corp'");
 
   // Check employees array
   json_value_t employees = json_object_get(&value, "employees");
   TEST_ASSERT(employees.type == JSON_ARRAY, "employees should be array");
-  TEST_ASSERT(employees.array.len == 2, "employees array should have 2 elements");
+  TEST_ASSERT(employees.array->len == 2, "employees array should have 2 elements");
 
   // Check first employee
-  json_value_t first_employee = employees.array.items[0];
+  json_value_t first_employee = employees.array->items[0];
   TEST_ASSERT(first_employee.type == JSON_OBJECT, "First employee should be object");
 
   json_value_t emp_name = json_object_get(&first_employee, "name");
   TEST_ASSERT(emp_name.type == JSON_STRING, "Employee name should be string");
-  TEST_ASSERT(strcmp(emp_name.string, "Alice Johnson") == 0, "Employee name should be 'Alice Johnson'");
+  TEST_ASSERT(strcmp(json_get_string(&emp_name), "Alice Johnson") == 0, "Employee name should be 'Alice Johnson'");
 
   json_value_t emp_age = json_object_get(&first_employee, "age");
   TEST_ASSERT(emp_age.type == JSON_NUMBER, "Employee age should be number");
@@ -140,9 +140,9 @@ void test_nested_json() {
   // Check skills array
   json_value_t skills = json_object_get(&first_employee, "skills");
   TEST_ASSERT(skills.type == JSON_ARRAY, "skills should be array");
-  TEST_ASSERT(skills.array.len == 3, "skills array should have 3 elements");
-  TEST_ASSERT(skills.array.items[0].type == JSON_STRING, "First skill should be string");
-  TEST_ASSERT(strcmp(skills.array.items[0].string, "JavaScript") == 0, "First skill should be 'JavaScript'");
+  TEST_ASSERT(skills.array->len == 3, "skills array should have 3 elements");
+  TEST_ASSERT(skills.array->items[0].type == JSON_STRING, "First skill should be string");
+  TEST_ASSERT(strcmp(json_get_string(&skills.array->items[0]), "JavaScript") == 0, "First skill should be 'JavaScript'");
 
   // Check nested address object
   json_value_t address = json_object_get(&first_employee, "address");
@@ -150,7 +150,7 @@ void test_nested_json() {
 
   json_value_t city = json_object_get(&address, "city");
   TEST_ASSERT(city.type == JSON_STRING, "city should be string");
-  TEST_ASSERT(strcmp(city.string, "San Francisco") == 0, "city should be 'San Francisco'");
+  TEST_ASSERT(strcmp(json_get_string(&city), "San Francisco") == 0, "city should be 'San Francisco'");
 
   // Check departments object
   json_value_t departments = json_object_get(&value, "departments");
@@ -161,7 +161,7 @@ void test_nested_json() {
 
   json_value_t eng_head = json_object_get(&engineering, "head");
   TEST_ASSERT(eng_head.type == JSON_STRING, "engineering head should be string");
-  TEST_ASSERT(strcmp(eng_head.string, "Alice Johnson") == 0, "engineering head should be 'Alice Johnson'");
+  TEST_ASSERT(strcmp(json_get_string(&eng_head), "Alice Johnson") == 0, "engineering head should be 'Alice Johnson'");
 
   json_value_t eng_size = json_object_get(&engineering, "size");
   TEST_ASSERT(eng_size.type == JSON_NUMBER, "engineering size should be number");
@@ -201,7 +201,7 @@ void test_complex_json() {
   // Check api_version
   json_value_t api_version = json_object_get(&value, "api_version");
   TEST_ASSERT(api_version.type == JSON_STRING, "api_version should be string");
-  TEST_ASSERT(strcmp(api_version.string, "v2.1") == 0, "api_version should be 'v2.1'");
+  TEST_ASSERT(strcmp(json_get_string(&api_version), "v2.1") == 0, "api_version should be 'v2.1'");
 
   // Check data object
   json_value_t data = json_object_get(&value, "data");
@@ -210,15 +210,15 @@ void test_complex_json() {
   // Check users array
   json_value_t users = json_object_get(&data, "users");
   TEST_ASSERT(users.type == JSON_ARRAY, "users should be array");
-  TEST_ASSERT(users.array.len == 2, "users array should have 2 elements");
+  TEST_ASSERT(users.array->len == 2, "users array should have 2 elements");
 
   // Check first user
-  json_value_t user1 = users.array.items[0];
+  json_value_t user1 = users.array->items[0];
   TEST_ASSERT(user1.type == JSON_OBJECT, "First user should be object");
 
   json_value_t username = json_object_get(&user1, "username");
   TEST_ASSERT(username.type == JSON_STRING, "username should be string");
-  TEST_ASSERT(strcmp(username.string, "user1") == 0, "username should be 'user1'");
+  TEST_ASSERT(strcmp(json_get_string(&username), "user1") == 0, "username should be 'user1'");
 
   json_value_t profile = json_object_get(&user1, "profile");
   TEST_ASSERT(profile.type == JSON_OBJECT, "profile should be object");
@@ -236,26 +236,26 @@ void test_complex_json() {
 
   json_value_t tags = json_object_get(&profile, "tags");
   TEST_ASSERT(tags.type == JSON_ARRAY, "tags should be array");
-  TEST_ASSERT(tags.array.len == 2, "tags array should have 2 elements");
+  TEST_ASSERT(tags.array->len == 2, "tags array should have 2 elements");
 
   // Check posts array
   json_value_t posts = json_object_get(&data, "posts");
   TEST_ASSERT(posts.type == JSON_ARRAY, "posts should be array");
-  TEST_ASSERT(posts.array.len == 1, "posts array should have 1 element");
+  TEST_ASSERT(posts.array->len == 1, "posts array should have 1 element");
 
-  json_value_t post = posts.array.items[0];
+  json_value_t post = posts.array->items[0];
   TEST_ASSERT(post.type == JSON_OBJECT, "post should be object");
 
   json_value_t comments = json_object_get(&post, "comments");
   TEST_ASSERT(comments.type == JSON_ARRAY, "comments should be array");
-  TEST_ASSERT(comments.array.len == 2, "comments array should have 2 elements");
+  TEST_ASSERT(comments.array->len == 2, "comments array should have 2 elements");
 
-  json_value_t first_comment = comments.array.items[0];
+  json_value_t first_comment = comments.array->items[0];
   TEST_ASSERT(first_comment.type == JSON_OBJECT, "First comment should be object");
 
   json_value_t comment_text = json_object_get(&first_comment, "text");
   TEST_ASSERT(comment_text.type == JSON_STRING, "comment text should be string");
-  TEST_ASSERT(strcmp(comment_text.string, "Great post!") == 0, "comment text should be 'Great post!'");
+  TEST_ASSERT(strcmp(json_get_string(&comment_text), "Great post!") == 0, "comment text should be 'Great post!'");
 
   // Check metadata
   json_value_t metadata = json_object_get(&value, "metadata");
@@ -287,11 +287,11 @@ void test_edge_cases_json() {
   // Check empty values
   json_value_t empty_string = json_object_get(&value, "empty_string");
   TEST_ASSERT(empty_string.type == JSON_STRING, "empty_string should be string");
-  TEST_ASSERT(strcmp(empty_string.string, "") == 0, "empty_string should be empty");
+  TEST_ASSERT(strcmp(json_get_string(&empty_string), "") == 0, "empty_string should be empty");
 
   json_value_t empty_array = json_object_get(&value, "empty_array");
   TEST_ASSERT(empty_array.type == JSON_ARRAY, "empty_array should be array");
-  TEST_ASSERT(empty_array.array.len == 0, "empty_array should have 0 elements");
+  TEST_ASSERT(empty_array.array->len == 0, "empty_array should have 0 elements");
 
   json_value_t empty_object = json_object_get(&value, "empty_object");
   TEST_ASSERT(empty_object.type == JSON_OBJECT, "empty_object should be object");
@@ -303,7 +303,7 @@ void test_edge_cases_json() {
 
   json_value_t nested_arr = json_object_get(&nested_empty, "arr");
   TEST_ASSERT(nested_arr.type == JSON_ARRAY, "nested arr should be array");
-  TEST_ASSERT(nested_arr.array.len == 0, "nested arr should be empty");
+  TEST_ASSERT(nested_arr.array->len == 0, "nested arr should be empty");
 
   json_value_t nested_obj = json_object_get(&nested_empty, "obj");
   TEST_ASSERT(nested_obj.type == JSON_OBJECT, "nested obj should be object");
@@ -351,22 +351,22 @@ void test_edge_cases_json() {
 
   json_value_t deep_value = json_object_get(&level4, "value");
   TEST_ASSERT(deep_value.type == JSON_STRING, "deep value should be string");
-  TEST_ASSERT(strcmp(deep_value.string, "deep") == 0, "deep value should be 'deep'");
+  TEST_ASSERT(strcmp(json_get_string(&deep_value), "deep") == 0, "deep value should be 'deep'");
 
   // Check mixed array
   json_value_t mixed_array = json_object_get(&value, "mixed_array");
   TEST_ASSERT(mixed_array.type == JSON_ARRAY, "mixed_array should be array");
-  TEST_ASSERT(mixed_array.array.len == 6, "mixed_array should have 6 elements");
+  TEST_ASSERT(mixed_array.array->len == 6, "mixed_array should have 6 elements");
 
-  TEST_ASSERT(mixed_array.array.items[0].type == JSON_NUMBER, "Element 0 should be number");
-  TEST_ASSERT(mixed_array.array.items[1].type == JSON_STRING, "Element 1 should be string");
-  TEST_ASSERT(mixed_array.array.items[2].type == JSON_BOOL, "Element 2 should be boolean");
-  TEST_ASSERT(mixed_array.array.items[3].type == JSON_NULL, "Element 3 should be null");
-  TEST_ASSERT(mixed_array.array.items[4].type == JSON_OBJECT, "Element 4 should be object");
-  TEST_ASSERT(mixed_array.array.items[5].type == JSON_ARRAY, "Element 5 should be array");
+  TEST_ASSERT(mixed_array.array->items[0].type == JSON_NUMBER, "Element 0 should be number");
+  TEST_ASSERT(mixed_array.array->items[1].type == JSON_STRING, "Element 1 should be string");
+  TEST_ASSERT(mixed_array.array->items[2].type == JSON_BOOL, "Element 2 should be boolean");
+  TEST_ASSERT(mixed_array.array->items[3].type == JSON_NULL, "Element 3 should be null");
+  TEST_ASSERT(mixed_array.array->items[4].type == JSON_OBJECT, "Element 4 should be object");
+  TEST_ASSERT(mixed_array.array->items[5].type == JSON_ARRAY, "Element 5 should be array");
 
-  json_value_t nested_array = mixed_array.array.items[5];
-  TEST_ASSERT(nested_array.array.len == 3, "nested array should have 3 elements");
+  json_value_t nested_array = mixed_array.array->items[5];
+  TEST_ASSERT(nested_array.array->len == 3, "nested array should have 3 elements");
 
   json_value_free(&value);
   lexer_free(&lexer);
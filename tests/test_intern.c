@@ -0,0 +1,202 @@
+#include "../include/parser.h"
+#include "../include/intern.h"
+#include "test_framework.h"
+
+#include <pthread.h>
+
+TEST_SUITE_INIT()
+
+void test_intern_basic() {
+  printf("\n=== Testing key interning ===\n");
+
+  intern_table_t *table = intern_table_create(0);
+  TEST_ASSERT(table != NULL, "Intern table should be created");
+
+  char buf[] = "name";
+  const char *a = intern_string(table, "name", 4);
+  const char *b = intern_string(table, buf, 4);
+  TEST_ASSERT(a != NULL && a == b, "Equal keys should share one canonical pointer");
+  TEST_ASSERT(a != buf, "Canonical key should be a copy");
+  TEST_ASSERT(strcmp(a, "name") == 0, "Canonical key should be NUL-terminated");
+
+  const char *c = intern_string(table, "names", 5);
+  TEST_ASSERT(c != NULL && c != a, "Different keys should not share a pointer");
+  TEST_ASSERT(intern_table_size(table) == 2, "Table should hold two keys");
+
+  TEST_ASSERT(intern_table_lookup(table, "name", 4, hash_string("name", 4)) == a,
+              "Lookup should find an interned key");
+  TEST_ASSERT(intern_table_lookup(table, "missing", 7, hash_string("missing", 7)) == NULL,
+              "Lookup should not add keys");
+
+  // Grow well past the initial capacity
+  char key[32];
+  int mismatches = 0;
+  const char *first[1000];
+  for (int i = 0; i < 1000; i++) {
+    snprintf(key, sizeof(key), "key_%d", i);
+    first[i] = intern_string(table, key, strlen(key));
+  }
+  for (int i = 0; i < 1000; i++) {
+    snprintf(key, sizeof(key), "key_%d", i);
+    if (intern_string(table, key, strlen(key)) != first[i]) mismatches++;
+  }
+  TEST_ASSERT(mismatches == 0, "Canonical pointers should survive growth");
+  TEST_ASSERT(intern_table_size(table) == 1002, "Every distinct key should be counted once");
+
+  intern_table_destroy(table);
+}
+
+void test_intern_limit() {
+  printf("\n=== Testing intern table limit ===\n");
+
+  intern_table_t *table = intern_table_create(2);
+  const char *a = intern_string(table, "a", 1);
+  const char *b = intern_string(table, "b", 1);
+  TEST_ASSERT(a && b, "Keys under the limit should be interned");
+  TEST_ASSERT(intern_string(table, "c", 1) == NULL, "Keys past the limit should be refused");
+  TEST_ASSERT(intern_string(table, "a", 1) == a, "Existing keys are still returned when full");
+  intern_table_destroy(table);
+}
+
+// Enough keys that the slot array grows several times while other threads
+// are probing it
+#define THREAD_KEYS 2048
+
+typedef struct {
+  intern_table_t *table;
+  int offset;
+  const char *seen[THREAD_KEYS];
+} intern_worker_t;
+
+static void *intern_worker(void *arg) {
+  intern_worker_t *worker = arg;
+  char key[32];
+  for (int round = 0; round < 20; round++) {
+    for (int j = 0; j < THREAD_KEYS; j++) {
+      // Each thread starts at a different key, so inserts race with lookups
+      int i = (j + worker->offset) % THREAD_KEYS;
+      snprintf(key, sizeof(key), "shared_key_%d", i);
+      const char *str = intern_string(worker->table, key, strlen(key));
+      if (round == 0) {
+        worker->seen[i] = str;
+      } else if (worker->seen[i] != str) {
+        worker->seen[i] = NULL;
+      }
+    }
+  }
+  return NULL;
+}
+
+void test_intern_threads() {
+  printf("\n=== Testing concurrent interning ===\n");
+
+  intern_table_t *table = intern_table_create(0);
+  intern_worker_t workers[4];
+  pthread_t threads[4];
+  for (int t = 0; t < 4; t++) {
+    workers[t].table = table;
+    workers[t].offset = t * THREAD_KEYS / 4;
+    pthread_create(&threads[t], NULL, intern_worker, &workers[t]);
+  }
+  for (int t = 0; t < 4; t++) {
+    pthread_join(threads[t], NULL);
+  }
+
+  int mismatches = 0;
+  for (int i = 0; i < THREAD_KEYS; i++) {
+    for (int t = 0; t < 4; t++) {
+      if (!workers[t].seen[i] || workers[t].seen[i] != workers[0].seen[i]) mismatches++;
+    }
+  }
+  TEST_ASSERT(mismatches == 0, "All threads should get the same canonical pointers");
+  TEST_ASSERT(intern_table_size(table) == THREAD_KEYS, "Each key should be interned once");
+
+  intern_table_destroy(table);
+}
+
+static json_value_t parse_with(const char *input, intern_table_t *table, parser_t *parser, lexer_t *lexer) {
+  *lexer = lexer_init(input);
+  *parser = parser_init(lexer);
+  parser->intern = table;
+  parser->current_token = next_token(lexer);
+  return parse(parser);
+}
+
+void test_parser_interning() {
+  printf("\n=== Testing parser with an intern table ===\n");
+
+  intern_table_t *table = intern_table_create(0);
+  const char *doc = "{\"identifier\": 1, \"display_name\": \"a\", \"tag_list\": {\"identifier\": 2}, "
+                    "\"identifier\": 3, \"id\": 4}";
+
+  lexer_t lexer1, lexer2;
+  parser_t parser1, parser2;
+  json_value_t v1 = parse_with(doc, table, &parser1, &lexer1);
+  json_value_t v2 = parse_with(doc, table, &parser2, &lexer2);
+  TEST_ASSERT(!parser1.has_error && !parser2.has_error, "Documents should parse");
+  TEST_ASSERT(intern_table_size(table) == 3, "Keys of both documents should be interned once");
+  TEST_ASSERT(json_object_has(&v1, "id"), "Short keys are stored inline rather than interned");
+
+  const char *id = intern_string(table, "identifier", 10);
+  uint32_t id_hash = hash_string("identifier", 10);
+  json_value_t *a = hash_table_get_hashed(v1.object, id, 10, id_hash);
+  json_value_t *b = hash_table_get_hashed(v2.object, "identifier", 10, id_hash);
+  TEST_ASSERT(a && a->number == 3, "Lookup with a canonical key should match; last duplicate wins");
+  TEST_ASSERT(b && b->number == 3, "Lookup with an equal key should still match");
+
+  // Both documents reference the same key storage
+  json_object_iter_t it = json_object_iter(&v1);
+  int shared = 0;
+  for (hash_entry_t *entry; (entry = json_object_next(&it));) {
+    json_str_t key = hash_entry_key(entry);
+    shared += intern_table_lookup(table, key.str, key.len, hash_string(key.str, key.len)) == key.str;
+  }
+  TEST_ASSERT(shared == 3, "Object keys should be canonical pointers");
+
+  json_value_t nested = json_object_get(&v2, "tag_list");
+  TEST_ASSERT(nested.type == JSON_OBJECT &&
+              hash_table_get_hashed(nested.object, id, 10, id_hash) != NULL,
+              "Nested objects should use the same canonical keys");
+
+  parser_free(&parser1);
+  parser_free(&parser2);
+  lexer_free(&lexer1);
+  lexer_free(&lexer2);
+
+  // A full dictionary falls back to copying keys
+  intern_table_t *small = intern_table_create(1);
+  lexer_t lexer3;
+  parser_t parser3;
+  json_value_t v3 = parse_with("{\"alpha_key\": 1, \"beta_key\": 2}", small, &parser3, &lexer3);
+  TEST_ASSERT(!parser3.has_error && json_object_size(&v3) == 2, "Keys past the limit should be copied");
+  TEST_ASSERT(json_object_has(&v3, "beta_key"), "Copied key should be found");
+
+  // Ownership is per key: the interned one stays, copied ones are released
+  size_t free_before = pool_bytes_free(parser3.pool);
+  TEST_ASSERT(json_object_delete_pooled(&v3, "beta_key", parser3.pool) == 0 &&
+              pool_bytes_free(parser3.pool) > free_before,
+              "Deleting a copied key next to an interned one should free it");
+  TEST_ASSERT(json_object_set_pooled(&v3, "gamma_key", json_value_number(3), parser3.pool) == 0,
+              "A key should be set after parsing");
+  free_before = pool_bytes_free(parser3.pool);
+  TEST_ASSERT(json_object_delete_pooled(&v3, "gamma_key", parser3.pool) == 0 &&
+              pool_bytes_free(parser3.pool) > free_before,
+              "A key set after parsing should be freed on delete");
+  free_before = pool_bytes_free(parser3.pool);
+  TEST_ASSERT(json_object_delete_pooled(&v3, "alpha_key", parser3.pool) == 0 &&
+              pool_bytes_free(parser3.pool) == free_before &&
+              intern_table_lookup(small, "alpha_key", 9, hash_string("alpha_key", 9)) != NULL,
+              "Deleting an interned key should leave it to the dictionary");
+  parser_free(&parser3);
+  lexer_free(&lexer3);
+  intern_table_destroy(small);
+
+  intern_table_destroy(table);
+}
+
+TEST_MAIN("Intern",
+  test_intern_basic();
+  test_intern_limit();
+  test_intern_threads();
+  test_parser_interning();
+)
@@ -12,25 +12,25 @@ void test_json_value_array_creation() {
   // Test 1: Create array with initial capacity
   json_value_t arr = json_value_array(4);
   TEST_ASSERT(arr.type == JSON_ARRAY, "Array should have JSON_ARRAY type");
-  TEST_ASSERT(arr.array.len == 0, "New array should have length 0");
-  TEST_ASSERT(arr.array.cap == 4, "New array should have capacity 4");
-  TEST_ASSERT(arr.array.items != NULL, "Array items should not be NULL");
-  free(arr.array.items);
+  TEST_ASSERT(arr.array->len == 0, "New array should have length 0");
+  TEST_ASSERT(arr.array->cap == 4, "New array should have capacity 4");
+  TEST_ASSERT(arr.array != NULL, "Array storage should not be NULL");
+  free(arr.array);
 
   // Test 2: Create array with different initial capacity
   json_value_t arr2 = json_value_array(10);
   TEST_ASSERT(arr2.type == JSON_ARRAY, "Second array should have JSON_ARRAY type");
-  TEST_ASSERT(arr2.array.cap == 10, "Array should have capacity 10");
-  TEST_ASSERT(arr2.array.len == 0, "Second array should start with length 0");
-  free(arr2.array.items);
+  TEST_ASSERT(arr2.array->cap == 10, "Array should have capacity 10");
+  TEST_ASSERT(arr2.array->len == 0, "Second array should start with length 0");
+  free(arr2.array);
 
   // Test 3: Create array with zero capacity (uses minimum capacity)
   json_value_t arr3 = json_value_array(0);
   TEST_ASSERT(arr3.type == JSON_ARRAY, "Array with zero capacity should have JSON_ARRAY type");
-  TEST_ASSERT(arr3.array.cap == ARRAY_MIN_CAP, "Array should have minimum capacity");
-  TEST_ASSERT(arr3.array.len == 0, "Array should have length 0");
-  TEST_ASSERT(arr3.array.items != NULL, "Array items should be allocated");
-  free(arr3.array.items);
+  TEST_ASSERT(arr3.array->cap == ARRAY_MIN_CAP, "Array should have minimum capacity");
+  TEST_ASSERT(arr3.array->len == 0, "Array should have length 0");
+  TEST_ASSERT(arr3.array != NULL, "Array storage should be allocated");
+  free(arr3.array);
 }
 
 void test_json_array_push() {
@@ -41,39 +41,39 @@ void test_json_array_push() {
   // Test 1: Push string value
   json_value_t str_val = json_value_string(strdup("hello"));
   json_array_push(&arr, str_val);
-  TEST_ASSERT(arr.array.len == 1, "Array length should be 1 after first push");
-  TEST_ASSERT(arr.array.items[0].type == JSON_STRING, "First item should be string type");
-  TEST_ASSERT(strcmp(arr.array.items[0].string, "hello") == 0, "String value should be correct");
+  TEST_ASSERT(arr.array->len == 1, "Array length should be 1 after first push");
+  TEST_ASSERT(arr.array->items[0].type == JSON_STRING, "First item should be string type");
+  TEST_ASSERT(strcmp(json_get_string(&arr.array->items[0]), "hello") == 0, "String value should be correct");
 
   // Test 2: Push number value
   json_value_t num_val = json_value_number(42.5);
   json_array_push(&arr, num_val);
-  TEST_ASSERT(arr.array.len == 2, "Array length should be 2 after second push");
-  TEST_ASSERT(arr.array.items[1].type == JSON_NUMBER, "Second item should be number type");
-  TEST_ASSERT(arr.array.items[1].number == 42.5, "Number value should be correct");
+  TEST_ASSERT(arr.array->len == 2, "Array length should be 2 after second push");
+  TEST_ASSERT(arr.array->items[1].type == JSON_NUMBER, "Second item should be number type");
+  TEST_ASSERT(arr.array->items[1].number == 42.5, "Number value should be correct");
 
   // Test 3: Push boolean value (should trigger resize since we're at 75% capacity)
   json_value_t bool_val = json_value_bool(true);
   json_array_push(&arr, bool_val);
-  TEST_ASSERT(arr.array.len == 3, "Array length should be 3 after third push");
-  TEST_ASSERT(arr.array.cap >= 3, "Array capacity should accommodate 3 items");
-  TEST_ASSERT(arr.array.items[2].type == JSON_BOOL, "Third item should be boolean type");
-  TEST_ASSERT(arr.array.items[2].boolean == true, "Boolean value should be correct");
+  TEST_ASSERT(arr.array->len == 3, "Array length should be 3 after third push");
+  TEST_ASSERT(arr.array->cap >= 3, "Array capacity should accommodate 3 items");
+  TEST_ASSERT(arr.array->items[2].type == JSON_BOOL, "Third item should be boolean type");
+  TEST_ASSERT(arr.array->items[2].boolean == true, "Boolean value should be correct");
 
   // Test 4: Push null value
   json_value_t null_val = json_value_init(JSON_NULL);
   json_array_push(&arr, null_val);
-  TEST_ASSERT(arr.array.len == 4, "Array length should be 4 after fourth push");
-  TEST_ASSERT(arr.array.items[3].type == JSON_NULL, "Fourth item should be null type");
+  TEST_ASSERT(arr.array->len == 4, "Array length should be 4 after fourth push");
+  TEST_ASSERT(arr.array->items[3].type == JSON_NULL, "Fourth item should be null type");
 
   // Verify all items are still accessible
-  TEST_ASSERT(strcmp(arr.array.items[0].string, "hello") == 0, "String value should be preserved");
-  TEST_ASSERT(arr.array.items[1].number == 42.5, "Number value should be preserved");
-  TEST_ASSERT(arr.array.items[2].boolean == true, "Boolean value should be preserved");
+  TEST_ASSERT(strcmp(json_get_string(&arr.array->items[0]), "hello") == 0, "String value should be preserved");
+  TEST_ASSERT(arr.array->items[1].number == 42.5, "Number value should be preserved");
+  TEST_ASSERT(arr.array->items[2].boolean == true, "Boolean value should be preserved");
 
   // Clean up
-  /* free(arr.array.items[0].string); */
-  /* free(arr.array.items); */
+  /* free(arr.array->items[0].string); */
+  /* free(arr.array); */
 }
 
 void test_json_array_pop() {
@@ -84,7 +84,7 @@ void test_json_array_pop() {
   // Test popping from empty array (edge case)
   int empty_result = json_array_pop(&arr);
   TEST_ASSERT(empty_result == -1, "Popping from empty array should return -1");
-  TEST_ASSERT(arr.array.len == 0, "Array length should remain 0");
+  TEST_ASSERT(arr.array->len == 0, "Array length should remain 0");
 
   // Fill array with test values
   json_value_t val1 = json_value_string(strdup("first"));
@@ -97,27 +97,27 @@ void test_json_array_pop() {
   json_array_push(&arr, val3);
   json_array_push(&arr, val4);
 
-  TEST_ASSERT(arr.array.len == 4, "Array should have 4 items before popping");
+  TEST_ASSERT(arr.array->len == 4, "Array should have 4 items before popping");
 
   // Test 1: Pop last item (LIFO behavior)
   int pop_result = json_array_pop(&arr);
   TEST_ASSERT(pop_result == 0, "Pop should return 0 on success");
-  TEST_ASSERT(arr.array.len == 3, "Array length should be 3 after first pop");
+  TEST_ASSERT(arr.array->len == 3, "Array length should be 3 after first pop");
 
   // Test 2: Pop another item
   pop_result = json_array_pop(&arr);
   TEST_ASSERT(pop_result == 0, "Second pop should return 0 on success");
-  TEST_ASSERT(arr.array.len == 2, "Array length should be 2 after second pop");
+  TEST_ASSERT(arr.array->len == 2, "Array length should be 2 after second pop");
 
   // Test 3: Pop third item
   pop_result = json_array_pop(&arr);
   TEST_ASSERT(pop_result == 0, "Third pop should return 0 on success");
-  TEST_ASSERT(arr.array.len == 1, "Array length should be 1 after third pop");
+  TEST_ASSERT(arr.array->len == 1, "Array length should be 1 after third pop");
 
   // Test 4: Pop final item
   pop_result = json_array_pop(&arr);
   TEST_ASSERT(pop_result == 0, "Fourth pop should return 0 on success");
-  TEST_ASSERT(arr.array.len == 0, "Array should be empty after fourth pop");
+  TEST_ASSERT(arr.array->len == 0, "Array should be empty after fourth pop");
 
   // Test 5: Pop from empty array again
   pop_result = json_array_pop(&arr);
@@ -125,7 +125,7 @@ void test_json_array_pop() {
 
   // Clean up
   /* free(val1.string); */
-  /* free(arr.array.items); */
+  /* free(arr.array); */
 }
 
 void test_json_array_mixed_operations() {
@@ -139,51 +139,51 @@ void test_json_array_mixed_operations() {
 
   json_array_push(&arr, val1);
   json_array_push(&arr, val2);
-  TEST_ASSERT(arr.array.len == 2, "Array should have 2 items after pushes");
+  TEST_ASSERT(arr.array->len == 2, "Array should have 2 items after pushes");
 
   int pop_result = json_array_pop(&arr);
   TEST_ASSERT(pop_result == 0, "Pop should succeed");
-  TEST_ASSERT(arr.array.len == 1, "Array should have 1 item after pop");
+  TEST_ASSERT(arr.array->len == 1, "Array should have 1 item after pop");
 
   // The last item should be val1 (LIFO - val2 was popped)
-  TEST_ASSERT(arr.array.items[0].type == JSON_STRING, "Remaining item should be string");
-  TEST_ASSERT(strcmp(arr.array.items[0].string, "test1") == 0, "Remaining string should be correct");
+  TEST_ASSERT(arr.array->items[0].type == JSON_STRING, "Remaining item should be string");
+  TEST_ASSERT(strcmp(json_get_string(&arr.array->items[0]), "test1") == 0, "Remaining string should be correct");
 
   // Push more items
   json_value_t val3 = json_value_bool(true);
   json_value_t val4 = json_value_init(JSON_NULL);
   json_array_push(&arr, val3);
   json_array_push(&arr, val4);
-  TEST_ASSERT(arr.array.len == 3, "Array should have 3 items after more pushes");
+  TEST_ASSERT(arr.array->len == 3, "Array should have 3 items after more pushes");
 
   // Verify items are in correct order
-  TEST_ASSERT(arr.array.items[0].type == JSON_STRING, "First item should be string");
-  TEST_ASSERT(arr.array.items[1].type == JSON_BOOL, "Second item should be boolean");
-  TEST_ASSERT(arr.array.items[2].type == JSON_NULL, "Third item should be null");
+  TEST_ASSERT(arr.array->items[0].type == JSON_STRING, "First item should be string");
+  TEST_ASSERT(arr.array->items[1].type == JSON_BOOL, "Second item should be boolean");
+  TEST_ASSERT(arr.array->items[2].type == JSON_NULL, "Third item should be null");
 
   // Pop all remaining items and verify LIFO order
   pop_result = json_array_pop(&arr);
   TEST_ASSERT(pop_result == 0, "Pop should succeed");
-  TEST_ASSERT(arr.array.len == 2, "Array should have 2 items after pop");
+  TEST_ASSERT(arr.array->len == 2, "Array should have 2 items after pop");
 
   pop_result = json_array_pop(&arr);
   TEST_ASSERT(pop_result == 0, "Pop should succeed");
-  TEST_ASSERT(arr.array.len == 1, "Array should have 1 item after pop");
+  TEST_ASSERT(arr.array->len == 1, "Array should have 1 item after pop");
 
   pop_result = json_array_pop(&arr);
   TEST_ASSERT(pop_result == 0, "Pop should succeed");
-  TEST_ASSERT(arr.array.len == 0, "Array should be empty after all pops");
+  TEST_ASSERT(arr.array->len == 0, "Array should be empty after all pops");
 
   // Clean up
   free(val1.string);
-  free(arr.array.items);
+  free(arr.array);
 }
 
 void test_json_array_capacity_management() {
   printf("\n=== Testing array capacity management ===\n");
 
   json_value_t arr = json_value_array(2);
-  size_t initial_cap = arr.array.cap;
+  size_t initial_cap = arr.array->cap;
 
   // Fill array to trigger expansion
   json_value_t values[10];
@@ -192,14 +192,14 @@ void test_json_array_capacity_management() {
     json_array_push(&arr, values[i]);
   }
 
-  TEST_ASSERT(arr.array.len == 10, "Array should have 10 items");
-  TEST_ASSERT(arr.array.cap >= 10, "Array capacity should accommodate all items");
-  TEST_ASSERT(arr.array.cap > initial_cap, "Array capacity should have expanded");
+  TEST_ASSERT(arr.array->len == 10, "Array should have 10 items");
+  TEST_ASSERT(arr.array->cap >= 10, "Array capacity should accommodate all items");
+  TEST_ASSERT(arr.array->cap > initial_cap, "Array capacity should have expanded");
 
   // Verify all values are preserved during capacity changes
   for (int i = 0; i < 10; i++) {
-    TEST_ASSERT(arr.array.items[i].type == JSON_NUMBER, "Array item should preserve type during expansion");
-    TEST_ASSERT(arr.array.items[i].number == i * 10.5, "Value should be preserved during expansion");
+    TEST_ASSERT(arr.array->items[i].type == JSON_NUMBER, "Array item should preserve type during expansion");
+    TEST_ASSERT(arr.array->items[i].number == i * 10.5, "Value should be preserved during expansion");
   }
 
   // Pop items to potentially trigger contraction
@@ -208,13 +208,13 @@ void test_json_array_capacity_management() {
     TEST_ASSERT(pop_result == 0, "Pop should succeed");
   }
 
-  TEST_ASSERT(arr.array.len == 2, "Array should have 2 items after pops");
+  TEST_ASSERT(arr.array->len == 2, "Array should have 2 items after pops");
 
   // Verify remaining items are still correct
-  TEST_ASSERT(arr.array.items[0].number == 0.0, "First remaining item should be correct");
-  TEST_ASSERT(arr.array.items[1].number == 10.5, "Second remaining item should be correct");
+  TEST_ASSERT(arr.array->items[0].number == 0.0, "First remaining item should be correct");
+  TEST_ASSERT(arr.array->items[1].number == 10.5, "Second remaining item should be correct");
 
-  free(arr.array.items);
+  free(arr.array);
 }
 
 void test_json_array_edge_cases() {
@@ -228,21 +228,21 @@ void test_json_array_edge_cases() {
   json_array_push(&nested_arr, inner_val);
   json_array_push(&arr, nested_arr);
 
-  TEST_ASSERT(arr.array.len == 1, "Array should contain the nested array");
-  TEST_ASSERT(arr.array.items[0].type == JSON_ARRAY, "Nested item should be array type");
-  TEST_ASSERT(arr.array.items[0].array.len == 1, "Nested array should have correct length");
-  TEST_ASSERT(arr.array.items[0].array.items[0].type == JSON_STRING, "Nested string should have correct type");
-  TEST_ASSERT(strcmp(arr.array.items[0].array.items[0].string, "nested") == 0, "Nested string should have correct value");
+  TEST_ASSERT(arr.array->len == 1, "Array should contain the nested array");
+  TEST_ASSERT(arr.array->items[0].type == JSON_ARRAY, "Nested item should be array type");
+  TEST_ASSERT(arr.array->items[0].array->len == 1, "Nested array should have correct length");
+  TEST_ASSERT(arr.array->items[0].array->items[0].type == JSON_STRING, "Nested string should have correct type");
+  TEST_ASSERT(strcmp(json_get_string(&arr.array->items[0].array->items[0]), "nested") == 0, "Nested string should have correct value");
 
   // Test pop from array with nested structures
   int pop_result = json_array_pop(&arr);
   TEST_ASSERT(pop_result == 0, "Pop should succeed");
-  TEST_ASSERT(arr.array.len == 0, "Array should be empty after pop");
+  TEST_ASSERT(arr.array->len == 0, "Array should be empty after pop");
 
   // Clean up
   free(inner_val.string);
-  free(nested_arr.array.items);
-  free(arr.array.items);
+  free(nested_arr.array);
+  free(arr.array);
 }
 
 void test_json_array_comparison() {
@@ -301,12 +301,12 @@ void test_json_array_comparison() {
   TEST_ASSERT(json_array_cmp(&not_array, &arr1) == -1, "Non-array vs array should return -1");
 
   // Clean up
-  free(arr1.array.items);
-  free(arr2.array.items);
-  free(arr3.array.items);
-  free(arr4.array.items);
-  free(arr5.array.items);
-  free(arr6.array.items);
+  free(arr1.array);
+  free(arr2.array);
+  free(arr3.array);
+  free(arr4.array);
+  free(arr5.array);
+  free(arr6.array);
   free(val5.string);
   free(val7.string);
   free(val8.string);
@@ -330,7 +330,7 @@ void test_json_array_null_safety() {
   TEST_ASSERT(json_array_cmp(NULL, &arr) == -1, "Comparison with NULL should return -1");
   TEST_ASSERT(json_array_cmp(&arr, NULL) == -1, "Comparison with NULL should return -1");
 
-  free(arr.array.items);
+  free(arr.array);
 }
 
 TEST_MAIN("JSON Array",
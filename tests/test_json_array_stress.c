@@ -15,29 +15,29 @@ void test_json_array_stress() {
     json_array_push(&arr, val);
   }
 
-  TEST_ASSERT(arr.array.len == num_items, "Array should contain all pushed items");
-  TEST_ASSERT(arr.array.cap >= num_items, "Array capacity should accommodate all items");
+  TEST_ASSERT(arr.array->len == num_items, "Array should contain all pushed items");
+  TEST_ASSERT(arr.array->cap >= num_items, "Array capacity should accommodate all items");
 
   // Verify all values are correct
   for (int i = 0; i < num_items; i++) {
-    TEST_ASSERT(arr.array.items[i].type == JSON_NUMBER, "Item should be number type");
-    TEST_ASSERT(arr.array.items[i].number == i, "Item value should be correct");
+    TEST_ASSERT(arr.array->items[i].type == JSON_NUMBER, "Item should be number type");
+    TEST_ASSERT(arr.array->items[i].number == i, "Item value should be correct");
   }
 
   // Test 2: Pop all items
   for (int i = num_items - 1; i >= 0; i--) {
     int pop_result = json_array_pop(&arr);
     TEST_ASSERT(pop_result == 0, "Pop should succeed");
-    TEST_ASSERT(arr.array.len == i, "Array length should decrease correctly");
+    TEST_ASSERT(arr.array->len == i, "Array length should decrease correctly");
   }
 
-  TEST_ASSERT(arr.array.len == 0, "Array should be empty after all pops");
+  TEST_ASSERT(arr.array->len == 0, "Array should be empty after all pops");
 
   // Test 3: Pop from empty array after stress test
   int final_pop = json_array_pop(&arr);
   TEST_ASSERT(final_pop == -1, "Final pop from empty array should return -1");
 
-  free(arr.array.items);
+  free(arr.array);
 }
 
 void test_json_array_memory_management() {
@@ -53,16 +53,16 @@ void test_json_array_memory_management() {
       json_array_push(&arr, val);
     }
     
-    TEST_ASSERT(arr.array.len == i, "Array should have correct number of items");
+    TEST_ASSERT(arr.array->len == i, "Array should have correct number of items");
     
     // Pop half the items
     for (int j = 0; j < i / 2; j++) {
       json_array_pop(&arr);
     }
     
-    TEST_ASSERT(arr.array.len == i - (i / 2), "Array should have correct length after pops");
+    TEST_ASSERT(arr.array->len == i - (i / 2), "Array should have correct length after pops");
     
-    free(arr.array.items);
+    free(arr.array);
   }
   
   TEST_ASSERT(1, "Memory management test completed without crashes");
@@ -147,25 +147,25 @@ void test_json_value_array() {
   // Test 1: Create array with initial capacity
   json_value_t arr = json_value_array(5);
   TEST_ASSERT(arr.type == JSON_ARRAY, "Array should have JSON_ARRAY type");
-  TEST_ASSERT(arr.array.items != NULL, "Array items should not be NULL");
-  TEST_ASSERT(arr.array.len == 0, "New array should have length 0");
-  TEST_ASSERT(arr.array.cap == 5, "Array should have specified capacity");
+  TEST_ASSERT(arr.array != NULL, "Array storage should not be NULL");
+  TEST_ASSERT(arr.array->len == 0, "New array should have length 0");
+  TEST_ASSERT(arr.array->cap == 5, "Array should have specified capacity");
 
   // Test 2: Create array with zero capacity (uses minimum capacity)
   json_value_t empty_arr = json_value_array(0);
   TEST_ASSERT(empty_arr.type == JSON_ARRAY, "Empty array should have JSON_ARRAY type");
-  TEST_ASSERT(empty_arr.array.len == 0, "Empty array should have length 0");
-  TEST_ASSERT(empty_arr.array.cap == ARRAY_MIN_CAP, "Empty array should have minimum capacity");
+  TEST_ASSERT(empty_arr.array->len == 0, "Empty array should have length 0");
+  TEST_ASSERT(empty_arr.array->cap == ARRAY_MIN_CAP, "Empty array should have minimum capacity");
 
   // Test 3: Create array with large capacity
   json_value_t large_arr = json_value_array(1000);
   TEST_ASSERT(large_arr.type == JSON_ARRAY, "Large array should have JSON_ARRAY type");
-  TEST_ASSERT(large_arr.array.cap == 1000, "Large array should have correct capacity");
-  TEST_ASSERT(large_arr.array.len == 0, "Large array should start with length 0");
+  TEST_ASSERT(large_arr.array->cap == 1000, "Large array should have correct capacity");
+  TEST_ASSERT(large_arr.array->len == 0, "Large array should start with length 0");
 
   // Clean up allocated arrays
-  free(arr.array.items);
-  free(large_arr.array.items);
+  free(arr.array);
+  free(large_arr.array);
 }
 
 void test_json_value_object() {
@@ -174,20 +174,20 @@ void test_json_value_object() {
   // Test 1: Create object with initial capacity
   json_value_t obj = json_value_object(3);
   TEST_ASSERT(obj.type == JSON_OBJECT, "Object should have JSON_OBJECT type");
-  TEST_ASSERT(obj.object.buckets != NULL, "Object buckets should not be NULL");
+  TEST_ASSERT(obj.object->entries != NULL, "Object entries should not be NULL");
   TEST_ASSERT(json_object_size(&obj) == 0, "New object should have size 0");
-  TEST_ASSERT(obj.object.capacity >= 3, "Object should have at least specified capacity");
+  TEST_ASSERT(obj.object->capacity >= 3, "Object should have at least specified capacity");
 
   // Test 2: Create object with zero capacity (should default to minimum)
   json_value_t empty_obj = json_value_object(0);
   TEST_ASSERT(empty_obj.type == JSON_OBJECT, "Empty object should have JSON_OBJECT type");
   TEST_ASSERT(json_object_size(&empty_obj) == 0, "Empty object should have size 0");
-  TEST_ASSERT(empty_obj.object.capacity >= 16, "Empty object should have default capacity");
+  TEST_ASSERT(empty_obj.object->capacity >= 16, "Empty object should have default capacity");
 
   // Test 3: Create object with large capacity (power of 2)
   json_value_t large_obj = json_value_object(100);
   TEST_ASSERT(large_obj.type == JSON_OBJECT, "Large object should have JSON_OBJECT type");
-  TEST_ASSERT(large_obj.object.capacity >= 100, "Large object should have at least specified capacity");
+  TEST_ASSERT(large_obj.object->capacity >= 100, "Large object should have at least specified capacity");
   TEST_ASSERT(json_object_size(&large_obj) == 0, "Large object should start with size 0");
 
   // Test 4: Test set and get operations
@@ -292,10 +292,10 @@ void test_json_array_cmp() {
   TEST_ASSERT(json_array_cmp(&arr3, &arr4) == 0, "Arrays with same elements should be equal");
 
   // Clean up
-  free(arr1.array.items);
-  free(arr2.array.items);
-  free(arr3.array.items);
-  free(arr4.array.items);
+  free(arr1.array);
+  free(arr2.array);
+  free(arr3.array);
+  free(arr4.array);
   free(val5.string);
   free(val7.string);
 }
@@ -419,6 +419,70 @@ void test_json_value_edge_cases() {
   // TEST_ASSERT(isnan(nan_val.number), "NaN value should remain NaN");
 }
 
+void test_json_value_accessors() {
+  printf("\n=== Testing json_value accessors ===\n");
+
+  TEST_ASSERT(sizeof(json_value_t) == 16, "Values should be 16 bytes");
+
+  json_value_t num = json_value_number(2.5);
+  json_value_t flag = json_value_bool(true);
+  json_value_t null = json_value_init(JSON_NULL);
+  TEST_ASSERT(json_typeof(&num) == JSON_NUMBER && json_get_number(&num) == 2.5, "Number accessor");
+  TEST_ASSERT(json_get_bool(&flag) && !json_get_bool(&num), "Bool accessor");
+  TEST_ASSERT(json_get_number(&flag) == 0 && json_get_string(&num) == NULL,
+              "Accessors of another type should give neutral results");
+  TEST_ASSERT(json_array_len(&null) == 0 && json_array_at(&null, 0) == NULL, "Non-arrays have no elements");
+
+  json_value_t arr = json_value_array(0);
+  for (int i = 0; i < 10; i++) {
+    json_array_push(&arr, json_value_number(i));
+  }
+  TEST_ASSERT(json_array_len(&arr) == 10, "Array length accessor");
+  TEST_ASSERT(json_get_number(json_array_at(&arr, 9)) == 9, "Array element accessor");
+  TEST_ASSERT(json_array_at(&arr, 10) == NULL, "Out of range elements should be NULL");
+  json_value_free(&arr);
+}
+
+void test_json_value_inline_strings() {
+  printf("\n=== Testing inline strings ===\n");
+
+  mem_pool_t *pool = pool_create();
+  json_value_t id = json_value_string_n("id", 2, pool);
+  json_str_t str = json_get_str(&id);
+  TEST_ASSERT((id.flags & JSON_VALUE_INLINE) && pool_bytes_used(pool) == 0, "Short strings should not touch the pool");
+  TEST_ASSERT(str.len == 2 && strcmp(str.str, "id") == 0 && str.str == json_get_string(&id),
+              "Inline strings should read back with their length");
+
+  const char longest[] = "abcdefghijkl";
+  json_value_t edge = json_value_string_n(longest, JSON_INLINE_MAX, pool);
+  json_value_t over = json_value_string_n("abcdefghijklm", JSON_INLINE_MAX + 1, pool);
+  TEST_ASSERT((edge.flags & JSON_VALUE_INLINE) && strcmp(json_get_string(&edge), longest) == 0,
+              "JSON_INLINE_MAX bytes should fit inline");
+  TEST_ASSERT(!(over.flags & JSON_VALUE_INLINE) && (over.flags & JSON_VALUE_POOLED) &&
+              json_get_str(&over).len == JSON_INLINE_MAX + 1, "Longer strings should be copied into the pool");
+
+  // Lengths are kept, so embedded NULs survive
+  json_value_t nul = json_value_string_n("a\0b", 3, NULL);
+  TEST_ASSERT(json_get_str(&nul).len == 3 && json_get_str(&nul).str[2] == 'b', "Length should cover embedded NULs");
+
+  // Copies of an inline value carry their bytes
+  json_value_t copy = id;
+  id = json_value_number(1);
+  TEST_ASSERT(strcmp(json_get_string(&copy), "id") == 0, "Copied values should own their inline bytes");
+  TEST_ASSERT(json_value_cmp(&copy, &edge) != 0 && json_value_cmp(&edge, &edge) == 0, "Inline strings should compare");
+
+  // Lengths are 32 bits; longer strings are refused before any copy
+  json_value_t huge = json_value_string_n("x", (size_t)JSON_STRING_LEN_MAX + 1, pool);
+  TEST_ASSERT(huge.type == JSON_NULL, "Strings over JSON_STRING_LEN_MAX should be refused");
+
+  json_value_t heap = json_value_string_n("a heap string", 13, NULL);
+  TEST_ASSERT(!(heap.flags & (JSON_VALUE_INLINE | JSON_VALUE_POOLED)), "Without a pool long strings go on the heap");
+  json_value_free(&heap);
+  json_value_free(&copy);
+  json_value_free_pooled(&over, pool);
+  pool_destroy(pool);
+}
+
 TEST_MAIN("JSON Value Test", 
   test_json_value_init();
   test_json_value_string();
@@ -431,4 +495,6 @@ TEST_MAIN("JSON Value Test",
   test_json_object_cmp();
   test_json_value_free();
   test_json_value_edge_cases();
+  test_json_value_accessors();
+  test_json_value_inline_strings();
 )
@@ -1,5 +1,6 @@
 #include "test_framework.h"
 #include "../include/lexer.h"
+#include "../include/hash.h"
 #include <string.h>
 
 TEST_SUITE_INIT()
@@ -361,6 +362,72 @@ void test_line_column_tracking() {
   lexer_free(&lexer);
 }
 
+void test_string_hashing() {
+  printf("\n=== Testing key hashing during string scan ===\n");
+
+  const char *inputs[] = {
+    "\"\"",
+    "\"id\"",
+    "\"exactly8\"",
+    "\"a_longer_key_spanning_several_words\"",
+    "\"esc\\\"aped\\\\key_with_more_than_eight\"",
+  };
+  int mismatches = 0;
+  for (size_t i = 0; i < sizeof(inputs) / sizeof(inputs[0]); i++) {
+    lexer_t lexer = lexer_init(inputs[i]);
+    lexer.hash_strings = true;
+    token_t token = next_token(&lexer);
+    if (token.type != TOKEN_STRING ||
+        token.hash != hash_string(token.lexeme.start, token.lexeme.length)) {
+      mismatches++;
+    }
+    token_free(&token);
+    lexer_free(&lexer);
+  }
+  TEST_ASSERT(mismatches == 0, "Scanned hash should match hash_string over the lexeme");
+
+  // An escape at every position of strings of every length up to three
+  // words, in the middle of a document and at its end
+  mismatches = 0;
+  for (size_t len = 2; len <= 24; len++) {
+    for (size_t at = 0; at + 2 <= len; at++) {
+      char input[64];
+      input[0] = '"';
+      memset(input + 1, 'x', len);
+      memcpy(input + 1 + at, "\\\\", 2);
+      for (int tail = 0; tail < 2; tail++) {
+        strcpy(input + 1 + len, tail ? "\": 1}" : "\"");
+        lexer_t lexer = lexer_init(input);
+        lexer.hash_strings = true;
+        token_t token = next_token(&lexer);
+        if (token.type != TOKEN_STRING || token.hash != hash_string(input + 1, len)) mismatches++;
+        token_free(&token);
+        lexer_free(&lexer);
+      }
+    }
+  }
+  TEST_ASSERT(mismatches == 0, "Hash should match after an escape in any position");
+
+  // Hashing is off by default and must not change positions
+  lexer_t lexer = lexer_init("{\"first_long_key_name\": 1,\n \"k\": 2}");
+  token_t token = next_token(&lexer);
+  token_free(&token);
+  token = next_token(&lexer);
+  TEST_ASSERT(token.hash == 0, "Strings are not hashed unless requested");
+  token_free(&token);
+  for (int i = 0; i < 3; i++) {
+    token = next_token(&lexer);
+    token_free(&token);
+  }
+  lexer.hash_strings = true;
+  token = next_token(&lexer);
+  TEST_ASSERT(token.type == TOKEN_STRING && token.line == 2 && token.column == 2,
+              "Hashed string keeps line/column tracking");
+  TEST_ASSERT(token.hash == hash_string("k", 1), "Hashed key after newline");
+  token_free(&token);
+  lexer_free(&lexer);
+}
+
 TEST_MAIN("Lexer", 
   test_single_character_tokens();
   test_string_tokens();
@@ -373,4 +440,5 @@ TEST_MAIN("Lexer",
   test_peek_functionality();
   test_complex_json();
   test_line_column_tracking();
+  test_string_hashing();
 )
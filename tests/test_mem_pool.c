@@ -0,0 +1,688 @@
+#include "../include/parser.h"
+#include "../include/mem_pool.h"
+#include "test_framework.h"
+
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <malloc.h>
+
+TEST_SUITE_INIT()
+
+void test_pool_alloc_aligned() {
+  printf("\n=== Testing aligned pool allocation ===\n");
+
+  mem_pool_t *pool = pool_create();
+  size_t alignments[] = {16, 32, 64, 4096};
+  int misaligned = 0;
+
+  for (size_t a = 0; a < sizeof(alignments) / sizeof(alignments[0]); a++) {
+    for (int i = 0; i < 100; i++) {
+      pool_alloc(pool, (size_t)(i % 7) + 1);  // knock the top off alignment
+      void *ptr = pool_alloc_aligned(pool, 24, alignments[a]);
+      if (!ptr || ((uintptr_t)ptr & (alignments[a] - 1)) != 0) misaligned++;
+    }
+  }
+  TEST_ASSERT(misaligned == 0, "Aligned allocations should honor the requested alignment");
+
+  void *small = pool_alloc_aligned(pool, 3, 4);
+  TEST_ASSERT(small && ((uintptr_t)small & (POOL_ALIGNMENT - 1)) == 0,
+              "Small alignments should fall back to pool alignment");
+  TEST_ASSERT(pool_alloc_aligned(pool, 8, 48) == NULL, "Non power of two alignment should fail");
+
+  // Padding is accounted as used and the block top follows the allocation
+  size_t used = pool_bytes_used(pool);
+  char *ptr = pool_alloc_aligned(pool, 64, 64);
+  TEST_ASSERT(pool_bytes_used(pool) >= used + 64, "Aligned allocation should count as used");
+  TEST_ASSERT(pool_extend(pool, ptr, 64, 128), "Aligned allocation should be extendable in place");
+
+  // Larger than the rest of the block: lands aligned in a new block
+  void *big = pool_alloc_aligned(pool, POOL_BLOCK_SIZE, POOL_CACHE_LINE);
+  TEST_ASSERT(big && ((uintptr_t)big & (POOL_CACHE_LINE - 1)) == 0,
+              "Allocation in a fresh block should be aligned");
+  memset(big, 0xAB, POOL_BLOCK_SIZE);
+
+  pool_destroy(pool);
+}
+
+void test_container_alignment() {
+  printf("\n=== Testing pooled container alignment ===\n");
+
+  mem_pool_t *pool = pool_create();
+  pool_alloc(pool, 8);
+
+  json_value_t arr = json_value_array_pooled(0, pool);
+  TEST_ASSERT(((uintptr_t)arr.array & (JSON_CONTAINER_ALIGN - 1)) == 0, "Array blocks should be aligned");
+  int misaligned = 0;
+  for (int i = 0; i < 100; i++) {
+    pool_alloc(pool, 8);
+    json_array_push_pooled(&arr, json_value_number(i), pool);
+    if (((uintptr_t)arr.array & (JSON_CONTAINER_ALIGN - 1)) != 0) misaligned++;
+  }
+  TEST_ASSERT(misaligned == 0, "Grown array blocks should stay aligned");
+
+  pool_alloc(pool, 8);
+  json_value_t obj = json_value_object_pooled(4, pool);
+  TEST_ASSERT(((uintptr_t)obj.object->entries & (JSON_CONTAINER_ALIGN - 1)) == 0, "Hash entries should be aligned");
+  TEST_ASSERT(((uintptr_t)hash_table_ctrl(obj.object) & (JSON_CONTAINER_ALIGN - 1)) == 0,
+              "Hash control bytes should be aligned");
+
+  pool_destroy(pool);
+}
+
+static void *pool_churn_thread(void *arg) {
+  (void)arg;
+  mem_pool_t *pools[2];
+  for (int i = 0; i < 2; i++) pools[i] = pool_create();
+  for (int i = 0; i < 2; i++) pool_destroy(pools[i]);
+  return NULL;
+}
+
+void test_pool_block_cache() {
+  printf("\n=== Testing recycled block cache ===\n");
+
+  pool_cache_trim();
+  pool_cache_set_limits(POOL_CACHE_THREAD_BLOCKS, POOL_CACHE_SHARED_BLOCKS);
+  pool_cache_stats_t before, after;
+  pool_cache_stats(&before);
+  TEST_ASSERT(before.thread_blocks == 0 && before.shared_blocks == 0, "Trim should empty the cache");
+
+  mem_pool_t *pool = pool_create();
+  pool_block_t *block = pool->head;
+  pool_destroy(pool);
+  pool = pool_create();
+  TEST_ASSERT(pool->head == block, "Next pool should reuse the released block");
+  TEST_ASSERT(pool->head->used == 0 && pool->head->next == NULL, "Reused block should be reset");
+  pool_destroy(pool);
+
+  pool_cache_stats(&after);
+  TEST_ASSERT(after.thread_hits == before.thread_hits + 1, "Reuse should count a thread hit");
+  TEST_ASSERT(after.released == before.released + 2, "Destroys should count releases");
+  TEST_ASSERT(after.thread_blocks == 1, "Calling thread should hold the block");
+
+  // Oversized blocks are never cached
+  pool = pool_create();
+  pool_alloc(pool, POOL_BLOCK_SIZE * 2);
+  pool_destroy(pool);
+  pool_cache_stats(&before);
+  TEST_ASSERT(before.thread_blocks == 1 && before.evicted == after.evicted, "Only standard blocks should be cached");
+
+  // Pools sized for small inputs recycle their blocks by size
+  pool_config_t small = pool_config_for_input(200);
+  pool = pool_create_with_config(&small);
+  block = pool->head;
+  pool_destroy(pool);
+  pool = pool_create_with_config(&small);
+  pool_cache_stats(&after);
+  TEST_ASSERT(pool->head == block && after.thread_hits == before.thread_hits + 1,
+              "Small blocks should be reused by the next pool of their size");
+  TEST_ASSERT(after.thread_blocks == 1 && pool->head->size == small.first_block_size,
+              "A standard block should not serve a small pool");
+  pool_destroy(pool);
+  pool_cache_stats(&before);
+
+  // Front list overflows into the shared list, then to the allocator
+  pool_cache_set_limits(1, 1);
+  mem_pool_t *pools[4];
+  for (int i = 0; i < 4; i++) pools[i] = pool_create();
+  for (int i = 0; i < 4; i++) pool_destroy(pools[i]);
+  pool_cache_stats(&after);
+  TEST_ASSERT(after.shared_blocks == 1, "Shared cache should respect its limit");
+  TEST_ASSERT(after.evicted > before.evicted, "Blocks past both limits should be freed");
+  pool_cache_trim();
+
+  // A thread's cached blocks move to the shared list when it exits
+  pool_cache_set_limits(POOL_CACHE_THREAD_BLOCKS, POOL_CACHE_SHARED_BLOCKS);
+  pthread_t thread;
+  pthread_create(&thread, NULL, pool_churn_thread, NULL);
+  pthread_join(thread, NULL);
+  pool_cache_stats(&after);
+  TEST_ASSERT(after.shared_blocks == 2, "Exiting thread should hand its blocks to the shared cache");
+
+  pool = pool_create();
+  pool_cache_stats(&before);
+  TEST_ASSERT(before.shared_hits == after.shared_hits + 1, "Another thread should reuse shared blocks");
+  pool_destroy(pool);
+
+  // Disabled cache goes straight to the allocator
+  pool_cache_trim();
+  pool_cache_set_limits(0, 0);
+  pool_destroy(pool_create());
+  pool_cache_stats(&after);
+  TEST_ASSERT(after.thread_blocks == 0 && after.shared_blocks == 0, "Disabled cache should hold nothing");
+
+  pool_cache_set_limits(POOL_CACHE_THREAD_BLOCKS, POOL_CACHE_SHARED_BLOCKS);
+}
+
+void test_pool_config() {
+  printf("\n=== Testing pool block sizing ===\n");
+
+  pool_config_t config = { .first_block_size = 8192, .max_block_size = 32768 };
+  mem_pool_t *pool = pool_create_with_config(&config);
+  TEST_ASSERT(pool->head->size == 8192, "First block should use the configured size");
+  TEST_ASSERT(pool_bytes_allocated(pool) == 8192, "Allocated bytes should match the first block");
+
+  // Fill block after block: sizes double up to the cap
+  size_t sizes[5];
+  for (int i = 0; i < 5; i++) {
+    pool_alloc(pool, pool->current->size - pool->current->used);
+    pool_alloc(pool, 8);
+    sizes[i] = pool->current->size;
+  }
+  TEST_ASSERT(sizes[0] == 16384 && sizes[1] == 32768, "Blocks should grow geometrically");
+  TEST_ASSERT(sizes[2] == 32768 && sizes[4] == 32768, "Growth should stop at the maximum block size");
+
+  void *big = pool_alloc(pool, 100000);
+  TEST_ASSERT(big && pool->current->size >= 100000, "Oversized request should get its own block");
+  pool_destroy(pool);
+
+  pool_config_t small = pool_config_for_input(200);
+  TEST_ASSERT(small.first_block_size == POOL_MIN_BLOCK_SIZE, "Tiny inputs should get the minimum block");
+  pool_config_t medium = pool_config_for_input(300000);
+  TEST_ASSERT(medium.first_block_size >= 300000 * POOL_INPUT_FOOTPRINT &&
+              (medium.first_block_size & (medium.first_block_size - 1)) == 0,
+              "Hint should cover the expected footprint with a power of two");
+  pool_config_t huge = pool_config_for_input((size_t)2 << 30);
+  TEST_ASSERT(huge.first_block_size == POOL_MAX_BLOCK_SIZE, "Huge inputs should be capped");
+
+  pool_config_t defaults = {0};
+  pool = pool_create_with_config(&defaults);
+  TEST_ASSERT(pool->head->size == POOL_BLOCK_SIZE, "Zero config should use the default block size");
+  pool_destroy(pool);
+
+  // Parser sizes its pool from the input unless told otherwise
+  lexer_t lexer = lexer_init("{\"id\": 1, \"tags\": [\"a\", \"b\"]}");
+  parser_t parser = parser_init(&lexer);
+  TEST_ASSERT(pool_bytes_allocated(parser.pool) == POOL_MIN_BLOCK_SIZE, "Small message should get a small pool");
+  parser.current_token = next_token(&lexer);
+  parse(&parser);
+  TEST_ASSERT(!parser.has_error && parser.pool->block_count == 1, "Small message should fit its first block");
+  parser_free(&parser);
+
+  pool_config_t fixed = pool_config_default();
+  parser = parser_init_ex(&lexer, &fixed);
+  TEST_ASSERT(pool_bytes_allocated(parser.pool) == POOL_BLOCK_SIZE, "Explicit config should override the hint");
+  parser_free(&parser);
+  lexer_free(&lexer);
+}
+
+// Resident pages of [addr, addr + len)
+static size_t resident_pages(void *addr, size_t len) {
+  size_t page = (size_t)sysconf(_SC_PAGESIZE);
+  uintptr_t start = (uintptr_t)addr & ~(uintptr_t)(page - 1);
+  size_t pages = ((uintptr_t)addr + len - start + page - 1) / page;
+  unsigned char *vec = malloc(pages);
+  size_t resident = 0;
+  if (mincore((void *)start, pages * page, vec) == 0) {
+    for (size_t i = 0; i < pages; i++) resident += vec[i] & 1;
+  }
+  free(vec);
+  return resident;
+}
+
+void test_pool_mapped_blocks() {
+  printf("\n=== Testing mmap-backed pool blocks ===\n");
+
+  size_t page = (size_t)sysconf(_SC_PAGESIZE);
+  pool_config_t config = { .first_block_size = 4 * 1024 * 1024, .flags = POOL_MMAP };
+  mem_pool_t *pool = pool_create_with_config(&config);
+  TEST_ASSERT(pool->head->map_size != 0, "Large block should be mapped");
+  TEST_ASSERT(pool->head->size >= config.first_block_size, "Mapped block should hold the requested size");
+  TEST_ASSERT(resident_pages(pool->head->data, pool->head->size) < 16, "Mapped block should start unpopulated");
+  pool_destroy(pool);
+
+  config.flags = POOL_MMAP | POOL_PREFAULT;
+  pool = pool_create_with_config(&config);
+  size_t size = pool->head->size;
+  TEST_ASSERT(resident_pages(pool->head->data, size) >= size / page,
+              "Prefaulted block should be resident");
+  pool_destroy(pool);
+
+  config.flags = POOL_HUGEPAGES;
+  pool = pool_create_with_config(&config);
+  TEST_ASSERT(pool->head->map_size != 0 && ((uintptr_t)pool->head & (POOL_HUGE_PAGE_SIZE - 1)) == 0,
+              "Huge-page block should be huge-page aligned");
+  memset(pool_alloc(pool, 3 * 1024 * 1024), 1, 3 * 1024 * 1024);
+  pool_destroy(pool);
+
+  // Requesting hugetlbfs pages falls back when none are reserved
+  config.flags = POOL_HUGETLB;
+  pool = pool_create_with_config(&config);
+  TEST_ASSERT(pool != NULL && pool->head->map_size != 0, "HugeTLB request should always yield a block");
+  pool_destroy(pool);
+
+  config.first_block_size = 64 * 1024;
+  config.flags = POOL_MMAP;
+  pool = pool_create_with_config(&config);
+  TEST_ASSERT(pool->head->map_size == 0, "Small blocks should stay on malloc");
+  pool_destroy(pool);
+}
+
+void test_pool_reset_trim() {
+  printf("\n=== Testing pool reset ===\n");
+
+  // Reset reuses existing blocks instead of chaining new ones
+  pool_config_t config = { .first_block_size = 8192, .max_block_size = 8192 };
+  mem_pool_t *pool = pool_create_with_config(&config);
+  for (int i = 0; i < 4; i++) pool_alloc(pool, 8000);
+  size_t blocks = pool->block_count;
+  size_t allocated = pool_bytes_allocated(pool);
+  pool_reset(pool);
+  TEST_ASSERT(pool_bytes_used(pool) == 0 && pool->current == pool->head, "Reset should rewind to the head");
+  for (int i = 0; i < 4; i++) pool_alloc(pool, 8000);
+  TEST_ASSERT(pool->block_count == blocks && pool_bytes_allocated(pool) == allocated,
+              "Refill after reset should reuse kept blocks");
+  pool_destroy(pool);
+
+  size_t retain = 1024 * 1024;
+  config = (pool_config_t){
+    .first_block_size = 4 * 1024 * 1024,
+    .flags = POOL_MMAP | POOL_TRIM_ON_RESET,
+    .retain_bytes = retain,
+  };
+  pool = pool_create_with_config(&config);
+  size_t size = pool->head->size;
+  memset(pool_alloc(pool, size), 0xAB, size);
+  pool_reset(pool);
+
+  size_t page = (size_t)sysconf(_SC_PAGESIZE);
+  char *data = pool->head->data;
+  TEST_ASSERT(resident_pages(data, retain) >= retain / page, "Pages under the high-water mark should stay resident");
+  TEST_ASSERT(resident_pages(data + retain + page, size - retain - page) == 0,
+              "Pages past the high-water mark should be released");
+  char *again = pool_alloc(pool, size);
+  TEST_ASSERT(again == data && again[retain - 1] == (char)0xAB && again[size - 1] == 0,
+              "Released pages should read back as zero");
+  pool_destroy(pool);
+}
+
+void test_pool_mark_rollback() {
+  printf("\n=== Testing pool mark and rollback ===\n");
+
+  pool_config_t config = { .first_block_size = 4096, .max_block_size = 4096 };
+  mem_pool_t *pool = pool_create_with_config(&config);
+  char *keep = pool_alloc(pool, 100);
+  memset(keep, 'k', 100);
+
+  pool_mark_t mark = pool_mark(pool);
+  size_t used = pool_bytes_used(pool);
+  char *first = pool_alloc(pool, 64);
+  pool_rollback(pool, mark);
+  TEST_ASSERT(pool_bytes_used(pool) == used, "Rollback should restore used bytes");
+  TEST_ASSERT(pool_alloc(pool, 64) == first, "Allocation after rollback should reuse the space");
+  pool_rollback(pool, mark);
+
+  // Spill over several blocks, then rewind across them
+  for (int i = 0; i < 10; i++) pool_alloc(pool, 3000);
+  size_t blocks = pool->block_count;
+  TEST_ASSERT(blocks > 5, "Allocations should span several blocks");
+  pool_rollback(pool, mark);
+  TEST_ASSERT(pool->current == mark.block && pool_bytes_used(pool) == used,
+              "Rollback should rewind across blocks");
+  TEST_ASSERT(keep[0] == 'k' && keep[99] == 'k', "Data before the mark should be untouched");
+
+  for (int i = 0; i < 10; i++) pool_alloc(pool, 3000);
+  TEST_ASSERT(pool->block_count == blocks, "Blocks freed by rollback should be reused");
+
+  // Nested marks
+  pool_rollback(pool, mark);
+  pool_alloc(pool, 500);
+  pool_mark_t inner = pool_mark(pool);
+  size_t inner_used = pool_bytes_used(pool);
+  pool_alloc(pool, 4000);
+  pool_rollback(pool, inner);
+  TEST_ASSERT(pool_bytes_used(pool) == inner_used, "Inner rollback should keep outer allocations");
+  pool_rollback(pool, mark);
+  TEST_ASSERT(pool_bytes_used(pool) == used, "Outer rollback should undo everything since its mark");
+  pool_destroy(pool);
+
+  // One pool reused across a stream of documents keeps a bounded footprint
+  const char *doc = "{\"id\": 42, \"tags\": [\"a\", \"b\", \"c\"], \"meta\": {\"ok\": true}}";
+  pool = pool_create();
+  pool_mark_t start = pool_mark(pool);
+  size_t peak = 0;
+  int errors = 0;
+  for (int i = 0; i < 1000; i++) {
+    lexer_t lexer = lexer_init(doc);
+    parser_t parser = parser_init(&lexer);
+    pool_destroy(parser.pool);
+    parser.pool = pool;
+    parser.owns_pool = false;
+    parser.current_token = next_token(&lexer);
+    json_value_t value = parse(&parser);
+    if (parser.has_error || json_object_size(&value) != 3) errors++;
+    if (pool_bytes_used(pool) > peak) peak = pool_bytes_used(pool);
+    parser_free(&parser);
+    lexer_free(&lexer);
+    pool_rollback(pool, start);
+  }
+  TEST_ASSERT(errors == 0, "Every streamed document should parse");
+  TEST_ASSERT(peak < 4096 && pool->block_count == 1, "Stream footprint should stay bounded");
+  pool_destroy(pool);
+}
+
+void test_pool_accounting() {
+  printf("\n=== Testing pool accounting ===\n");
+
+  pool_usage_t usage;
+  mem_pool_t *plain = pool_create();
+  TEST_ASSERT(!pool_usage(plain, &usage), "Accounting should be off by default");
+  pool_destroy(plain);
+
+  const char *doc = "{\"name\": \"abcdef\", \"list\": [1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, "
+                    "13, 14, 15, 16, 17, 18, 19, 20], \"nested\": {\"a\": \"x\"}, "
+                    "\"description\": \"a longer string value\"}";
+  pool_config_t config = pool_config_for_input(strlen(doc));
+  config.flags |= POOL_ACCOUNTING;
+  lexer_t lexer = lexer_init(doc);
+  parser_t parser = parser_init_ex(&lexer, &config);
+  parser.current_token = next_token(&lexer);
+  json_value_t value = parse(&parser);
+  TEST_ASSERT(!parser.has_error && json_object_size(&value) == 4, "Document should parse");
+
+  TEST_ASSERT(pool_usage(parser.pool, &usage), "Accounting pool should report usage");
+  // Only the long string and key need pool storage
+  TEST_ASSERT(usage.live[POOL_CAT_STRING] == 24, "String values should be counted");
+  TEST_ASSERT(usage.live[POOL_CAT_KEY] == 16, "Copied keys should be counted");
+  TEST_ASSERT(usage.live[POOL_CAT_HASH] > 0, "Hash slots should be counted");
+  TEST_ASSERT(usage.live[POOL_CAT_ARRAY] >= 20 * sizeof(json_value_t), "Array storage should be counted");
+  TEST_ASSERT(usage.abandoned[POOL_CAT_ARRAY] > 0, "Array growth should leave abandoned bytes");
+
+  size_t total = usage.padding + usage.unused;
+  for (int i = 0; i < POOL_CAT_COUNT; i++) {
+    total += usage.live[i] + usage.abandoned[i];
+  }
+  TEST_ASSERT(total - usage.recycled == pool_bytes_allocated(parser.pool),
+              "Categories should add up to the pool size");
+  TEST_ASSERT(usage.live[POOL_CAT_OTHER] == 0, "Parser allocations should all be tagged");
+
+  pool_reset(parser.pool);
+  pool_usage(parser.pool, &usage);
+  TEST_ASSERT(usage.live[POOL_CAT_STRING] == 0 && usage.abandoned[POOL_CAT_ARRAY] == 0,
+              "Reset should clear the counters");
+
+  parser_free(&parser);
+  lexer_free(&lexer);
+}
+
+void test_pool_static() {
+  printf("\n=== Testing static pools ===\n");
+
+  static char buffer[65536];
+  TEST_ASSERT(pool_create_static(buffer, 16) == NULL, "A buffer smaller than the header should be refused");
+
+  mem_pool_t *pool = pool_create_static(buffer + 1, sizeof(buffer) - 1);
+  TEST_ASSERT(pool != NULL, "Static pool should be created in an unaligned buffer");
+  TEST_ASSERT((char *)pool >= buffer && (char *)pool < buffer + sizeof(buffer),
+              "Pool header should live in the buffer");
+  size_t capacity = pool_bytes_allocated(pool);
+  char *p = pool_alloc(pool, 100);
+  TEST_ASSERT(p > (char *)pool && p + 100 <= buffer + sizeof(buffer), "Allocations should come from the buffer");
+  TEST_ASSERT(pool_alloc(pool, capacity) == NULL, "Allocations past the buffer should fail");
+  TEST_ASSERT(pool->block_count == 1, "A static pool should never grow");
+  pool_reset(pool);
+  TEST_ASSERT(pool_alloc(pool, capacity) != NULL, "The whole buffer should be usable after a reset");
+  pool_destroy(pool);
+
+  // Parse a document without touching the heap
+  char doc[4096];
+  int n = snprintf(doc, sizeof(doc), "{\"items\": [");
+  for (int i = 0; i < 40; i++) {
+    n += snprintf(doc + n, sizeof(doc) - n, "%s{\"id\": %d, \"name\": \"item\"}", i ? ", " : "", i);
+  }
+  n += snprintf(doc + n, sizeof(doc) - n, "], \"long\": 1234567890.12345678901234567890123456789, "
+                                          "\"longer\": 12345678901234567890123456789012345678901234567890123456789012345678.9, \"k0\": 0");
+  for (int i = 1; i < 20; i++) {
+    n += snprintf(doc + n, sizeof(doc) - n, ", \"k%d\": %d", i, i);
+  }
+  snprintf(doc + n, sizeof(doc) - n, "}");
+
+  struct mallinfo2 before = mallinfo2();
+  pool = pool_create_static(buffer, sizeof(buffer));
+  lexer_t lexer = lexer_init_view(doc, strlen(doc));
+  parser_t parser = parser_init_with_pool(&lexer, pool);
+  parser.current_token = next_token(&lexer);
+  json_value_t value = parse(&parser);
+  bool ok = !parser.has_error;
+  json_value_t items = json_object_get(&value, "items");
+  json_value_t last = json_object_get(&value, "k19");
+  json_value_t longer = json_object_get(&value, "longer");
+  parser_free(&parser);
+  lexer_free(&lexer);
+  struct mallinfo2 after = mallinfo2();
+
+  TEST_ASSERT(ok && json_object_size(&value) == 23, "Document should parse into the static pool");
+  TEST_ASSERT(items.type == JSON_ARRAY && items.array->len == 40, "Nested array should be complete");
+  TEST_ASSERT(last.type == JSON_NUMBER && last.number == 19, "Objects wider than the member stack should parse");
+  TEST_ASSERT(longer.type == JSON_NUMBER && longer.number > 1.2e67 && longer.number < 1.3e67,
+              "Numbers too long for the stack should be read from the pool");
+  TEST_ASSERT(after.uordblks == before.uordblks, "Parsing should not allocate from the heap");
+  TEST_ASSERT(lexer.start == doc, "The lexer should read the caller's buffer in place");
+
+  // A buffer that is too small fails the parse cleanly
+  static char tiny[512];
+  pool = pool_create_static(tiny, sizeof(tiny));
+  lexer = lexer_init_view(doc, strlen(doc));
+  parser = parser_init_with_pool(&lexer, pool);
+  parser.current_token = next_token(&lexer);
+  parse(&parser);
+  TEST_ASSERT(parser.has_error && strstr(parser.error_message, "Out of memory") != NULL,
+              "Running out of room should be a parse error");
+  parser_free(&parser);
+  lexer_free(&lexer);
+}
+
+void test_pool_free_lists() {
+  printf("\n=== Testing pool free lists ===\n");
+
+  mem_pool_t *pool = pool_create();
+  char *a = pool_alloc(pool, 24);
+  char *b = pool_alloc(pool, 64);
+  pool_free(pool, a, 24);
+  pool_free(pool, b, 64);
+  TEST_ASSERT(pool_bytes_free(pool) == 16 + 64, "A chunk should be filed under the largest class it holds");
+
+  TEST_ASSERT(pool_alloc_reuse(pool, 40, POOL_ALIGNMENT) == b, "A request should take a chunk that fits");
+  TEST_ASSERT(pool_alloc_reuse(pool, 12, POOL_ALIGNMENT) == a, "A partly used chunk should serve its class");
+  size_t used = pool_bytes_used(pool);
+  char *c = pool_alloc_reuse(pool, 16, POOL_ALIGNMENT);
+  TEST_ASSERT(c != a && c != b && pool_bytes_used(pool) > used, "An empty class should fall back to the bump pointer");
+
+  // Large chunks all share the last class and keep their size
+  char *big = pool_alloc(pool, 100000);
+  pool_free(pool, big, 100000);
+  TEST_ASSERT(pool_alloc_reuse(pool, 200000, POOL_ALIGNMENT) != big, "A large chunk that is too small should be skipped");
+  TEST_ASSERT(pool_alloc_reuse(pool, 50000, POOL_ALIGNMENT) == big, "A large chunk should serve a smaller large request");
+
+  // Misaligned chunks are not handed out for aligned requests
+  char *odd = pool_alloc(pool, 8);
+  if (((uintptr_t)odd & 63) == 0) odd = pool_alloc(pool, 8);
+  char *pad = pool_alloc(pool, 64);
+  (void)pad;
+  pool_free(pool, odd, 64);
+  TEST_ASSERT(pool_alloc_reuse(pool, 64, 64) != odd, "Chunk alignment should be respected");
+
+  pool_reset(pool);
+  TEST_ASSERT(pool_bytes_free(pool) == 0, "Reset should empty the free lists");
+  pool_destroy(pool);
+}
+
+void test_pooled_dom_mutation() {
+  printf("\n=== Testing edits to a pooled document ===\n");
+
+  const char *doc = "{\"name\": \"store\", \"tags\": [\"a\", \"b\"], \"settings\": {\"x\": 1}}";
+  lexer_t lexer = lexer_init(doc);
+  parser_t parser = parser_init(&lexer);
+  parser.current_token = next_token(&lexer);
+  json_value_t root = parse(&parser);
+  mem_pool_t *pool = parser.pool;
+  TEST_ASSERT(!parser.has_error, "Document should parse");
+
+  json_value_t *tags = hash_table_get(root.object, "tags", 4);
+  json_value_t *settings = hash_table_get(root.object, "settings", 8);
+  char key[32];
+  char text[64];
+  size_t used_after_warmup = 0;
+  int errors = 0;
+  for (int round = 0; round < 1000; round++) {
+    // Replace a string value: too long to store inline, and with its
+    // terminator exactly one free-list class, so each copy reuses the last
+    snprintf(text, sizeof(text), "replacement %03d", round);
+    json_value_t str = json_value_string_n(text, strlen(text), pool);
+    if (str.type != JSON_STRING || json_object_set_pooled(&root, "name", str, pool) != 0) errors++;
+
+    // Grow and shrink an array
+    for (int i = 0; i < 20; i++) {
+      if (json_array_push_pooled(tags, json_value_number(i), pool) != 0) errors++;
+    }
+    for (int i = 0; i < 20; i++) {
+      if (json_array_pop_pooled(tags, pool) != 0) errors++;
+    }
+
+    // Churn keys through a nested object, growing its table
+    for (int i = 0; i < 20; i++) {
+      snprintf(key, sizeof(key), "key-%d-%d", round, i);
+      if (json_object_set_pooled(settings, key, json_value_number(i), pool) != 0) errors++;
+    }
+    for (int i = 0; i < 20; i++) {
+      snprintf(key, sizeof(key), "key-%d-%d", round, i);
+      if (json_object_delete_pooled(settings, key, pool) != 0) errors++;
+    }
+
+    if (round == 100) used_after_warmup = pool_bytes_used(pool);
+  }
+
+  TEST_ASSERT(errors == 0, "Every edit should succeed");
+  json_value_t name = json_object_get(&root, "name");
+  TEST_ASSERT(strcmp(json_get_string(&name), "replacement 999") == 0, "Last replacement should win");
+  TEST_ASSERT(tags->array->len == 2 && strcmp(json_get_string(&tags->array->items[1]), "b") == 0,
+              "Array should be back to its parsed contents");
+  TEST_ASSERT(json_object_size(settings) == 1, "Deleted keys should be gone");
+  TEST_ASSERT(pool_bytes_used(pool) == used_after_warmup, "Edits should reuse pool memory instead of growing");
+
+  // The heap API must not realloc or copy into pool storage
+  size_t cap = tags->array->cap;
+  int pushed = 0;
+  while (json_array_push(tags, json_value_number(pushed)) == 0) pushed++;
+  TEST_ASSERT(tags->array->len == cap && pushed == (int)cap - 2,
+              "Heap push should fill a pooled array's spare room, then fail");
+  TEST_ASSERT(json_array_push_pooled(tags, json_value_number(0), pool) == 0 && tags->array->cap > cap,
+              "The pooled push should still grow it");
+  TEST_ASSERT(json_object_set(settings, strdup("a_key_too_long_to_inline"), json_value_number(1)) == -1 &&
+              !json_object_has(settings, "a_key_too_long_to_inline"),
+              "Heap set should report a member it cannot store in a pooled table");
+
+  // Freeing pooled values must not hand pool memory to free()
+  json_value_free(&root);
+  parser_free(&parser);
+  lexer_free(&lexer);
+}
+
+typedef struct {
+  int parsed;
+  size_t allocated_after_warmup;
+  size_t allocated_at_end;
+  size_t misses_before;
+} thread_pool_worker_t;
+
+static void *thread_pool_worker(void *arg) {
+  thread_pool_worker_t *worker = arg;
+  pool_thread_attach(NULL);
+  const char *doc = "{\"id\": 7, \"tags\": [\"a\", \"b\"], \"nested\": {\"x\": 1.5}}";
+  for (int i = 0; i < 500; i++) {
+    lexer_t lexer = lexer_init_view(doc, strlen(doc));
+    parser_t parser = parser_init(&lexer);
+    parser.current_token = next_token(&lexer);
+    json_value_t value = parse(&parser);
+    if (!parser.has_error && json_object_get(&value, "id").number == 7) worker->parsed++;
+    parser_free(&parser);
+    lexer_free(&lexer);
+    if (i == 10) worker->allocated_after_warmup = pool_bytes_allocated(pool_thread_current());
+  }
+  worker->allocated_at_end = pool_bytes_allocated(pool_thread_current());
+  // Exits attached; the exit hook destroys the pool
+  return NULL;
+}
+
+void test_pool_thread_attach() {
+  printf("\n=== Testing thread pools ===\n");
+
+  const char *doc = "{\"a\": [1, 2, 3], \"b\": \"text\"}";
+  lexer_t lexer1 = lexer_init(doc);
+  parser_t parser1 = parser_init(&lexer1);
+  TEST_ASSERT(parser1.owns_pool && !parser1.thread_pool, "Without a thread pool the parser owns its pool");
+  parser_free(&parser1);
+  lexer_free(&lexer1);
+
+  mem_pool_t *pool = pool_thread_attach(NULL);
+  TEST_ASSERT(pool != NULL && pool_thread_current() == pool, "Attach should give the thread a pool");
+  TEST_ASSERT(pool_thread_attach(NULL) == pool, "Attaching twice should keep the same pool");
+
+  lexer1 = lexer_init(doc);
+  lexer_t lexer2 = lexer_init(doc);
+  parser1 = parser_init(&lexer1);
+  parser_t parser2 = parser_init(&lexer2);
+  TEST_ASSERT(parser1.pool == pool && parser2.pool == pool && !parser1.owns_pool,
+              "Parsers should borrow the thread pool");
+  parser1.current_token = next_token(&lexer1);
+  parser2.current_token = next_token(&lexer2);
+  json_value_t v1 = parse(&parser1);
+  json_value_t v2 = parse(&parser2);
+  TEST_ASSERT(!parser1.has_error && !parser2.has_error, "Documents should parse in the thread pool");
+  TEST_ASSERT(!pool_thread_detach(), "Detach should fail while parsers borrow the pool");
+
+  parser_free(&parser1);
+  lexer_free(&lexer1);
+  json_value_t b = json_object_get(&v2, "b");
+  TEST_ASSERT(pool_bytes_used(pool) > 0 && b.type == JSON_STRING && strcmp(json_get_string(&b), "text") == 0,
+              "Other documents should survive one parser being freed");
+  (void)v1;
+  parser_free(&parser2);
+  lexer_free(&lexer2);
+  TEST_ASSERT(pool_bytes_used(pool) == 0, "Last release should reset the pool");
+
+  // Explicit config still gets a private pool
+  lexer1 = lexer_init(doc);
+  pool_config_t config = pool_config_default();
+  parser1 = parser_init_ex(&lexer1, &config);
+  TEST_ASSERT(parser1.owns_pool && parser1.pool != pool, "Explicit config should bypass the thread pool");
+  parser_free(&parser1);
+  lexer_free(&lexer1);
+
+  TEST_ASSERT(pool_thread_detach() && pool_thread_current() == NULL, "Detach should drop the pool");
+
+  // Workers parse a stream of documents in their own pools
+  pool_cache_stats_t before, after;
+  pool_cache_stats(&before);
+  thread_pool_worker_t workers[4] = {0};
+  pthread_t threads[4];
+  for (int t = 0; t < 4; t++) {
+    pthread_create(&threads[t], NULL, thread_pool_worker, &workers[t]);
+  }
+  int parsed = 0, stable = 0;
+  for (int t = 0; t < 4; t++) {
+    pthread_join(threads[t], NULL);
+    parsed += workers[t].parsed;
+    stable += workers[t].allocated_at_end == workers[t].allocated_after_warmup;
+  }
+  pool_cache_stats(&after);
+  TEST_ASSERT(parsed == 4 * 500, "Every worker document should parse");
+  TEST_ASSERT(stable == 4, "Thread pools should not grow across documents");
+  TEST_ASSERT(after.misses - before.misses <= 4, "Each worker should allocate at most one block");
+  TEST_ASSERT(after.released - before.released == 4, "Exited threads should release their pools and be counted");
+}
+
+TEST_MAIN("Memory Pool",
+  test_pool_alloc_aligned();
+  test_container_alignment();
+  test_pool_block_cache();
+  test_pool_config();
+  test_pool_mapped_blocks();
+  test_pool_reset_trim();
+  test_pool_mark_rollback();
+  test_pool_accounting();
+  test_pool_static();
+  test_pool_free_lists();
+  test_pooled_dom_mutation();
+  test_pool_thread_attach();
+)
@@ -0,0 +1,242 @@
+#include "../include/minify.h"
+#include "../include/serializer.h"
+#include "../include/parser.h"
+#include "test_framework.h"
+
+#include <string.h>
+
+TEST_SUITE_INIT()
+
+static char *read_file(const char *path, size_t *len) {
+  FILE *file = fopen(path, "rb");
+  if (!file) return NULL;
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  char *data = malloc(size + 1);
+  *len = fread(data, 1, size, file);
+  data[*len] = '\0';
+  fclose(file);
+  return data;
+}
+
+// Byte-at-a-time model of the minifier
+static size_t reference_minify(const char *in, size_t len, char *out) {
+  bool in_string = false, escaped = false;
+  size_t o = 0;
+  for (size_t i = 0; i < len; i++) {
+    char ch = in[i];
+    bool space = ch == ' ' || ch == '\n' || ch == '\t' || ch == '\r';
+    if (in_string || !space) out[o++] = ch;
+    if (escaped) {
+      escaped = false;
+    } else if (ch == '\\') {
+      escaped = true;
+    } else if (ch == '"') {
+      in_string = !in_string;
+    }
+  }
+  return o;
+}
+
+static bool minifies_to(const char *in, const char *expected) {
+  size_t len = strlen(in);
+  char *out = malloc(len + 1);
+  size_t out_len = json_minify(in, len, out);
+  out[out_len] = '\0';
+  bool same = strcmp(out, expected) == 0;
+  if (!same) printf("  got: %s\n", out);
+  free(out);
+  return same;
+}
+
+// Sink collecting writer output
+typedef struct {
+  char *data;
+  size_t len;
+} sink_t;
+
+static bool sink_write(void *ctx, const struct iovec *iov, int iovcnt) {
+  sink_t *sink = ctx;
+  for (int i = 0; i < iovcnt; i++) {
+    sink->data = realloc(sink->data, sink->len + iov[i].iov_len + 1);
+    memcpy(sink->data + sink->len, iov[i].iov_base, iov[i].iov_len);
+    sink->len += iov[i].iov_len;
+    sink->data[sink->len] = '\0';
+  }
+  return true;
+}
+
+// Reformat text with the given indent; NULL on error
+static char *reformat(const char *text, int indent) {
+  sink_t sink = {0};
+  json_writer_config_t config = {.indent = indent, .chunk_size = 128};
+  json_writer_t w = json_writer_init_fn(sink_write, &sink, &config);
+  bool ok = json_reformat(text, strlen(text), &w) && json_writer_finish(&w);
+  json_writer_free(&w);
+  if (!ok) {
+    free(sink.data);
+    return NULL;
+  }
+  return sink.data;
+}
+
+void test_minify_basic() {
+  printf("\n=== Testing minify ===\n");
+
+  TEST_ASSERT(minifies_to("{ \"a\" : [ 1 ,\n\t2 ]\r\n}", "{\"a\":[1,2]}"), "Whitespace between tokens should go");
+  TEST_ASSERT(minifies_to("[\"a b\\t\", \" \\\" x \"]", "[\"a b\\t\",\" \\\" x \"]"),
+              "Whitespace in strings and escaped quotes should stay");
+  TEST_ASSERT(minifies_to("[\"\\\\\" , \"\\\\\\\\\" , 1]", "[\"\\\\\",\"\\\\\\\\\",1]"),
+              "Even backslash runs should not escape the quote");
+  TEST_ASSERT(minifies_to("", ""), "Empty input");
+  TEST_ASSERT(minifies_to("   \n  ", ""), "Whitespace only");
+
+  // Long enough for whole blocks, with strings crossing block boundaries
+  char text[512], expected[512];
+  size_t t = 0, e = 0;
+  for (int i = 0; i < 12; i++) {
+    const char *piece = i % 3 == 0 ? "  \"key \\\" with  spaces\"  :\n    " :
+                        i % 3 == 1 ? "[ 1 , 2 ,\t\"\\\\\" ]" : "\r\n\"long string value with words\" ,  ";
+    size_t len = strlen(piece);
+    memcpy(text + t, piece, len);
+    t += len;
+  }
+  text[t] = '\0';
+  e = reference_minify(text, t, expected);
+  expected[e] = '\0';
+  TEST_ASSERT(minifies_to(text, expected), "Multi-block text should match the byte-at-a-time model");
+}
+
+void test_minify_random() {
+  printf("\n=== Testing minify against the byte model ===\n");
+
+  // Random text over the bytes that matter, in every alignment
+  const char alphabet[] = "  \n\t\r\"\"\\\\ab{}[],:1";
+  uint64_t state = 0x2545F4914F6CDD1DULL;
+  char in[700], out[700], expected[700];
+  int mismatches = 0, in_place = 0;
+  for (int round = 0; round < 20000; round++) {
+    size_t len = 1 + round % 690;
+    for (size_t i = 0; i < len; i++) {
+      state ^= state << 13;
+      state ^= state >> 7;
+      state ^= state << 17;
+      in[i] = alphabet[state % (sizeof(alphabet) - 1)];
+    }
+    size_t expected_len = reference_minify(in, len, expected);
+    size_t out_len = json_minify(in, len, out);
+    mismatches += out_len != expected_len || memcmp(out, expected, out_len) != 0;
+
+    out_len = json_minify(in, len, in);
+    in_place += out_len != expected_len || memcmp(in, expected, out_len) != 0;
+  }
+  TEST_ASSERT(mismatches == 0, "Random text should minify like the byte model");
+  TEST_ASSERT(in_place == 0, "Minifying in place should give the same result");
+}
+
+void test_minify_files() {
+  printf("\n=== Testing minify over sample files ===\n");
+
+  const char *files[] = {
+    "benchmarks/data/config.json", "benchmarks/data/unicode.json", "benchmarks/data/geojson.json",
+    "benchmarks/data/long_strings.json", "samples/nested.json",
+  };
+  for (size_t f = 0; f < sizeof(files) / sizeof(files[0]); f++) {
+    size_t len;
+    char *text = read_file(files[f], &len);
+    if (!text) {
+      printf("  skipping %s\n", files[f]);
+      continue;
+    }
+    char *out = malloc(len + 1);
+    size_t out_len = json_minify(text, len, out);
+    out[out_len] = '\0';
+
+    // The parse -> serialize path gives the same text when member order
+    // is kept; compare the documents instead
+    lexer_t a = lexer_init(text), b = lexer_init(out);
+    parser_t pa = parser_init(&a), pb = parser_init(&b);
+    pa.current_token = next_token(&a);
+    pb.current_token = next_token(&b);
+    json_value_t va = parse(&pa), vb = parse(&pb);
+    char *sa = json_serialize(&va, NULL), *sb = json_serialize(&vb, NULL);
+    char message[128];
+    snprintf(message, sizeof(message), "%s should minify to the same document", files[f]);
+    TEST_ASSERT(!pb.has_error && sa && sb && strcmp(sa, sb) == 0, message);
+
+    char *compact = reformat(text, 0);
+    snprintf(message, sizeof(message), "%s: compact reformat should equal minify", files[f]);
+    TEST_ASSERT(compact && strcmp(compact, out) == 0, message);
+    char *pretty = reformat(text, 2);
+    char *again = pretty ? malloc(strlen(pretty) + 1) : NULL;
+    size_t again_len = again ? json_minify(pretty, strlen(pretty), again) : 0;
+    snprintf(message, sizeof(message), "%s: pretty reformat should minify back", files[f]);
+    TEST_ASSERT(again && again_len == out_len && memcmp(again, out, out_len) == 0, message);
+
+    free(again);
+    free(pretty);
+    free(compact);
+    free(sa);
+    free(sb);
+    parser_free(&pa);
+    parser_free(&pb);
+    lexer_free(&a);
+    lexer_free(&b);
+    free(out);
+    free(text);
+  }
+}
+
+void test_reformat() {
+  printf("\n=== Testing reformat ===\n");
+
+  char *pretty = reformat("{\"a\":[1,2.50,{}],\"b\":{\"c\":\"x\\ny\"},\"d\":[]}", 2);
+  TEST_ASSERT(pretty && strcmp(pretty,
+                               "{\n"
+                               "  \"a\": [\n"
+                               "    1,\n"
+                               "    2.50,\n"
+                               "    {}\n"
+                               "  ],\n"
+                               "  \"b\": {\n"
+                               "    \"c\": \"x\\ny\"\n"
+                               "  },\n"
+                               "  \"d\": []\n"
+                               "}") == 0,
+              "Pretty output should keep number and string text");
+  free(pretty);
+
+  char *scalar = reformat("  -1.5e+10  ", 2);
+  TEST_ASSERT(scalar && strcmp(scalar, "-1.5e+10") == 0, "Scalar document");
+  free(scalar);
+
+  const char *invalid[] = {
+    "", "[1,]", "[1 2]", "{\"a\" 1}", "{\"a\":1,}", "{1:2}", "[}", "{]", "[1]]", "[1] 2",
+    "{\"a\":}", "[,1]", "{,}", "tru", "[\"open", "{\"a\"}", ":", "[[]",
+  };
+  int accepted = 0;
+  for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+    char *out = reformat(invalid[i], 0);
+    if (out) {
+      printf("  accepted: %s\n", invalid[i]);
+      accepted++;
+    }
+    free(out);
+  }
+  TEST_ASSERT(accepted == 0, "Invalid documents should be rejected");
+
+  sink_t sink = {0};
+  json_writer_t w = json_writer_init_fn(sink_write, &sink, NULL);
+  TEST_ASSERT(!json_reformat("[1,,2]", 6, &w) && strstr(w.error_message, "column 4"),
+              "Error should give the position");
+  json_writer_free(&w);
+  free(sink.data);
+}
+
+TEST_MAIN("Minify",
+  test_minify_basic();
+  test_minify_random();
+  test_minify_files();
+  test_reformat();
+)
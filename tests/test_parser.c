@@ -15,10 +15,22 @@ void test_parse_string() {
 
   json_value_t value = parse_string(&parser);
   TEST_ASSERT(value.type == JSON_STRING, "Should parse string type");
-  TEST_ASSERT(strcmp(value.string, "hello") == 0, "String value should be correct");
+  TEST_ASSERT(strcmp(json_get_string(&value), "hello") == 0, "String value should be correct");
   TEST_ASSERT(!parser.has_error, "Should not have error");
 
   json_value_free(&value);
+  parser_free(&parser);
+  lexer_free(&lexer);
+
+  // Test 2: A string too long for the 32-bit length, refused unread
+  lexer = lexer_init("\"x\"");
+  parser = parser_init(&lexer);
+  parser.current_token = next_token(&lexer);
+  parser.current_token.lexeme.length = (size_t)JSON_STRING_LEN_MAX + 1;
+  value = parse_string(&parser);
+  TEST_ASSERT(value.type == JSON_NULL && parser.has_error && strstr(parser.error_message, "String too long"),
+              "Oversized string should be a parse error");
+  parser_free(&parser);
   lexer_free(&lexer);
 }
 
@@ -210,7 +222,7 @@ void test_parse_simple_values() {
 
   json_value_t value = parse_value(&parser);
   TEST_ASSERT(value.type == JSON_STRING, "parse_value should parse string");
-  TEST_ASSERT(strcmp(value.string, "hello") == 0, "String value should be correct");
+  TEST_ASSERT(strcmp(json_get_string(&value), "hello") == 0, "String value should be correct");
   TEST_ASSERT(!parser.has_error, "Should not have error");
 
   json_value_free(&value);
@@ -269,7 +281,7 @@ void test_parse_simple_values() {
 
   value = parse_value(&parser);
   TEST_ASSERT(value.type == JSON_ARRAY, "parse_value should parse array");
-  TEST_ASSERT(value.array.len == 3, "Array should have 3 elements");
+  TEST_ASSERT(value.array->len == 3, "Array should have 3 elements");
   TEST_ASSERT(!parser.has_error, "Should not have error");
 
   json_value_free(&value);
@@ -282,8 +294,8 @@ void test_parse_simple_values() {
 
   value = parse_value(&parser);
   TEST_ASSERT(value.type == JSON_ARRAY, "parse_value should parse nested array");
-  TEST_ASSERT(value.array.len == 2, "Outer array should have 2 elements");
-  TEST_ASSERT(value.array.items[0].type == JSON_ARRAY, "First element should be array");
+  TEST_ASSERT(value.array->len == 2, "Outer array should have 2 elements");
+  TEST_ASSERT(value.array->items[0].type == JSON_ARRAY, "First element should be array");
   TEST_ASSERT(!parser.has_error, "Should not have error");
 
   json_value_free(&value);
@@ -311,7 +323,7 @@ void test_parse_array() {
 
   json_value_t value = parse_array(&parser);
   TEST_ASSERT(value.type == JSON_ARRAY, "Empty array should have JSON_ARRAY type");
-  TEST_ASSERT(value.array.len == 0, "Empty array should have length 0");
+  TEST_ASSERT(value.array->len == 0, "Empty array should have length 0");
   TEST_ASSERT(!parser.has_error, "Should not have error for empty array");
 
   json_value_free(&value);
@@ -324,9 +336,9 @@ void test_parse_array() {
 
   value = parse_array(&parser);
   TEST_ASSERT(value.type == JSON_ARRAY, "Should parse array type");
-  TEST_ASSERT(value.array.len == 1, "Array should have 1 element");
-  TEST_ASSERT(value.array.items[0].type == JSON_NUMBER, "First element should be number");
-  TEST_ASSERT(value.array.items[0].number == 42.0, "Number value should be 42");
+  TEST_ASSERT(value.array->len == 1, "Array should have 1 element");
+  TEST_ASSERT(value.array->items[0].type == JSON_NUMBER, "First element should be number");
+  TEST_ASSERT(value.array->items[0].number == 42.0, "Number value should be 42");
   TEST_ASSERT(!parser.has_error, "Should not have error");
 
   json_value_free(&value);
@@ -339,10 +351,10 @@ void test_parse_array() {
 
   value = parse_array(&parser);
   TEST_ASSERT(value.type == JSON_ARRAY, "Should parse array with multiple elements");
-  TEST_ASSERT(value.array.len == 3, "Array should have 3 elements");
-  TEST_ASSERT(value.array.items[0].number == 1.0, "First element should be 1");
-  TEST_ASSERT(value.array.items[1].number == 2.0, "Second element should be 2");
-  TEST_ASSERT(value.array.items[2].number == 3.0, "Third element should be 3");
+  TEST_ASSERT(value.array->len == 3, "Array should have 3 elements");
+  TEST_ASSERT(value.array->items[0].number == 1.0, "First element should be 1");
+  TEST_ASSERT(value.array->items[1].number == 2.0, "Second element should be 2");
+  TEST_ASSERT(value.array->items[2].number == 3.0, "Third element should be 3");
 
   json_value_free(&value);
   lexer_free(&lexer);
@@ -354,13 +366,13 @@ void test_parse_array() {
 
   value = parse_array(&parser);
   TEST_ASSERT(value.type == JSON_ARRAY, "Should parse array with mixed types");
-  TEST_ASSERT(value.array.len == 4, "Array should have 4 elements");
-  TEST_ASSERT(value.array.items[0].type == JSON_NUMBER, "First element should be number");
-  TEST_ASSERT(value.array.items[1].type == JSON_STRING, "Second element should be string");
-  TEST_ASSERT(strcmp(value.array.items[1].string, "hello") == 0, "String value should be correct");
-  TEST_ASSERT(value.array.items[2].type == JSON_BOOL, "Third element should be boolean");
-  TEST_ASSERT(value.array.items[2].boolean == true, "Boolean value should be true");
-  TEST_ASSERT(value.array.items[3].type == JSON_NULL, "Fourth element should be null");
+  TEST_ASSERT(value.array->len == 4, "Array should have 4 elements");
+  TEST_ASSERT(value.array->items[0].type == JSON_NUMBER, "First element should be number");
+  TEST_ASSERT(value.array->items[1].type == JSON_STRING, "Second element should be string");
+  TEST_ASSERT(strcmp(json_get_string(&value.array->items[1]), "hello") == 0, "String value should be correct");
+  TEST_ASSERT(value.array->items[2].type == JSON_BOOL, "Third element should be boolean");
+  TEST_ASSERT(value.array->items[2].boolean == true, "Boolean value should be true");
+  TEST_ASSERT(value.array->items[3].type == JSON_NULL, "Fourth element should be null");
 
   json_value_free(&value);
   lexer_free(&lexer);
@@ -372,15 +384,15 @@ void test_parse_array() {
 
   value = parse_array(&parser);
   TEST_ASSERT(value.type == JSON_ARRAY, "Should parse nested array");
-  TEST_ASSERT(value.array.len == 2, "Outer array should have 2 elements");
-  TEST_ASSERT(value.array.items[0].type == JSON_ARRAY, "First element should be array");
-  TEST_ASSERT(value.array.items[0].array.len == 2, "First nested array should have 2 elements");
-  TEST_ASSERT(value.array.items[0].array.items[0].number == 1.0, "First nested element should be 1");
-  TEST_ASSERT(value.array.items[0].array.items[1].number == 2.0, "Second nested element should be 2");
-  TEST_ASSERT(value.array.items[1].type == JSON_ARRAY, "Second element should be array");
-  TEST_ASSERT(value.array.items[1].array.len == 2, "Second nested array should have 2 elements");
-  TEST_ASSERT(value.array.items[1].array.items[0].number == 3.0, "Third nested element should be 3");
-  TEST_ASSERT(value.array.items[1].array.items[1].number == 4.0, "Fourth nested element should be 4");
+  TEST_ASSERT(value.array->len == 2, "Outer array should have 2 elements");
+  TEST_ASSERT(value.array->items[0].type == JSON_ARRAY, "First element should be array");
+  TEST_ASSERT(value.array->items[0].array->len == 2, "First nested array should have 2 elements");
+  TEST_ASSERT(value.array->items[0].array->items[0].number == 1.0, "First nested element should be 1");
+  TEST_ASSERT(value.array->items[0].array->items[1].number == 2.0, "Second nested element should be 2");
+  TEST_ASSERT(value.array->items[1].type == JSON_ARRAY, "Second element should be array");
+  TEST_ASSERT(value.array->items[1].array->len == 2, "Second nested array should have 2 elements");
+  TEST_ASSERT(value.array->items[1].array->items[0].number == 3.0, "Third nested element should be 3");
+  TEST_ASSERT(value.array->items[1].array->items[1].number == 4.0, "Fourth nested element should be 4");
 
   json_value_free(&value);
   lexer_free(&lexer);
@@ -392,7 +404,7 @@ void test_parse_array() {
 
   value = parse_array(&parser);
   TEST_ASSERT(value.type == JSON_ARRAY, "Should handle whitespace in array");
-  TEST_ASSERT(value.array.len == 3, "Array with whitespace should have 3 elements");
+  TEST_ASSERT(value.array->len == 3, "Array with whitespace should have 3 elements");
 
   json_value_free(&value);
   lexer_free(&lexer);
@@ -457,7 +469,7 @@ void test_parse_object() {
   TEST_ASSERT(json_object_size(&value) == 1, "Object should have 1 entry");
   json_value_t name_val = json_object_get(&value, "name");
   TEST_ASSERT(name_val.type == JSON_STRING, "Value should be string");
-  TEST_ASSERT(strcmp(name_val.string, "John") == 0, "String value should be 'John'");
+  TEST_ASSERT(strcmp(json_get_string(&name_val), "John") == 0, "String value should be 'John'");
   TEST_ASSERT(!parser.has_error, "Should not have error");
 
   json_value_free(&value);
@@ -489,7 +501,7 @@ void test_parse_object() {
 
   json_value_t v_name = json_object_get(&value, "name");
   TEST_ASSERT(v_name.type == JSON_STRING, "name value should be string");
-  TEST_ASSERT(strcmp(v_name.string, "Alice") == 0, "name value should be 'Alice'");
+  TEST_ASSERT(strcmp(json_get_string(&v_name), "Alice") == 0, "name value should be 'Alice'");
 
   json_value_t v_age = json_object_get(&value, "age");
   TEST_ASSERT(v_age.type == JSON_NUMBER, "age value should be number");
@@ -528,7 +540,7 @@ void test_parse_object() {
   TEST_ASSERT(json_object_size(&value) == 1, "Object should have 1 entry");
   json_value_t numbers = json_object_get(&value, "numbers");
   TEST_ASSERT(numbers.type == JSON_ARRAY, "Value should be array");
-  TEST_ASSERT(numbers.array.len == 3, "Array should have 3 elements");
+  TEST_ASSERT(numbers.array->len == 3, "Array should have 3 elements");
 
   json_value_free(&value);
   lexer_free(&lexer);
@@ -545,7 +557,7 @@ void test_parse_object() {
   TEST_ASSERT(person.type == JSON_OBJECT, "Value should be object");
   TEST_ASSERT(json_object_size(&person) == 2, "Nested object should have 2 entries");
   json_value_t nested_name = json_object_get(&person, "name");
-  TEST_ASSERT(strcmp(nested_name.string, "Bob") == 0, "Nested value should be 'Bob'");
+  TEST_ASSERT(strcmp(json_get_string(&nested_name), "Bob") == 0, "Nested value should be 'Bob'");
 
   json_value_free(&value);
   lexer_free(&lexer);
@@ -573,9 +585,9 @@ void test_parse_object() {
   TEST_ASSERT(json_object_size(&value) == 1, "Object should have 1 entry");
   json_value_t users = json_object_get(&value, "users");
   TEST_ASSERT(users.type == JSON_ARRAY, "Value should be array");
-  TEST_ASSERT(users.array.len == 2, "Array should have 2 elements");
-  TEST_ASSERT(users.array.items[0].type == JSON_OBJECT, "Array element should be object");
-  TEST_ASSERT(json_object_size(&users.array.items[0]) == 1, "First object should have 1 entry");
+  TEST_ASSERT(users.array->len == 2, "Array should have 2 elements");
+  TEST_ASSERT(users.array->items[0].type == JSON_OBJECT, "Array element should be object");
+  TEST_ASSERT(json_object_size(&users.array->items[0]) == 1, "First object should have 1 entry");
 
   json_value_free(&value);
   lexer_free(&lexer);
@@ -645,6 +657,27 @@ void test_parse_object() {
 
   json_value_free(&value);
   lexer_free(&lexer);
+
+  // Test 16: Duplicate key - the replaced value goes back to the pool
+  lexer = lexer_init("{\"a\": [1, 2, 3], \"b\": \"a string too long to inline\"}");
+  parser = parser_init(&lexer);
+  parser.current_token = next_token(&lexer);
+  value = parse_object(&parser);
+  size_t distinct_free = pool_bytes_free(parser.pool);
+  parser_free(&parser);
+  lexer_free(&lexer);
+
+  lexer = lexer_init("{\"a\": [1, 2, 3], \"a\": \"a string too long to inline\"}");
+  parser = parser_init(&lexer);
+  parser.current_token = next_token(&lexer);
+  value = parse_object(&parser);
+  TEST_ASSERT(!parser.has_error && json_object_size(&value) == 1 &&
+              json_object_get(&value, "a").type == JSON_STRING,
+              "Last value of a duplicate key should win");
+  TEST_ASSERT(pool_bytes_free(parser.pool) > distinct_free,
+              "Replaced duplicate value should be freed to the pool");
+  parser_free(&parser);
+  lexer_free(&lexer);
 }
 
 TEST_MAIN("Parser",
@@ -0,0 +1,487 @@
+#include "../include/serializer.h"
+#include "../include/parser.h"
+#include "../include/builder.h"
+#include "test_framework.h"
+
+#include <math.h>
+#include <string.h>
+#include <unistd.h>
+
+TEST_SUITE_INIT()
+
+static char *read_file(const char *path) {
+  FILE *file = fopen(path, "rb");
+  if (!file) return NULL;
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  char *data = malloc(size + 1);
+  size_t read = fread(data, 1, size, file);
+  data[read] = '\0';
+  fclose(file);
+  return data;
+}
+
+typedef struct {
+  lexer_t lexer;
+  parser_t parser;
+  json_value_t value;
+} parsed_t;
+
+static void parse_text(parsed_t *doc, const char *text) {
+  doc->lexer = lexer_init(text);
+  doc->parser = parser_init(&doc->lexer);
+  doc->parser.current_token = next_token(&doc->lexer);
+  doc->value = parse(&doc->parser);
+}
+
+static void parsed_free(parsed_t *doc) {
+  parser_free(&doc->parser);
+  lexer_free(&doc->lexer);
+}
+
+// Serialize text's parse and compare with expected
+static bool serializes_to(const char *text, const char *expected) {
+  parsed_t doc;
+  parse_text(&doc, text);
+  char *out = json_serialize(&doc.value, NULL);
+  bool same = !doc.parser.has_error && out && strcmp(out, expected) == 0;
+  if (!same) printf("  got: %s\n", out ? out : "(null)");
+  free(out);
+  parsed_free(&doc);
+  return same;
+}
+
+static bool values_equal(json_value_t *a, json_value_t *b) {
+  if (a->type != b->type) return false;
+  switch (a->type) {
+    case JSON_NULL: return true;
+    case JSON_BOOL: return a->boolean == b->boolean;
+    case JSON_NUMBER: return a->number == b->number || (isnan(a->number) && isnan(b->number));
+    case JSON_STRING: return json_value_cmp(a, b) == 0;
+    case JSON_ARRAY:
+      if (a->array->len != b->array->len) return false;
+      for (size_t i = 0; i < a->array->len; i++) {
+        if (!values_equal(&a->array->items[i], &b->array->items[i])) return false;
+      }
+      return true;
+    case JSON_OBJECT: {
+      if (a->object->size != b->object->size) return false;
+      json_object_iter_t it = json_object_iter(a);
+      for (hash_entry_t *entry; (entry = json_object_next(&it));) {
+        json_value_t *other = hash_table_get(b->object, hash_entry_key(entry).str, hash_entry_key_len(entry));
+        if (!other || !values_equal(&entry->value, other)) return false;
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+void test_serialize_scalars() {
+  printf("\n=== Testing scalar serialization ===\n");
+
+  TEST_ASSERT(serializes_to("null", "null"), "null");
+  TEST_ASSERT(serializes_to("true", "true"), "true");
+  TEST_ASSERT(serializes_to("false", "false"), "false");
+  TEST_ASSERT(serializes_to("0", "0"), "Zero");
+  TEST_ASSERT(serializes_to("-12345678901", "-12345678901"), "Negative integer");
+  TEST_ASSERT(serializes_to("9007199254740992", "9007199254740992"), "2^53 should stay an integer");
+  TEST_ASSERT(serializes_to("1e3", "1000"), "Integral exponent form should print as an integer");
+  TEST_ASSERT(serializes_to("0.1", "0.1"), "0.1 should use the shortest exact form");
+  TEST_ASSERT(serializes_to("-2.5e-7", "-2.5e-7"), "Small fraction");
+  TEST_ASSERT(serializes_to("1e300", "1e+300"), "Large double should use the shortest exact form");
+  TEST_ASSERT(serializes_to("0.30000000000000004", "0.30000000000000004"), "17-digit double should round-trip");
+
+  json_value_t nan = json_value_number(NAN);
+  json_value_t inf = json_value_number(-INFINITY);
+  char buf[32];
+  TEST_ASSERT(json_serialize_to(&nan, buf, sizeof(buf)) == 4 && strcmp(buf, "null") == 0, "NaN should be null");
+  TEST_ASSERT(json_serialize_to(&inf, buf, sizeof(buf)) == 4 && strcmp(buf, "null") == 0, "Infinity should be null");
+
+  // Every integer digit count
+  int64_t value = 1;
+  int mismatches = 0;
+  for (int digits = 1; digits <= 16; digits++) {
+    json_value_t number = json_value_number((double)value);
+    char expected[32];
+    snprintf(expected, sizeof(expected), "%lld", (long long)value);
+    json_serialize_to(&number, buf, sizeof(buf));
+    mismatches += strcmp(buf, expected) != 0;
+    value = value * 10 + (digits % 10);
+  }
+  TEST_ASSERT(mismatches == 0, "Integers of every length should format exactly");
+}
+
+void test_serialize_containers() {
+  printf("\n=== Testing container serialization ===\n");
+
+  TEST_ASSERT(serializes_to("[]", "[]"), "Empty array");
+  TEST_ASSERT(serializes_to("{}", "{}"), "Empty object");
+  TEST_ASSERT(serializes_to(" [ 1 , [ true , null ] , \"x\" ] ", "[1,[true,null],\"x\"]"),
+              "Whitespace should be dropped");
+  TEST_ASSERT(serializes_to("{\"a\": {\"b\": [1, 2]}}", "{\"a\":{\"b\":[1,2]}}"), "Nested object");
+  TEST_ASSERT(serializes_to("{\"b\": 1, \"a\": {\"z\": null, \"y\": []}, \"c\": 2}",
+                            "{\"b\":1,\"a\":{\"z\":null,\"y\":[]},\"c\":2}"),
+              "Members should keep source order");
+  TEST_ASSERT(serializes_to("{\"a\": 1, \"b\": 2, \"a\": 3}", "{\"a\":3,\"b\":2}"),
+              "A duplicate key keeps its first position and last value");
+
+  parsed_t doc;
+  parse_text(&doc, "{\"id\": 1, \"name\": \"n\", \"list\": [1, 2, 3], \"flag\": false}");
+  char *out = json_serialize(&doc.value, NULL);
+  parsed_t again;
+  parse_text(&again, out);
+  TEST_ASSERT(!again.parser.has_error && values_equal(&doc.value, &again.value),
+              "Multi-member object should re-parse to the same document");
+  free(out);
+  parsed_free(&again);
+  parsed_free(&doc);
+}
+
+void test_serialize_strings() {
+  printf("\n=== Testing string escaping ===\n");
+
+  TEST_ASSERT(serializes_to("\"a\\\"b\\\\c\\n\\u00e9\\/\"", "\"a\\\"b\\\\c\\n\\u00e9\\/\""),
+              "Escape sequences from the parser should pass through unchanged");
+  TEST_ASSERT(serializes_to("\"caf\xc3\xa9 \xe2\x9c\x93\"", "\"caf\xc3\xa9 \xe2\x9c\x93\""),
+              "UTF-8 should be copied as is");
+
+  // Builder text is stored as given; a backslash that starts a valid
+  // escape is indistinguishable from one and passes through
+  json_builder_t b = json_builder_init(NULL);
+  json_builder_begin_array(&b);
+  json_builder_string(&b, "say \"hi\"", 8);
+  json_builder_string(&b, "tab\there\nnl\x01", 12);
+  json_builder_string(&b, "C:\\path\\x", 9);
+  json_builder_string(&b, "trailing\\", 9);
+  json_builder_end(&b);
+  json_value_t doc = json_builder_finish(&b);
+  char *out = json_serialize(&doc, NULL);
+  TEST_ASSERT(out && strcmp(out, "[\"say \\\"hi\\\"\",\"tab\\there\\nnl\\u0001\","
+                                 "\"C:\\\\path\\\\x\",\"trailing\\\\\"]") == 0,
+              "Quotes, control characters and stray backslashes should be escaped");
+  parsed_t again;
+  parse_text(&again, out);
+  TEST_ASSERT(!again.parser.has_error, "Escaped output should parse");
+  free(out);
+  parsed_free(&again);
+  json_builder_free(&b);
+
+  // Special bytes at every offset around the 16- and 8-byte scan widths
+  char text[64], expected[80];
+  int mismatches = 0;
+  for (int pos = 0; pos < 40; pos++) {
+    memset(text, 'x', 40);
+    text[40] = '\0';
+    text[pos] = '"';
+    json_value_t str = json_value_string(text);
+    snprintf(expected, sizeof(expected), "\"%.*s\\\"%s\"", pos, text, text + pos + 1);
+    char *got = json_serialize(&str, NULL);
+    mismatches += strcmp(got, expected) != 0;
+    free(got);
+  }
+  TEST_ASSERT(mismatches == 0, "Quote should be found at every offset");
+}
+
+void test_serialize_buffers() {
+  printf("\n=== Testing output buffers ===\n");
+
+  parsed_t doc;
+  parse_text(&doc, "{\"key\": [1, 2, 3, \"four\"]}");
+  const char *expected = "{\"key\":[1,2,3,\"four\"]}";
+  size_t len = strlen(expected);
+
+  char buf[64];
+  TEST_ASSERT(json_serialize_to(&doc.value, buf, len + 1) == len && strcmp(buf, expected) == 0,
+              "Exact-size caller buffer should fit text and NUL");
+  TEST_ASSERT(json_serialize_to(&doc.value, buf, len) == 0, "Buffer without room for the NUL should fail");
+  TEST_ASSERT(json_serialize_to(&doc.value, buf, 5) == 0, "Small buffer should fail");
+
+  json_buffer_t buffer = json_buffer_init(0);
+  TEST_ASSERT(json_serialize_into(&buffer, &doc.value) && buffer.len == len, "Growable buffer should grow");
+  char *first = buffer.data;
+  buffer.len = 0;
+  TEST_ASSERT(json_serialize_into(&buffer, &doc.value) && buffer.data == first &&
+              strcmp(buffer.data, expected) == 0, "Reused buffer should not reallocate");
+  json_buffer_free(&buffer);
+  parsed_free(&doc);
+}
+
+void test_serialize_round_trip() {
+  printf("\n=== Testing round trips over sample files ===\n");
+
+  const char *files[] = {
+    "samples/simple.json", "samples/array.json", "samples/nested.json",
+    "benchmarks/data/unicode.json", "benchmarks/data/numeric_edges.json",
+    "benchmarks/data/deeply_nested.json", "benchmarks/data/long_strings.json",
+  };
+  for (size_t f = 0; f < sizeof(files) / sizeof(files[0]); f++) {
+    char *text = read_file(files[f]);
+    if (!text) {
+      printf("  skipping %s\n", files[f]);
+      continue;
+    }
+    parsed_t doc;
+    parse_text(&doc, text);
+    char *out = json_serialize(&doc.value, NULL);
+    parsed_t again;
+    parse_text(&again, out);
+    char message[128];
+    snprintf(message, sizeof(message), "%s should round-trip", files[f]);
+    TEST_ASSERT(!doc.parser.has_error && !again.parser.has_error && values_equal(&doc.value, &again.value),
+                message);
+    free(out);
+    parsed_free(&again);
+    parsed_free(&doc);
+    free(text);
+  }
+}
+
+// Parallel output must equal json_serialize() byte for byte
+static bool parallel_matches(const json_value_t *value, int threads, size_t min_split) {
+  json_parallel_config_t config = {.threads = threads, .min_split = min_split};
+  size_t expected_len, len;
+  char *expected = json_serialize(value, &expected_len);
+  char *text = json_serialize_parallel(value, &len, &config);
+  bool same = expected && text && len == expected_len && memcmp(text, expected, len) == 0;
+
+  FILE *file = tmpfile();
+  bool fd_ok = file && json_serialize_parallel_fd(value, fileno(file), &config);
+  char *written = malloc(expected_len + 1);
+  size_t got = 0;
+  if (fd_ok) {
+    rewind(file);
+    got = fread(written, 1, expected_len + 1, file);
+  }
+  same = same && fd_ok && got == expected_len && memcmp(written, expected, got) == 0;
+  if (file) fclose(file);
+  free(written);
+  free(expected);
+  free(text);
+  return same;
+}
+
+void test_serialize_parallel() {
+  printf("\n=== Testing parallel serialization ===\n");
+
+  // Large array of mixed values, including containers
+  json_builder_t b = json_builder_init(NULL);
+  json_builder_begin_array(&b);
+  for (int i = 0; i < 20000; i++) {
+    switch (i % 4) {
+      case 0: json_builder_number(&b, i * 0.5); break;
+      case 1: json_builder_string(&b, "s\"q", 3); break;
+      case 2:
+        json_builder_begin_object(&b);
+        json_builder_key(&b, "i", 1);
+        json_builder_number(&b, i);
+        json_builder_end(&b);
+        break;
+      default: json_builder_null(&b);
+    }
+  }
+  json_builder_end(&b);
+  json_value_t array = json_builder_finish(&b);
+  TEST_ASSERT(parallel_matches(&array, 4, 100), "Split array should match the sequential text");
+  TEST_ASSERT(parallel_matches(&array, 3, 7), "Many small ranges should match");
+  TEST_ASSERT(parallel_matches(&array, 1, 0), "One thread should match");
+  TEST_ASSERT(parallel_matches(&array, 0, 0), "Default config should match");
+  json_builder_free(&b);
+
+  // Large object: ranges over table entries
+  b = json_builder_init(NULL);
+  json_builder_begin_object(&b);
+  for (int i = 0; i < 5000; i++) {
+    char key[16];
+    int key_len = snprintf(key, sizeof(key), "key%d", i);
+    json_builder_key(&b, key, key_len);
+    json_builder_number(&b, i);
+  }
+  json_builder_end(&b);
+  json_value_t object = json_builder_finish(&b);
+  TEST_ASSERT(parallel_matches(&object, 4, 64), "Split object should match the sequential text");
+  TEST_ASSERT(parallel_matches(&object, 4, 1), "Single-slot ranges should match");
+  json_builder_free(&b);
+
+  // Large array below small containers, as in GeoJSON
+  b = json_builder_init(NULL);
+  json_builder_begin_object(&b);
+  json_builder_key(&b, "type", 4);
+  json_builder_string(&b, "FeatureCollection", 17);
+  json_builder_key(&b, "features", 8);
+  json_builder_begin_array(&b);
+  for (int i = 0; i < 3000; i++) {
+    json_builder_begin_array(&b);
+    json_builder_number(&b, -122.4 + i * 1e-4);
+    json_builder_number(&b, 37.7);
+    json_builder_end(&b);
+  }
+  json_builder_end(&b);
+  json_builder_key(&b, "empty", 5);
+  json_builder_begin_array(&b);
+  json_builder_end(&b);
+  json_builder_end(&b);
+  json_value_t nested = json_builder_finish(&b);
+  TEST_ASSERT(parallel_matches(&nested, 4, 256), "Nested large array should match");
+  TEST_ASSERT(parallel_matches(&nested, 4, 2), "Splitting at every level should match");
+  json_builder_free(&b);
+
+  json_value_t scalar = json_value_number(1.5);
+  TEST_ASSERT(parallel_matches(&scalar, 4, 1), "Scalar root should match");
+  parsed_t doc;
+  parse_text(&doc, "[[], {}, [1], {\"a\": []}]");
+  TEST_ASSERT(parallel_matches(&doc.value, 2, 1), "Empty and one-member containers should match");
+  parsed_free(&doc);
+
+  // Closed descriptor
+  int fds[2];
+  TEST_ASSERT(pipe(fds) == 0, "pipe");
+  close(fds[0]);
+  close(fds[1]);
+  TEST_ASSERT(!json_serialize_parallel_fd(&scalar, fds[1], NULL), "Write to a closed fd should fail");
+}
+
+// Canonical form of text's parse; expected NULL means it must fail
+static bool canonicalizes_to(const char *text, const char *expected) {
+  parsed_t doc;
+  parse_text(&doc, text);
+  char *out = doc.parser.has_error ? NULL : json_serialize_canonical(&doc.value, NULL);
+  bool same = expected ? out && strcmp(out, expected) == 0 : !doc.parser.has_error && !out;
+  if (!same) printf("  got: %s\n", out ? out : "(null)");
+  free(out);
+  parsed_free(&doc);
+  return same;
+}
+
+void test_serialize_canonical() {
+  printf("\n=== Testing canonical serialization ===\n");
+
+  // RFC 8785, section 3.2.2
+  TEST_ASSERT(canonicalizes_to(
+                  "{\"numbers\": [333333333.33333329, 1E30, 4.50, 2e-3, 0.000000000000000000000000001],\n"
+                  " \"string\": \"\\u20ac$\\u000F\\u000aA'\\u0042\\u0022\\u005c\\\\\\\"\\/\",\n"
+                  " \"literals\": [null, true, false]}",
+                  "{\"literals\":[null,true,false],\"numbers\":[333333333.3333333,1e+30,4.5,0.002,1e-27],"
+                  "\"string\":\"\xe2\x82\xac$\\u000f\\nA'B\\\"\\\\\\\\\\\"/\"}"),
+              "RFC 8785 example");
+
+  // RFC 8785, section 3.2.3: UTF-16 order puts U+1F600 (a surrogate pair)
+  // before U+FB33
+  TEST_ASSERT(canonicalizes_to("{\"\\u20ac\": 1, \"\\r\": 2, \"\\ufb33\": 3, \"1\": 4, "
+                               "\"\\ud83d\\ude00\": 5, \"\\u0080\": 6, \"\\u00f6\": 7}",
+                               "{\"\\r\":2,\"1\":4,\"\xc2\x80\":6,\"\xc3\xb6\":7,\"\xe2\x82\xac\":1,"
+                               "\"\xf0\x9f\x98\x80\":5,\"\xef\xac\xb3\":3}"),
+              "Keys should sort by UTF-16 code units");
+  TEST_ASSERT(canonicalizes_to("{\"b\": 1, \"a\": {\"z\": [], \"y\": {}}, \"aa\": 2, \"A\": 3, \"abcdefghij\": 4,"
+                               " \"abcdefghi\": 5, \"abcdefghik\": 6}",
+                               "{\"A\":3,\"a\":{\"y\":{},\"z\":[]},\"aa\":2,\"abcdefghi\":5,"
+                               "\"abcdefghij\":4,\"abcdefghik\":6,\"b\":1}"),
+              "Nested objects and long common prefixes");
+  TEST_ASSERT(canonicalizes_to("[\"\\/\\b\\u0007\\u007f\\u2028\", -0, 1e21, 100, 0.1]",
+                               "[\"/\\b\\u0007\x7f\xe2\x80\xa8\",0,1e+21,100,0.1]"),
+              "Minimal escaping and ECMAScript numbers");
+
+  TEST_ASSERT(canonicalizes_to("[\"\\ud800\"]", NULL), "Lone surrogate should fail");
+  TEST_ASSERT(canonicalizes_to("{\"\\ude00x\": 1}", NULL), "Lone low surrogate key should fail");
+  TEST_ASSERT(canonicalizes_to("{\"a\": 1, \"\\u0061\": 2}", NULL), "Keys equal once decoded should fail");
+  json_value_t nan = json_value_number(NAN);
+  TEST_ASSERT(json_serialize_canonical(&nan, NULL) == NULL, "NaN should fail");
+
+  // Wide objects take the merge sort; compare with strcmp order
+  char text[8192];
+  size_t pos = 0;
+  text[pos++] = '{';
+  uint64_t state = 0x2545F4914F6CDD1DULL;
+  for (int i = 0; i < 300; i++) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    pos += snprintf(text + pos, sizeof(text) - pos, "%s\"k%llu\": %d", i ? "," : "",
+                    (unsigned long long)(state % 1000000007), i);
+  }
+  text[pos++] = '}';
+  text[pos] = '\0';
+  parsed_t doc;
+  parse_text(&doc, text);
+  size_t len;
+  char *out = json_serialize_canonical(&doc.value, &len);
+  bool sorted = out != NULL;
+  const char *prev = NULL;
+  size_t prev_len = 0;
+  for (const char *p = out ? out + 1 : NULL; sorted && *p == '"'; ) {
+    const char *end = strchr(p + 1, '"');
+    size_t key_len = end - (p + 1);
+    if (prev) {
+      int cmp = memcmp(prev, p + 1, prev_len < key_len ? prev_len : key_len);
+      sorted = cmp < 0 || (cmp == 0 && prev_len < key_len);
+    }
+    prev = p + 1;
+    prev_len = key_len;
+    p = strchr(end, ',');
+    p = p ? p + 1 : end + strlen(end);
+  }
+  TEST_ASSERT(sorted && json_object_size(&doc.value) > 250, "Wide object keys should be in order");
+
+  // Canonical text is a fixed point
+  parsed_t again;
+  parse_text(&again, out ? out : "null");
+  char *twice = json_serialize_canonical(&again.value, NULL);
+  TEST_ASSERT(out && twice && strcmp(out, twice) == 0, "Canonicalizing canonical text should not change it");
+  free(twice);
+  free(out);
+  parsed_free(&again);
+  parsed_free(&doc);
+}
+
+void test_serialize_failed_storage() {
+  printf("\n=== Testing containers without storage ===\n");
+
+  // What json_value_array() and json_value_object() return when their
+  // allocation fails
+  json_value_t empty_array = json_value_init(JSON_ARRAY);
+  empty_array.array = NULL;
+  json_value_t empty_object = json_value_init(JSON_OBJECT);
+  empty_object.object = NULL;
+
+  char *out = json_serialize(&empty_array, NULL);
+  TEST_ASSERT(out && strcmp(out, "[]") == 0, "An array without storage should serialize as []");
+  free(out);
+
+  json_value_t doc = json_value_array(2);
+  json_array_push(&doc, empty_array);
+  json_array_push(&doc, empty_object);
+  out = json_serialize(&doc, NULL);
+  TEST_ASSERT(out && strcmp(out, "[[],{}]") == 0, "Nested containers without storage should be empty");
+  free(out);
+
+  json_parallel_config_t config = {.threads = 2, .min_split = 1};
+  out = json_serialize_parallel(&doc, NULL, &config);
+  TEST_ASSERT(out && strcmp(out, "[[],{}]") == 0, "Parallel plan should treat them as empty");
+  free(out);
+  out = json_serialize_parallel(&empty_array, NULL, &config);
+  TEST_ASSERT(out && strcmp(out, "[]") == 0, "Parallel root without storage should be empty");
+  free(out);
+
+  json_spans_t spans = json_spans_init();
+  out = json_serialize_spliced(&doc, &spans, NULL);
+  TEST_ASSERT(out && strcmp(out, "[[],{}]") == 0, "Spliced output should treat them as empty");
+  free(out);
+  json_spans_free(&spans);
+
+  out = json_serialize_canonical(&doc, NULL);
+  TEST_ASSERT(out && strcmp(out, "[[],{}]") == 0, "Canonical output should treat them as empty");
+  free(out);
+  json_value_free(&doc);
+}
+
+TEST_MAIN("Serializer",
+  test_serialize_scalars();
+  test_serialize_containers();
+  test_serialize_strings();
+  test_serialize_buffers();
+  test_serialize_round_trip();
+  test_serialize_parallel();
+  test_serialize_canonical();
+  test_serialize_failed_storage();
+)
@@ -0,0 +1,304 @@
+#include "../include/span.h"
+#include "../include/serializer.h"
+#include "../include/parser.h"
+#include "test_framework.h"
+
+#include <math.h>
+#include <string.h>
+
+TEST_SUITE_INIT()
+
+static char *read_file(const char *path, size_t *len) {
+  FILE *file = fopen(path, "rb");
+  if (!file) return NULL;
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  char *data = malloc(size + 1);
+  *len = fread(data, 1, size, file);
+  data[*len] = '\0';
+  fclose(file);
+  return data;
+}
+
+typedef struct {
+  lexer_t lexer;
+  parser_t parser;
+  json_spans_t spans;
+  json_value_t value;
+} parsed_t;
+
+static void parse_with_spans(parsed_t *doc, const char *text, size_t len) {
+  doc->spans = json_spans_init();
+  doc->lexer = lexer_init_view(text, len);
+  doc->parser = parser_init(&doc->lexer);
+  doc->parser.spans = &doc->spans;
+  doc->parser.current_token = next_token(&doc->lexer);
+  doc->value = parse(&doc->parser);
+}
+
+static void parsed_free(parsed_t *doc) {
+  parser_free(&doc->parser);
+  lexer_free(&doc->lexer);
+  json_spans_free(&doc->spans);
+}
+
+static bool values_equal(json_value_t *a, json_value_t *b) {
+  if (a->type != b->type) return false;
+  switch (a->type) {
+    case JSON_NULL: return true;
+    case JSON_BOOL: return a->boolean == b->boolean;
+    case JSON_NUMBER: return a->number == b->number || (isnan(a->number) && isnan(b->number));
+    case JSON_STRING: return json_value_cmp(a, b) == 0;
+    case JSON_ARRAY:
+      if (a->array->len != b->array->len) return false;
+      for (size_t i = 0; i < a->array->len; i++) {
+        if (!values_equal(&a->array->items[i], &b->array->items[i])) return false;
+      }
+      return true;
+    case JSON_OBJECT: {
+      if (a->object->size != b->object->size) return false;
+      json_object_iter_t it = json_object_iter(a);
+      for (hash_entry_t *entry; (entry = json_object_next(&it));) {
+        json_value_t *other = hash_table_get(b->object, hash_entry_key(entry).str, hash_entry_key_len(entry));
+        if (!other || !values_equal(&entry->value, other)) return false;
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+// Spliced text of doc, which must parse back to doc's value; the fd
+// variant must write the same text
+static char *spliced_checked(parsed_t *doc, bool *ok) {
+  size_t len;
+  char *text = json_serialize_spliced(&doc->value, &doc->spans, &len);
+  *ok = text != NULL;
+  if (!text) return NULL;
+
+  parsed_t again;
+  parse_with_spans(&again, text, len);
+  *ok = !again.parser.has_error && values_equal(&doc->value, &again.value);
+  parsed_free(&again);
+
+  FILE *file = tmpfile();
+  bool fd_ok = file && json_serialize_spliced_fd(&doc->value, &doc->spans, fileno(file));
+  char *written = malloc(len + 1);
+  size_t got = 0;
+  if (fd_ok) {
+    rewind(file);
+    got = fread(written, 1, len + 1, file);
+  }
+  *ok = *ok && fd_ok && got == len && memcmp(written, text, len) == 0;
+  if (file) fclose(file);
+  free(written);
+  return text;
+}
+
+void test_span_table() {
+  printf("\n=== Testing span table ===\n");
+
+  json_spans_t spans = json_spans_init();
+  static json_value_t storage[1000];
+  bool added = true;
+  for (size_t i = 0; i < 1000; i++) {
+    added = added && json_spans_add(&spans, &storage[i], i * 10, i + 1);
+  }
+  TEST_ASSERT(added && spans.size == 1000, "Adds should grow the table");
+
+  json_value_t array = json_value_init(JSON_ARRAY);
+  array.array = (json_array_t *)&storage[637];
+  TEST_ASSERT(json_spans_find(&spans, &array) == NULL, "Values without the span flag have no span");
+  array.flags |= JSON_VALUE_SPAN;
+  const json_span_t *span = json_spans_find(&spans, &array);
+  TEST_ASSERT(span && span->start == 6370 && span->len == 638, "Lookup by storage");
+
+  json_spans_add(&spans, &storage[637], 5, 6);
+  span = json_spans_find(&spans, &array);
+  TEST_ASSERT(spans.size == 1000 && span && span->start == 5, "Adding again should replace the span");
+
+  json_value_t number = json_value_number(1);
+  number.flags |= JSON_VALUE_SPAN;
+  TEST_ASSERT(json_spans_find(&spans, &number) == NULL, "Scalars have no span");
+
+  json_spans_clear(&spans);
+  TEST_ASSERT(spans.size == 0 && json_spans_find(&spans, &array) == NULL, "Clear should forget every span");
+  json_spans_free(&spans);
+}
+
+void test_span_parse() {
+  printf("\n=== Testing spans from the parser ===\n");
+
+  const char *text = "  { \"a\" : [ 1 , 2.50 ] ,\n  \"b\" : { } , \"c\" : [ ] }  ";
+  parsed_t doc;
+  parse_with_spans(&doc, text, strlen(text));
+  TEST_ASSERT(!doc.parser.has_error && doc.spans.input == text, "Parse should store the input");
+  TEST_ASSERT(doc.spans.size == 4, "Every container should have a span");
+
+  const json_span_t *root = json_spans_find(&doc.spans, &doc.value);
+  TEST_ASSERT(root && root->start == 2 && root->len == strlen(text) - 4, "Root span is the object's text");
+  json_value_t *a = hash_table_get(doc.value.object, "a", 1);
+  const json_span_t *span = json_spans_find(&doc.spans, a);
+  TEST_ASSERT(span && strncmp(text + span->start, "[ 1 , 2.50 ]", span->len) == 0, "Nested array span");
+
+  char *out = json_serialize_spliced(&doc.value, &doc.spans, NULL);
+  TEST_ASSERT(out && strcmp(out, "{ \"a\" : [ 1 , 2.50 ] ,\n  \"b\" : { } , \"c\" : [ ] }") == 0,
+              "An unedited document should be copied as it was");
+  free(out);
+  parsed_free(&doc);
+
+  // Without a table the parser records nothing
+  lexer_t lexer = lexer_init("[1,[2]]");
+  parser_t parser = parser_init(&lexer);
+  parser.current_token = next_token(&lexer);
+  json_value_t value = parse(&parser);
+  TEST_ASSERT(!(value.flags & JSON_VALUE_SPAN), "No spans without a table");
+  parser_free(&parser);
+  lexer_free(&lexer);
+
+  // Containers closed before an error keep their spans; the rest have none
+  text = "[[1, 2], {\"a\": 1,}]";
+  parse_with_spans(&doc, text, strlen(text));
+  TEST_ASSERT(doc.parser.has_error && doc.spans.size == 1, "Only clean containers should get spans");
+  parsed_free(&doc);
+}
+
+void test_span_edits() {
+  printf("\n=== Testing spliced serialization of edits ===\n");
+
+  const char *text = "{\"a\": {\"x\": 1, \"y\": [1, 2, 3]},\n \"b\": [ 1.50, {\"k\": \"v\"} ]}";
+  parsed_t doc;
+  parse_with_spans(&doc, text, strlen(text));
+
+  // Edit a leaf two levels down
+  json_object_edit(json_object_edit(&doc.value, "a"), "x")->number = 2;
+  bool ok;
+  char *out = spliced_checked(&doc, &ok);
+  TEST_ASSERT(ok, "Spliced text should parse back to the edited document");
+  TEST_ASSERT(out && strstr(out, "\"b\":[ 1.50, {\"k\": \"v\"} ]") && strstr(out, "\"y\":[1, 2, 3]"),
+              "Untouched subtrees should be copied as they were");
+  TEST_ASSERT(out && strstr(out, "\"x\":2"), "The edited path should be written afresh");
+  free(out);
+
+  // Array element edit and a push into a nested array
+  json_value_t *b = json_object_edit(&doc.value, "b");
+  json_value_t *k = json_object_edit(json_array_edit(b, 1), "k");
+  *k = json_value_number(7);
+  json_value_t *y = json_object_edit(json_object_edit(&doc.value, "a"), "y");
+  json_array_push_pooled(y, json_value_number(4), doc.parser.pool);
+  out = spliced_checked(&doc, &ok);
+  TEST_ASSERT(ok && out && strstr(out, "[1.5,{\"k\":7}]") && strstr(out, "\"y\":[1,2,3,4]"),
+              "Edits through arrays and pushes should be written");
+  free(out);
+
+  // A member set directly on the root replaces a copied subtree
+  json_object_set_pooled(&doc.value, "b", json_value_bool(true), doc.parser.pool);
+  out = spliced_checked(&doc, &ok);
+  TEST_ASSERT(ok && out && strstr(out, "\"b\":true"), "Set should replace the member");
+  free(out);
+
+  TEST_ASSERT(json_object_edit(&doc.value, "missing") == NULL && json_array_edit(y, 10) == NULL,
+              "Edit lookups of missing members give NULL");
+
+  // Touching a container writes it afresh even without an API edit
+  json_value_touch(&doc.value);
+  out = json_serialize_spliced(&doc.value, &doc.spans, NULL);
+  TEST_ASSERT(out && out[0] == '{' && out[1] == '"', "Touched root should be compact");
+  free(out);
+  parsed_free(&doc);
+}
+
+void test_span_unsafe_edits() {
+  printf("\n=== Testing edits that skip the path ===\n");
+
+  const char *text = "{\"a\": {\"x\": 1, \"y\": [1, 2, 3]},\n \"b\": [ 1.50, {\"k\": \"v\"} ]}";
+
+  // The _edit chain touches every level, so untouched siblings are reused
+  parsed_t doc;
+  parse_with_spans(&doc, text, strlen(text));
+  TEST_ASSERT(json_spans_verify(&doc.spans, &doc.value), "An unedited document should verify");
+  json_array_edit(json_object_edit(&doc.value, "b"), 0)->number = 9;
+  json_array_push_pooled(json_object_edit(json_object_edit(&doc.value, "a"), "y"), json_value_number(4),
+                         doc.parser.pool);
+  bool ok;
+  char *out = spliced_checked(&doc, &ok);
+  TEST_ASSERT(ok && out && strstr(out, "\"y\":[1,2,3,4]") && strstr(out, "[9,{\"k\": \"v\"}]"),
+              "Edits down the _edit chain should be written, siblings copied");
+  TEST_ASSERT(json_spans_verify(&doc.spans, &doc.value), "The _edit chain should verify");
+  free(out);
+  parsed_free(&doc);
+
+  // A call on a nested container reached by pointer retires the spans
+  parse_with_spans(&doc, text, strlen(text));
+  json_value_t *a = hash_table_get(doc.value.object, "a", 1);
+  json_array_push_pooled(hash_table_get(a->object, "y", 1), json_value_number(4), doc.parser.pool);
+  TEST_ASSERT(json_spans_find(&doc.spans, &doc.value) == NULL, "The still-flagged root should not be copied");
+  out = spliced_checked(&doc, &ok);
+  TEST_ASSERT(ok && out && strstr(out, "\"y\":[1,2,3,4]"), "The nested push should not be lost");
+  free(out);
+  parsed_free(&doc);
+
+  // A field written through json_array_at() makes no call; verify finds it
+  parse_with_spans(&doc, text, strlen(text));
+  json_array_at(hash_table_get(doc.value.object, "b", 1), 0)->number = 9;
+  TEST_ASSERT(!json_spans_verify(&doc.spans, &doc.value), "Verify should report a write that skipped the path");
+  parsed_free(&doc);
+
+  // A later parse records spans again
+  parse_with_spans(&doc, text, strlen(text));
+  TEST_ASSERT(json_spans_find(&doc.spans, &doc.value) != NULL, "Spans parsed after the edit should be used");
+  parsed_free(&doc);
+}
+
+void test_span_files() {
+  printf("\n=== Testing spliced serialization of sample files ===\n");
+
+  const char *files[] = {
+    "benchmarks/data/geojson.json", "benchmarks/data/github_api.json", "benchmarks/data/deeply_nested.json",
+    "samples/complex.json",
+  };
+  for (size_t f = 0; f < sizeof(files) / sizeof(files[0]); f++) {
+    size_t len;
+    char *text = read_file(files[f], &len);
+    if (!text) {
+      printf("  skipping %s\n", files[f]);
+      continue;
+    }
+    parsed_t doc;
+    parse_with_spans(&doc, text, len);
+
+    // Edit the first leaf reached by always taking the first child
+    json_value_t *value = &doc.value;
+    while (value && (value->type == JSON_ARRAY || value->type == JSON_OBJECT)) {
+      if (value->type == JSON_ARRAY) {
+        value = json_array_edit(value, 0);
+      } else {
+        json_object_iter_t it = json_object_iter(value);
+        hash_entry_t *first = json_object_next(&it);
+        value = first ? json_object_edit(value, hash_entry_key(first).str) : NULL;
+      }
+    }
+    if (value) *value = json_value_number(123456);
+
+    bool ok;
+    char *out = spliced_checked(&doc, &ok);
+    char message[128];
+    snprintf(message, sizeof(message), "%s should splice to the edited document", files[f]);
+    TEST_ASSERT(!doc.parser.has_error && value && ok, message);
+    snprintf(message, sizeof(message), "%s: spliced text should contain the edit", files[f]);
+    TEST_ASSERT(out && strstr(out, "123456"), message);
+
+    free(out);
+    parsed_free(&doc);
+    free(text);
+  }
+}
+
+TEST_MAIN("Span",
+  test_span_table();
+  test_span_parse();
+  test_span_edits();
+  test_span_unsafe_edits();
+  test_span_files();
+)
@@ -1,6 +1,8 @@
 #include "test_framework.h"
 #include "../include/lexer.h"
 #include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 TEST_SUITE_INIT()
 
@@ -159,17 +161,41 @@ void test_slice_to_double() {
   double d7 = slice_to_double(slice7);
   TEST_ASSERT(d7 > 123.45 && d7 < 123.46, "Should use stack buffer for small numbers");
 
-  // Test 8: Large number requiring heap allocation (>= 32 bytes)
+  // Test 8: Long number still copied to the stack (< 64 bytes)
   const char *num8 = "123456789012345678901234567890.123456";
   string_slice_t slice8 = {.start = num8, .length = 37};
   double d8 = slice_to_double(slice8);
-  TEST_ASSERT(d8 > 1.0e29, "Should use heap allocation for large numbers");
+  TEST_ASSERT(d8 > 1.0e29, "Should parse long numbers");
 
   // Test 9: Partial slice from larger string
   const char *json_num = "42, \"next\": 100";
   string_slice_t slice9 = {.start = json_num, .length = 2};
   double d9 = slice_to_double(slice9);
   TEST_ASSERT(d9 == 42.0, "Should parse number from partial string");
+
+  // Test 10: Slices whose input runs on with more digits cannot be read in
+  // place, below and above the stack buffer size
+  char digits[201];
+  memset(digits, '1', 200);
+  digits[200] = '\0';
+  string_slice_t slice10 = {.start = digits, .length = 40};
+  TEST_ASSERT(slice_to_double(slice10) > 1.1e39 && slice_to_double(slice10) < 1.2e39,
+              "Should stop at the slice end below the buffer size");
+  string_slice_t slice11 = {.start = digits, .length = 100};
+  TEST_ASSERT(slice_to_double(slice11) > 1.1e99 && slice_to_double(slice11) < 1.2e99,
+              "Should stop at the slice end above the buffer size");
+
+  // Test 11: A long slice ending right before an unmapped page, with no
+  // terminator; reading past it faults
+  size_t page = (size_t)sysconf(_SC_PAGESIZE);
+  char *pages = mmap(NULL, 2 * page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  TEST_ASSERT(pages != MAP_FAILED && mprotect(pages + page, page, PROT_NONE) == 0, "Guard page should be set up");
+  char *unterminated = pages + page - 100;
+  memset(unterminated, '2', 100);
+  string_slice_t slice12 = {.start = unterminated, .length = 100};
+  double d12 = slice_to_double(slice12);
+  TEST_ASSERT(d12 > 2.2e99 && d12 < 2.3e99, "Should not read past an unterminated slice");
+  munmap(pages, 2 * page);
 }
 
 void test_slice_print() {
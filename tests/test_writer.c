@@ -0,0 +1,359 @@
+#include "../include/writer.h"
+#include "../include/serializer.h"
+#include "../include/parser.h"
+#include "test_framework.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+TEST_SUITE_INIT()
+
+// Callback sink collecting output in memory
+typedef struct {
+  char *data;
+  size_t len;
+  size_t cap;
+  int calls;
+  int max_iovcnt;
+  bool fail;
+} sink_t;
+
+static bool sink_write(void *ctx, const struct iovec *iov, int iovcnt) {
+  sink_t *sink = ctx;
+  if (sink->fail) return false;
+  sink->calls++;
+  if (iovcnt > sink->max_iovcnt) sink->max_iovcnt = iovcnt;
+  for (int i = 0; i < iovcnt; i++) {
+    if (sink->len + iov[i].iov_len + 1 > sink->cap) {
+      sink->cap = (sink->len + iov[i].iov_len + 1) * 2;
+      sink->data = realloc(sink->data, sink->cap);
+    }
+    memcpy(sink->data + sink->len, iov[i].iov_base, iov[i].iov_len);
+    sink->len += iov[i].iov_len;
+  }
+  sink->data[sink->len] = '\0';
+  return true;
+}
+
+static void sink_reset(sink_t *sink) {
+  free(sink->data);
+  memset(sink, 0, sizeof(*sink));
+}
+
+// Document used across tests: every value kind, nested both ways
+static void write_sample(json_writer_t *w) {
+  json_writer_begin_object(w);
+  json_writer_key(w, "id", 2);
+  json_writer_number(w, 42);
+  json_writer_key(w, "name", 4);
+  json_writer_string(w, "say \"hi\"\n", 9);
+  json_writer_key(w, "tags", 4);
+  json_writer_begin_array(w);
+  json_writer_bool(w, true);
+  json_writer_null(w);
+  json_writer_number(w, -0.5);
+  json_writer_begin_object(w);
+  json_writer_end(w);
+  json_writer_end(w);
+  json_writer_key(w, "empty", 5);
+  json_writer_begin_array(w);
+  json_writer_end(w);
+  json_writer_end(w);
+}
+
+static const char *SAMPLE_COMPACT =
+    "{\"id\":42,\"name\":\"say \\\"hi\\\"\\n\",\"tags\":[true,null,-0.5,{}],\"empty\":[]}";
+
+void test_writer_compact() {
+  printf("\n=== Testing compact output ===\n");
+
+  sink_t sink = {0};
+  json_writer_t w = json_writer_init_fn(sink_write, &sink, NULL);
+  write_sample(&w);
+  TEST_ASSERT(json_writer_finish(&w), "Finish should succeed");
+  TEST_ASSERT(sink.data && strcmp(sink.data, SAMPLE_COMPACT) == 0, "Compact output should match");
+  TEST_ASSERT(sink.calls == 1, "Small document should be sent in one call");
+  TEST_ASSERT(w.written == strlen(SAMPLE_COMPACT), "written should count every byte");
+  json_writer_free(&w);
+  sink_reset(&sink);
+
+  w = json_writer_init_fn(sink_write, &sink, NULL);
+  json_writer_number(&w, 1e21);
+  TEST_ASSERT(json_writer_finish(&w) && strcmp(sink.data, "1e+21") == 0, "Scalar root");
+  json_writer_free(&w);
+  sink_reset(&sink);
+}
+
+void test_writer_pretty() {
+  printf("\n=== Testing pretty-printing ===\n");
+
+  sink_t sink = {0};
+  json_writer_config_t config = {.indent = 2};
+  json_writer_t w = json_writer_init_fn(sink_write, &sink, &config);
+  write_sample(&w);
+  TEST_ASSERT(json_writer_finish(&w), "Finish should succeed");
+  const char *expected =
+      "{\n"
+      "  \"id\": 42,\n"
+      "  \"name\": \"say \\\"hi\\\"\\n\",\n"
+      "  \"tags\": [\n"
+      "    true,\n"
+      "    null,\n"
+      "    -0.5,\n"
+      "    {}\n"
+      "  ],\n"
+      "  \"empty\": []\n"
+      "}";
+  TEST_ASSERT(sink.data && strcmp(sink.data, expected) == 0, "Pretty output should match");
+  if (sink.data && strcmp(sink.data, expected) != 0) printf("%s\n", sink.data);
+  json_writer_free(&w);
+  sink_reset(&sink);
+
+  // Deeper than the space run used for indentation
+  w = json_writer_init_fn(sink_write, &sink, &config);
+  for (int i = 0; i < 40; i++) json_writer_begin_array(&w);
+  json_writer_null(&w);
+  for (int i = 0; i < 40; i++) json_writer_end(&w);
+  TEST_ASSERT(json_writer_finish(&w) && strstr(sink.data, "\n                                                                                null\n"),
+              "Deep indentation should be written in full");
+  json_writer_free(&w);
+  sink_reset(&sink);
+}
+
+void test_writer_chunks() {
+  printf("\n=== Testing chunked output ===\n");
+
+  // Tiny chunks: every append crosses boundaries; output must not change
+  sink_t sink = {0};
+  json_writer_config_t config = {.chunk_size = 64, .max_chunks = 3};
+  json_writer_t w = json_writer_init_fn(sink_write, &sink, &config);
+  json_writer_begin_array(&w);
+  for (int i = 0; i < 200; i++) {
+    write_sample(&w);
+  }
+  json_writer_end(&w);
+  TEST_ASSERT(json_writer_finish(&w), "Finish should succeed");
+  size_t sample_len = strlen(SAMPLE_COMPACT);
+  TEST_ASSERT(sink.len == 200 * sample_len + 199 + 2, "Output length should match");
+  int mismatches = 0;
+  for (int i = 0; i < 200; i++) {
+    mismatches += memcmp(sink.data + 1 + i * (sample_len + 1), SAMPLE_COMPACT, sample_len) != 0;
+  }
+  TEST_ASSERT(mismatches == 0, "Every record should be intact across chunk boundaries");
+  TEST_ASSERT(sink.calls > 50, "Output should be flushed as chunks fill");
+  TEST_ASSERT(sink.max_iovcnt == 3, "Full chunks should go out in one gather call");
+  for (int i = 3; i < JSON_WRITER_MAX_CHUNKS; i++) {
+    if (w.chunks[i]) mismatches++;
+  }
+  TEST_ASSERT(mismatches == 0, "No more than max_chunks chunks should be allocated");
+  json_writer_free(&w);
+  sink_reset(&sink);
+
+  // Long strings: clean runs longer than a chunk are sent without copying
+  char *text = malloc(10000);
+  memset(text, 'a', 10000);
+  text[5000] = '\t';
+  w = json_writer_init_fn(sink_write, &sink, &config);
+  json_writer_begin_array(&w);
+  json_writer_string(&w, text, 10000);
+  json_writer_string(&w, "tail", 4);
+  json_writer_end(&w);
+  TEST_ASSERT(json_writer_finish(&w), "Finish should succeed");
+  TEST_ASSERT(sink.len == 1 + 1 + 10001 + 1 + 1 + 6 + 1, "Long string length");
+  TEST_ASSERT(sink.data[0] == '[' && sink.data[1] == '"' && sink.data[5002] == '\\' &&
+              sink.data[5003] == 't' && strcmp(sink.data + sink.len - 9, "\",\"tail\"]") == 0,
+              "Long string should be escaped in place");
+  json_writer_free(&w);
+  sink_reset(&sink);
+  free(text);
+}
+
+void test_writer_fd() {
+  printf("\n=== Testing file descriptor output ===\n");
+
+  FILE *file = tmpfile();
+  TEST_ASSERT(file != NULL, "tmpfile");
+  if (!file) return;
+  json_writer_config_t config = {.chunk_size = 256, .max_chunks = 2, .indent = 1};
+  json_writer_t w = json_writer_init_fd(fileno(file), &config);
+  json_writer_begin_array(&w);
+  for (int i = 0; i < 10000; i++) {
+    json_writer_begin_object(&w);
+    json_writer_key(&w, "i", 1);
+    json_writer_number(&w, i);
+    json_writer_key(&w, "x", 1);
+    json_writer_number(&w, i * 0.25);
+    json_writer_end(&w);
+  }
+  json_writer_end(&w);
+  TEST_ASSERT(json_writer_finish(&w), "Finish should succeed");
+  uint64_t written = w.written;
+  json_writer_free(&w);
+
+  off_t size = lseek(fileno(file), 0, SEEK_END);
+  TEST_ASSERT(size > 0 && (uint64_t)size == written, "File should hold every byte written");
+  char *text = malloc(size + 1);
+  lseek(fileno(file), 0, SEEK_SET);
+  size_t got = read(fileno(file), text, size);
+  text[got] = '\0';
+  fclose(file);
+
+  lexer_t lexer = lexer_init(text);
+  parser_t parser = parser_init(&lexer);
+  parser.current_token = next_token(&lexer);
+  json_value_t doc = parse(&parser);
+  TEST_ASSERT(!parser.has_error && doc.type == JSON_ARRAY && doc.array->len == 10000,
+              "Streamed file should parse back");
+  json_value_t *x = doc.type == JSON_ARRAY ? hash_table_get(doc.array->items[9999].object, "x", 1) : NULL;
+  TEST_ASSERT(x && x->number == 9999 * 0.25, "Values should survive the round trip");
+  parser_free(&parser);
+  lexer_free(&lexer);
+  free(text);
+
+  // Writes to a closed descriptor fail and stick
+  int fds[2];
+  TEST_ASSERT(pipe(fds) == 0, "pipe");
+  close(fds[1]);
+  close(fds[0]);
+  w = json_writer_init_fd(fds[1], NULL);
+  json_writer_null(&w);
+  TEST_ASSERT(!json_writer_finish(&w) && w.has_error, "Write to a closed fd should fail");
+  json_writer_free(&w);
+}
+
+void test_writer_errors() {
+  printf("\n=== Testing writer errors ===\n");
+
+  sink_t sink = {0};
+  json_writer_t w = json_writer_init_fn(sink_write, &sink, NULL);
+  json_writer_end(&w);
+  TEST_ASSERT(w.has_error, "End without an open container should fail");
+  json_writer_free(&w);
+
+  w = json_writer_init_fn(sink_write, &sink, NULL);
+  json_writer_begin_object(&w);
+  json_writer_number(&w, 1);
+  TEST_ASSERT(w.has_error, "Object value without a key should fail");
+  json_writer_free(&w);
+
+  w = json_writer_init_fn(sink_write, &sink, NULL);
+  json_writer_begin_array(&w);
+  json_writer_key(&w, "k", 1);
+  TEST_ASSERT(w.has_error, "Key in an array should fail");
+  json_writer_free(&w);
+
+  w = json_writer_init_fn(sink_write, &sink, NULL);
+  json_writer_begin_object(&w);
+  json_writer_key(&w, "k", 1);
+  json_writer_end(&w);
+  TEST_ASSERT(w.has_error, "Key without a value should fail");
+  json_writer_free(&w);
+
+  w = json_writer_init_fn(sink_write, &sink, NULL);
+  json_writer_null(&w);
+  json_writer_null(&w);
+  TEST_ASSERT(w.has_error, "Second root value should fail");
+  json_writer_free(&w);
+
+  w = json_writer_init_fn(sink_write, &sink, NULL);
+  json_writer_begin_array(&w);
+  TEST_ASSERT(!json_writer_finish(&w), "Finish with an open container should fail");
+  json_writer_free(&w);
+
+  w = json_writer_init_fn(sink_write, &sink, NULL);
+  TEST_ASSERT(!json_writer_finish(&w), "Finish with nothing written should fail");
+  json_writer_free(&w);
+  TEST_ASSERT(sink.calls == 0, "Failed documents should not reach the sink");
+
+  sink.fail = true;
+  w = json_writer_init_fn(sink_write, &sink, NULL);
+  json_writer_null(&w);
+  TEST_ASSERT(!json_writer_finish(&w) && w.has_error, "Sink failure should be reported");
+  json_writer_null(&w);
+  TEST_ASSERT(w.has_error, "Errors should stick");
+  json_writer_free(&w);
+  sink_reset(&sink);
+}
+
+void test_writer_matches_serializer() {
+  printf("\n=== Testing agreement with the serializer ===\n");
+
+  const char *text = "[1.5,\"a\\u00e9\\\\b\",[[],{}],0.1,-7,1e-7,true]";
+  lexer_t lexer = lexer_init(text);
+  parser_t parser = parser_init(&lexer);
+  parser.current_token = next_token(&lexer);
+  json_value_t doc = parse(&parser);
+  char *expected = json_serialize(&doc, NULL);
+
+  sink_t sink = {0};
+  json_writer_t w = json_writer_init_fn(sink_write, &sink, NULL);
+  json_writer_begin_array(&w);
+  json_writer_number(&w, 1.5);
+  json_writer_string_raw(&w, "a\\u00e9\\\\b", 10);
+  json_writer_begin_array(&w);
+  json_writer_begin_array(&w);
+  json_writer_end(&w);
+  json_writer_begin_object(&w);
+  json_writer_end(&w);
+  json_writer_end(&w);
+  json_writer_number(&w, 0.1);
+  json_writer_number(&w, -7);
+  json_writer_number(&w, 1e-7);
+  json_writer_bool(&w, true);
+  json_writer_end(&w);
+  TEST_ASSERT(json_writer_finish(&w) && expected && strcmp(sink.data, expected) == 0,
+              "Writer and serializer should produce the same text");
+  json_writer_free(&w);
+  sink_reset(&sink);
+  free(expected);
+  parser_free(&parser);
+  lexer_free(&lexer);
+}
+
+static void test_writer_escaping(void) {
+  printf("\n=== Testing text round-trip ===\n");
+
+  const char *path = "C:\\new\\temp";
+  const char *quote = "say \"hi\" \\u0041";
+  sink_t sink = {0};
+  json_writer_t w = json_writer_init_fn(sink_write, &sink, NULL);
+  json_writer_begin_object(&w);
+  json_writer_key(&w, quote, strlen(quote));
+  json_writer_string(&w, path, strlen(path));
+  json_writer_key_raw(&w, "r\\u0041w", 8);
+  json_writer_string_raw(&w, "\\n\\", 3);
+  json_writer_end(&w);
+  TEST_ASSERT(json_writer_finish(&w), "Escaped document should finish");
+  TEST_ASSERT(strcmp(sink.data, "{\"say \\\"hi\\\" \\\\u0041\":\"C:\\\\new\\\\temp\","
+                                "\"r\\u0041w\":\"\\n\\\\\"}") == 0,
+              "Text should be fully escaped and raw escapes kept");
+
+  // Parsed back, the text keeps its backslashes and quotes
+  lexer_t lexer = lexer_init(sink.data);
+  parser_t parser = parser_init(&lexer);
+  parser.current_token = next_token(&lexer);
+  json_value_t doc = parse(&parser);
+  json_value_t value = json_object_get(&doc, "say \\\"hi\\\" \\\\u0041");
+  TEST_ASSERT(value.type == JSON_STRING, "Escaped key should be found");
+  TEST_ASSERT(value.type == JSON_STRING && strcmp(json_get_string(&value), "C:\\\\new\\\\temp") == 0,
+              "Path should keep its backslashes");
+  char *text = json_serialize(&doc, NULL);
+  TEST_ASSERT(text && strcmp(text, sink.data) == 0, "Serializer should write the same text back");
+  free(text);
+  parser_free(&parser);
+  lexer_free(&lexer);
+
+  json_writer_free(&w);
+  sink_reset(&sink);
+}
+
+TEST_MAIN("Writer",
+  test_writer_compact();
+  test_writer_pretty();
+  test_writer_chunks();
+  test_writer_fd();
+  test_writer_errors();
+  test_writer_matches_serializer();
+  test_writer_escaping();
+)